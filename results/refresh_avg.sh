@@ -1,5 +1,6 @@
 #!/bin/bash
 echo > time.avg
+echo > setup.avg
 echo > memory.avg
 echo > points.avg
 echo > time_point_dist.avg
@@ -29,6 +30,20 @@ do
 						echo "$f $s $t $theta $l :$avg: ($nb_tests tests)" >> time.avg
 					fi
 					
+					#AVG Setup time
+					sum=0
+					nb_tests=0
+					for setup in $(cat setup.all 2>/dev/null | grep "$f $s $t $theta $l " | cut -d' ' -f6)
+					do 
+						sum=$(($sum+$setup))
+						nb_tests=$(($nb_tests+1)) 
+					done
+					if [ $sum -gt 0 ]
+					then
+						avg=$(($sum / $nb_tests))
+						echo "$f $s $t $theta $l :$avg: ($nb_tests tests)" >> setup.avg
+					fi
+					
 					#AVG Memory
 					sum=0
 					nb_tests=0
@@ -14,20 +14,19 @@
 #include <time.h>
 #include <string.h>
 #include <sys/time.h>
+#include <unistd.h>
 #include "pcs_elliptic_curve_operations.h"
 #include "pcs_pollard_rho.h"
 #include "pcs_storage.h"
 #include "pcs.h"
-
-elliptic_curve_t E;
-point_t P;
-point_t Q;
-mpz_t n;
-mpz_t *A; 
-mpz_t *B;
-point_t M[__NB_ENSEMBLES__];
-uint8_t trailling_bits;
-uint8_t nb_bits;
+#include "pcs_checkpoint.h"
+#include "pcs_multi.h"
+#include "pcs_precomp.h"
+#include "pcs_orbit.h"
+#include "pcs_lanes.h"
+#include "pcs_limbs.h"
+#include "pcs_adaptive.h"
+#include "pcs_group.h"
 
 /** Determines whether a point is a distinguished one.
  *
@@ -47,14 +46,133 @@ int is_distinguished(point_t R, int trailling_bits, mpz_t *q)
 	return (res);
 }
 
+/** Determines whether a point is a distinguished one, reading only the low bits of x.
+ *
+ *	@brief Same result as is_distinguished, without allocating anything:
+ *	the x-coordinate is only divided once the point is known to be
+ *	distinguished, which is rare.
+ *
+ *  @param[in]	R				A point on an elliptic curve.
+ *  @param[in]	trailling_bits	Number of trailling zero bits in a ditinguished point.
+ *  @param[out]	q				The x-coordinate, without the trailling zeros.
+ *  @return 	1 if the point is distinguished, 0 otherwise.
+ */
+int is_distinguished_lean(point_t R, int trailling_bits, mpz_t *q)
+{
+	if(mpz_sgn(R.x) != 0 && mpz_scan1(R.x, 0) < (mp_bitcnt_t)trailling_bits)
+	{
+		return 0;
+	}
+	mpz_tdiv_q_2exp(*q, R.x, trailling_bits);
+	return 1;
+}
+
+/** Builds the fixed-base table of a point.
+ *
+ *	@brief For each window j of __FIXED_BASE_WINDOW__ bits, the table holds 
+ *	the points v*2^(j*__FIXED_BASE_WINDOW__)*B, for v = 1,...,2^__FIXED_BASE_WINDOW__ - 1.
+ *	A scalar multiplication of B then costs one addition per window.
+ *
+ *  @param[in]		ctx		The PCS context.
+ *  @param[in]		B		The base point.
+ *  @param[in,out]	table	The table, allocated if NULL.
+ */
+void fixed_base_table(pcs_ctx_t *ctx, point_t B, point_t **table)
+{
+	int i, j, v;
+	int nb_values = (1 << __FIXED_BASE_WINDOW__) - 1;
+	int nb_bits_scalar = mpz_sizeinbase(ctx->n, 2);
+	point_t *T;
+	if(nb_bits_scalar < ctx->nb_bits)
+	{
+		nb_bits_scalar = ctx->nb_bits;
+	}
+	ctx->P_table_windows = (nb_bits_scalar + __FIXED_BASE_WINDOW__ - 1) / __FIXED_BASE_WINDOW__;
+	if(*table == NULL)
+	{
+		*table = malloc(sizeof(point_t) * ctx->P_table_windows * nb_values);
+		for(i = 0; i < ctx->P_table_windows * nb_values; i++)
+		{
+			point_init(&(*table)[i]);
+		}
+	}
+	for(j = 0; j < ctx->P_table_windows; j++)
+	{
+		T = &(*table)[j * nb_values];
+		if(j == 0)
+		{
+			mpz_set(T[0].x, B.x);
+			mpz_set(T[0].y, B.y);
+			mpz_set(T[0].z, B.z);
+		}
+		else
+		{
+			ctx->group->op(&T[0], T[-1], T[-nb_values], ctx->E); //(2^w - 1 + 1) times the previous base
+		}
+		for(v = 1; v < nb_values; v++)
+		{
+			ctx->group->op(&T[v], T[v - 1], T[0], ctx->E);
+		}
+	}
+}
+
+/** Builds the fixed-base table of the point P.
+ *
+ *  @param[in]	ctx	The PCS context.
+ */
+void fixed_base_init(pcs_ctx_t *ctx)
+{
+	fixed_base_table(ctx, ctx->P, &ctx->P_table);
+}
+
+/** Multiplies a point with a scalar using its fixed-base table.
+ *
+ *  @param[in]	ctx		The PCS context.
+ *  @param[in]	table	The table built by fixed_base_table.
+ *  @param[in]	B		The base point of the table.
+ *  @param[out]	R		The point result.
+ *  @param[in]	s		The scalar.
+ */
+void fixed_base_table_mul(pcs_ctx_t *ctx, point_t *table, point_t B, point_t *R, mpz_t s)
+{
+	int j, v;
+	int nb_values = (1 << __FIXED_BASE_WINDOW__) - 1;
+	if(mpz_sgn(s) < 0 || mpz_sizeinbase(s, 2) > (size_t)(ctx->P_table_windows * __FIXED_BASE_WINDOW__))
+	{
+		ctx->group->exp(R, B, s, ctx->E);
+		return;
+	}
+	ctx->group->identity(R);
+	for(j = 0; j < ctx->P_table_windows; j++)
+	{
+		v = (mpz_getlimbn(s, (j * __FIXED_BASE_WINDOW__) / GMP_NUMB_BITS) >> ((j * __FIXED_BASE_WINDOW__) % GMP_NUMB_BITS)) & nb_values;
+		if(v != 0)
+		{
+			ctx->group->op(R, *R, table[j * nb_values + v - 1], ctx->E);
+		}
+	}
+}
+
+/** Multiplies P with a scalar using the fixed-base table.
+ *
+ *  @param[in]	ctx	The PCS context.
+ *  @param[out]	R	The point result.
+ *  @param[in]	s	The scalar.
+ */
+void fixed_base_mul(pcs_ctx_t *ctx, point_t *R, mpz_t s)
+{
+	fixed_base_table_mul(ctx, ctx->P_table, ctx->P, R, s);
+}
+
 /** Checks if the linear combination aP+bQ is equal to R or its inverse.
  *
- *  @param[in]	R	A point on an elliptic curve.
+ *  @param[in]	ctx	The PCS context.
+ *  @param[in]	R	An element of the group of the context.
  *  @param[in]	a	a coefficient.
  *  @param[in]	b	b coefficient.
  *  @return 	1 if aP+bQ = R, 0 if aP+bQ = -R.
  */
-int same_point(point_t R, mpz_t a, mpz_t b)
+int same_point(pcs_ctx_t *ctx, point_t R, mpz_t a, mpz_t b)
 {
 	int res;
 	point_t *S1, *S2, *S;
@@ -62,210 +180,582 @@ int same_point(point_t R, mpz_t a, mpz_t b)
 	{
 		preallocation_init();
 	}
-	S1 = &(temp_point[omp_get_thread_num()][1]);
-	S2 = &(temp_point[omp_get_thread_num()][2]);
-	S = &(temp_point[omp_get_thread_num()][3]);
-	double_and_add(S1, P, a, E);
-	double_and_add(S2, Q, b, E);
-	add(S, *S1, *S2, E);
-	res=(mpz_cmp(R.y, S->y) == 0);
+	S1 = &(temp_point[1]);
+	S2 = &(temp_point[2]);
+	S = &(temp_point[3]);
+	fixed_base_mul(ctx, S1, a);
+	ctx->group->exp(S2, ctx->Q, b, ctx->E);
+	ctx->group->op(S, *S1, *S2, ctx->E);
+	res = ctx->group->same(R, *S);
 	return res;
 }
 
-/** Computes the linear combination aP+bQ on E.
+/** Computes the linear combination aP+bQ in the group of the context.
  *
+ *  @param[in]	ctx	The PCS context.
  *  @param[out]	R	Resulting point.
  *  @param[in]	a	a coefficient.
  *  @param[in]	b	b coefficient.
  */
-void lin_comb(point_t * R, mpz_t a, mpz_t b)
+void lin_comb(pcs_ctx_t *ctx, point_t * R, mpz_t a, mpz_t b)
 {
 	point_t *S1, *S2;
 	if(!preallocation_init_done)
 	{
 		preallocation_init();
 	}
-	S1 = &(temp_point[omp_get_thread_num()][1]);
-	S2 = &(temp_point[omp_get_thread_num()][2]);
-	double_and_add(S1, P, a, E);
-	double_and_add(S2, Q, b, E);
-	add(R, *S1, *S2, E);
+	S1 = &(temp_point[1]);
+	S2 = &(temp_point[2]);
+	fixed_base_mul(ctx, S1, a);
+	ctx->group->exp(S2, ctx->Q, b, ctx->E);
+	ctx->group->op(R, *S1, *S2, ctx->E);
 }
 
 /** Checks if there is a collision.
  *
+ *	@brief Both trails are walked again from their starting coefficients
+ *	with the operations of the group of the context, keeping the b
+ *	coefficients this time. Trails ending at two different points are a
+ *	false match of a lossy store (see pcs_struct_fingerprint.h), whose
+ *	steps are counted in the context.
  */
-int is_collision(mpz_t x, mpz_t a1, mpz_t a2, int trailling_bits)
+int is_collision(pcs_ctx_t *ctx, mpz_t x, mpz_t a1, mpz_t a2, int trailling_bits)
 {
 	uint8_t r;
-	mpz_t *xDist_;
+	mpz_t *xDist_, *xDist1;
 	int retval = 0;
+	unsigned long long int nb_steps = 0;
 	mpz_t *b1, *b2;
 	point_t *R;
+	if(ctx->nb_targets > 0)
+	{
+		return is_collision_target(ctx, x, a1, a2, trailling_bits);
+	}
 	if(!preallocation_init_done)
 	{
 		preallocation_init();
 	}
-	b1 = &(temp_obj[omp_get_thread_num()][9]);
-	b2 = &(temp_obj[omp_get_thread_num()][10]);
-	xDist_ = &(temp_obj[omp_get_thread_num()][11]);
-	R = &(temp_point[omp_get_thread_num()][4]);
+	b1 = &(temp_obj[9]);
+	b2 = &(temp_obj[10]);
+	xDist_ = &(temp_obj[11]);
+	xDist1 = &(temp_obj[17]);
+	R = &(temp_point[4]);
 	
 	mpz_set_ui(*b2, 0);
 	mpz_set_ui(*b1, 0);
-	double_and_add(R, P, a1, E);
+	fixed_base_mul(ctx, R, a1);
 	//recompute first a,b pair
-	while(!is_distinguished(*R, trailling_bits, xDist_))
+	if(ctx->orbit > 1)
+	{
+		nb_steps += orbit_trail(ctx, R, a1, *b1, trailling_bits, xDist_);
+	}
+	while(!ctx->group->distinguished(*R, trailling_bits, xDist_))
 	{
-		r = hash(R->y);
-		compute_a(a1, A[r], n);
-		compute_b(*b1, B[r], n);
-		f(*R, M[r], R, E);
+		r = ctx->group->partition(*R);
+		compute_a(a1, ctx->A[r], ctx->n);
+		compute_b(*b1, ctx->B[r], ctx->n);
+		ctx->group->op(R, *R, ctx->M[r], ctx->E);
+		nb_steps++;
 	}
+	mpz_set(*xDist1, *xDist_);
 	
 	//recompute second a,b pair
-	double_and_add(R, P, a2, E);
-	while(!is_distinguished(*R, trailling_bits, xDist_))
+	fixed_base_mul(ctx, R, a2);
+	if(ctx->orbit > 1)
+	{
+		nb_steps += orbit_trail(ctx, R, a2, *b2, trailling_bits, xDist_);
+	}
+	while(!ctx->group->distinguished(*R, trailling_bits, xDist_))
+	{
+		r = ctx->group->partition(*R);
+		compute_a(a2, ctx->A[r], ctx->n);
+		compute_b(*b2, ctx->B[r], ctx->n);
+		ctx->group->op(R, *R, ctx->M[r], ctx->E);
+		nb_steps++;
+	}
+	if(mpz_cmp(*xDist1, *xDist_) != 0) //the store only kept a fingerprint of x
 	{
-		r = hash(R->y);
-		compute_a(a2, A[r], n);
-		compute_b(*b2, B[r], n);
-		f(*R, M[r], R, E);
+		#pragma omp atomic
+		ctx->nb_false_matches++;
+		#pragma omp atomic
+		ctx->nb_false_steps += nb_steps;
+		return 0;
 	}
 	if(mpz_cmp(*b1, *b2) != 0) //we found two different pairs, so collision
 	{
-		if(!same_point(*R, a1, *b1)) //it's the inverse point
+		if(!same_point(ctx, *R, a1, *b1)) //it's the inverse point
 		{	
 			mpz_neg(a2, a2); 
-			mpz_mmod(a2, a2, n);
+			mpz_mmod(a2, a2, ctx->n);
 			mpz_neg(*b2, *b2);
-			mpz_mmod(*b2, *b2, n);
+			mpz_mmod(*b2, *b2, ctx->n);
 		}
-		compute_x(x, a1, a2, *b1, *b2, n);
+		compute_x(x, a1, a2, *b1, *b2, ctx->n);
 		retval = 1;
 	}
 	return retval;
 }
 
-/** Initialize all variables needed to do a PCS algorithm.
+/** Add a distinguished point found outside of the context's walkers.
+ *
+ *	@brief Used by a coordinator, which owns the storage structure while
+ *	the walks are done by remote workers.
  *
+ *	@param[in]	xDist	The x coordinate, without the trailling zeros.
+ *	@param[in]	a		The starting coefficient of the trail.
+ *	@param[out]	x_res	The logarithm, if a collision was found.
+ *	@return 	1 if the point gave a collision, 0 otherwise.
  */
-void pcs_init(point_t P_init, point_t Q_init, elliptic_curve_t E_init, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, int type_struct, int nb_threads, uint8_t level)
+int pcs_add_point(pcs_ctx_t *ctx, mpz_t xDist, mpz_t a, mpz_t x_res)
+{
+	char xDist_str[100];
+	mpz_t *a1, *a2;
+	if(!preallocation_init_done)
+	{
+		preallocation_init();
+	}
+	a1 = &(temp_obj[15]);
+	a2 = &(temp_obj[16]);
+
+	if(struct_add(&ctx->storage, *a2, a, xDist, xDist_str))
+	{
+		mpz_set(*a1, a);
+		return is_collision(ctx, x_res, *a1, *a2, ctx->trailling_bits);
+	}
+	return 0;
+}
+
+/** Create a context holding all variables needed to do a PCS algorithm.
+ *
+ *	@brief The storage structure and the walkers are allocated here
+ *	once, and can be reused for several runs thanks to pcs_reset.
+ *	The coefficients of the adding walk are copied into the context.
+ *
+ *	@param[in]	group	The group the walk works in, &pcs_group_ec for the
+ *						points of E, see pcs_group.h.
+ *	@return	The new context, to be freed with pcs_destroy.
+ */
+pcs_ctx_t *pcs_create(point_t P_init, point_t Q_init, elliptic_curve_t E_init, const pcs_group_t *group, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, int type_struct, int nb_threads, uint8_t level)
+{
+	pcs_storage_t storage;
+	struct_init(&storage, type_struct, n_init, trailling_bits_init, nb_bits_init, nb_threads, level);
+	return pcs_create_with_storage(P_init, Q_init, E_init, group, n_init, A_init, B_init, nb_bits_init, trailling_bits_init, storage, nb_threads, level);
+}
+
+/** Create a context on a storage structure built by the caller.
+ *
+ *	@brief Used for structures that are not created by struct_init, such 
+ *	as a store shared with other processes. The structure is freed with
+ *	the context.
+ *
+ *	@return	The new context, to be freed with pcs_destroy.
+ */
+pcs_ctx_t *pcs_create_with_storage(point_t P_init, point_t Q_init, elliptic_curve_t E_init, const pcs_group_t *group, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, pcs_storage_t storage, int nb_threads, uint8_t level)
 {
 	uint8_t i;
+	unsigned long int seed;
+	pcs_ctx_t *ctx = malloc(sizeof(pcs_ctx_t));
+	
+	point_init(&ctx->P);
+	point_init(&ctx->Q);
+	curve_init(&ctx->E);
+	mpz_init(ctx->n);
+	
+	mpz_set(ctx->E.A, E_init.A);
+	mpz_set(ctx->E.B, E_init.B);
+	mpz_set(ctx->E.p, E_init.p);
+	ctx->E.field = E_init.field;
+	ctx->group = group;
 	
-	point_init(&P);
-	point_init(&Q);
-	curve_init(&E);
-	mpz_init(n);
+	mpz_set(ctx->n, n_init);
 	
-	mpz_set(P.x, P_init.x);
-	mpz_set(P.y, P_init.y);
-	mpz_set(P.z, P_init.z);
+	for(i=0; i<__NB_ENSEMBLES__; i++)
+	{
+		mpz_init_set(ctx->A[i], A_init[i]);
+		mpz_init_set(ctx->B[i], B_init[i]);
+		mpz_inits(ctx->M[i].x,ctx->M[i].y,ctx->M[i].z,NULL);
+	}
+	ctx->trailling_bits = trailling_bits_init;
+	ctx->nb_bits = nb_bits_init;
+	ctx->level = level;
+	ctx->nb_threads = nb_threads;
+	ctx->checkpoint_path = NULL;
+	ctx->checkpoint_interval = 0;
+	ctx->checkpoint_request = 0;
+	ctx->checkpoint_captured = 0;
+	ctx->stop = NULL;
+	ctx->nb_targets = 0;
+	ctx->Q_table = NULL;
+	ctx->table = NULL;
+	ctx->step_type = __STEP_ADD__;
+	ctx->lanes_kernel = __LANES_KERNEL_BEST__;
+	ctx->adaptive_points = 0;
+	ctx->nb_false_matches = 0;
+	ctx->nb_false_steps = 0;
+	ctx->schedule = NULL;
+	ctx->schedule_size = 0;
 	
-	mpz_set(Q.x, Q_init.x);
-	mpz_set(Q.y, Q_init.y);
-	mpz_set(Q.z, Q_init.z);
+	ctx->P_table = NULL;
+	pcs_set_points(ctx, P_init, Q_init);
+	orbit_init(ctx);
 	
-	mpz_set(E.A, E_init.A);
-	mpz_set(E.B, E_init.B);
-	mpz_set(E.p, E_init.p);
+	ctx->storage = storage;
 	
-	mpz_set(n, n_init);
+	//Each thread initializes its own walker, so that its memory is local to the thread
+	ctx->walkers = malloc(sizeof(pcs_walker_t) * nb_threads);
+	seed = (unsigned long int)time(NULL) ^ ((unsigned long int)getpid() << 16) ^ (unsigned long int)ctx;
+	#pragma omp parallel num_threads(nb_threads)
+	{
+		pcs_walker_t *w = &ctx->walkers[omp_get_thread_num()];
+		point_init(&w->R);
+		point_init(&w->saved_R);
+		point_init(&w->cycle_R);
+		mpz_inits(w->a, w->a2, w->x, w->xDist, w->saved_a, NULL);
+		w->trail_length = 0;
+		w->nb_steps = 0;
+		w->resume = 0;
+		w->checkpoint_seen = 0;
+		gmp_randinit_default(w->r_state);
+		gmp_randseed_ui(w->r_state, seed * (omp_get_thread_num() + 1));
+	}
+	return ctx;
+}
+
+/** Set the points P and Q and recompute the adding walk steps.
+ *
+ *	@brief The fixed-base table is only rebuilt if P changes.
+ *
+ */
+void pcs_set_points(pcs_ctx_t *ctx, point_t P_init, point_t Q_init)
+{
+	uint8_t i;
+	if(ctx->P_table == NULL || !equal(ctx->P, P_init))
+	{
+		mpz_set(ctx->P.x, P_init.x);
+		mpz_set(ctx->P.y, P_init.y);
+		mpz_set(ctx->P.z, P_init.z);
+		fixed_base_init(ctx);
+	}
 	
-	A = A_init;
-	B = B_init;
+	mpz_set(ctx->Q.x, Q_init.x);
+	mpz_set(ctx->Q.y, Q_init.y);
+	mpz_set(ctx->Q.z, Q_init.z);
 	
 	for(i=0; i<__NB_ENSEMBLES__; i++)
 	{
-		mpz_inits(M[i].x,M[i].y,M[i].z,NULL);
-		lin_comb(&M[i],A[i],B[i]);
+		lin_comb(ctx, &ctx->M[i], ctx->A[i], ctx->B[i]);
+	}
+}
+
+/** Prepare a new run on the same curve, reusing the storage structure and the walkers.
+ *
+ *	@brief The storage structure is emptied in place instead of being freed 
+ *	and allocated again. The walkers keep their random states, so that two
+ *	consecutive runs never start from the same points.
+ *
+ */
+void pcs_reset(pcs_ctx_t *ctx, point_t P_init, point_t Q_init)
+{
+	int i;
+	pcs_set_points(ctx, P_init, Q_init);
+	if(ctx->adaptive_points > 0)
+	{
+		pcs_adaptive_reset(ctx);
 	}
+	else
+	{
+		struct_reset(&ctx->storage);
+	}
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		ctx->walkers[i].resume = 0;
+	}
+}
+
+/** Choose the step function of the walk.
+ *
+ *	@brief With __STEP_LEAN__, the walkers step with f_lean and check the
+ *	distinguished points with is_distinguished_lean. The points walked are
+ *	the same as with __STEP_ADD__ (f and is_distinguished), so the
+ *	trails are walked again in is_collision with f either way. With
+ *	__STEP_LANES__, each thread walks many trails at once in the lanes of
+ *	vector registers (see pcs_lanes.h), and falls back to __STEP_LEAN__
+ *	where lanes_supported says the lanes cannot be used. With
+ *	__STEP_LIMBS__, the coordinates are kept on a fixed number of limbs
+ *	(see pcs_limbs.h), for the curves too large for the lanes, with the
+ *	same fallback where limbs_supported says no.
+ *
+ */
+void pcs_set_step(pcs_ctx_t *ctx, int step_type)
+{
+	ctx->step_type = step_type;
+}
+
+/** Take a copy of a walker for the checkpoint being written.
+ *
+ *	@brief The random state of the walker is reseeded with a value that 
+ *	is saved with the copy, so that a resumed walker draws the same 
+ *	starting points as the one that goes on.
+ *
+ */
+void walker_save(pcs_ctx_t *ctx, pcs_walker_t *w)
+{
+	mpz_set(w->saved_R.x, w->R.x);
+	mpz_set(w->saved_R.y, w->R.y);
+	mpz_set(w->saved_R.z, w->R.z);
+	mpz_set(w->saved_a, w->a);
+	w->saved_trail_length = w->trail_length;
+	w->saved_seed = gmp_urandomb_ui(w->r_state, 32);
+	gmp_randseed_ui(w->r_state, w->saved_seed);
+	w->checkpoint_seen = ctx->checkpoint_request;
+	#pragma omp flush
+	#pragma omp atomic
+	ctx->checkpoint_captured++;
+}
+
+/** Draw the starting point of a new trail.
+ *
+ */
+void start_trail(pcs_ctx_t *ctx, pcs_walker_t *w)
+{
+	if(ctx->nb_targets > 0)
+	{
+		start_trail_target(ctx, w);
+	}
+	else
+	{
+		mpz_urandomb(w->a, w->r_state, ctx->nb_bits);
+		fixed_base_mul(ctx, &w->R, w->a);
+		orbit_canonical(ctx, &w->R, NULL, NULL);
+	}
+	mpz_set_ui(w->cycle_R.z, 0);
+	w->trail_length = 0;
+}
+
+/** Check whether a run is over.
+ *
+ *	@brief A run is over once the requested number of collisions is found,
+ *	or when it is stopped from outside through ctx->stop.
+ *
+ */
+int run_done(pcs_ctx_t *ctx, int *collision_count, int nb_collisions)
+{
+	return (*collision_count >= nb_collisions || (ctx->stop != NULL && *ctx->stop));
+}
+
+/** Handle a distinguished point reached by a walker.
+ *
+ *	@brief The point is looked up in the table, if any, then added to
+ *	the storage structure, and a collision found increments the count of
+ *	the run. w->R and w->a hold the point and the starting coefficient of
+ *	its trail, and w->xDist its x-coordinate without the trailling zeros.
+ *	In an adaptive run, the point is dropped if it is no longer
+ *	distinguished with the current criterion (see pcs_adaptive.h).
+ *
+ */
+void walk_distinguished(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count)
+{
+	char xDist_str[100];
+	int found, stored;
+	if(ctx->adaptive_points > 0 && !pcs_adaptive_enter(ctx, w))
+	{
+		return;
+	}
+	found = (ctx->table != NULL && table_collision(ctx, w->x, w->a, w->xDist));
+	stored = 0;
+	if(!found)
+	{
+		stored = !struct_add(&ctx->storage, w->a2, w->a, w->xDist, xDist_str);
+		if(!stored)
+		{
+			found = is_collision(ctx, w->x, w->a, w->a2, ctx->trailling_bits);
+		}
+	}
+	if(ctx->adaptive_points > 0)
+	{
+		pcs_adaptive_leave(ctx, stored);
+	}
+	if(found)
+	{
+		#pragma omp critical
+		{
+			(*collision_count)++;
+			mpz_set(x_res, w->x);
+		}
+	}
+}
+
+/** Walk until the run is over.
+ *
+ *	@brief A walker resumed from a checkpoint goes on from its saved
+ *	point, otherwise it starts from a random one. The steps other than
+ *	__STEP_ADD__ walk with f_lean on a curve, and with the operation of
+ *	the group otherwise.
+ *
+ */
+void walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions)
+{
+    int trail_length_max = pow(2, ctx->trailling_bits) * 20;
+	uint8_t r, trailling_bits = ctx->trailling_bits;
+	int lean = (ctx->step_type != __STEP_ADD__ && ctx->group == &pcs_group_ec);
+	int (*distinguished)(point_t, int, mpz_t *) = lean ? is_distinguished_lean : ctx->group->distinguished;
 	
-	trailling_bits = trailling_bits_init;
-	nb_bits = nb_bits_init;
+	w->checkpoint_seen = ctx->checkpoint_request;
+	w->nb_steps = 0;
+	if(w->resume)
+	{
+		w->resume = 0;
+	}
+	else
+	{
+		//Initialize a starting point
+		start_trail(ctx, w);
+	}
 	
-	struct_init(type_struct, n, trailling_bits, nb_bits, nb_threads, level);
+	while(!run_done(ctx, collision_count, nb_collisions))
+	{
+		if(w->checkpoint_seen != ctx->checkpoint_request)
+		{
+			walker_save(ctx, w);
+		}
+		if(distinguished(w->R, ctx->trailling_bits, &w->xDist))
+		{
+			walk_distinguished(ctx, w, x_res, collision_count);
+			start_trail(ctx, w);
+		}
+		else
+		{
+			if(ctx->orbit > 1)
+			{
+				w->nb_steps += orbit_walk(ctx, &w->R, NULL, NULL, &w->cycle_R, w->trail_length + 1);
+			}
+			else if(lean)
+			{
+				r=hash(w->R.y);
+				f_lean(&w->R, ctx->M[r], ctx->E);
+				w->nb_steps++;
+			}
+			else
+			{
+				r = ctx->group->partition(w->R);
+				ctx->group->op(&w->R, w->R, ctx->M[r], ctx->E);
+				w->nb_steps++;
+			}
+			w->trail_length++;
+			if(trailling_bits != ctx->trailling_bits)
+			{
+				//The criterion of an adaptive run was tightened
+				trailling_bits = ctx->trailling_bits;
+				trail_length_max = pow(2, trailling_bits) * 20;
+			}
+			if(w->trail_length > trail_length_max)
+			{
+				start_trail(ctx, w);
+			}
+		}
+	}
 }
 
 /** Run the PCS algorithm.
  *
+ *	@brief If checkpoints are enabled, one more thread is started
+ *	to write them while the walkers go on.
+ *
+ *	@return	The number of collisions found, which is less than 
+ *			nb_collisions if the run was stopped through ctx->stop.
  */
-long long int pcs_run(mpz_t x_res, int nb_threads, int nb_collisions)
+long long int pcs_run(pcs_ctx_t *ctx, mpz_t x_res, int nb_collisions)
 {
-	point_t R;
-	mpz_t a, a2;
-	mpz_t x, xDist;
-	uint8_t r;
-    int trail_length;
-    int trail_length_max = pow(2, trailling_bits) * 20;
     int collision_count = 0;
-	char xDist_str[50];
-	#pragma omp parallel private(R, a, a2, x, r, xDist, xDist_str, trail_length) shared(collision_count, x_res, trail_length_max) num_threads(nb_threads)
+    int nb_team = ctx->nb_threads + (ctx->checkpoint_path != NULL);
+    int lanes = (ctx->step_type == __STEP_LANES__ && lanes_supported(ctx));
+    int limbs = (ctx->step_type == __STEP_LIMBS__ && limbs_supported(ctx));
+	ctx->nb_false_matches = 0;
+	ctx->nb_false_steps = 0;
+	if(ctx->adaptive_points > 0)
 	{
-		point_init(&R);
-		mpz_inits(x, a2, a, xDist, NULL);
-		
-		//Initialize a starting point
-		gmp_randstate_t r_state;
-		gmp_randinit_default(r_state);
-		gmp_randseed_ui(r_state, time(NULL) * (omp_get_thread_num() + 1));
-		mpz_urandomb(a, r_state, nb_bits);
-		double_and_add(&R, P, a, E);
-        	trail_length = 0;
-		
-		while(collision_count < nb_collisions)
+		pcs_adaptive_start(ctx);
+	}
+	#pragma omp parallel shared(collision_count, x_res) num_threads(nb_team)
+	{
+		if(omp_get_thread_num() < ctx->nb_threads)
 		{
-            		if(is_distinguished(R, trailling_bits, &xDist))
+			if(lanes)
 			{
-                		if(struct_add(a2, a, xDist, xDist_str))
-				{
-					if(is_collision(x, a, a2, trailling_bits))
-					{
-						#pragma omp critical
-						{
-							collision_count++;
-                            				mpz_set(x_res, x);
-						}
-					}
-				}
-				mpz_urandomb(a, r_state, nb_bits);
-				double_and_add(&R, P, a, E);
-                		trail_length = 0;
+				lanes_walk(ctx, &ctx->walkers[omp_get_thread_num()], x_res, &collision_count, nb_collisions);
+			}
+			else if(limbs)
+			{
+				limbs_walk(ctx, &ctx->walkers[omp_get_thread_num()], x_res, &collision_count, nb_collisions);
 			}
 			else
 			{
-				r=hash(R.y);
-				f(R, M[r], &R, E);
-                		trail_length++;
-               			if(trail_length > trail_length_max)
-                		{
-                    			mpz_urandomb(a, r_state, nb_bits);
-                    			double_and_add(&R, P, a, E);
-                    			trail_length = 0;
-                		}
+				walk(ctx, &ctx->walkers[omp_get_thread_num()], x_res, &collision_count, nb_collisions);
 			}
 		}
-		point_clear(&R);
-		mpz_clears(a, a2, x, xDist, NULL);
-		gmp_randclear(r_state);
+		else
+		{
+			pcs_checkpoint_loop(ctx, &collision_count, nb_collisions);
+		}
 	}
-	return 0;
+	return collision_count;
 }
 
-/** Free all variables used in the previous PCS run.
+/** Get the number of steps walked by all the walkers during the last run.
  *
  */
-void pcs_clear()
+unsigned long long int pcs_steps(pcs_ctx_t *ctx)
 {
-	uint8_t i;
-	point_clear(&P);
-	point_clear(&Q);
-	curve_clear(&E);
-	mpz_clear(n);
+	int i;
+	unsigned long long int nb_steps = 0;
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		nb_steps += ctx->walkers[i].nb_steps;
+	}
+	return nb_steps;
+}
+
+/** Get the memory occupation of the storage structure of a context.
+ *
+ *  @return 	The memory occupation in bytes.
+ */
+unsigned long long int pcs_memory(pcs_ctx_t *ctx, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	return struct_memory(&ctx->storage, nb_points, rate_of_use, rate_slots);
+}
+
+/** Free a context and all variables it holds.
+ *
+ */
+void pcs_destroy(pcs_ctx_t *ctx)
+{
+	int i;
+	point_clear(&ctx->P);
+	point_clear(&ctx->Q);
+	curve_clear(&ctx->E);
+	mpz_clear(ctx->n);
 	for(i = 0; i < __NB_ENSEMBLES__; i++)
 	{
-		mpz_clears(M[i].x, M[i].y, M[i].z, NULL);
+		mpz_clears(ctx->A[i], ctx->B[i], ctx->M[i].x, ctx->M[i].y, ctx->M[i].z, NULL);
+	}
+	for(i = 0; i < ctx->P_table_windows * ((1 << __FIXED_BASE_WINDOW__) - 1); i++)
+	{
+		point_clear(&ctx->P_table[i]);
+	}
+	free(ctx->P_table);
+	orbit_clear(ctx);
+	pcs_free_targets(ctx);
+	pcs_adaptive_free(ctx);
+	struct_free(&ctx->storage);
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		point_clear(&ctx->walkers[i].R);
+		point_clear(&ctx->walkers[i].saved_R);
+		point_clear(&ctx->walkers[i].cycle_R);
+		mpz_clears(ctx->walkers[i].a, ctx->walkers[i].a2, ctx->walkers[i].x, ctx->walkers[i].xDist, ctx->walkers[i].saved_a, NULL);
+		gmp_randclear(ctx->walkers[i].r_state);
 	}
-	struct_free();
+	free(ctx->walkers);
+	free(ctx->checkpoint_path);
+	free(ctx);
 }
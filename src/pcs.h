@@ -3,14 +3,144 @@
  *	Created by Monika Trimoska on 03/12/2015.
  *	Copyright © 2015 Monika Trimoska. All rights reserved.
  */
+#ifndef PCS_H
+#define PCS_H
 
 #include <gmp.h>
 #include <omp.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_storage.h"
+#include "pcs_group.h"
 
 #define __NB_ENSEMBLES__ 20
+#define __FIXED_BASE_WINDOW__ 4
+#define __ORBIT_MAX__ 6
+#define __STEP_ADD__ 0
+#define __STEP_LEAN__ 1
+#define __STEP_LANES__ 2
+#define __STEP_LIMBS__ 3
 
-void combLin(point_t * R, mpz_t a, mpz_t b);
-void pcs_init(point_t P_init, point_t Q_init, elliptic_curve_t E_init, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, int type_struct, int nb_threads, uint8_t level);
-long long int pcs_run(mpz_t x_res, int nb_threads, int nb_collisions);
-void pcs_clear();
+typedef struct pcs_table pcs_table_t;
+
+/** A number of trailling zero bits used by an adaptive run, from the given time on.
+ *
+ *	@brief time is in microseconds since the start of the run, nb_steps
+ *	the steps walked by then, and nb_points the points kept in the store
+ *	with the new criterion.
+ */
+typedef struct
+{
+	uint8_t trailling_bits;
+	unsigned long long int time;
+	unsigned long long int nb_steps;
+	unsigned long int nb_points;
+}pcs_schedule_t;
+
+/** State of one walker, kept alive between two runs.
+ */
+typedef struct
+{
+	point_t R;
+	mpz_t a;
+	mpz_t a2;
+	mpz_t x;
+	mpz_t xDist;
+	gmp_randstate_t r_state;
+	int trail_length;
+	unsigned long long int nb_steps;
+	char resume;
+	/* Point of the trail kept to detect fruitless cycles, see pcs_orbit.h */
+	point_t cycle_R;
+	/* Copy of the walker taken for the last checkpoint */
+	point_t saved_R;
+	mpz_t saved_a;
+	int saved_trail_length;
+	unsigned long int saved_seed;
+	int checkpoint_seen;
+}pcs_walker_t;
+
+/** Context of one PCS solve.
+ *  @brief Holds everything a solve needs, so that several solves can run
+ *  at the same time in one process.
+ */
+typedef struct
+{
+	elliptic_curve_t E;
+	/* Group the walk works in, given by E, see pcs_group.h */
+	const pcs_group_t *group;
+	point_t P;
+	point_t Q;
+	mpz_t n;
+	mpz_t A[__NB_ENSEMBLES__];
+	mpz_t B[__NB_ENSEMBLES__];
+	point_t M[__NB_ENSEMBLES__];
+	point_t *P_table;
+	int P_table_windows;
+	uint8_t trailling_bits;
+	uint8_t nb_bits;
+	uint8_t level;
+	int nb_threads;
+	pcs_storage_t storage;
+	pcs_walker_t *walkers;
+	char *checkpoint_path;
+	int checkpoint_interval;
+	volatile int checkpoint_request;
+	volatile int checkpoint_captured;
+	volatile uint32_t *stop;
+	/* Targets sharing the storage structure, see pcs_multi.h */
+	int nb_targets;
+	int target;
+	uint8_t target_bits;
+	point_t *targets;
+	mpz_t *target_logs;
+	char *target_solved;
+	point_t *Q_table;
+	/* Precomputed table of distinguished points, see pcs_precomp.h */
+	pcs_table_t *table;
+	/* Step function of the walk, __STEP_ADD__, __STEP_LEAN__, __STEP_LANES__, or __STEP_LIMBS__ */
+	int step_type;
+	/* Kernel of the lanes, see pcs_lanes.h */
+	int lanes_kernel;
+	/* Automorphism group the walk works modulo, see pcs_orbit.h */
+	int orbit;
+	int orbit_order;
+	mpz_t orbit_x[__ORBIT_MAX__];
+	mpz_t orbit_y[__ORBIT_MAX__];
+	mpz_t orbit_log[__ORBIT_MAX__];
+	/* Adaptive number of trailling zero bits, see pcs_adaptive.h */
+	unsigned long int adaptive_points;
+	uint8_t adaptive_start;
+	uint8_t adaptive_max;
+	volatile unsigned long int adaptive_count;
+	pthread_rwlock_t adaptive_lock;
+	unsigned long long int adaptive_time;
+	pcs_schedule_t *schedule;
+	int schedule_size;
+	/* Matches of a lossy store told false by is_collision during the last run, and their re-walk steps */
+	unsigned long long int nb_false_matches;
+	unsigned long long int nb_false_steps;
+}pcs_ctx_t;
+
+pcs_ctx_t *pcs_create(point_t P_init, point_t Q_init, elliptic_curve_t E_init, const pcs_group_t *group, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, int type_struct, int nb_threads, uint8_t level);
+pcs_ctx_t *pcs_create_with_storage(point_t P_init, point_t Q_init, elliptic_curve_t E_init, const pcs_group_t *group, mpz_t n_init, mpz_t *A_init, mpz_t *B_init, uint8_t nb_bits_init, uint8_t trailling_bits_init, pcs_storage_t storage, int nb_threads, uint8_t level);
+int is_distinguished(point_t R, int trailling_bits, mpz_t *q);
+int is_distinguished_lean(point_t R, int trailling_bits, mpz_t *q);
+void fixed_base_table(pcs_ctx_t *ctx, point_t B, point_t **table);
+void fixed_base_table_mul(pcs_ctx_t *ctx, point_t *table, point_t B, point_t *R, mpz_t s);
+void fixed_base_mul(pcs_ctx_t *ctx, point_t *R, mpz_t s);
+void pcs_set_points(pcs_ctx_t *ctx, point_t P_init, point_t Q_init);
+void pcs_reset(pcs_ctx_t *ctx, point_t P_init, point_t Q_init);
+void pcs_set_step(pcs_ctx_t *ctx, int step_type);
+int pcs_add_point(pcs_ctx_t *ctx, mpz_t xDist, mpz_t a, mpz_t x_res);
+void walker_save(pcs_ctx_t *ctx, pcs_walker_t *w);
+int run_done(pcs_ctx_t *ctx, int *collision_count, int nb_collisions);
+void start_trail(pcs_ctx_t *ctx, pcs_walker_t *w);
+void walk_distinguished(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count);
+void walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions);
+long long int pcs_run(pcs_ctx_t *ctx, mpz_t x_res, int nb_collisions);
+unsigned long long int pcs_steps(pcs_ctx_t *ctx);
+unsigned long long int pcs_memory(pcs_ctx_t *ctx, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+void pcs_destroy(pcs_ctx_t *ctx);
+#endif
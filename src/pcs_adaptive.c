@@ -0,0 +1,220 @@
+/** @file pcs_adaptive.c
+ *  @brief Number of trailling zero bits tightened during a run, to keep the store within a number of points.
+ *
+ *	An adaptive run starts with the number of trailling zero bits d of
+ *	the context, small enough that the first collisions are detected
+ *	soon after they happen, and adds one to it each time the store holds
+ *	more than max_points points. The store is then rebuilt with the
+ *	points whose x still has d + 1 trailling zero bits, about half of
+ *	them: a trail ends at its first point of d zero bits, so that it also
+ *	ends at its first point of d + 1 zero bits when it is kept, and the
+ *	points the walkers reach afterwards are checked again with the new d
+ *	before they are stored. is_collision walks the trails again with the
+ *	d of the store.
+ *
+ *	The walkers add their points under the read side of a lock and the
+ *	rebuild holds its write side, so that a walker only waits for a
+ *	rebuild when it reaches a distinguished point meanwhile. The rebuild
+ *	holds the old and the new store at once, up to 1.5 times the target.
+ *	d stops at adaptive_max, past which the store grows again.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <gmp.h>
+#include <omp.h>
+#include <pthread.h>
+#include "pcs_adaptive.h"
+#include "pcs_struct_shm.h"
+#include "pcs_struct_net.h"
+#include "pcs_struct_frozen.h"
+#include "pcs_struct_fingerprint.h"
+
+/** State of the rebuild of the store given to struct_foreach.
+ */
+typedef struct
+{
+	pcs_storage_t *storage;
+	int shift;
+	mpz_t xDist;
+	mpz_t a_out;
+	char xDist_str[100];
+	unsigned long int nb_points;
+}adaptive_filter_t;
+
+static unsigned long long int adaptive_now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (unsigned long long int)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/** Keep the walk of a context within max_points stored points by tightening the distinguishing criterion.
+ *
+ *	@brief The number of trailling zero bits of the context is the one
+ *	the runs start with, and it goes up to the largest one the store can
+ *	hold, with a suffix of x of one bit at least in PRTL. The shared,
+ *	network, frozen and fingerprint stores, which struct_init does not
+ *	create, can not be adaptive, and the steps in lanes, on limbs or on
+ *	binary words fall back to __STEP_LEAN__.
+ */
+void pcs_set_adaptive(pcs_ctx_t *ctx, unsigned long int max_points)
+{
+	int max;
+	if(ctx->storage.type == __STRUCT_SHM__ || ctx->storage.type == __STRUCT_NET__ || ctx->storage.type == __STRUCT_FROZEN__ || ctx->storage.type == __STRUCT_FINGERPRINT__)
+	{
+		fprintf(stderr, "The number of trailling zero bits can only be adaptive with a store of the process (PRTL or hash_unix).\n");
+		exit(1);
+	}
+	max = (ctx->storage.type == 0) ? ctx->nb_bits - ctx->level - 1 : ctx->nb_bits / 2;
+	if(max > __ADAPTIVE_MAX_BITS__)
+	{
+		max = __ADAPTIVE_MAX_BITS__;
+	}
+	if(max < ctx->trailling_bits)
+	{
+		max = ctx->trailling_bits;
+	}
+	ctx->adaptive_points = max_points;
+	ctx->adaptive_start = ctx->trailling_bits;
+	ctx->adaptive_max = max;
+	ctx->adaptive_count = 0;
+	pthread_rwlock_init(&ctx->adaptive_lock, NULL);
+	free(ctx->schedule);
+	ctx->schedule = malloc(sizeof(pcs_schedule_t) * (max - ctx->trailling_bits + 1));
+	ctx->schedule_size = 0;
+}
+
+/** Start the schedule of a run with the current number of trailling zero bits.
+ *
+ *	@brief The steps of the walkers are set to zero here already, so
+ *	that a rebuild before a walker starts does not count its last run.
+ */
+void pcs_adaptive_start(pcs_ctx_t *ctx)
+{
+	int i;
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		ctx->walkers[i].nb_steps = 0;
+	}
+	ctx->adaptive_time = adaptive_now();
+	ctx->schedule[0].trailling_bits = ctx->trailling_bits;
+	ctx->schedule[0].time = 0;
+	ctx->schedule[0].nb_steps = 0;
+	ctx->schedule[0].nb_points = ctx->adaptive_count;
+	ctx->schedule_size = 1;
+}
+
+/** Empty the store for a new run, with the number of trailling zero bits of the start.
+ *
+ */
+void pcs_adaptive_reset(pcs_ctx_t *ctx)
+{
+	if(ctx->trailling_bits != ctx->adaptive_start)
+	{
+		struct_free(&ctx->storage);
+		struct_init(&ctx->storage, ctx->storage.type, ctx->n, ctx->adaptive_start, ctx->nb_bits, ctx->nb_threads, ctx->level);
+		ctx->trailling_bits = ctx->adaptive_start;
+	}
+	else
+	{
+		struct_reset(&ctx->storage);
+	}
+	ctx->adaptive_count = 0;
+}
+
+/** Check a distinguished point again with the current criterion, before it is stored.
+ *
+ *	@brief On success, the read side of the lock is held until
+ *	pcs_adaptive_leave, and w->xDist is the x-coordinate of w->R without
+ *	the current trailling zeros.
+ *
+ *	@return 	1 if the point is still distinguished, 0 if its trail has to be dropped.
+ */
+int pcs_adaptive_enter(pcs_ctx_t *ctx, pcs_walker_t *w)
+{
+	pthread_rwlock_rdlock(&ctx->adaptive_lock);
+	if(!ctx->group->distinguished(w->R, ctx->trailling_bits, &w->xDist))
+	{
+		pthread_rwlock_unlock(&ctx->adaptive_lock);
+		return 0;
+	}
+	return 1;
+}
+
+static void adaptive_filter(mpz_t xDist, mpz_t a, void *arg)
+{
+	adaptive_filter_t *filter = arg;
+	if(mpz_sgn(xDist) != 0 && mpz_scan1(xDist, 0) < (mp_bitcnt_t)filter->shift)
+	{
+		return;
+	}
+	mpz_tdiv_q_2exp(filter->xDist, xDist, filter->shift);
+	struct_add(filter->storage, filter->a_out, a, filter->xDist, filter->xDist_str);
+	filter->nb_points++;
+}
+
+/** Rebuild the store with one more trailling zero bit.
+ *
+ *	@brief Another walker may have done it meanwhile, which the count
+ *	of points tells once the write side of the lock is held.
+ */
+static void adaptive_tighten(pcs_ctx_t *ctx)
+{
+	adaptive_filter_t filter;
+	pcs_storage_t storage;
+	pcs_schedule_t *s;
+	pthread_rwlock_wrlock(&ctx->adaptive_lock);
+	if(ctx->adaptive_count > ctx->adaptive_points && ctx->trailling_bits < ctx->adaptive_max)
+	{
+		struct_init(&storage, ctx->storage.type, ctx->n, ctx->trailling_bits + 1, ctx->nb_bits, ctx->nb_threads, ctx->level);
+		filter.storage = &storage;
+		filter.shift = 1;
+		filter.nb_points = 0;
+		mpz_inits(filter.xDist, filter.a_out, NULL);
+		struct_foreach(&ctx->storage, adaptive_filter, &filter);
+		mpz_clears(filter.xDist, filter.a_out, NULL);
+		struct_free(&ctx->storage);
+		ctx->storage = storage;
+		ctx->trailling_bits++;
+		ctx->adaptive_count = filter.nb_points;
+		s = &ctx->schedule[ctx->schedule_size++];
+		s->trailling_bits = ctx->trailling_bits;
+		s->time = adaptive_now() - ctx->adaptive_time;
+		s->nb_steps = pcs_steps(ctx);
+		s->nb_points = filter.nb_points;
+	}
+	pthread_rwlock_unlock(&ctx->adaptive_lock);
+}
+
+/** Release the lock taken by pcs_adaptive_enter, and tighten the criterion if the store is full.
+ *
+ *	@param[in]	stored	1 if the point was added to the store, 0 if it was found there.
+ */
+void pcs_adaptive_leave(pcs_ctx_t *ctx, int stored)
+{
+	unsigned long int count = 0;
+	if(stored)
+	{
+		#pragma omp atomic capture
+		count = ++ctx->adaptive_count;
+	}
+	pthread_rwlock_unlock(&ctx->adaptive_lock);
+	if(count > ctx->adaptive_points && ctx->trailling_bits < ctx->adaptive_max)
+	{
+		adaptive_tighten(ctx);
+	}
+}
+
+/** Free the schedule and the lock of an adaptive context.
+ *
+ */
+void pcs_adaptive_free(pcs_ctx_t *ctx)
+{
+	if(ctx->adaptive_points > 0)
+	{
+		pthread_rwlock_destroy(&ctx->adaptive_lock);
+	}
+	free(ctx->schedule);
+	ctx->schedule = NULL;
+}
@@ -0,0 +1,17 @@
+/** @file pcs_adaptive.h
+ *
+ */
+#ifndef PCS_ADAPTIVE_H
+#define PCS_ADAPTIVE_H
+
+#include "pcs.h"
+
+#define __ADAPTIVE_MAX_BITS__ 26 /* so that the trail length limit 2^d * 20 fits an int */
+
+void pcs_set_adaptive(pcs_ctx_t *ctx, unsigned long int max_points);
+void pcs_adaptive_start(pcs_ctx_t *ctx);
+void pcs_adaptive_reset(pcs_ctx_t *ctx);
+int pcs_adaptive_enter(pcs_ctx_t *ctx, pcs_walker_t *w);
+void pcs_adaptive_leave(pcs_ctx_t *ctx, int stored);
+void pcs_adaptive_free(pcs_ctx_t *ctx);
+#endif
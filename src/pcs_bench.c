@@ -0,0 +1,572 @@
+/** @file pcs_bench.c
+ *  @brief Microbenchmark of the field kernels, of the inversion and of the steps of the walk.
+ *
+ *	For each field kernel of pcs_field.h that runs on the processor, and
+ *	for 1 to __FIELD_MAX_LIMBS__ limbs, the multiplications and squarings
+ *	are checked against GMP, then timed on a chain of dependent
+ *	operations, as they are in a step of the walk. invert_mod is checked
+ *	against mpz_invert and both are timed modulo the prime of each curve of
+ *	the file curves. The products, squares and inverses of the binary
+ *	fields of pcs_binary.h are checked against the generic kernel and
+ *	timed with each kernel, for each curve of the file curves_binary. Then,
+ *	on some of the curves of both files, a run of one thread is timed with
+ *	each step of the walk: add, lean, lanes with each of the kernels of
+ *	pcs_lanes.h, limbs, and binary with each of the kernels of
+ *	pcs_binary.h, and in some of the groups F_p^* of the file curves_fp,
+ *	with the operation of the group (see pcs_group.h).
+ *
+ *	The cycles are those of the time-stamp counter, which ticks at the
+ *	nominal frequency of the processor.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs.h"
+#include "pcs_field.h"
+#include "pcs_invert.h"
+#include "pcs_lanes.h"
+#include "pcs_limbs.h"
+#include "pcs_binary.h"
+#include "pcs_group.h"
+#include "pcs_curves.h"
+#include "pcs_vect_bin.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define __BENCH_CYCLES__() __rdtsc()
+#else
+#define __BENCH_CYCLES__() 0ULL
+#endif
+
+#define __DEFAULT_NB_OPS__ 10000000
+#define __DEFAULT_RUN_SECONDS__ 2
+#define __DEFAULT_NB_INVERSIONS__ 200000
+#define __NB_INVERT_VALUES__ 256
+#define __NB_CHECKS__ 10000
+#define __MAX_CURVES__ 32
+
+/** Print out executable usage.
+ */
+void print_usage() {
+    printf("Usage: \n-f : bits of a curve of the file curves to time the steps of the walk on, can be given several times (default is 35, 65, 95 and 115, the file has curves up to 255 bits)\n-b : degree of a curve of the file curves_binary to time the steps of the walk on, can be given several times (default is 35, 65 and 115, the file has curves up to 233 bits)\n-p : bits of a prime of the file curves_fp to time the walk in F_p^* on, can be given several times (default is 35, 65 and 115, the file has primes up to 192 bits)\n-m : number of field operations timed per kernel and size (default is %d)\n-i : number of inversions timed per curve (default is %d)\n-s : seconds of each timed run of the walk (default is %d)\n", __DEFAULT_NB_OPS__, __DEFAULT_NB_INVERSIONS__, __DEFAULT_RUN_SECONDS__);
+}
+
+/** Get the current time in nanoseconds.
+ */
+unsigned long long int now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** Check the multiplications and squarings of a field against GMP.
+ *
+ * 	@return 	The number of wrong results.
+ */
+int check_field(field_t *F, mpz_t p, gmp_randstate_t r_state)
+{
+	uint64_t a[__FIELD_MAX_LIMBS__], b[__FIELD_MAX_LIMBS__], r[__FIELD_MAX_LIMBS__];
+	mpz_t x, y, z, e;
+	int i, nb_wrong = 0;
+	mpz_inits(x, y, z, e, NULL);
+	for(i = 0; i < __NB_CHECKS__; i++)
+	{
+		mpz_urandomm(x, r_state, p);
+		mpz_urandomm(y, r_state, p);
+		if(i == 0)
+		{
+			mpz_sub_ui(x, p, 1);
+			mpz_sub_ui(y, p, 1);
+		}
+		field_set(a, x, F);
+		field_set(b, y, F);
+		F->mul(r, a, b, F);
+		field_get(z, r, F);
+		mpz_mul(e, x, y);
+		mpz_mod(e, e, p);
+		nb_wrong += (mpz_cmp(z, e) != 0);
+		F->sqr(r, a, NULL, F);
+		field_get(z, r, F);
+		mpz_mul(e, x, x);
+		mpz_mod(e, e, p);
+		nb_wrong += (mpz_cmp(z, e) != 0);
+	}
+	mpz_clears(x, y, z, e, NULL);
+	return nb_wrong;
+}
+
+/** Time a chain of nb_ops dependent multiplications, or squarings.
+ *
+ * 	@param[out]	ns		Nanoseconds per operation.
+ * 	@return 	Cycles per operation.
+ */
+double time_field(field_t *F, mpz_t p, gmp_randstate_t r_state, int square, long int nb_ops, double *ns)
+{
+	uint64_t a[__FIELD_MAX_LIMBS__], b[__FIELD_MAX_LIMBS__];
+	unsigned long long int c1, c2, t1, t2;
+	volatile uint64_t sink;
+	mpz_t x;
+	long int i;
+	mpz_init(x);
+	mpz_urandomm(x, r_state, p);
+	field_set(a, x, F);
+	mpz_urandomm(x, r_state, p);
+	field_set(b, x, F);
+	t1 = now_ns();
+	c1 = __BENCH_CYCLES__();
+	if(square)
+	{
+		for(i = 0; i < nb_ops; i++)
+		{
+			F->sqr(a, a, NULL, F);
+		}
+	}
+	else
+	{
+		for(i = 0; i < nb_ops; i++)
+		{
+			F->mul(a, a, b, F);
+		}
+	}
+	c2 = __BENCH_CYCLES__();
+	t2 = now_ns();
+	sink = a[0];
+	(void)sink;
+	mpz_clear(x);
+	*ns = (double)(t2 - t1) / nb_ops;
+	return (double)(c2 - c1) / nb_ops;
+}
+
+/** Time the field kernels for 1 to __FIELD_MAX_LIMBS__ limbs.
+ *
+ */
+void bench_field(long int nb_ops)
+{
+	gmp_randstate_t r_state;
+	field_t F;
+	mpz_t p;
+	double mul_cycles, mul_ns, sqr_cycles, sqr_ns;
+	int kernel, n, nb_wrong;
+
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, 1);
+	mpz_init(p);
+	printf("kernel      limbs   mul cycles     mul ns   sqr cycles     sqr ns   checks\n");
+	for(kernel = 0; kernel < __FIELD_NB_KERNELS__; kernel++)
+	{
+		if(!field_kernel_available(kernel))
+		{
+			printf("%-10s  does not run on this processor\n", field_kernel_name(kernel));
+			continue;
+		}
+		for(n = 1; n <= __FIELD_MAX_LIMBS__; n++)
+		{
+			//a prime of 64n - 2 bits, as large as the curves of n limbs get
+			mpz_urandomb(p, r_state, 64 * n - 2);
+			mpz_setbit(p, 64 * n - 3);
+			mpz_nextprime(p, p);
+			field_init(&F, p, kernel);
+			nb_wrong = check_field(&F, p, r_state);
+			mul_cycles = time_field(&F, p, r_state, 0, nb_ops, &mul_ns);
+			sqr_cycles = time_field(&F, p, r_state, 1, nb_ops, &sqr_ns);
+			printf("%-10s  %5d   %10.1f %10.2f   %10.1f %10.2f   %s\n", field_kernel_name(kernel), n, mul_cycles, mul_ns, sqr_cycles, sqr_ns, nb_wrong ? "wrong" : "ok");
+		}
+	}
+	mpz_clear(p);
+	gmp_randclear(r_state);
+}
+
+/** Stop a run of the walk after a given time.
+ */
+typedef struct
+{
+	volatile uint32_t stop;
+	int seconds;
+}bench_timer_t;
+
+void *bench_timer(void *arg)
+{
+	bench_timer_t *timer = (bench_timer_t *)arg;
+	sleep(timer->seconds);
+	timer->stop = 1;
+	return NULL;
+}
+
+/** Read the f-bit curve of a file of curves, and its first point.
+ *
+ * 	@return 	0 if the curve was read, 1 otherwise.
+ */
+int read_curve(const char *curves_path, const char *points_path, int f, elliptic_curve_t *E, mpz_t n, point_t *P)
+{
+	return (curves_read(curves_path, f, E, n) || curves_read_point(points_path, f, 0, P));
+}
+
+/** Check invert_mod against mpz_invert and time both, modulo the prime of the f-bit curve.
+ *
+ * 	@return 	1 if there is no f-bit curve, 0 otherwise.
+ */
+int bench_invert(int f, long int nb_inversions)
+{
+	elliptic_curve_t E;
+	point_t P;
+	mpz_t n, r, e, a[__NB_INVERT_VALUES__];
+	gmp_randstate_t r_state;
+	unsigned long long int c1, c2, t1, t2;
+	double invert_cycles, invert_ns, mpz_cycles, mpz_ns;
+	long int i;
+	int nb_wrong = 0;
+
+	mpz_inits(E.A, E.B, E.p, n, r, e, NULL);
+	point_init(&P);
+	if(read_curve("curves", "points", f, &E, n, &P))
+	{
+		mpz_clears(E.A, E.B, E.p, n, r, e, NULL);
+		point_clear(&P);
+		return 1;
+	}
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, f);
+	for(i = 0; i < __NB_INVERT_VALUES__; i++)
+	{
+		mpz_init(a[i]);
+		mpz_urandomm(a[i], r_state, E.p);
+		if(!invert_mod(r, a[i], E.p) != !mpz_invert(e, a[i], E.p) || mpz_cmp(r, e) != 0)
+		{
+			nb_wrong++;
+		}
+	}
+	t1 = now_ns();
+	c1 = __BENCH_CYCLES__();
+	for(i = 0; i < nb_inversions; i++)
+	{
+		invert_mod(r, a[i % __NB_INVERT_VALUES__], E.p);
+	}
+	c2 = __BENCH_CYCLES__();
+	t2 = now_ns();
+	invert_cycles = (double)(c2 - c1) / nb_inversions;
+	invert_ns = (double)(t2 - t1) / nb_inversions;
+	t1 = now_ns();
+	c1 = __BENCH_CYCLES__();
+	for(i = 0; i < nb_inversions; i++)
+	{
+		mpz_invert(r, a[i % __NB_INVERT_VALUES__], E.p);
+	}
+	c2 = __BENCH_CYCLES__();
+	t2 = now_ns();
+	mpz_cycles = (double)(c2 - c1) / nb_inversions;
+	mpz_ns = (double)(t2 - t1) / nb_inversions;
+	printf("%3d   %10.0f %10.1f   %10.0f %10.1f   %7.2f   %s\n", f, invert_cycles, invert_ns, mpz_cycles, mpz_ns, mpz_ns / invert_ns, nb_wrong ? "wrong" : "ok");
+
+	for(i = 0; i < __NB_INVERT_VALUES__; i++)
+	{
+		mpz_clear(a[i]);
+	}
+	mpz_clears(E.A, E.B, E.p, n, r, e, NULL);
+	point_clear(&P);
+	gmp_randclear(r_state);
+	return 0;
+}
+
+/** Check the products, squares and inverses of a kernel of a binary field against the generic kernel, and time them.
+ *
+ * 	@brief The products and squares are timed on chains of nb_ops
+ * 	dependent operations, the inverses on nb_inversions of them.
+ */
+void bench_binary(int f, int kernel, long int nb_ops, long int nb_inversions)
+{
+	elliptic_curve_t E;
+	point_t P;
+	binary_field_t F, G;
+	uint64_t a[__BINARY_MAX_WORDS__], b[__BINARY_MAX_WORDS__], r[__BINARY_MAX_WORDS__], e[__BINARY_MAX_WORDS__];
+	gmp_randstate_t r_state;
+	unsigned long long int c1, c2;
+	double mul_cycles, sqr_cycles, inv_cycles;
+	volatile uint64_t sink;
+	mpz_t n, x;
+	long int i;
+	int nb_wrong = 0;
+
+	mpz_inits(E.A, E.B, E.p, n, x, NULL);
+	point_init(&P);
+	if(read_curve("curves_binary", "points_binary", f, &E, n, &P) || binary_field_init(&F, E.p, kernel) || binary_field_init(&G, E.p, __BINARY_KERNEL_GENERIC__))
+	{
+		mpz_clears(E.A, E.B, E.p, n, x, NULL);
+		point_clear(&P);
+		return;
+	}
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, f);
+	for(i = 0; i < __NB_CHECKS__; i++)
+	{
+		mpz_urandomb(x, r_state, F.m);
+		binary_from_mpz(a, x, &F);
+		mpz_urandomb(x, r_state, F.m);
+		binary_from_mpz(b, x, &F);
+		binary_mul(r, a, b, &F);
+		binary_mul(e, a, b, &G);
+		nb_wrong += (memcmp(r, e, F.nb_words * sizeof(uint64_t)) != 0);
+		binary_sqr(r, a, &F);
+		binary_mul(e, a, a, &G);
+		nb_wrong += (memcmp(r, e, F.nb_words * sizeof(uint64_t)) != 0);
+		if(binary_invert(r, a, &F))
+		{
+			binary_mul(e, r, a, &G);
+			binary_to_mpz(x, e, &G);
+			nb_wrong += (mpz_cmp_ui(x, 1) != 0);
+		}
+	}
+	c1 = __BENCH_CYCLES__();
+	for(i = 0; i < nb_ops; i++)
+	{
+		binary_mul(a, a, b, &F);
+	}
+	c2 = __BENCH_CYCLES__();
+	mul_cycles = (double)(c2 - c1) / nb_ops;
+	c1 = __BENCH_CYCLES__();
+	for(i = 0; i < nb_ops; i++)
+	{
+		binary_sqr(a, a, &F);
+	}
+	c2 = __BENCH_CYCLES__();
+	sqr_cycles = (double)(c2 - c1) / nb_ops;
+	c1 = __BENCH_CYCLES__();
+	for(i = 0; i < nb_inversions; i++)
+	{
+		binary_invert(a, a, &F);
+		a[0] ^= 1;
+	}
+	c2 = __BENCH_CYCLES__();
+	inv_cycles = (double)(c2 - c1) / nb_inversions;
+	sink = a[0];
+	(void)sink;
+	printf("%3d   %-10s %10.1f %10.1f %10.0f   %s\n", f, binary_kernel_name(kernel), mul_cycles, sqr_cycles, inv_cycles, nb_wrong ? "wrong" : "ok");
+
+	mpz_clears(E.A, E.B, E.p, n, x, NULL);
+	point_clear(&P);
+	gmp_randclear(r_state);
+}
+
+/** Time a run of one thread with a step of the walk.
+ *
+ * 	@param[in]	kernel	The kernel of the lanes for __STEP_LANES__.
+ * 	@param[out]	cycles	Cycles per step.
+ * 	@return 	Steps per second.
+ */
+double time_walk(pcs_ctx_t *ctx, int step_type, int kernel, int seconds, double *cycles)
+{
+	bench_timer_t timer;
+	pthread_t thread;
+	unsigned long long int c1, c2, t1, t2, nb_steps;
+	mpz_t x_res;
+	mpz_init(x_res);
+	pcs_set_step(ctx, step_type);
+	lanes_set_kernel(ctx, kernel);
+	timer.stop = 0;
+	timer.seconds = seconds;
+	ctx->stop = &timer.stop;
+	pthread_create(&thread, NULL, bench_timer, &timer);
+	t1 = now_ns();
+	c1 = __BENCH_CYCLES__();
+	//the run goes on until it is stopped, it cannot find that many collisions
+	pcs_run(ctx, x_res, 1 << 30);
+	c2 = __BENCH_CYCLES__();
+	t2 = now_ns();
+	pthread_join(thread, NULL);
+	ctx->stop = NULL;
+	nb_steps = pcs_steps(ctx);
+	mpz_clear(x_res);
+	*cycles = (double)(c2 - c1) / nb_steps;
+	return nb_steps / ((t2 - t1) * 1e-9);
+}
+
+/** Time the steps of the walk on the f-bit curve of a file of curves.
+ *
+ *	@param[in]	field	The field of the curves of the file,
+ *						__CURVE_FIELD_PRIME__ or __CURVE_FIELD_BINARY__.
+ *	@param[in]	group	The group the file describes, see pcs_group.h.
+ *	@brief In the groups other than the points of a curve (see
+ *	pcs_group.h), only the walk with the operation of the group is timed.
+ */
+void bench_walk(const char *curves_path, const char *points_path, int field, const pcs_group_t *group, int f, int seconds)
+{
+	elliptic_curve_t E;
+	point_t P, Q;
+	mpz_t n, key, A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	gmp_randstate_t r_state;
+	pcs_ctx_t *ctx;
+	double rate, cycles;
+	int i, kernel, trailling_bits, nb_bits, type_struct;
+
+	curve_init(&E);
+	mpz_inits(n, key, NULL);
+	point_init(&P);
+	point_init(&Q);
+	if(read_curve(curves_path, points_path, f, &E, n, &P))
+	{
+		fprintf(stderr, "Can not read the %d-bit curve of the files %s and %s.\n", f, curves_path, points_path);
+		exit(1);
+	}
+	E.field = field;
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, f);
+	mpz_urandomm(key, r_state, n);
+	group->exp(&Q, P, key, E);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_init(A[i]);
+		mpz_init(B[i]);
+		mpz_urandomm(A[i], r_state, n);
+		mpz_urandomm(B[i], r_state, n);
+	}
+	trailling_bits = (f / 4 < 20) ? f / 4 : 20;
+	//the points of the large curves do not fit in the PRTL words, they are stored in the hash table
+	nb_bits = mpz_sizeinbase(n, 2);
+	type_struct = (2 * nb_bits - trailling_bits - 7 > __DATA_SIZE_IN_BYTES__ * 8) ? 1 : 0;
+	ctx = pcs_create(P, Q, E, group, n, A, B, nb_bits, trailling_bits, type_struct, 1, 7);
+
+	rate = time_walk(ctx, __STEP_ADD__, __LANES_KERNEL_BEST__, seconds, &cycles);
+	printf("%3d   %-18s %12.0f %12.0f\n", f, (ctx->group == &pcs_group_ec) ? "add" : ctx->group->name, rate, cycles);
+	//the other steps walk on the points of a curve
+	if(ctx->group == &pcs_group_ec)
+	{
+		rate = time_walk(ctx, __STEP_LEAN__, __LANES_KERNEL_BEST__, seconds, &cycles);
+		printf("%3d   %-18s %12.0f %12.0f\n", f, "lean", rate, cycles);
+		for(kernel = 0; kernel < __LANES_NB_KERNELS__; kernel++)
+		{
+			if(!lanes_supported(ctx) || !lanes_kernel_available(kernel))
+			{
+				printf("%3d   lanes %-12s does not run here\n", f, lanes_kernel_name(kernel));
+				continue;
+			}
+			rate = time_walk(ctx, __STEP_LANES__, kernel, seconds, &cycles);
+			printf("%3d   lanes %-12s %12.0f %12.0f\n", f, lanes_kernel_name(kernel), rate, cycles);
+		}
+		if(limbs_supported(ctx))
+		{
+			rate = time_walk(ctx, __STEP_LIMBS__, __LANES_KERNEL_BEST__, seconds, &cycles);
+			printf("%3d   %-18s %12.0f %12.0f\n", f, "limbs", rate, cycles);
+		}
+	}
+
+	pcs_destroy(ctx);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_clears(A[i], B[i], NULL);
+	}
+	curve_clear(&E);
+	mpz_clears(n, key, NULL);
+	point_clear(&P);
+	point_clear(&Q);
+	gmp_randclear(r_state);
+}
+
+int main(int argc,char * argv[])
+{
+	int curves[__MAX_CURVES__] = {35, 65, 95, 115};
+	int nb_curves = 0;
+	int binary_curves[__MAX_CURVES__] = {35, 65, 115};
+	int nb_binary_curves = 0;
+	int fp_groups[__MAX_CURVES__] = {35, 65, 115};
+	int nb_fp_groups = 0;
+	long int nb_ops = __DEFAULT_NB_OPS__;
+	long int nb_inversions = __DEFAULT_NB_INVERSIONS__;
+	int seconds = __DEFAULT_RUN_SECONDS__;
+	int listed[__MAX_CURVES__];
+	int option, i, kernel, nb_listed;
+
+	while ((option = getopt(argc, argv, "f:b:p:m:i:s:h")) != -1) {
+		switch (option) {
+			case 'f' : if(nb_curves < __MAX_CURVES__)
+				{
+					curves[nb_curves++] = atoi(optarg);
+				}
+				break;
+			case 'b' : if(nb_binary_curves < __MAX_CURVES__)
+				{
+					binary_curves[nb_binary_curves++] = atoi(optarg);
+				}
+				break;
+			case 'p' : if(nb_fp_groups < __MAX_CURVES__)
+				{
+					fp_groups[nb_fp_groups++] = atoi(optarg);
+				}
+				break;
+			case 'm' : nb_ops = atol(optarg);
+				break;
+			case 'i' : nb_inversions = atol(optarg);
+				break;
+			case 's' : seconds = atoi(optarg);
+				break;
+			case 'h' : print_usage();
+				exit(0);
+			default: print_usage();
+				exit(1);
+		}
+	}
+	if(nb_curves == 0)
+	{
+		nb_curves = 4;
+	}
+	if(nb_binary_curves == 0)
+	{
+		nb_binary_curves = 3;
+	}
+	if(nb_fp_groups == 0)
+	{
+		nb_fp_groups = 3;
+	}
+	if(nb_ops < 1 || nb_inversions < 1 || seconds < 1)
+	{
+		print_usage();
+		exit(1);
+	}
+
+	printf("Field multiplications, best kernel %s:\n", field_kernel_name(field_best_kernel()));
+	bench_field(nb_ops);
+	printf("\nInversions modulo the prime of each curve:\n");
+	printf("  f   invert_mod cycles     ns   mpz_invert cycles     ns   speedup   checks\n");
+	nb_listed = curves_list("curves", listed, __MAX_CURVES__);
+	for(i = 0; i < nb_listed && i < __MAX_CURVES__; i++)
+	{
+		bench_invert(listed[i], nb_inversions);
+	}
+	printf("\nBinary fields of the curves of the file curves_binary, best kernel %s:\n", binary_kernel_name(__BINARY_KERNEL_BEST__));
+	printf("  m   kernel     mul cycles sqr cycles inv cycles   checks\n");
+	nb_listed = curves_list("curves_binary", listed, __MAX_CURVES__);
+	for(i = 0; i < nb_listed && i < __MAX_CURVES__; i++)
+	{
+		for(kernel = 0; kernel < __BINARY_NB_KERNELS__; kernel++)
+		{
+			if(binary_kernel_available(kernel))
+			{
+				bench_binary(listed[i], kernel, nb_ops / 10, nb_inversions / 10);
+			}
+		}
+	}
+	printf("\nSteps of the walk on one thread, best lanes kernel %s:\n", lanes_kernel_name(__LANES_KERNEL_BEST__));
+	printf("  f   step                    steps/s  cycles/step\n");
+	for(i = 0; i < nb_curves; i++)
+	{
+		bench_walk("curves", "points", __CURVE_FIELD_PRIME__, &pcs_group_ec, curves[i], seconds);
+	}
+	printf("\nSteps of the walk on one thread, on binary curves:\n");
+	printf("  m   step                    steps/s  cycles/step\n");
+	for(i = 0; i < nb_binary_curves; i++)
+	{
+		bench_walk("curves_binary", "points_binary", __CURVE_FIELD_BINARY__, &pcs_group_ec, binary_curves[i], seconds);
+	}
+	printf("\nSteps of the walk on one thread, in F_p^*:\n");
+	printf("  f   group                   steps/s  cycles/step\n");
+	for(i = 0; i < nb_fp_groups; i++)
+	{
+		bench_walk("curves_fp", "points_fp", __CURVE_FIELD_PRIME__, &pcs_group_fp, fp_groups[i], seconds);
+	}
+	preallocation_clear();
+	return 0;
+}
@@ -0,0 +1,547 @@
+/** @file pcs_binary.c
+ *  @brief Curves over the binary fields GF(2^m), with carry-less multiplication.
+ *
+ *	A binary curve is the curve y^2 + xy = x^3 + Ax^2 + B over GF(2^m),
+ *	given in an elliptic_curve_t of field __CURVE_FIELD_BINARY__ whose p is
+ *	the reduction polynomial F of the field rather than a prime: bit i of
+ *	p, of A, of B and of the coordinates of the points is the coefficient
+ *	of t^i. F has degree m and, being irreducible, a constant term, which
+ *	p leaves out: p = F - 1. Nothing else changes: the points are stored,
+ *	hashed and distinguished through the integers their coordinates stand
+ *	for, so that the storage structures, the checkpoints and the network
+ *	work on binary curves as they are. add goes to binary_add for them.
+ *
+ *	The elements are kept on __BINARY_MAX_WORDS__ words. A product is a
+ *	carry-less product of the words, with the PCLMULQDQ instruction or
+ *	with a 4-bit window on 128-bit integers, then reduced by the few terms
+ *	of F, a trinomial or a pentanomial: the words above t^m are folded
+ *	back with shifts and xors, from the top one down. A square only
+ *	spreads the bits of its operand before it is reduced. The inverse is
+ *	a^(2^m - 2), with the m - 1 squarings and about 2 log(m)
+ *	multiplications of Itoh and Tsujii. The best kernel is found once,
+ *	with CPUID, the first time it is asked for; binary_add always uses it,
+ *	the other kernels are there to be checked and timed by pcs_bench.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_binary.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define __BINARY_PCLMUL_BUILD__
+#include <cpuid.h>
+#include <wmmintrin.h>
+#define __BINARY_PCLMUL_TARGET__ __attribute__((target("pclmul,sse2")))
+#endif
+
+#define __BINARY_INLINE__ static inline __attribute__((always_inline))
+
+/** Carry-less product of two words, with a window of 4 bits of b.
+ *
+ */
+static unsigned __int128 clmul64(uint64_t a, uint64_t b)
+{
+	unsigned __int128 tab[16], r = 0;
+	int i;
+	tab[0] = 0;
+	tab[1] = a;
+	for(i = 2; i < 16; i += 2)
+	{
+		tab[i] = tab[i / 2] << 1;
+		tab[i + 1] = tab[i] ^ a;
+	}
+	for(i = 60; i >= 0; i -= 4)
+	{
+		r = (r << 4) ^ tab[(b >> i) & 15];
+	}
+	return r;
+}
+
+static void generic_clmul(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+	unsigned __int128 t;
+	int i, j;
+	memset(r, 0, 2 * n * sizeof(uint64_t));
+	for(i = 0; i < n; i++)
+	{
+		for(j = 0; j < n; j++)
+		{
+			t = clmul64(a[i], b[j]);
+			r[i + j] ^= (uint64_t)t;
+			r[i + j + 1] ^= (uint64_t)(t >> 64);
+		}
+	}
+}
+
+/** Spread the 32 bits of x over the even bits of a word, which squares it.
+ *
+ */
+static uint64_t spread32(uint64_t x)
+{
+	x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+	x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+	x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	x = (x | (x << 2)) & 0x3333333333333333ULL;
+	x = (x | (x << 1)) & 0x5555555555555555ULL;
+	return x;
+}
+
+static void generic_csqr(uint64_t *r, const uint64_t *a, int n)
+{
+	int i;
+	for(i = 0; i < n; i++)
+	{
+		r[2 * i] = spread32(a[i] & 0xFFFFFFFFULL);
+		r[2 * i + 1] = spread32(a[i] >> 32);
+	}
+}
+
+#ifdef __BINARY_PCLMUL_BUILD__
+/** The words of a carry-less product are taken out of the register one
+ *	by one: a load of the high half of a 16-byte store is not forwarded
+ *	from it, and would wait for the store to complete.
+ */
+__BINARY_PCLMUL_TARGET__ static void pclmul_clmul(uint64_t *r, const uint64_t *a, const uint64_t *b, int n)
+{
+	__m128i x, t;
+	int i, j;
+	for(i = 0; i < 2 * n; i++)
+	{
+		r[i] = 0;
+	}
+	for(i = 0; i < n; i++)
+	{
+		x = _mm_cvtsi64_si128(a[i]);
+		for(j = 0; j < n; j++)
+		{
+			t = _mm_clmulepi64_si128(x, _mm_cvtsi64_si128(b[j]), 0x00);
+			r[i + j] ^= _mm_cvtsi128_si64(t);
+			r[i + j + 1] ^= _mm_cvtsi128_si64(_mm_unpackhi_epi64(t, t));
+		}
+	}
+}
+
+__BINARY_PCLMUL_TARGET__ static void pclmul_csqr(uint64_t *r, const uint64_t *a, int n)
+{
+	__m128i x, t;
+	int i;
+	for(i = 0; i < n; i++)
+	{
+		x = _mm_cvtsi64_si128(a[i]);
+		t = _mm_clmulepi64_si128(x, x, 0x00);
+		r[2 * i] = _mm_cvtsi128_si64(t);
+		r[2 * i + 1] = _mm_cvtsi128_si64(_mm_unpackhi_epi64(t, t));
+	}
+}
+#endif
+
+static const char *binary_kernel_names[__BINARY_NB_KERNELS__] = {"pclmul", "generic"};
+static int binary_pclmul_present = 0;
+static pthread_once_t binary_dispatch_once = PTHREAD_ONCE_INIT;
+
+/** Look for PCLMULQDQ in CPUID leaf 1.
+ *
+ */
+static void binary_dispatch(void)
+{
+#ifdef __BINARY_PCLMUL_BUILD__
+	unsigned int eax, ebx, ecx, edx;
+	if(__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+	{
+		binary_pclmul_present = (ecx >> 1) & 1;
+	}
+#endif
+}
+
+/** Check whether a kernel of the binary fields runs on this processor.
+ *
+ */
+int binary_kernel_available(int kernel)
+{
+	pthread_once(&binary_dispatch_once, binary_dispatch);
+	switch(kernel)
+	{
+		case __BINARY_KERNEL_PCLMUL__: return binary_pclmul_present;
+		case __BINARY_KERNEL_GENERIC__: return 1;
+		default: return 0;
+	}
+}
+
+/** Get the fastest kernel of the binary fields that runs on this processor.
+ *
+ */
+int binary_best_kernel(void)
+{
+	return binary_kernel_available(__BINARY_KERNEL_PCLMUL__) ? __BINARY_KERNEL_PCLMUL__ : __BINARY_KERNEL_GENERIC__;
+}
+
+const char *binary_kernel_name(int kernel)
+{
+	if(kernel == __BINARY_KERNEL_BEST__)
+	{
+		kernel = binary_best_kernel();
+	}
+	return binary_kernel_names[kernel];
+}
+
+/** Set up the field of a reduction polynomial.
+ *
+ *	@param[in]	poly	F - 1, F of degree at most __BINARY_MAX_BITS__ and
+ *						with at most __BINARY_MAX_TERMS__ terms besides t^m.
+ *						Whether F is irreducible is not checked.
+ *	@param[in]	kernel	__BINARY_KERNEL_BEST__, or a kernel that
+ *						binary_kernel_available says runs on this processor.
+ *	@return 	0 if the field was set up, 1 if it is not supported.
+ */
+int binary_field_init(binary_field_t *F, mpz_t poly, int kernel)
+{
+	mp_bitcnt_t i;
+	if(GMP_NUMB_BITS != 64 || mpz_sgn(poly) <= 0 || mpz_odd_p(poly))
+	{
+		return 1;
+	}
+	memset(F, 0, sizeof(binary_field_t));
+	F->m = mpz_sizeinbase(poly, 2) - 1;
+	if(F->m < 2 || F->m > __BINARY_MAX_BITS__)
+	{
+		return 1;
+	}
+	F->nb_words = (F->m + 63) / 64;
+	F->terms[F->nb_terms++] = 0;
+	for(i = mpz_scan1(poly, 1); i < (mp_bitcnt_t)F->m; i = mpz_scan1(poly, i + 1))
+	{
+		if(F->nb_terms == __BINARY_MAX_TERMS__)
+		{
+			return 1;
+		}
+		F->terms[F->nb_terms++] = i;
+	}
+	//degree bound of a product, lowered by m - terms[nb_terms - 1] per fold
+	for(i = 2 * F->m - 2; i >= (mp_bitcnt_t)F->m; i -= F->m - F->terms[F->nb_terms - 1])
+	{
+		F->nb_folds++;
+	}
+	if(kernel == __BINARY_KERNEL_BEST__)
+	{
+		kernel = binary_best_kernel();
+	}
+	if(!binary_kernel_available(kernel))
+	{
+		return 1;
+	}
+	F->kernel = kernel;
+	F->clmul = generic_clmul;
+	F->csqr = generic_csqr;
+#ifdef __BINARY_PCLMUL_BUILD__
+	if(kernel == __BINARY_KERNEL_PCLMUL__)
+	{
+		F->clmul = pclmul_clmul;
+		F->csqr = pclmul_csqr;
+	}
+#endif
+	return 0;
+}
+
+void binary_from_mpz(uint64_t *r, mpz_t z, const binary_field_t *F)
+{
+	int i;
+	for(i = 0; i < F->nb_words; i++)
+	{
+		r[i] = mpz_getlimbn(z, i);
+	}
+}
+
+void binary_to_mpz(mpz_t z, const uint64_t *a, const binary_field_t *F)
+{
+	mpz_import(z, F->nb_words, -1, sizeof(uint64_t), 0, 0, a);
+}
+
+/** Add h t^k to u, for h of n words and u of 2n words.
+ *
+ *	@brief h is read from hp[n..2n-1], between two runs of n zero words,
+ *	so that each word of u takes the same operations whatever k is.
+ */
+__BINARY_INLINE__ void binary_fold(uint64_t *u, const uint64_t *hp, int k, int n)
+{
+	const int kw = k / 64, ks = k % 64;
+	int i;
+	for(i = 0; i < 2 * n; i++)
+	{
+		//hp[n + i - kw - 1] >> (64 - ks), in two shifts for ks = 0
+		u[i] ^= (hp[n + i - kw] << ks) | ((hp[n + i - kw - 1] >> 1) >> (63 - ks));
+	}
+}
+
+/** r = t mod F, for t of 2n words below t^(2m - 1), which is destroyed.
+ *
+ *	@brief The part h of t at t^m and above is taken out of it, as n
+ *	words, and added back shifted by each term of F, nb_folds times: the
+ *	first fold leaves less than t^(2m - 1 - (m - terms[nb_terms - 1])),
+ *	and for the usual trinomials and pentanomials, whose terms are below
+ *	m/2, the second one leaves less than t^m. The words of t are indexed
+ *	by constants, and stay in registers.
+ */
+__BINARY_INLINE__ void binary_reduce_n(uint64_t *r, uint64_t *t, const binary_field_t *F, int n)
+{
+	const int s = F->m % 64;
+	uint64_t hp[3 * __BINARY_MAX_WORDS__];
+	int i, j, k;
+	for(i = 0; i < F->nb_folds; i++)
+	{
+		for(j = 0; j < 3 * n; j++)
+		{
+			if(j < n || j >= 2 * n)
+			{
+				hp[j] = 0;
+			}
+			else if(s == 0)
+			{
+				//t^m is the first bit of word n
+				hp[j] = t[j];
+			}
+			else
+			{
+				//t^m is in word n - 1
+				hp[j] = (t[j - 1] >> s) | ((t[j] << 1) << (63 - s));
+			}
+		}
+		if(s != 0)
+		{
+			t[n - 1] &= (1ULL << s) - 1;
+		}
+		for(j = n; j < 2 * n; j++)
+		{
+			t[j] = 0;
+		}
+		for(k = 0; k < F->nb_terms; k++)
+		{
+			binary_fold(t, hp, F->terms[k], n);
+		}
+	}
+	for(j = 0; j < n; j++)
+	{
+		r[j] = t[j];
+	}
+}
+
+static void binary_reduce(uint64_t *r, uint64_t *t, const binary_field_t *F)
+{
+	switch(F->nb_words)
+	{
+		case 1: binary_reduce_n(r, t, F, 1); break;
+		case 2: binary_reduce_n(r, t, F, 2); break;
+		case 3: binary_reduce_n(r, t, F, 3); break;
+		default: binary_reduce_n(r, t, F, 4); break;
+	}
+}
+
+void binary_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, const binary_field_t *F)
+{
+	uint64_t t[2 * __BINARY_MAX_WORDS__];
+	F->clmul(t, a, b, F->nb_words);
+	binary_reduce(r, t, F);
+}
+
+void binary_sqr(uint64_t *r, const uint64_t *a, const binary_field_t *F)
+{
+	uint64_t t[2 * __BINARY_MAX_WORDS__];
+	F->csqr(t, a, F->nb_words);
+	binary_reduce(r, t, F);
+}
+
+static int binary_is_zero(const uint64_t *a, const binary_field_t *F)
+{
+	int i;
+	for(i = 0; i < F->nb_words; i++)
+	{
+		if(a[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static int binary_equal(const uint64_t *a, const uint64_t *b, const binary_field_t *F)
+{
+	int i;
+	for(i = 0; i < F->nb_words; i++)
+	{
+		if(a[i] != b[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void binary_xor(uint64_t *r, const uint64_t *a, const uint64_t *b, const binary_field_t *F)
+{
+	int i;
+	for(i = 0; i < F->nb_words; i++)
+	{
+		r[i] = a[i] ^ b[i];
+	}
+}
+
+/** Invert an element, by Itoh and Tsujii.
+ *
+ *	@brief With b_k = a^(2^k - 1), b_(j + k) = b_j^(2^k) b_k and
+ *	b_(k + 1) = b_k^2 a: b_(m - 1) is built by following the bits of
+ *	m - 1 from the top, and 1/a = a^(2^m - 2) = b_(m - 1)^2.
+ *
+ *	@return 	0 if a is 0, 1 otherwise.
+ */
+int binary_invert(uint64_t *r, const uint64_t *a, const binary_field_t *F)
+{
+	uint64_t b[__BINARY_MAX_WORDS__], t[__BINARY_MAX_WORDS__];
+	int e = F->m - 1, bit, k = 1, i;
+	if(binary_is_zero(a, F))
+	{
+		return 0;
+	}
+	memcpy(b, a, F->nb_words * sizeof(uint64_t));
+	for(bit = 30 - __builtin_clz(e); bit >= 0; bit--)
+	{
+		memcpy(t, b, F->nb_words * sizeof(uint64_t));
+		for(i = 0; i < k; i++)
+		{
+			binary_sqr(t, t, F);
+		}
+		binary_mul(b, t, b, F);
+		k *= 2;
+		if((e >> bit) & 1)
+		{
+			binary_sqr(b, b, F);
+			binary_mul(b, b, a, F);
+			k++;
+		}
+	}
+	binary_sqr(r, b, F);
+	return 1;
+}
+
+/** Get the field of a binary curve, set up once per thread and curve.
+ *
+ *	@return 	The field, or NULL if it is not supported.
+ */
+static const binary_field_t *binary_curve_field(elliptic_curve_t E)
+{
+	static __thread binary_field_t F;
+	static __thread uint64_t poly[__BINARY_MAX_WORDS__ + 1];
+	static __thread int state = 0;
+	uint64_t p[__BINARY_MAX_WORDS__ + 1];
+	int i;
+	if(mpz_sizeinbase(E.p, 2) > __BINARY_MAX_BITS__ + 1)
+	{
+		return NULL;
+	}
+	for(i = 0; i <= __BINARY_MAX_WORDS__; i++)
+	{
+		p[i] = mpz_getlimbn(E.p, i);
+	}
+	if(state == 0 || memcmp(p, poly, sizeof(p)) != 0)
+	{
+		memcpy(poly, p, sizeof(p));
+		state = binary_field_init(&F, E.p, __BINARY_KERNEL_BEST__) ? -1 : 1;
+	}
+	return (state == 1) ? &F : NULL;
+}
+
+/** Add two points of a binary curve, neither of which is the identity element.
+ *
+ *	@brief P1 + P2 has the slope l = (y1 + y2)/(x1 + x2), and 2P1 the slope
+ *	l = x1 + y1/x1. -P1 is (x1, x1 + y1), so that x1 = x2 gives either
+ *	P2 = -P1, or P2 = P1 and a doubling, which gives the identity element
+ *	for x1 = 0.
+ *
+ *	@return		0 if the addition was performed, 1 if the field of the curve
+ *				is not supported.
+ */
+int binary_add(point_t *P3, point_t P1, point_t P2, elliptic_curve_t E)
+{
+	const binary_field_t *F = binary_curve_field(E);
+	uint64_t x1[__BINARY_MAX_WORDS__], y1[__BINARY_MAX_WORDS__], x2[__BINARY_MAX_WORDS__], y2[__BINARY_MAX_WORDS__];
+	uint64_t a[__BINARY_MAX_WORDS__], l[__BINARY_MAX_WORDS__], t[__BINARY_MAX_WORDS__], x3[__BINARY_MAX_WORDS__];
+	if(F == NULL)
+	{
+		return 1;
+	}
+	binary_from_mpz(x1, P1.x, F);
+	binary_from_mpz(y1, P1.y, F);
+	binary_from_mpz(x2, P2.x, F);
+	binary_from_mpz(y2, P2.y, F);
+	binary_from_mpz(a, E.A, F);
+	binary_xor(t, x1, y1, F);
+	if(binary_equal(x1, x2, F) && (binary_equal(y2, t, F) || binary_is_zero(x1, F)))
+	{
+		mpz_set_ui(P3->x, 0);
+		mpz_set_ui(P3->y, 1);
+		mpz_set_ui(P3->z, 0);
+		return 0;
+	}
+	if(binary_equal(x1, x2, F))
+	{
+		//x3 = l^2 + l + a, y3 = x1^2 + l x3 + x3
+		binary_invert(t, x1, F);
+		binary_mul(l, y1, t, F);
+		binary_xor(l, l, x1, F);
+		binary_sqr(x3, l, F);
+		binary_xor(x3, x3, l, F);
+		binary_xor(x3, x3, a, F);
+		binary_sqr(y2, x1, F);
+		binary_mul(t, l, x3, F);
+		binary_xor(y2, y2, t, F);
+		binary_xor(y2, y2, x3, F);
+	}
+	else
+	{
+		//x3 = l^2 + l + x1 + x2 + a, y3 = l(x1 + x3) + x3 + y1
+		binary_xor(t, x1, x2, F);
+		binary_invert(t, t, F);
+		binary_xor(l, y1, y2, F);
+		binary_mul(l, l, t, F);
+		binary_sqr(x3, l, F);
+		binary_xor(x3, x3, l, F);
+		binary_xor(x3, x3, x1, F);
+		binary_xor(x3, x3, x2, F);
+		binary_xor(x3, x3, a, F);
+		binary_xor(t, x1, x3, F);
+		binary_mul(t, t, l, F);
+		binary_xor(t, t, x3, F);
+		binary_xor(y2, t, y1, F);
+	}
+	binary_to_mpz(P3->x, x3, F);
+	binary_to_mpz(P3->y, y2, F);
+	mpz_set_ui(P3->z, 1);
+	return 0;
+}
+
+/** Check whether a point is on a binary curve, y^2 + xy = x^3 + Ax^2 + B.
+ *
+ *	@return		1 for yes and 0 for no.
+ */
+int binary_on_curve(point_t P, elliptic_curve_t E)
+{
+	const binary_field_t *F = binary_curve_field(E);
+	uint64_t x[__BINARY_MAX_WORDS__], y[__BINARY_MAX_WORDS__], c[__BINARY_MAX_WORDS__], l[__BINARY_MAX_WORDS__], r[__BINARY_MAX_WORDS__];
+	if(F == NULL || mpz_sgn(P.x) < 0 || mpz_sgn(P.y) < 0 || mpz_sizeinbase(P.x, 2) > (size_t)F->m || mpz_sizeinbase(P.y, 2) > (size_t)F->m)
+	{
+		return 0;
+	}
+	binary_from_mpz(x, P.x, F);
+	binary_from_mpz(y, P.y, F);
+	//y(y + x) and x^2(x + A) + B
+	binary_xor(l, y, x, F);
+	binary_mul(l, l, y, F);
+	binary_from_mpz(c, E.A, F);
+	binary_xor(c, c, x, F);
+	binary_sqr(r, x, F);
+	binary_mul(r, r, c, F);
+	binary_from_mpz(c, E.B, F);
+	binary_xor(r, r, c, F);
+	return binary_equal(l, r, F);
+}
@@ -0,0 +1,52 @@
+/** @file pcs_binary.h
+ *
+ */
+#ifndef PCS_BINARY_H
+#define PCS_BINARY_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs_elliptic_curve_operations.h"
+
+#define __BINARY_MAX_BITS__ 255
+#define __BINARY_MAX_WORDS__ 4
+#define __BINARY_MAX_TERMS__ 8 /* terms of the reduction polynomial besides t^m */
+#define __BINARY_KERNEL_BEST__ -1
+#define __BINARY_KERNEL_PCLMUL__ 0
+#define __BINARY_KERNEL_GENERIC__ 1
+#define __BINARY_NB_KERNELS__ 2
+
+typedef void (*binary_clmul_t)(uint64_t *r, const uint64_t *a, const uint64_t *b, int n);
+typedef void (*binary_csqr_t)(uint64_t *r, const uint64_t *a, int n);
+
+/** The field GF(2^m) = GF(2)[t]/(F), F = t^m + t^terms[nb_terms - 1] + ... + t^terms[0], terms[0] = 0.
+ *
+ *	@brief The elements are nb_words words, least significant first, bit i
+ *	being the coefficient of t^i, below t^m. clmul and csqr are the
+ *	carry-less product and square of the kernel, on 2 nb_words words.
+ *	nb_folds is the number of folds by F that bring a product below t^m.
+ */
+typedef struct
+{
+	int m;
+	int nb_words;
+	int nb_terms;
+	int terms[__BINARY_MAX_TERMS__];
+	int nb_folds;
+	int kernel;
+	binary_clmul_t clmul;
+	binary_csqr_t csqr;
+}binary_field_t;
+
+int binary_best_kernel(void);
+int binary_kernel_available(int kernel);
+const char *binary_kernel_name(int kernel);
+int binary_field_init(binary_field_t *F, mpz_t poly, int kernel);
+void binary_from_mpz(uint64_t *r, mpz_t z, const binary_field_t *F);
+void binary_to_mpz(mpz_t z, const uint64_t *a, const binary_field_t *F);
+void binary_mul(uint64_t *r, const uint64_t *a, const uint64_t *b, const binary_field_t *F);
+void binary_sqr(uint64_t *r, const uint64_t *a, const binary_field_t *F);
+int binary_invert(uint64_t *r, const uint64_t *a, const binary_field_t *F);
+int binary_add(point_t *P3, point_t P1, point_t P2, elliptic_curve_t E);
+int binary_on_curve(point_t P, elliptic_curve_t E);
+#endif
@@ -0,0 +1,369 @@
+/** @file pcs_checkpoint.c
+ *  @brief Checkpoints of a running PCS solve, and resuming a solve from one.
+ *
+ *	A checkpoint is a binary file holding, in this order:
+ *	- the magic string __CHECKPOINT_MAGIC__;
+ *	- nb_bits, trailling_bits, level, the storage type, the size of the
+ *	  orbits the walk works on and the field of the curve (one byte each)
+ *	  and the number of walkers (uint32_t);
+ *	- the curve A, B, p, the order n, the points P and Q and the adding
+ *	  sets A[] and B[], in the portable format of mpz_out_raw;
+ *	- for each walker, R (x, y, z) and a with mpz_out_raw, the trail
+ *	  length (uint32_t) and the seed of its random state (uint64_t);
+ *	- the sizes in bytes of a stored x coordinate and a coefficient (one
+ *	  byte each) and the number of stored points (uint64_t);
+ *	- the stored points, as fixed-size little-endian x coordinates
+ *	  (without the trailling zeros) followed by their a coefficient.
+ *	The integers of fixed size are written in the byte order of the host.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs_checkpoint.h"
+#include "pcs_orbit.h"
+
+/** State of the points writer given to struct_foreach.
+ */
+typedef struct
+{
+	FILE *file;
+	unsigned char *buffer;
+	size_t x_bytes;
+	size_t a_bytes;
+	uint64_t nb_points;
+	int error;
+}checkpoint_writer_t;
+
+/** Sizes in bytes of a stored x coordinate and a coefficient.
+ *
+ */
+static void checkpoint_sizes(pcs_ctx_t *ctx, size_t *x_bytes, size_t *a_bytes)
+{
+	size_t a_bits = mpz_sizeinbase(ctx->n, 2);
+	if(a_bits < ctx->nb_bits)
+	{
+		a_bits = ctx->nb_bits;
+	}
+	*x_bytes = (mpz_sizeinbase(ctx->E.p, 2) - ctx->trailling_bits + 7) / 8;
+	*a_bytes = (a_bits + 7) / 8;
+}
+
+/** Write a number on a fixed number of bytes.
+ *
+ *  @return 	0 if the number fits, 1 otherwise.
+ */
+static int write_fixed(unsigned char *buffer, size_t nb_bytes, mpz_t value)
+{
+	size_t count;
+	if(mpz_sgn(value) < 0 || mpz_sizeinbase(value, 256) > nb_bytes)
+	{
+		return 1;
+	}
+	memset(buffer, 0, nb_bytes);
+	mpz_export(buffer, &count, -1, 1, 0, 0, value);
+	return 0;
+}
+
+/** Write one stored point, called by struct_foreach.
+ *
+ */
+static void write_point(mpz_t xDist, mpz_t a, void *arg)
+{
+	checkpoint_writer_t *writer = arg;
+	if(write_fixed(writer->buffer, writer->x_bytes, xDist) || write_fixed(writer->buffer + writer->x_bytes, writer->a_bytes, a))
+	{
+		writer->error = 1;
+		return;
+	}
+	if(fwrite(writer->buffer, writer->x_bytes + writer->a_bytes, 1, writer->file) != 1)
+	{
+		writer->error = 1;
+	}
+	writer->nb_points++;
+}
+
+/** Enable periodic checkpoints of the runs of a context.
+ *
+ *	@param[in]	path		The checkpoint file, replaced at each checkpoint.
+ *	@param[in]	interval	The time between two checkpoints, in seconds.
+ */
+void pcs_set_checkpoint(pcs_ctx_t *ctx, const char *path, int interval)
+{
+	free(ctx->checkpoint_path);
+	ctx->checkpoint_path = (path != NULL) ? strdup(path) : NULL;
+	ctx->checkpoint_interval = interval;
+}
+
+/** Write a checkpoint every ctx->checkpoint_interval seconds, until the run ends.
+ *
+ *	@brief Run by one more thread of the team of pcs_run. The walkers are
+ *	asked to copy their state the next time they step, which does not stop
+ *	them. Once every walker has done it, the points are written while the
+ *	walkers go on. Since points are never removed during a run, the file
+ *	holds at least all the points found before the copies of the walkers.
+ *
+ *	@param[in]	collision_count	The number of collisions found so far.
+ *	@param[in]	nb_collisions	The number of collisions to find.
+ */
+void pcs_checkpoint_loop(pcs_ctx_t *ctx, int *collision_count, int nb_collisions)
+{
+	time_t last = time(NULL);
+	unsigned long int nb_points;
+	int done = 0;
+	while(!done)
+	{
+		usleep(__CHECKPOINT_POLL_US__);
+		#pragma omp flush
+		done = run_done(ctx, collision_count, nb_collisions);
+		if(done || time(NULL) - last < ctx->checkpoint_interval)
+		{
+			continue;
+		}
+		ctx->checkpoint_captured = 0;
+		#pragma omp flush
+		ctx->checkpoint_request++;
+		while(!done && ctx->checkpoint_captured < ctx->nb_threads)
+		{
+			usleep(__CHECKPOINT_POLL_US__);
+			#pragma omp flush
+			done = run_done(ctx, collision_count, nb_collisions);
+		}
+		if(!done && pcs_checkpoint_write(ctx, ctx->checkpoint_path, &nb_points) == 0)
+		{
+			printf("\t\tCheckpoint: %lu points written to %s\n", nb_points, ctx->checkpoint_path);
+		}
+		last = time(NULL);
+	}
+}
+
+/** Write a checkpoint of a context.
+ *
+ *	@brief The walkers are written as copied for this checkpoint. The
+ *	file is written next to its path and renamed at the end, so that a
+ *	crash while writing keeps the previous checkpoint.
+ *
+ *	@param[out]	nb_points	The number of points written.
+ *  @return 	0 if the checkpoint was written, 1 otherwise.
+ */
+int pcs_checkpoint_write(pcs_ctx_t *ctx, const char *path, unsigned long int *nb_points)
+{
+	FILE *file;
+	char *path_tmp;
+	checkpoint_writer_t writer;
+	uint8_t header[6];
+	uint32_t nb_walkers, trail_length;
+	uint64_t seed;
+	long int nb_points_pos;
+	int i;
+
+	path_tmp = malloc(strlen(path) + 5);
+	sprintf(path_tmp, "%s.tmp", path);
+	file = fopen(path_tmp, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Can not open checkpoint file %s.\n", path_tmp);
+		free(path_tmp);
+		return 1;
+	}
+
+	fwrite(__CHECKPOINT_MAGIC__, 8, 1, file);
+	header[0] = ctx->nb_bits;
+	header[1] = ctx->trailling_bits;
+	header[2] = ctx->level;
+	header[3] = ctx->storage.type;
+	header[4] = ctx->orbit;
+	header[5] = ctx->E.field;
+	nb_walkers = ctx->nb_threads;
+	fwrite(header, 6, 1, file);
+	fwrite(&nb_walkers, sizeof(nb_walkers), 1, file);
+	mpz_out_raw(file, ctx->E.A);
+	mpz_out_raw(file, ctx->E.B);
+	mpz_out_raw(file, ctx->E.p);
+	mpz_out_raw(file, ctx->n);
+	mpz_out_raw(file, ctx->P.x);
+	mpz_out_raw(file, ctx->P.y);
+	mpz_out_raw(file, ctx->Q.x);
+	mpz_out_raw(file, ctx->Q.y);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_out_raw(file, ctx->A[i]);
+		mpz_out_raw(file, ctx->B[i]);
+	}
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		mpz_out_raw(file, ctx->walkers[i].saved_R.x);
+		mpz_out_raw(file, ctx->walkers[i].saved_R.y);
+		mpz_out_raw(file, ctx->walkers[i].saved_R.z);
+		mpz_out_raw(file, ctx->walkers[i].saved_a);
+		trail_length = ctx->walkers[i].saved_trail_length;
+		seed = ctx->walkers[i].saved_seed;
+		fwrite(&trail_length, sizeof(trail_length), 1, file);
+		fwrite(&seed, sizeof(seed), 1, file);
+	}
+
+	checkpoint_sizes(ctx, &writer.x_bytes, &writer.a_bytes);
+	header[0] = writer.x_bytes;
+	header[1] = writer.a_bytes;
+	fwrite(header, 2, 1, file);
+	nb_points_pos = ftell(file);
+	writer.nb_points = 0;
+	fwrite(&writer.nb_points, sizeof(writer.nb_points), 1, file);
+
+	writer.file = file;
+	writer.buffer = malloc(writer.x_bytes + writer.a_bytes);
+	writer.error = 0;
+	struct_foreach(&ctx->storage, write_point, &writer);
+	free(writer.buffer);
+
+	fseek(file, nb_points_pos, SEEK_SET);
+	fwrite(&writer.nb_points, sizeof(writer.nb_points), 1, file);
+	if(fflush(file) != 0 || fsync(fileno(file)) != 0 || ferror(file))
+	{
+		writer.error = 1;
+	}
+	fclose(file);
+	if(writer.error || rename(path_tmp, path) != 0)
+	{
+		fprintf(stderr, "Can not write checkpoint file %s.\n", path);
+		unlink(path_tmp);
+		free(path_tmp);
+		return 1;
+	}
+	free(path_tmp);
+	*nb_points = writer.nb_points;
+	return 0;
+}
+
+/** Create a context from a checkpoint.
+ *
+ *	@brief The stored points are added again to a new storage structure
+ *	and the walkers will go on from their saved points on the next run.
+ *	If there are more threads than saved walkers, the other walkers start
+ *	from random points. If there are less, the trails of the last saved
+ *	walkers are dropped.
+ *
+ *	@param[in]	nb_threads	Number of threads of the new context.
+ *	@param[out]	nb_points	The number of points read.
+ *	@return		The new context, or NULL if the checkpoint can not be read.
+ */
+pcs_ctx_t *pcs_checkpoint_load(const char *path, int nb_threads, unsigned long int *nb_points)
+{
+	FILE *file;
+	char magic[8];
+	uint8_t header[6];
+	uint32_t nb_walkers, trail_length;
+	uint64_t seed, nb_points_file, k;
+	size_t x_bytes, a_bytes, x_bytes_file, a_bytes_file;
+	unsigned char *buffer;
+	char xDist_str[100];
+	elliptic_curve_t E;
+	point_t P, Q, R;
+	mpz_t n, a, a_out, xDist;
+	mpz_t A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	pcs_ctx_t *ctx = NULL;
+	pcs_walker_t *w;
+	int i, ok;
+
+	file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Can not open checkpoint file %s.\n", path);
+		return NULL;
+	}
+	curve_init(&E);
+	point_init(&P);
+	point_init(&Q);
+	point_init(&R);
+	mpz_inits(n, a, a_out, xDist, NULL);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_inits(A[i], B[i], NULL);
+	}
+
+	ok = (fread(magic, 8, 1, file) == 1 && memcmp(magic, __CHECKPOINT_MAGIC__, 8) == 0);
+	ok = ok && fread(header, 6, 1, file) == 1 && fread(&nb_walkers, sizeof(nb_walkers), 1, file) == 1;
+	ok = ok && mpz_inp_raw(E.A, file) && mpz_inp_raw(E.B, file) && mpz_inp_raw(E.p, file) && mpz_inp_raw(n, file);
+	ok = ok && mpz_inp_raw(P.x, file) && mpz_inp_raw(P.y, file) && mpz_inp_raw(Q.x, file) && mpz_inp_raw(Q.y, file);
+	for(i = 0; ok && i < __NB_ENSEMBLES__; i++)
+	{
+		ok = mpz_inp_raw(A[i], file) && mpz_inp_raw(B[i], file);
+	}
+	if(ok)
+	{
+		mpz_set_ui(P.z, 1);
+		mpz_set_ui(Q.z, 1);
+		E.field = header[5];
+		ctx = pcs_create(P, Q, E, &pcs_group_ec, n, A, B, header[0], header[1], header[3], nb_threads, header[2]);
+		if(header[4] > 1)
+		{
+			ok = (orbit_enable(ctx) == header[4]);
+		}
+	}
+	for(i = 0; ok && i < (int)nb_walkers; i++)
+	{
+		ok = mpz_inp_raw(R.x, file) && mpz_inp_raw(R.y, file) && mpz_inp_raw(R.z, file) && mpz_inp_raw(a, file);
+		ok = ok && fread(&trail_length, sizeof(trail_length), 1, file) == 1 && fread(&seed, sizeof(seed), 1, file) == 1;
+		if(ok && i < nb_threads)
+		{
+			w = &ctx->walkers[i];
+			mpz_set(w->R.x, R.x);
+			mpz_set(w->R.y, R.y);
+			mpz_set(w->R.z, R.z);
+			mpz_set(w->a, a);
+			w->trail_length = trail_length;
+			gmp_randseed_ui(w->r_state, seed);
+			w->resume = 1;
+		}
+	}
+
+	ok = ok && fread(header, 2, 1, file) == 1 && fread(&nb_points_file, sizeof(nb_points_file), 1, file) == 1;
+	if(ok)
+	{
+		checkpoint_sizes(ctx, &x_bytes, &a_bytes);
+		x_bytes_file = header[0];
+		a_bytes_file = header[1];
+		ok = (x_bytes_file == x_bytes && a_bytes_file == a_bytes);
+	}
+	if(ok)
+	{
+		buffer = malloc(x_bytes + a_bytes);
+		for(k = 0; ok && k < nb_points_file; k++)
+		{
+			ok = (fread(buffer, x_bytes + a_bytes, 1, file) == 1);
+			if(ok)
+			{
+				mpz_import(xDist, x_bytes, -1, 1, 0, 0, buffer);
+				mpz_import(a, a_bytes, -1, 1, 0, 0, buffer + x_bytes);
+				struct_add(&ctx->storage, a_out, a, xDist, xDist_str);
+			}
+		}
+		free(buffer);
+		*nb_points = nb_points_file;
+	}
+	fclose(file);
+
+	if(!ok)
+	{
+		fprintf(stderr, "Can not read checkpoint file %s.\n", path);
+		if(ctx != NULL)
+		{
+			pcs_destroy(ctx);
+			ctx = NULL;
+		}
+	}
+	curve_clear(&E);
+	point_clear(&P);
+	point_clear(&Q);
+	point_clear(&R);
+	mpz_clears(n, a, a_out, xDist, NULL);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_clears(A[i], B[i], NULL);
+	}
+	return ctx;
+}
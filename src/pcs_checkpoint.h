@@ -0,0 +1,16 @@
+/** @file pcs_checkpoint.h
+ *
+ */
+#ifndef PCS_CHECKPOINT_H
+#define PCS_CHECKPOINT_H
+
+#include "pcs.h"
+
+#define __CHECKPOINT_MAGIC__ "PCSCKPT3"
+#define __CHECKPOINT_POLL_US__ 1000
+
+void pcs_set_checkpoint(pcs_ctx_t *ctx, const char *path, int interval);
+void pcs_checkpoint_loop(pcs_ctx_t *ctx, int *collision_count, int nb_collisions);
+int pcs_checkpoint_write(pcs_ctx_t *ctx, const char *path, unsigned long int *nb_points);
+pcs_ctx_t *pcs_checkpoint_load(const char *path, int nb_threads, unsigned long int *nb_points);
+#endif
@@ -0,0 +1,524 @@
+/** @file pcs_collide.c
+ *  @brief Parallel collision search for any function of n-bit words.
+ *
+ *	The distinguished point method of pcs_run, for a function f given
+ *	by the user instead of the adding walk on a curve (van Oorschot and
+ *	Wiener, "Parallel collision search with cryptanalytic applications",
+ *	J. Cryptology 1999). Each thread draws a start x0, iterates x = f(x)
+ *	until x has trailling_bits trailling zero bits, and adds x to the
+ *	storage structure with a = x0. A match gives two trails reaching the
+ *	same distinguished point, which are walked again from their starts to
+ *	find the two inputs of f, x1 != x2, with f(x1) = f(x2), and useful
+ *	tells whether the search goes on.
+ *
+ *	A collision of an n-bit random function is expected after about
+ *	sqrt(pi*2^n/2) steps in total, plus 2^trailling_bits steps per thread
+ *	to reach the next distinguished point.
+ *
+ *	A meet in the middle is after one golden collision among the about
+ *	2^n/2 collisions of f, which the storage structure can not hold, and
+ *	one function only leads to some of them, always the same. The golden
+ *	collision search keeps w points in a table of w slots, overwritten
+ *	in place, and walks versions of the function, f(x) xor a salt, which
+ *	have the same collisions but other trails, changing the version after
+ *	10w distinguished points. The distinguished points of a version are
+ *	those whose trailling bits are its mark: an input of the golden
+ *	collision which is distinguished ends the trails instead of being
+ *	walked from, and is so in some versions only. With a fraction 2.25 sqrt(w/2^n) of the
+ *	points distinguished, the golden collision is expected after
+ *	2.5 sqrt(2^3n/w) steps (van Oorschot and Wiener, section 4.2).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include <gmp.h>
+#include <string.h>
+#include <omp.h>
+#include "pcs_storage.h"
+#include "pcs_collide.h"
+
+/** Final mixing function of splitmix64.
+ *
+ */
+static inline uint64_t mix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/** Get the image of x by the version of the function of salt salt, reduced to the words of the function.
+ *
+ */
+static inline uint64_t collide_f(collide_ctx_t *ctx, uint64_t x, uint64_t salt)
+{
+	return (ctx->fn.f(x, ctx->fn.arg) ^ salt) & ctx->mask;
+}
+
+/** Get the salt of a version of the function.
+ *
+ *	@return		0 out of a golden collision search, where f is walked as it is.
+ */
+uint64_t collide_salt(collide_ctx_t *ctx, uint64_t version)
+{
+	return (ctx->max_points == 0) ? 0 : mix64(ctx->seed + version) & ctx->mask;
+}
+
+/** Get the trailling bits of the distinguished points of a version of the function.
+ *
+ *	@return		0 out of a golden collision search.
+ */
+static uint64_t collide_mark(collide_ctx_t *ctx, uint64_t version)
+{
+	return (ctx->max_points == 0) ? 0 : mix64(~(ctx->seed + version)) & ((1ULL << ctx->trailling_bits) - 1);
+}
+
+/** Count the steps from x to the first distinguished point.
+ *
+ *	@return 	The number of steps, or -1 after more than 20 * 2^trailling_bits steps.
+ */
+static long long int collide_trail_length(collide_ctx_t *ctx, uint64_t x, uint64_t salt, uint64_t mark)
+{
+	uint64_t dmask = (1ULL << ctx->trailling_bits) - 1;
+	long long int trail_length_max = 20LL << ctx->trailling_bits;
+	long long int length = 0;
+	while(((x ^ mark) & dmask) != 0)
+	{
+		if(length++ > trail_length_max)
+		{
+			return -1;
+		}
+		x = collide_f(ctx, x, salt);
+	}
+	return length;
+}
+
+/** Create a collision search.
+ *
+ *	@brief The points are kept in the storage structure type_struct,
+ *	__STRUCT_FROZEN__ aside, set up for 2^nb_bits elements: the stored
+ *	a is the start of a trail, on nb_bits bits, and xDist the
+ *	distinguished point without its trailling zeros.
+ */
+collide_ctx_t *collide_create(collide_function_t fn, uint8_t trailling_bits, int type_struct, int nb_threads, uint8_t level)
+{
+	collide_ctx_t *ctx;
+	mpz_t n;
+	unsigned long int seed;
+	if(fn.nb_bits < 1 || fn.nb_bits > __COLLIDE_MAX_BITS__ || trailling_bits >= fn.nb_bits)
+	{
+		fprintf(stderr, "A collision search works on words of 1 to %d bits, with fewer trailling zero bits than bits.\n", __COLLIDE_MAX_BITS__);
+		exit(1);
+	}
+	ctx = malloc(sizeof(collide_ctx_t));
+	ctx->fn = fn;
+	ctx->mask = (fn.nb_bits == 64) ? UINT64_MAX : (1ULL << fn.nb_bits) - 1;
+	ctx->trailling_bits = trailling_bits;
+	ctx->level = level;
+	ctx->nb_threads = nb_threads;
+	ctx->stop = NULL;
+	ctx->nb_collisions = 0;
+	ctx->nb_useless = 0;
+	ctx->nb_robin_hoods = 0;
+	ctx->x1 = 0;
+	ctx->x2 = 0;
+	ctx->max_points = 0;
+	ctx->version_points = 0;
+	ctx->table = NULL;
+	ctx->table_locks = NULL;
+	ctx->seed = 0;
+	ctx->version = 0;
+	ctx->first_version = 0;
+	ctx->versions = NULL;
+	ctx->versions_size = 0;
+	mpz_init(n);
+	mpz_ui_pow_ui(n, 2, fn.nb_bits);
+	struct_init(&ctx->storage, type_struct, n, trailling_bits, fn.nb_bits, nb_threads, level);
+	mpz_clear(n);
+
+	//Each thread initializes its own walker, so that its memory is local to the thread
+	ctx->walkers = malloc(sizeof(collide_walker_t) * nb_threads);
+	seed = (unsigned long int)time(NULL) ^ ((unsigned long int)getpid() << 16) ^ (unsigned long int)ctx;
+	#pragma omp parallel num_threads(nb_threads)
+	{
+		collide_walker_t *w = &ctx->walkers[omp_get_thread_num()];
+		mpz_inits(w->a, w->a2, w->xDist, NULL);
+		w->nb_steps = 0;
+		w->nb_locate_steps = 0;
+		gmp_randinit_default(w->r_state);
+		gmp_randseed_ui(w->r_state, seed * (omp_get_thread_num() + 1));
+	}
+	return ctx;
+}
+
+/** Search the collisions of another function of the same number of bits.
+ *
+ *	@brief The storage structure is emptied.
+ */
+void collide_reset(collide_ctx_t *ctx, collide_function_t fn)
+{
+	if(fn.nb_bits != ctx->fn.nb_bits)
+	{
+		fprintf(stderr, "The function of a collision search keeps its %d bits.\n", ctx->fn.nb_bits);
+		exit(1);
+	}
+	ctx->fn = fn;
+	struct_reset(&ctx->storage);
+}
+
+/** Make a golden collision search of a context.
+ *
+ *	@brief The points are kept in a table of max_points slots, and the
+ *	function changes after version_points distinguished points, 0 for
+ *	__COLLIDE_VERSION_FACTOR__ * max_points. The table is set up once,
+ *	and emptied by the change of version of each run.
+ */
+void collide_set_golden(collide_ctx_t *ctx, unsigned long int max_points, unsigned long int version_points)
+{
+	int i;
+	if(max_points == 0 || ctx->table != NULL)
+	{
+		fprintf(stderr, "A golden collision search is set once, with a table of at least one point.\n");
+		exit(1);
+	}
+	ctx->max_points = max_points;
+	ctx->version_points = (version_points == 0) ? __COLLIDE_VERSION_FACTOR__ * max_points : version_points;
+	ctx->table = calloc(max_points, sizeof(collide_slot_t));
+	ctx->table_locks = malloc(sizeof(omp_lock_t) * __COLLIDE_LOCKS__);
+	ctx->versions_size = 64;
+	ctx->versions = calloc(ctx->versions_size, sizeof(collide_version_t));
+	if(ctx->table == NULL || ctx->table_locks == NULL || ctx->versions == NULL)
+	{
+		fprintf(stderr, "Can not allocate the table of %lu points of the golden collision search.\n", max_points);
+		exit(1);
+	}
+	for(i = 0; i < __COLLIDE_LOCKS__; i++)
+	{
+		omp_init_lock(&ctx->table_locks[i]);
+	}
+}
+
+/** Add a distinguished point to the table of a golden collision search.
+ *
+ *	@brief The point takes the slot of its hash, whatever it held.
+ *
+ *	@return 	1 if the slot held the same point of the same version, whose start is then in start_out, 0 otherwise.
+ */
+static int collide_table_add(collide_ctx_t *ctx, uint64_t version, uint64_t xDist, uint64_t start, uint64_t *start_out)
+{
+	unsigned long int i = mix64(xDist) % ctx->max_points;
+	omp_lock_t *lock = &ctx->table_locks[i % __COLLIDE_LOCKS__];
+	collide_slot_t *slot = &ctx->table[i];
+	int found;
+	omp_set_lock(lock);
+	found = (slot->tag == version + 1 && slot->xDist == xDist);
+	if(found)
+	{
+		*start_out = slot->start;
+	}
+	slot->xDist = xDist;
+	slot->start = start;
+	slot->tag = version + 1;
+	omp_unset_lock(lock);
+	return found;
+}
+
+/** Get the work of a version of the last run.
+ *
+ *	@brief Called in the critical section of the counts.
+ */
+static collide_version_t *collide_version(collide_ctx_t *ctx, uint64_t version)
+{
+	return &ctx->versions[version - ctx->first_version];
+}
+
+/** Count a distinguished point of a version, and go to the next version after version_points of them.
+ *
+ *	@brief The walkers still on the previous version drop their trails.
+ */
+static void collide_version_point(collide_ctx_t *ctx, uint64_t version)
+{
+	unsigned long int i;
+	#pragma omp critical
+	{
+		if(version == ctx->version && ++collide_version(ctx, version)->nb_points >= ctx->version_points)
+		{
+			i = ctx->version + 1 - ctx->first_version;
+			if(i >= ctx->versions_size)
+			{
+				ctx->versions = realloc(ctx->versions, 2 * ctx->versions_size * sizeof(collide_version_t));
+				memset(&ctx->versions[ctx->versions_size], 0, ctx->versions_size * sizeof(collide_version_t));
+				ctx->versions_size *= 2;
+			}
+			ctx->version++;
+		}
+	}
+}
+
+/** Find the collision of two trails reaching the same distinguished point.
+ *
+ *	@brief The trails are walked with the version version of the
+ *	function. The longer trail is walked until both are as far from the
+ *	distinguished point, then both are walked together until their
+ *	images are the same. The steps walked are added to nb_steps.
+ *
+ *	@return 	1 if x1 != x2 with f(x1) = f(x2) were found, 0 for a Robin
+ *	Hood (one start on the other trail) and -1 if the trails do not reach
+ *	the same point.
+ */
+int collide_locate(collide_ctx_t *ctx, uint64_t version, uint64_t s1, uint64_t s2, uint64_t *x1, uint64_t *x2, unsigned long long int *nb_steps)
+{
+	uint64_t salt = collide_salt(ctx, version), mark = collide_mark(ctx, version);
+	long long int l1 = collide_trail_length(ctx, s1, salt, mark);
+	long long int l2 = collide_trail_length(ctx, s2, salt, mark);
+	uint64_t u = s1, v = s2, fu, fv;
+	if(l1 < 0 || l2 < 0)
+	{
+		return -1;
+	}
+	*nb_steps += l1 + l2;
+	for(; l1 > l2; l1--)
+	{
+		u = collide_f(ctx, u, salt);
+		(*nb_steps)++;
+	}
+	for(; l2 > l1; l2--)
+	{
+		v = collide_f(ctx, v, salt);
+		(*nb_steps)++;
+	}
+	if(u == v)
+	{
+		return 0;
+	}
+	for(; l1 > 0; l1--)
+	{
+		fu = collide_f(ctx, u, salt);
+		fv = collide_f(ctx, v, salt);
+		*nb_steps += 2;
+		if(fu == fv)
+		{
+			*x1 = u;
+			*x2 = v;
+			return 1;
+		}
+		u = fu;
+		v = fv;
+	}
+	return -1;
+}
+
+static int collide_done(collide_ctx_t *ctx, int *useful_count, int nb_useful)
+{
+	return (*useful_count >= nb_useful || (ctx->stop != NULL && *ctx->stop));
+}
+
+/** Add a distinguished point of a trail to the points of the search.
+ *
+ *	@return 	1 if another trail reached it, whose start is then in start_out, 0 otherwise.
+ */
+static int collide_add(collide_ctx_t *ctx, collide_walker_t *w, uint64_t version, uint64_t xDist, uint64_t start, uint64_t *start_out)
+{
+	char xDist_str[100];
+	int found;
+	if(ctx->max_points > 0)
+	{
+		if(version != ctx->version) //the function changed during the trail
+		{
+			return 0;
+		}
+		found = collide_table_add(ctx, version, xDist, start, start_out);
+		collide_version_point(ctx, version);
+		return found;
+	}
+	mpz_set_ui(w->a, start);
+	mpz_set_ui(w->xDist, xDist);
+	if(!struct_add(&ctx->storage, w->a2, w->a, w->xDist, xDist_str))
+	{
+		return 0;
+	}
+	*start_out = mpz_get_ui(w->a2);
+	return 1;
+}
+
+/** Walk the trails of one thread until the run is over.
+ *
+ */
+static void collide_walk(collide_ctx_t *ctx, collide_walker_t *w, int *useful_count, int nb_useful)
+{
+	uint64_t dmask = (1ULL << ctx->trailling_bits) - 1;
+	long long int trail_length_max = 20LL << ctx->trailling_bits;
+	long long int trail_length;
+	uint64_t x0, x, x1, x2, s2, version, salt, mark;
+	int found;
+
+	w->nb_steps = 0;
+	w->nb_locate_steps = 0;
+	while(!collide_done(ctx, useful_count, nb_useful))
+	{
+		version = ctx->version;
+		salt = collide_salt(ctx, version);
+		mark = collide_mark(ctx, version);
+		x0 = gmp_urandomb_ui(w->r_state, ctx->fn.nb_bits);
+		x = x0;
+		trail_length = 0;
+		while(((x ^ mark) & dmask) != 0 && trail_length <= trail_length_max)
+		{
+			x = collide_f(ctx, x, salt);
+			trail_length++;
+		}
+		w->nb_steps += trail_length;
+		if(trail_length > trail_length_max) //the trail is probably in a cycle
+		{
+			continue;
+		}
+		if(!collide_add(ctx, w, version, x >> ctx->trailling_bits, x0, &s2))
+		{
+			continue;
+		}
+		found = collide_locate(ctx, version, s2, x0, &x1, &x2, &w->nb_locate_steps);
+		if(found <= 0)
+		{
+			#pragma omp critical
+			{
+				ctx->nb_robin_hoods++;
+				if(ctx->max_points > 0)
+				{
+					collide_version(ctx, version)->nb_robin_hoods++;
+				}
+			}
+			continue;
+		}
+		found = (ctx->fn.useful == NULL || ctx->fn.useful(x1, x2, ctx->fn.arg));
+		#pragma omp critical
+		{
+			ctx->nb_collisions++;
+			if(ctx->max_points > 0)
+			{
+				collide_version(ctx, version)->nb_collisions++;
+				collide_version(ctx, version)->nb_useless += !found;
+			}
+			if(!found)
+			{
+				ctx->nb_useless++;
+			}
+			else if(*useful_count < nb_useful)
+			{
+				(*useful_count)++;
+				ctx->x1 = x1;
+				ctx->x2 = x2;
+			}
+		}
+	}
+}
+
+/** Search collisions until nb_useful of them are useful or the run is stopped through ctx->stop.
+ *
+ *	@brief The points stored by the previous runs are kept, see
+ *	collide_reset, but for a golden collision search, whose runs start on
+ *	a new version of the function with a new seed.
+ *
+ *	@return 	The number of useful collisions found, the last one being in ctx->x1 and ctx->x2.
+ */
+long long int collide_run(collide_ctx_t *ctx, int nb_useful)
+{
+	int useful_count = 0;
+	ctx->nb_collisions = 0;
+	ctx->nb_useless = 0;
+	ctx->nb_robin_hoods = 0;
+	if(ctx->max_points > 0)
+	{
+		ctx->seed = gmp_urandomb_ui(ctx->walkers[0].r_state, 64);
+		ctx->version++;
+		ctx->first_version = ctx->version;
+		memset(ctx->versions, 0, ctx->versions_size * sizeof(collide_version_t));
+	}
+	#pragma omp parallel shared(useful_count) num_threads(ctx->nb_threads)
+	{
+		collide_walk(ctx, &ctx->walkers[omp_get_thread_num()], &useful_count, nb_useful);
+	}
+	return useful_count;
+}
+
+/** Get the number of versions of the function walked by the last run.
+ *
+ */
+unsigned long int collide_nb_versions(collide_ctx_t *ctx)
+{
+	return (ctx->max_points == 0) ? 1 : ctx->version - ctx->first_version + 1;
+}
+
+/** Get the number of evaluations of f of the last run.
+ *
+ *	@brief Those spent walking again the trails of the matches are
+ *	counted apart, in nb_locate_steps if it is not NULL.
+ *
+ *	@return 	The number of steps of the walks.
+ */
+unsigned long long int collide_steps(collide_ctx_t *ctx, unsigned long long int *nb_locate_steps)
+{
+	unsigned long long int nb_steps = 0;
+	int i;
+	if(nb_locate_steps != NULL)
+	{
+		*nb_locate_steps = 0;
+	}
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		nb_steps += ctx->walkers[i].nb_steps;
+		if(nb_locate_steps != NULL)
+		{
+			*nb_locate_steps += ctx->walkers[i].nb_locate_steps;
+		}
+	}
+	return nb_steps;
+}
+
+/** Get the memory of the points of a search.
+ *
+ *	@brief For a golden collision search, the points are those of the
+ *	table stored by the last version, and both rates are the share of
+ *	the slots they take.
+ *
+ *	@return 	The memory in bytes.
+ */
+unsigned long long int collide_memory(collide_ctx_t *ctx, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	unsigned long int i;
+	if(ctx->max_points == 0)
+	{
+		return struct_memory(&ctx->storage, nb_points, rate_of_use, rate_slots);
+	}
+	*nb_points = 0;
+	for(i = 0; i < ctx->max_points; i++)
+	{
+		*nb_points += (ctx->table[i].tag == ctx->version + 1);
+	}
+	*rate_of_use = (float)*nb_points / ctx->max_points;
+	*rate_slots = *rate_of_use;
+	return ctx->max_points * sizeof(collide_slot_t) + __COLLIDE_LOCKS__ * sizeof(omp_lock_t);
+}
+
+void collide_destroy(collide_ctx_t *ctx)
+{
+	int i;
+	struct_free(&ctx->storage);
+	if(ctx->table != NULL)
+	{
+		for(i = 0; i < __COLLIDE_LOCKS__; i++)
+		{
+			omp_destroy_lock(&ctx->table_locks[i]);
+		}
+		free(ctx->table);
+		free(ctx->table_locks);
+		free(ctx->versions);
+	}
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		mpz_clears(ctx->walkers[i].a, ctx->walkers[i].a2, ctx->walkers[i].xDist, NULL);
+		gmp_randclear(ctx->walkers[i].r_state);
+	}
+	free(ctx->walkers);
+	free(ctx);
+}
@@ -0,0 +1,117 @@
+/** @file pcs_collide.h
+ *
+ */
+#ifndef PCS_COLLIDE_H
+#define PCS_COLLIDE_H
+
+#include <inttypes.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs_storage.h"
+
+#define __COLLIDE_MAX_BITS__ 64
+#define __COLLIDE_LOCKS__ 4096
+#define __COLLIDE_VERSION_FACTOR__ 10 /* distinguished points per version, in points of the table, by default */
+
+/** A function of n-bit words, n <= __COLLIDE_MAX_BITS__, whose collisions are searched.
+ *
+ *	@brief f maps [0, 2^nb_bits) to itself (its result is masked to
+ *	nb_bits bits) and useful tells whether the collision f(x1) = f(x2),
+ *	x1 != x2, is one the search is after. A NULL useful accepts all of
+ *	them. Both are called by all the threads at once with arg, which they
+ *	must only read.
+ */
+typedef struct
+{
+	const char *name;
+	int nb_bits;
+	uint64_t (*f)(uint64_t x, const void *arg);
+	int (*useful)(uint64_t x1, uint64_t x2, const void *arg);
+	const void *arg;
+}collide_function_t;
+
+/** State of one walker of a collision search.
+ */
+typedef struct
+{
+	mpz_t a;
+	mpz_t a2;
+	mpz_t xDist;
+	gmp_randstate_t r_state;
+	unsigned long long int nb_steps;
+	unsigned long long int nb_locate_steps;
+}collide_walker_t;
+
+/** A slot of the table of a golden collision search.
+ *
+ *	@brief tag is 1 + the version of the function that stored the
+ *	point, 0 for an empty slot.
+ */
+typedef struct
+{
+	uint64_t xDist;
+	uint64_t start;
+	uint64_t tag;
+}collide_slot_t;
+
+/** Work of one version of the function in a golden collision search.
+ */
+typedef struct
+{
+	unsigned long long int nb_points;
+	unsigned long long int nb_collisions;
+	unsigned long long int nb_useless;
+	unsigned long long int nb_robin_hoods;
+}collide_version_t;
+
+/** Context of one collision search.
+ *
+ *	@brief The counts are those of the last run: the collisions located
+ *	by the re-walk from two trail starts, those of them useful rejected,
+ *	and the Robin Hoods, where one start lies on the other trail and the
+ *	trails do not collide. x1 and x2 hold the last useful collision.
+ *
+ *	A golden collision search (max_points > 0, see collide_set_golden)
+ *	keeps the points in a table of max_points slots instead of the
+ *	storage structure, and walks the version version of the function,
+ *	f(x) xor a salt drawn from seed and version, which changes after
+ *	version_points distinguished points. The versions of the last run go
+ *	from first_version to version, and versions holds their work.
+ */
+typedef struct
+{
+	collide_function_t fn;
+	uint64_t mask;
+	uint8_t trailling_bits;
+	uint8_t level;
+	int nb_threads;
+	pcs_storage_t storage;
+	collide_walker_t *walkers;
+	volatile uint32_t *stop;
+	unsigned long long int nb_collisions;
+	unsigned long long int nb_useless;
+	unsigned long long int nb_robin_hoods;
+	uint64_t x1;
+	uint64_t x2;
+	unsigned long int max_points;
+	unsigned long int version_points;
+	collide_slot_t *table;
+	omp_lock_t *table_locks;
+	uint64_t seed;
+	volatile uint64_t version;
+	uint64_t first_version;
+	collide_version_t *versions;
+	unsigned long int versions_size;
+}collide_ctx_t;
+
+collide_ctx_t *collide_create(collide_function_t fn, uint8_t trailling_bits, int type_struct, int nb_threads, uint8_t level);
+void collide_reset(collide_ctx_t *ctx, collide_function_t fn);
+void collide_set_golden(collide_ctx_t *ctx, unsigned long int max_points, unsigned long int version_points);
+uint64_t collide_salt(collide_ctx_t *ctx, uint64_t version);
+int collide_locate(collide_ctx_t *ctx, uint64_t version, uint64_t s1, uint64_t s2, uint64_t *x1, uint64_t *x2, unsigned long long int *nb_steps);
+long long int collide_run(collide_ctx_t *ctx, int nb_useful);
+unsigned long int collide_nb_versions(collide_ctx_t *ctx);
+unsigned long long int collide_steps(collide_ctx_t *ctx, unsigned long long int *nb_locate_steps);
+unsigned long long int collide_memory(collide_ctx_t *ctx, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+void collide_destroy(collide_ctx_t *ctx);
+#endif
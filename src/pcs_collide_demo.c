@@ -0,0 +1,251 @@
+/** @file pcs_collide_demo.c
+ *  @brief Functions to benchmark the collision search of pcs_collide.h on.
+ *
+ *	sha256 truncates SHA-256 to n bits: all its collisions are useful,
+ *	and the first one is expected after sqrt(pi*2^n/2) steps.
+ *
+ *	cipher is the meet in the middle attack on the double encryption
+ *	C = E_k2(E_k1(P)) with a toy cipher of w-bit blocks and keys, w = n - 1.
+ *	The input of f is a key k and a bit telling whether it is the first
+ *	key, mapped to E_k(P), or the second one, mapped to D_k(C), and the
+ *	output is one of them again, chosen by a bit of the hash of the
+ *	block. The useful collisions are those between a first and a second
+ *	key, which give E_k1(P) = D_k2(C). About 2^w key pairs satisfy it, and
+ *	only one of them, the golden collision, also satisfies the other
+ *	plaintext-ciphertext pairs (van Oorschot and Wiener, "Parallel
+ *	collision search with cryptanalytic applications", J. Cryptology
+ *	1999, section 5.3): collide_cipher_check tells it, and
+ *	collide_cipher_golden is the predicate of its golden collision search.
+ *
+ *	The toy cipher has __COLLIDE_CIPHER_ROUNDS__ rounds of an addition of
+ *	the round key, a multiplication by an odd constant, a xorshift of half
+ *	a block and a rotation, all of them modulo 2^w. It has no security at
+ *	all but is a permutation for each key, as a block cipher is.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "pcs_collide.h"
+#include "pcs_collide_demo.h"
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t sha256_h[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static inline uint32_t rotr32(uint32_t x, int s)
+{
+	return (x >> s) | (x << (32 - s));
+}
+
+/** Get the first nb_bits bits of SHA-256(salt || x).
+ *
+ *	@brief The 16 bytes of the message and their padding fill one block,
+ *	so that the hash is one compression.
+ */
+uint64_t collide_sha256_bits(uint64_t salt, uint64_t x, int nb_bits)
+{
+	uint32_t W[64];
+	uint32_t a, b, c, d, e, f, g, h, t1, t2;
+	int i;
+	W[0] = salt >> 32;
+	W[1] = (uint32_t)salt;
+	W[2] = x >> 32;
+	W[3] = (uint32_t)x;
+	W[4] = 0x80000000;
+	for(i = 5; i < 15; i++)
+	{
+		W[i] = 0;
+	}
+	W[15] = 128;
+	for(i = 16; i < 64; i++)
+	{
+		W[i] = W[i - 16] + (rotr32(W[i - 15], 7) ^ rotr32(W[i - 15], 18) ^ (W[i - 15] >> 3)) + W[i - 7] + (rotr32(W[i - 2], 17) ^ rotr32(W[i - 2], 19) ^ (W[i - 2] >> 10));
+	}
+	a = sha256_h[0]; b = sha256_h[1]; c = sha256_h[2]; d = sha256_h[3];
+	e = sha256_h[4]; f = sha256_h[5]; g = sha256_h[6]; h = sha256_h[7];
+	for(i = 0; i < 64; i++)
+	{
+		t1 = h + (rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + W[i];
+		t2 = (rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+	a += sha256_h[0];
+	b += sha256_h[1];
+	return (((uint64_t)a << 32) | b) >> (64 - nb_bits);
+}
+
+static uint64_t sha256_f(uint64_t x, const void *arg)
+{
+	const collide_sha256_t *h = arg;
+	return collide_sha256_bits(h->salt, x, h->nb_bits);
+}
+
+/** Set fn to the first nb_bits bits of SHA-256(salt || x).
+ *
+ *	@brief The function reads h, which has to outlive the search.
+ */
+void collide_sha256_init(collide_function_t *fn, collide_sha256_t *h, int nb_bits, uint64_t salt)
+{
+	h->salt = salt;
+	h->nb_bits = nb_bits;
+	fn->name = "sha256";
+	fn->nb_bits = nb_bits;
+	fn->f = sha256_f;
+	fn->useful = NULL;
+	fn->arg = h;
+}
+
+static const uint64_t cipher_mul[__COLLIDE_CIPHER_ROUNDS__] = {0x9e3779b97f4a7c15, 0xbf58476d1ce4e5b9, 0x94d049bb133111eb, 0xd6e8feb86659fd93};
+
+static inline uint64_t cipher_rotl(uint64_t x, int s, int w, uint64_t mask)
+{
+	return ((x << s) | (x >> (w - s))) & mask;
+}
+
+static inline int cipher_rotation(int w, int round)
+{
+	return w * (round + 1) / (__COLLIDE_CIPHER_ROUNDS__ + 1);
+}
+
+static inline uint64_t cipher_round_key(const collide_cipher_t *c, uint64_t k, int round)
+{
+	return cipher_rotl(k, cipher_rotation(c->key_bits, round), c->key_bits, c->mask) ^ (cipher_mul[round] & c->mask);
+}
+
+uint64_t collide_cipher_encrypt(const collide_cipher_t *c, uint64_t k, uint64_t x)
+{
+	int w = c->key_bits, half = (w + 1) / 2;
+	int r;
+	for(r = 0; r < __COLLIDE_CIPHER_ROUNDS__; r++)
+	{
+		x = (x + cipher_round_key(c, k, r)) * cipher_mul[r] & c->mask;
+		x ^= x >> half;
+		x = cipher_rotl(x, cipher_rotation(w, r), w, c->mask);
+	}
+	return x;
+}
+
+/** Decrypt x with the key k.
+ *
+ *	@brief x ^= x >> half is its own inverse as 2 * half >= w.
+ */
+uint64_t collide_cipher_decrypt(const collide_cipher_t *c, uint64_t k, uint64_t x)
+{
+	int w = c->key_bits, half = (w + 1) / 2;
+	int r;
+	for(r = __COLLIDE_CIPHER_ROUNDS__ - 1; r >= 0; r--)
+	{
+		x = cipher_rotl(x, w - cipher_rotation(w, r), w, c->mask);
+		x ^= x >> half;
+		x = (x * c->mul_inv[r] - cipher_round_key(c, k, r)) & c->mask;
+	}
+	return x;
+}
+
+static uint64_t cipher_f(uint64_t x, const void *arg)
+{
+	const collide_cipher_t *c = arg;
+	uint64_t k = x & c->mask;
+	uint64_t y = (x >> c->key_bits) ? collide_cipher_decrypt(c, k, c->C[0]) : collide_cipher_encrypt(c, k, c->P[0]);
+	return y | ((y * cipher_mul[0]) >> 63) << c->key_bits;
+}
+
+/** Get the first and the second key of a collision of the double encryption.
+ *
+ */
+void collide_cipher_keys(const collide_cipher_t *c, uint64_t x1, uint64_t x2, uint64_t *k1, uint64_t *k2)
+{
+	*k1 = ((x1 >> c->key_bits) ? x2 : x1) & c->mask;
+	*k2 = ((x1 >> c->key_bits) ? x1 : x2) & c->mask;
+}
+
+/** Tell whether the keys k1, k2 encrypt all the plaintexts to their ciphertexts.
+ *
+ */
+int collide_cipher_check(const collide_cipher_t *c, uint64_t k1, uint64_t k2)
+{
+	int i;
+	for(i = 0; i < __COLLIDE_CIPHER_PAIRS__; i++)
+	{
+		if(collide_cipher_encrypt(c, k2, collide_cipher_encrypt(c, k1, c->P[i])) != c->C[i])
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** Tell whether a collision is between a first and a second key, which gives a candidate pair of keys.
+ *
+ */
+static int cipher_useful(uint64_t x1, uint64_t x2, const void *arg)
+{
+	const collide_cipher_t *c = arg;
+	return ((x1 >> c->key_bits) != (x2 >> c->key_bits));
+}
+
+/** Tell whether a collision is the golden one, whose keys are right on all the pairs.
+ *
+ *	@brief The predicate of a golden collision search of the function of collide_cipher_init.
+ */
+int collide_cipher_golden(uint64_t x1, uint64_t x2, const void *arg)
+{
+	const collide_cipher_t *c = arg;
+	uint64_t k1, k2;
+	if(!cipher_useful(x1, x2, arg))
+	{
+		return 0;
+	}
+	collide_cipher_keys(c, x1, x2, &k1, &k2);
+	return collide_cipher_check(c, k1, k2);
+}
+
+/** Set fn to the meet in the middle search of the keys k1, k2 of the double encryption of the plaintexts P.
+ *
+ *	@brief The keys have nb_bits - 1 bits, and the function reads c,
+ *	which has to outlive the search.
+ */
+void collide_cipher_init(collide_function_t *fn, collide_cipher_t *c, int nb_bits, uint64_t k1, uint64_t k2, uint64_t P[])
+{
+	uint64_t inv;
+	int i;
+	if(nb_bits < 9 || nb_bits > __COLLIDE_MAX_BITS__)
+	{
+		fprintf(stderr, "The toy cipher has keys of 8 to %d bits.\n", __COLLIDE_MAX_BITS__ - 1);
+		exit(1);
+	}
+	c->key_bits = nb_bits - 1;
+	c->mask = (1ULL << c->key_bits) - 1;
+	for(i = 0; i < __COLLIDE_CIPHER_ROUNDS__; i++)
+	{
+		//Newton's iteration doubles the number of correct low bits, the odd constant being right on 3 bits
+		inv = cipher_mul[i];
+		inv *= 2 - cipher_mul[i] * inv;
+		inv *= 2 - cipher_mul[i] * inv;
+		inv *= 2 - cipher_mul[i] * inv;
+		inv *= 2 - cipher_mul[i] * inv;
+		inv *= 2 - cipher_mul[i] * inv;
+		c->mul_inv[i] = inv;
+	}
+	for(i = 0; i < __COLLIDE_CIPHER_PAIRS__; i++)
+	{
+		c->P[i] = P[i] & c->mask;
+		c->C[i] = collide_cipher_encrypt(c, k2 & c->mask, collide_cipher_encrypt(c, k1 & c->mask, c->P[i]));
+	}
+	fn->name = "cipher";
+	fn->nb_bits = nb_bits;
+	fn->f = cipher_f;
+	fn->useful = cipher_useful;
+	fn->arg = c;
+}
@@ -0,0 +1,44 @@
+/** @file pcs_collide_demo.h
+ *
+ */
+#ifndef PCS_COLLIDE_DEMO_H
+#define PCS_COLLIDE_DEMO_H
+
+#include <inttypes.h>
+#include "pcs_collide.h"
+
+#define __COLLIDE_CIPHER_ROUNDS__ 4
+#define __COLLIDE_CIPHER_PAIRS__ 3
+
+/** The first nb_bits bits of SHA-256(salt || x), salt and x on 8 bytes each, big-endian.
+ */
+typedef struct
+{
+	uint64_t salt;
+	int nb_bits;
+}collide_sha256_t;
+
+/** Double encryption C = E_k2(E_k1(P)) with a toy cipher of w-bit blocks and keys.
+ *
+ *	@brief The pairs P[i], C[i] are encrypted with the same keys: the
+ *	collisions E_k1(P[0]) = D_k2(C[0]) are searched, and the other pairs
+ *	tell the right keys.
+ */
+typedef struct
+{
+	int key_bits;
+	uint64_t mask;
+	uint64_t P[__COLLIDE_CIPHER_PAIRS__];
+	uint64_t C[__COLLIDE_CIPHER_PAIRS__];
+	uint64_t mul_inv[__COLLIDE_CIPHER_ROUNDS__];
+}collide_cipher_t;
+
+uint64_t collide_sha256_bits(uint64_t salt, uint64_t x, int nb_bits);
+void collide_sha256_init(collide_function_t *fn, collide_sha256_t *h, int nb_bits, uint64_t salt);
+uint64_t collide_cipher_encrypt(const collide_cipher_t *c, uint64_t k, uint64_t x);
+uint64_t collide_cipher_decrypt(const collide_cipher_t *c, uint64_t k, uint64_t x);
+void collide_cipher_init(collide_function_t *fn, collide_cipher_t *c, int nb_bits, uint64_t k1, uint64_t k2, uint64_t P[]);
+int collide_cipher_check(const collide_cipher_t *c, uint64_t k1, uint64_t k2);
+int collide_cipher_golden(uint64_t x1, uint64_t x2, const void *arg);
+void collide_cipher_keys(const collide_cipher_t *c, uint64_t x1, uint64_t x2, uint64_t *k1, uint64_t *k2);
+#endif
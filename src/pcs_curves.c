@@ -0,0 +1,173 @@
+/** @file pcs_curves.c
+ *  @brief Reading the curves and the points of the files curves and points.
+ *
+ *	A file of curves has one line per curve, f A B p n, with f the number
+ *	of bits of p and n the prime order of the points, possibly followed
+ *	by other fields, which are ignored. A file of points has, for each
+ *	curve, a line of f followed by dashes, then one line x y per point of
+ *	order n. The numbers are in base 10 and separated by blanks. The lines
+ *	of the files given with the code up to 115 bits are padded to a fixed
+ *	length, but lines can be of any length: the curves are looked up by
+ *	f, not by their offset in the file.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <gmp.h>
+#include "pcs_curves.h"
+
+#define __CURVES_FIELDS__ 5
+
+/** Split a line into its first fields, in place.
+ *
+ *	@return 	The number of fields found, at most max.
+ */
+static int curves_fields(char *line, char **fields, int max)
+{
+	char *save = NULL;
+	int i;
+	for(i = 0; i < max; i++)
+	{
+		fields[i] = strtok_r((i == 0) ? line : NULL, " \t\r\n", &save);
+		if(fields[i] == NULL)
+		{
+			break;
+		}
+	}
+	return i;
+}
+
+/** Get the curve of a header line of a file of points.
+ *
+ *	@return 	f, or 0 if the line is not a header.
+ */
+static int curves_header(const char *line)
+{
+	const char *c = line;
+	while(isdigit((unsigned char)*c))
+	{
+		c++;
+	}
+	return (c != line && *c == '-') ? atoi(line) : 0;
+}
+
+/** List the curves of a file of curves.
+ *
+ *	@param[out]	bits	The sizes f of the curves, in the order of the file.
+ *	@return 	The number of curves, of which the first max are listed, or
+ *				-1 if the file can not be opened.
+ */
+int curves_list(const char *path, int *bits, int max)
+{
+	FILE *file;
+	char *line = NULL, *fields[__CURVES_FIELDS__];
+	size_t size = 0;
+	int nb_curves = 0;
+	file = fopen(path, "r");
+	if(file == NULL)
+	{
+		return -1;
+	}
+	while(getline(&line, &size, file) != -1)
+	{
+		if(curves_fields(line, fields, __CURVES_FIELDS__) == __CURVES_FIELDS__)
+		{
+			if(nb_curves < max)
+			{
+				bits[nb_curves] = atoi(fields[0]);
+			}
+			nb_curves++;
+		}
+	}
+	free(line);
+	fclose(file);
+	return nb_curves;
+}
+
+/** Read the f-bit curve of a file of curves.
+ *
+ *	@param[out]	E	The curve.
+ *	@param[out]	n	The order of its points.
+ *	@return 	0 if the curve was read, 1 otherwise.
+ */
+int curves_read(const char *path, int f, elliptic_curve_t *E, mpz_t n)
+{
+	FILE *file;
+	char *line = NULL, *fields[__CURVES_FIELDS__];
+	size_t size = 0;
+	int res = 1;
+	file = fopen(path, "r");
+	if(file == NULL)
+	{
+		return 1;
+	}
+	while(getline(&line, &size, file) != -1)
+	{
+		if(curves_fields(line, fields, __CURVES_FIELDS__) == __CURVES_FIELDS__ && atoi(fields[0]) == f)
+		{
+			res = (mpz_set_str(E->A, fields[1], 10) != 0 || mpz_set_str(E->B, fields[2], 10) != 0
+				|| mpz_set_str(E->p, fields[3], 10) != 0 || mpz_set_str(n, fields[4], 10) != 0);
+			break;
+		}
+	}
+	free(line);
+	fclose(file);
+	return res;
+}
+
+/** Read a point of the f-bit curve of a file of points.
+ *
+ *	@param[in]	i	Index of the point, taken modulo the number of points
+ *					of the curve.
+ *	@param[out]	P	The point.
+ *	@return 	0 if the point was read, 1 otherwise.
+ */
+int curves_read_point(const char *path, int f, int i, point_t *P)
+{
+	FILE *file;
+	char *line = NULL, *fields[2];
+	size_t size = 0;
+	long int start = -1;
+	int nb_points = 0, k, res = 1;
+	file = fopen(path, "r");
+	if(file == NULL)
+	{
+		return 1;
+	}
+	//count the points of the curve, and keep where they start
+	while(getline(&line, &size, file) != -1)
+	{
+		if(start < 0)
+		{
+			if(curves_header(line) == f)
+			{
+				start = ftell(file);
+			}
+		}
+		else if(curves_header(line) != 0)
+		{
+			break;
+		}
+		else if(curves_fields(line, fields, 2) == 2)
+		{
+			nb_points++;
+		}
+	}
+	if(nb_points > 0 && fseek(file, start, SEEK_SET) == 0)
+	{
+		k = i % nb_points;
+		while(getline(&line, &size, file) != -1)
+		{
+			if(curves_fields(line, fields, 2) == 2 && k-- == 0)
+			{
+				res = (mpz_set_str(P->x, fields[0], 10) != 0 || mpz_set_str(P->y, fields[1], 10) != 0);
+				break;
+			}
+		}
+	}
+	mpz_set_ui(P->z, 1);
+	free(line);
+	fclose(file);
+	return res;
+}
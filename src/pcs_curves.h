@@ -0,0 +1,15 @@
+/** @file pcs_curves.h
+ *
+ */
+#ifndef PCS_CURVES_H
+#define PCS_CURVES_H
+
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+
+#define __CURVES_MAX_BITS__ 255
+
+int curves_list(const char *path, int *bits, int max);
+int curves_read(const char *path, int f, elliptic_curve_t *E, mpz_t n);
+int curves_read_point(const char *path, int f, int i, point_t *P);
+#endif
@@ -0,0 +1,642 @@
+/** @file pcs_daemon.c
+ *  @brief A long-running PCS solver serving jobs over a Unix socket.
+ *
+ *	The daemon keeps the PCS contexts of the last jobs (adding walk, M table,
+ *	fixed-base table of P, storage structure and walkers) as well as the
+ *	OpenMP threads alive between jobs. A job on a curve and a point P already
+ *	seen only pays for pcs_reset instead of pcs_create.
+ *
+ *	A job is one line of text of space separated key=value fields:
+ *
+ *		solve p=<p> A=<A> B=<B> n=<n> Px=<x> Py=<y> Qx=<x> Qy=<y> [d=<d>] [l=<l>] [s=PRTL|hash_unix] [c=<collisions>] [T=<seconds>]
+ *
+ *	The curve fields p, A, B and n can be replaced by f=<f>, which reads the
+ *	f-bit curve of the file curves. The jobs are solved one at a time, so
+ *	that each is stopped after at most the time limit of the daemon, or
+ *	the lower one given by T. The other commands are "stats", which
+ *	lists the cached contexts, and "shutdown". The replies are lines of text,
+ *	the last line of a reply to a job starts with "end" or "error".
+ */
+#include <stdio.h>
+#include <gmp.h>
+#include <omp.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs.h"
+#include "pcs_vect_bin.h"
+#include "pcs_curves.h"
+
+#define __DEFAULT_SOCKET_PATH__ "/tmp/pcs_daemon.sock"
+#define __DEFAULT_CACHE_SIZE__ 4
+#define __JOB_LINE_SIZE__ 4096
+#define __NB_STRUCTURES__ 2
+#define __DEFAULT_TIME_LIMIT__ 600
+
+/** A cached PCS context and the settings it was created with.
+ */
+typedef struct
+{
+	pcs_ctx_t *ctx;
+	uint8_t level;
+	unsigned long long int last_use;
+	unsigned long int nb_jobs;
+}daemon_slot_t;
+
+/** State of the daemon, shared by all connections.
+ */
+typedef struct
+{
+	daemon_slot_t *cache;
+	int cache_size;
+	int nb_threads;
+	int time_limit;
+	unsigned long long int nb_jobs;
+	gmp_randstate_t r_state;
+}daemon_t;
+
+/** A parsed job.
+ */
+typedef struct
+{
+	elliptic_curve_t E;
+	mpz_t n;
+	point_t P;
+	point_t Q;
+	uint8_t nb_bits;
+	uint8_t trailling_bits;
+	uint8_t level;
+	int type_struct;
+	int nb_collisions;
+	int time_limit;
+}job_t;
+
+/** Stop the run of a job once its time limit is reached.
+ */
+typedef struct
+{
+	volatile uint32_t stop;
+	int seconds;
+	int done;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+}job_timer_t;
+
+static char *struct_i_str[] = {"PRTL", "hash_unix"};
+
+/** Print out executable usage.
+ */
+void print_usage() {
+    printf("Usage: \n-S : run the daemon, listening on the given Unix socket (default is "__DEFAULT_SOCKET_PATH__")\n-C : send the jobs read on stdin to the daemon listening on the given Unix socket, one job per line\n-t : number of threads to use (default is the number of cores avaliable)\n-k : number of PCS contexts kept warm between jobs (default is %d)\n-T : time limit of a job in seconds, 0 for none (default is %d)\n", __DEFAULT_CACHE_SIZE__, __DEFAULT_TIME_LIMIT__);
+}
+
+/** Get the current time in microseconds.
+ */
+unsigned long long int now_us()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return (tv.tv_sec) * 1000000ULL + tv.tv_usec;
+}
+
+/** Read the curve of the file curves used by pcs_exec.
+ *
+ * 	@return 	0 if the curve was read, 1 otherwise.
+ */
+int read_curve(job_t *job, int f)
+{
+	if(f < 1 || f > __CURVES_MAX_BITS__ || curves_read("curves", f, &job->E, job->n))
+	{
+		return 1;
+	}
+	job->nb_bits = f;
+	return 0;
+}
+
+/** Parse a job line.
+ *
+ * 	@param[out]	job			The parsed job.
+ * 	@param[in]	line		The job line, without the command. It is modified.
+ * 	@param[in]	time_limit	The time limit of the daemon, in seconds, 0 for none.
+ * 	@param[out]	err			A message explaining the error, if any.
+ * 	@return 	0 if the job is valid, 1 otherwise.
+ */
+int parse_job(job_t *job, char *line, int time_limit, const char **err)
+{
+	char *field, *value, *save_ptr;
+	int has_curve = 0, has_points = 0, f = 0, d = -1, i;
+	unsigned int max_bits;
+
+	job->level = 7;
+	job->type_struct = 0;
+	job->nb_collisions = 1;
+	job->time_limit = time_limit;
+	job->nb_bits = 0;
+	mpz_set_ui(job->P.z, 1);
+	mpz_set_ui(job->Q.z, 1);
+
+	for(field = strtok_r(line, " \t\r\n", &save_ptr); field != NULL; field = strtok_r(NULL, " \t\r\n", &save_ptr))
+	{
+		value = strchr(field, '=');
+		if(value == NULL)
+		{
+			*err = "fields must be of the form key=value";
+			return 1;
+		}
+		*value++ = '\0';
+		if(strcmp(field, "p") == 0) { has_curve |= 1 * (mpz_set_str(job->E.p, value, 10) == 0); }
+		else if(strcmp(field, "A") == 0) { has_curve |= 2 * (mpz_set_str(job->E.A, value, 10) == 0); }
+		else if(strcmp(field, "B") == 0) { has_curve |= 4 * (mpz_set_str(job->E.B, value, 10) == 0); }
+		else if(strcmp(field, "n") == 0) { has_curve |= 8 * (mpz_set_str(job->n, value, 10) == 0); }
+		else if(strcmp(field, "Px") == 0) { has_points |= 1 * (mpz_set_str(job->P.x, value, 10) == 0); }
+		else if(strcmp(field, "Py") == 0) { has_points |= 2 * (mpz_set_str(job->P.y, value, 10) == 0); }
+		else if(strcmp(field, "Qx") == 0) { has_points |= 4 * (mpz_set_str(job->Q.x, value, 10) == 0); }
+		else if(strcmp(field, "Qy") == 0) { has_points |= 8 * (mpz_set_str(job->Q.y, value, 10) == 0); }
+		else if(strcmp(field, "f") == 0) { f = atoi(value); }
+		else if(strcmp(field, "d") == 0) { d = atoi(value); }
+		else if(strcmp(field, "l") == 0) { job->level = atoi(value); }
+		else if(strcmp(field, "c") == 0) { job->nb_collisions = atoi(value); }
+		else if(strcmp(field, "T") == 0) { job->time_limit = atoi(value); }
+		else if(strcmp(field, "s") == 0)
+		{
+			job->type_struct = -1;
+			for(i = 0; i < __NB_STRUCTURES__; i++)
+			{
+				if(strcmp(value, struct_i_str[i]) == 0)
+				{
+					job->type_struct = i;
+				}
+			}
+			if(job->type_struct < 0)
+			{
+				*err = "unknown storage structure";
+				return 1;
+			}
+		}
+		else
+		{
+			*err = "unknown field";
+			return 1;
+		}
+	}
+
+	if(has_curve != 15)
+	{
+		if(f == 0 || read_curve(job, f))
+		{
+			*err = "missing curve: give p, A, B and n, or f for a curve of the file curves";
+			return 1;
+		}
+	}
+	else
+	{
+		job->nb_bits = (f > 0) ? f : (int)mpz_sizeinbase(job->E.p, 2);
+	}
+	if(has_points != 15)
+	{
+		*err = "missing point: give Px, Py, Qx and Qy";
+		return 1;
+	}
+	if(mpz_cmp_ui(job->n, 1) <= 0 || mpz_cmp_ui(job->E.p, 3) <= 0 || !is_elliptic_curve(job->E))
+	{
+		*err = "invalid curve";
+		return 1;
+	}
+	mpz_mmod(job->P.x, job->P.x, job->E.p);
+	mpz_mmod(job->P.y, job->P.y, job->E.p);
+	mpz_mmod(job->Q.x, job->Q.x, job->E.p);
+	mpz_mmod(job->Q.y, job->Q.y, job->E.p);
+	if(!P_is_on_E(job->P, job->E) || !P_is_on_E(job->Q, job->E))
+	{
+		*err = "P and Q must be on the curve";
+		return 1;
+	}
+	if(d < 0)
+	{
+		d = job->nb_bits / 4;
+	}
+	job->trailling_bits = d;
+	if(d < 1 || d >= job->nb_bits || job->level < 1 || job->level > 30 || job->nb_collisions < 1)
+	{
+		*err = "invalid d, l or c";
+		return 1;
+	}
+	if(job->time_limit < 0 || (time_limit > 0 && (job->time_limit == 0 || job->time_limit > time_limit)))
+	{
+		*err = "invalid T, the time limit of the daemon is the largest one";
+		return 1;
+	}
+	if(job->type_struct == 0 && job->level > job->nb_bits - job->trailling_bits)
+	{
+		*err = "l can not be greater than f - d, the length of a word stored in PRTL";
+		return 1;
+	}
+	max_bits = __DATA_SIZE_IN_BYTES__ * 8;
+	if(job->type_struct == 0 && (unsigned int)(2 * job->nb_bits - job->trailling_bits - job->level) > max_bits)
+	{
+		*err = "curve too large for PRTL, use s=hash_unix";
+		return 1;
+	}
+	return 0;
+}
+
+/** Find a cached context for a job, or create one.
+ *
+ * 	@brief A context is reused if it has the same curve, point P and
+ * 	storage settings. Its storage is then reset in place and only the M
+ * 	table is recomputed for the new Q. Otherwise the least recently used
+ * 	context is destroyed and replaced.
+ *
+ * 	@param[out]	cached	1 if the context was reused, 0 otherwise.
+ */
+pcs_ctx_t *get_context(daemon_t *daemon, job_t *job, int *cached)
+{
+	int i, lru = 0;
+	pcs_ctx_t *ctx;
+	mpz_t A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	for(i = 0; i < daemon->cache_size; i++)
+	{
+		ctx = daemon->cache[i].ctx;
+		if(ctx != NULL && ctx->storage.type == job->type_struct && daemon->cache[i].level == job->level
+			&& ctx->nb_bits == job->nb_bits && ctx->trailling_bits == job->trailling_bits
+			&& mpz_cmp(ctx->E.p, job->E.p) == 0 && mpz_cmp(ctx->E.A, job->E.A) == 0
+			&& mpz_cmp(ctx->E.B, job->E.B) == 0 && mpz_cmp(ctx->n, job->n) == 0 && equal(ctx->P, job->P))
+		{
+			pcs_reset(ctx, job->P, job->Q);
+			daemon->cache[i].last_use = ++daemon->nb_jobs;
+			daemon->cache[i].nb_jobs++;
+			*cached = 1;
+			return ctx;
+		}
+		if(daemon->cache[lru].ctx != NULL && (ctx == NULL || daemon->cache[i].last_use < daemon->cache[lru].last_use))
+		{
+			lru = i;
+		}
+	}
+	if(daemon->cache[lru].ctx != NULL)
+	{
+		pcs_destroy(daemon->cache[lru].ctx);
+	}
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_inits(A[i], B[i], NULL);
+		mpz_urandomm(A[i], daemon->r_state, job->n);
+		mpz_urandomm(B[i], daemon->r_state, job->n);
+	}
+	daemon->cache[lru].ctx = pcs_create(job->P, job->Q, job->E, &pcs_group_ec, job->n, A, B, job->nb_bits, job->trailling_bits, job->type_struct, daemon->nb_threads, job->level);
+	daemon->cache[lru].level = job->level;
+	daemon->cache[lru].last_use = ++daemon->nb_jobs;
+	daemon->cache[lru].nb_jobs = 1;
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_clears(A[i], B[i], NULL);
+	}
+	*cached = 0;
+	return daemon->cache[lru].ctx;
+}
+
+/** Set the stop flag of a job once its time limit is reached, unless the job is done before.
+ *
+ */
+void *job_timer(void *arg)
+{
+	job_timer_t *timer = (job_timer_t *)arg;
+	struct timespec deadline;
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += timer->seconds;
+	pthread_mutex_lock(&timer->lock);
+	while(!timer->done)
+	{
+		if(pthread_cond_timedwait(&timer->cond, &timer->lock, &deadline) == ETIMEDOUT)
+		{
+			timer->stop = 1;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&timer->lock);
+	return NULL;
+}
+
+/** Solve a job and write the reply.
+ *
+ *	@brief The run is stopped through ctx->stop once the time limit of
+ *	the job is reached, and the reply is then an error line.
+ */
+void solve_job(daemon_t *daemon, char *line, FILE *out)
+{
+	job_t job;
+	pcs_ctx_t *ctx;
+	const char *err = NULL;
+	mpz_t x;
+	point_t R;
+	unsigned long long int time1, time_setup, time_run, memory;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots = 0.0;
+	int cached, verified, nb_found;
+	job_timer_t timer;
+	pthread_t thread;
+
+	curve_init(&job.E);
+	point_init(&job.P);
+	point_init(&job.Q);
+	point_init(&R);
+	mpz_inits(job.n, x, NULL);
+
+	if(parse_job(&job, line, daemon->time_limit, &err))
+	{
+		fprintf(out, "error %s\n", err);
+	}
+	else
+	{
+		fprintf(out, "accepted %llu f=%d d=%d l=%d s=%s\n", daemon->nb_jobs + 1, job.nb_bits, job.trailling_bits, job.level, struct_i_str[job.type_struct]);
+		fflush(out);
+
+		time1 = now_us();
+		ctx = get_context(daemon, &job, &cached);
+		time_setup = now_us() - time1;
+
+		timer.stop = 0;
+		timer.seconds = job.time_limit;
+		timer.done = 0;
+		pthread_mutex_init(&timer.lock, NULL);
+		pthread_cond_init(&timer.cond, NULL);
+		if(job.time_limit > 0)
+		{
+			ctx->stop = &timer.stop;
+			pthread_create(&thread, NULL, job_timer, &timer);
+		}
+		time1 = now_us();
+		nb_found = pcs_run(ctx, x, job.nb_collisions);
+		time_run = now_us() - time1;
+		if(job.time_limit > 0)
+		{
+			pthread_mutex_lock(&timer.lock);
+			timer.done = 1;
+			pthread_cond_signal(&timer.cond);
+			pthread_mutex_unlock(&timer.lock);
+			pthread_join(thread, NULL);
+			ctx->stop = NULL;
+		}
+		pthread_mutex_destroy(&timer.lock);
+		pthread_cond_destroy(&timer.cond);
+
+		if(nb_found < job.nb_collisions)
+		{
+			fprintf(out, "error time limit of %d seconds reached after %llu steps\n", job.time_limit, pcs_steps(ctx));
+		}
+		else
+		{
+			memory = pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+			double_and_add(&R, job.P, x, job.E);
+			verified = equal(R, job.Q);
+			gmp_fprintf(out, "result x=%Zd verified=%d\n", x, verified);
+			fprintf(out, "stats time=%llu setup=%llu cached=%d memory=%llu points=%lu rate=%.2f\n", time_run, time_setup, cached, memory, nb_points, rate_of_use);
+			fprintf(out, "end\n");
+		}
+	}
+	fflush(out);
+
+	curve_clear(&job.E);
+	point_clear(&job.P);
+	point_clear(&job.Q);
+	point_clear(&R);
+	mpz_clears(job.n, x, NULL);
+}
+
+/** Write the list of the cached contexts.
+ *
+ */
+void print_stats(daemon_t *daemon, FILE *out)
+{
+	int i;
+	unsigned long long int memory;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	pcs_ctx_t *ctx;
+	for(i = 0; i < daemon->cache_size; i++)
+	{
+		ctx = daemon->cache[i].ctx;
+		if(ctx != NULL)
+		{
+			memory = pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+			gmp_fprintf(out, "context %d p=%Zd Px=%Zd d=%d l=%d s=%s jobs=%lu memory=%llu\n", i, ctx->E.p, ctx->P.x, ctx->trailling_bits, daemon->cache[i].level, struct_i_str[ctx->storage.type], daemon->cache[i].nb_jobs, memory);
+		}
+	}
+	fprintf(out, "end\n");
+	fflush(out);
+}
+
+/** Serve the jobs of one connection, until it is closed.
+ *
+ * 	@return 	1 if the daemon must shut down, 0 otherwise.
+ */
+int serve_connection(daemon_t *daemon, int fd)
+{
+	FILE *in, *out;
+	char line[__JOB_LINE_SIZE__];
+	char *command;
+	int shutdown = 0;
+	in = fdopen(fd, "r");
+	out = fdopen(dup(fd), "w");
+	if(in == NULL || out == NULL)
+	{
+		fprintf(stderr, "Can not open connection streams.\n");
+		exit(1);
+	}
+	while(!shutdown && fgets(line, __JOB_LINE_SIZE__, in) != NULL)
+	{
+		command = line + strspn(line, " \t");
+		if(strncmp(command, "solve", 5) == 0 && (command[5] == ' ' || command[5] == '\t'))
+		{
+			solve_job(daemon, command + 5, out);
+		}
+		else if(strncmp(command, "stats", 5) == 0)
+		{
+			print_stats(daemon, out);
+		}
+		else if(strncmp(command, "shutdown", 8) == 0)
+		{
+			fprintf(out, "bye\n");
+			shutdown = 1;
+		}
+		else if(command[strspn(command, " \t\r\n")] != '\0')
+		{
+			fprintf(out, "error unknown command\n");
+		}
+		fflush(out);
+	}
+	fclose(out);
+	fclose(in);
+	return shutdown;
+}
+
+/** Run the daemon.
+ *
+ */
+void run_server(char *socket_path, int nb_threads, int cache_size, int time_limit)
+{
+	daemon_t daemon;
+	struct sockaddr_un addr;
+	int fd_listen, fd, i, shutdown = 0;
+
+	daemon.cache = calloc(cache_size, sizeof(daemon_slot_t));
+	daemon.cache_size = cache_size;
+	daemon.nb_threads = nb_threads;
+	daemon.time_limit = time_limit;
+	daemon.nb_jobs = 0;
+	gmp_randinit_default(daemon.r_state);
+	gmp_randseed_ui(daemon.r_state, (unsigned long int)time(NULL) ^ ((unsigned long int)getpid() << 16));
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(strlen(socket_path) >= sizeof(addr.sun_path))
+	{
+		fprintf(stderr, "Socket path too long.\n");
+		exit(1);
+	}
+	strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+	fd_listen = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(socket_path);
+	if(fd_listen < 0 || bind(fd_listen, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd_listen, 16) < 0)
+	{
+		fprintf(stderr, "Can not listen on socket %s.\n", socket_path);
+		exit(1);
+	}
+	//A client closing its connection early must not kill the daemon
+	signal(SIGPIPE, SIG_IGN);
+
+	//Start the OpenMP threads now, so that the first job does not pay for it
+	#pragma omp parallel num_threads(nb_threads)
+	{
+		if(!preallocation_init_done)
+		{
+			preallocation_init();
+		}
+	}
+	printf("Listening on %s with %d threads\n", socket_path, nb_threads);
+	fflush(stdout);
+
+	while(!shutdown)
+	{
+		fd = accept(fd_listen, NULL, NULL);
+		if(fd < 0)
+		{
+			continue;
+		}
+		shutdown = serve_connection(&daemon, fd);
+	}
+	close(fd_listen);
+	unlink(socket_path);
+
+	for(i = 0; i < cache_size; i++)
+	{
+		if(daemon.cache[i].ctx != NULL)
+		{
+			pcs_destroy(daemon.cache[i].ctx);
+		}
+	}
+	free(daemon.cache);
+	gmp_randclear(daemon.r_state);
+}
+
+/** Send the jobs read on stdin to a daemon and print out the replies.
+ *
+ */
+void run_client(char *socket_path)
+{
+	struct sockaddr_un addr;
+	FILE *in, *out;
+	char line[__JOB_LINE_SIZE__];
+	char reply[__JOB_LINE_SIZE__];
+	int fd, done;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path) - 1);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		fprintf(stderr, "Can not connect to socket %s.\n", socket_path);
+		exit(1);
+	}
+	in = fdopen(fd, "r");
+	out = fdopen(dup(fd), "w");
+	while(fgets(line, __JOB_LINE_SIZE__, stdin) != NULL)
+	{
+		if(line[strspn(line, " \t\r\n")] == '\0')
+		{
+			continue;
+		}
+		fputs(line, out);
+		fflush(out);
+		done = 0;
+		while(!done && fgets(reply, __JOB_LINE_SIZE__, in) != NULL)
+		{
+			fputs(reply, stdout);
+			done = (strncmp(reply, "end", 3) == 0 || strncmp(reply, "error", 5) == 0 || strncmp(reply, "bye", 3) == 0);
+		}
+		fflush(stdout);
+		if(!done)
+		{
+			fprintf(stderr, "Connection closed by the daemon.\n");
+			exit(1);
+		}
+	}
+	fclose(out);
+	fclose(in);
+}
+
+int main(int argc,char * argv[])
+{
+	char *socket_path = __DEFAULT_SOCKET_PATH__;
+	int option;
+	int client = 0;
+	int nb_threads = omp_get_num_procs();
+	int cache_size = __DEFAULT_CACHE_SIZE__;
+	int time_limit = __DEFAULT_TIME_LIMIT__;
+
+	while ((option = getopt(argc, argv, "S:C:t:k:T:h")) != -1) {
+		switch (option) {
+			case 'S' : socket_path = optarg;
+				client = 0;
+				break;
+			case 'C' : socket_path = optarg;
+				client = 1;
+				break;
+			case 't' : nb_threads = atoi(optarg);
+				break;
+			case 'k' : cache_size = atoi(optarg);
+				break;
+			case 'T' : time_limit = atoi(optarg);
+				break;
+			case 'h' : print_usage();
+				exit(0);
+			default: print_usage();
+				exit(1);
+		}
+	}
+	if(nb_threads < 1 || cache_size < 1 || time_limit < 0)
+	{
+		print_usage();
+		exit(1);
+	}
+	if(client)
+	{
+		run_client(socket_path);
+	}
+	else
+	{
+		run_server(socket_path, nb_threads, cache_size, time_limit);
+		preallocation_clear();
+	}
+	return 0;
+}
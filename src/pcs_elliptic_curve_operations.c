@@ -11,72 +11,78 @@
 #include<gmp.h>
 #include<omp.h>
 #include<assert.h>
+#include<pthread.h>
 #include "pcs_elliptic_curve_operations.h"
+#include "pcs_binary.h"
 
 /*** BEGIN: Preallocation for GMP objects*/
-char preallocation_init_done = 0;
-mpz_t** temp_obj;
-point_t** temp_point;
-static int nb_threads = 0;
+/* The temp objects are thread-local, so that the functions using them can be 
+ * called at the same time by different solves, in any team of threads. */
+__thread char preallocation_init_done = 0;
+__thread mpz_t *temp_obj;
+__thread point_t *temp_point;
+static pthread_key_t preallocation_key;
+static pthread_once_t preallocation_key_once = PTHREAD_ONCE_INIT;
 
-/** Set number of threads used for this execution.
+/** Destructor of the thread-specific key, called when a thread exits.
  *
  */
-void set_nb_threads(int nb_t)
+static void preallocation_destroy(void *temp)
 {
-	nb_threads = nb_t;
+	(void) temp;
+	preallocation_clear();
 }
 
-/** Allocates the temp objects that are used in all functions.
+/** Creates the thread-specific key used to clear the temp objects at thread exit.
+ *
+ */
+static void preallocation_key_init(void)
+{
+	pthread_key_create(&preallocation_key, preallocation_destroy);
+}
+
+/** Allocates the temp objects of the calling thread.
  *
  */
 void preallocation_init()
 {
-	int i, j;
-	assert(nb_threads > 0 && "Number of threads is not set");
-	temp_obj = (mpz_t **) malloc(sizeof(mpz_t *) * nb_threads);
-	temp_point = (point_t **) malloc(sizeof(point_t *) * nb_threads);
-	for(j = 0; j < nb_threads; j++)
+	int i;
+	temp_obj = (mpz_t *) malloc(sizeof(mpz_t) * __NB_TEMP_MPZ_OBJ__);
+	for(i = 0; i < __NB_TEMP_MPZ_OBJ__; i++)
 	{
-		temp_obj[j] = (mpz_t *) malloc(sizeof(mpz_t) * __NB_TEMP_MPZ_OBJ__);
-		for(i = 0; i < __NB_TEMP_MPZ_OBJ__; i++)
-		{
-			mpz_init(temp_obj[j][i]);
-		}
+		mpz_init(temp_obj[i]);
 	}
-	for(j = 0; j < nb_threads; j++)
+	temp_point = (point_t *) malloc(sizeof(point_t) * __NB_TEMP_POINTS__);
+	for(i = 0; i < __NB_TEMP_POINTS__; i++)
 	{
-		temp_point[j] = (point_t *) malloc(sizeof(point_t) * __NB_TEMP_POINTS__);
-		for(i = 0; i < __NB_TEMP_POINTS__; i++)
-		{
-			point_init(&temp_point[j][i]);
-		}
+		point_init(&temp_point[i]);
 	}
+	pthread_once(&preallocation_key_once, preallocation_key_init);
+	pthread_setspecific(preallocation_key, temp_obj);
 	preallocation_init_done = 1;
 }
 
-/** Clears the temp objects that are used in all functions.
+/** Clears the temp objects of the calling thread.
  *
  */
 void preallocation_clear()
 {
-	int i, j;
-	for(j = 0; j < nb_threads; j++)
+	int i;
+	if(!preallocation_init_done)
 	{
-		for(i = 0; i < __NB_TEMP_MPZ_OBJ__; i++)
-		{
-			mpz_clear(temp_obj[j][i]);
-		}
+		return;
 	}
-	for(j = 0; j < nb_threads; j++)
+	for(i = 0; i < __NB_TEMP_MPZ_OBJ__; i++)
 	{
-		for(i = 0; i < __NB_TEMP_POINTS__; i++)
-		{
-			point_clear(&temp_point[j][i]);
-		}
+		mpz_clear(temp_obj[i]);
+	}
+	for(i = 0; i < __NB_TEMP_POINTS__; i++)
+	{
+		point_clear(&temp_point[i]);
 	}
 	free(temp_obj);
 	free(temp_point);
+	pthread_setspecific(preallocation_key, NULL);
 	preallocation_init_done = 0;
 }
 
@@ -91,13 +97,14 @@ void point_init(point_t *P)
 	mpz_inits(P->x, P->y, P->z, NULL);
 }
 
-/** Initializes a curve.
+/** Initializes a curve, over a prime field until its field is set.
  *
  * 	@param[in,out]	E	The curve to be initialized.
  */
 void curve_init(elliptic_curve_t *E)
 {
 	mpz_inits(E->A, E->B, E->p, NULL);
+	E->field = __CURVE_FIELD_PRIME__;
 }
 
 /** Clears a point structure.
@@ -153,6 +160,7 @@ void curve_to_string(elliptic_curve_t E)
 }
 
 /** Checks if the structure repsents a nonsingular elliptic curve of the form y^2 = x^3 + Ax + B.
+ *	A binary curve y^2 + xy = x^3 + Ax^2 + B is nonsingular when B is not 0.
  *
  * 	@param[in]	E	The curve to be checked.
  * 	@return 	Returns 1 for yes and 0 for no.
@@ -161,6 +169,10 @@ int is_elliptic_curve(elliptic_curve_t E)
 {
 	int result;
 	mpz_t discriminant, k1, k2;
+	if(E.field == __CURVE_FIELD_BINARY__)
+	{
+		return mpz_sgn(E.B) != 0;
+	}
 	mpz_init(discriminant);
 	//discriminant=4*pow(A,3)+27*pow(B,2);
 	mpz_init(k1);
@@ -197,6 +209,10 @@ int P_is_on_E(point_t P, elliptic_curve_t E)
 			return 1;
 		}
 	}
+	if(E.field == __CURVE_FIELD_BINARY__)
+	{
+		return binary_on_curve(P, E);
+	}
 	
 	mpz_t left, right, sub_right;
 	mpz_init(left);
@@ -246,16 +262,20 @@ int add(point_t *P3, point_t P1, point_t P2, elliptic_curve_t E)
 	{
 		mpz_set(P3->x, P2.x);
 		mpz_set(P3->y, P2.y);
-		mpz_set_ui(P3->z, 1);
+		mpz_set(P3->z, P2.z);
 		return 0;
 	}
 	if(mpz_get_ui(P2.z) != 1)
 	{
 		mpz_set(P3->x, P1.x);
 		mpz_set(P3->y, P1.y);
-		mpz_set_ui(P3->z, 1);
+		mpz_set(P3->z, P1.z);
 		return 0;
 	}
+	if(E.field == __CURVE_FIELD_BINARY__)
+	{
+		return binary_add(P3, P1, P2, E);
+	}
 	
 	//Other cases
 	mpz_t *l, *up, *down, *v, *up_bis, *x3, *y3;
@@ -263,13 +283,13 @@ int add(point_t *P3, point_t P1, point_t P2, elliptic_curve_t E)
 	{
 		preallocation_init();
 	}
-	l = &(temp_obj[omp_get_thread_num()][0]);
-	up = &(temp_obj[omp_get_thread_num()][1]);
-	down = &(temp_obj[omp_get_thread_num()][2]);
-	v = &(temp_obj[omp_get_thread_num()][3]);
-	up_bis = &(temp_obj[omp_get_thread_num()][4]);
-	x3 = &(temp_obj[omp_get_thread_num()][5]);
-	y3 = &(temp_obj[omp_get_thread_num()][6]);
+	l = &(temp_obj[0]);
+	up = &(temp_obj[1]);
+	down = &(temp_obj[2]);
+	v = &(temp_obj[3]);
+	up_bis = &(temp_obj[4]);
+	x3 = &(temp_obj[5]);
+	y3 = &(temp_obj[6]);
 	
 	if(equal(P1, P2))
 	{
@@ -380,9 +400,9 @@ int double_and_add(point_t *R, point_t P, mpz_t s, elliptic_curve_t E)
 	{
 		preallocation_init();
 	}
-	remainder = &(temp_obj[omp_get_thread_num()][7]);
-	s_cpy = &(temp_obj[omp_get_thread_num()][8]);
-	temp = &(temp_point[omp_get_thread_num()][0]);
+	remainder = &(temp_obj[7]);
+	s_cpy = &(temp_obj[8]);
+	temp = &(temp_point[0]);
 	mpz_set(*s_cpy, s);
 	mpz_set(temp->x, P.x);
 	mpz_set(temp->y, P.y);
@@ -3,6 +3,8 @@
  *	Created by Monika Trimoska on 03/12/2015.
  *	Copyright © 2015 Monika Trimoska. All rights reserved.
  */
+#ifndef PCS_ELLIPTIC_CURVE_OPERATIONS_H
+#define PCS_ELLIPTIC_CURVE_OPERATIONS_H
 #include<gmp.h>
 
 /** Elliptic curve point structure
@@ -14,23 +16,28 @@ typedef struct
 	mpz_t z;
 }point_t;
 
+#define __CURVE_FIELD_PRIME__ 0
+#define __CURVE_FIELD_BINARY__ 1
+
 /** Elliptic curve structure
  *  @brief Elliptic curve defined by an equation of the form y^2 = x^3 + Ax + B
+ *  over GF(p), or y^2 + xy = x^3 + Ax^2 + B over GF(2^m) when field is
+ *  __CURVE_FIELD_BINARY__, p being then the reduction polynomial, see pcs_binary.h
  */
 typedef struct
 {
 	mpz_t A;
 	mpz_t B;
 	mpz_t p;
+	int field;
 }elliptic_curve_t;
 
-#define __NB_TEMP_MPZ_OBJ__ 18
-#define __NB_TEMP_POINTS__ 5
-extern char preallocation_init_done;
-extern mpz_t** temp_obj;
-extern point_t** temp_point;
+#define __NB_TEMP_MPZ_OBJ__ 20
+#define __NB_TEMP_POINTS__ 6
+extern __thread char preallocation_init_done;
+extern __thread mpz_t *temp_obj;
+extern __thread point_t *temp_point;
 
-void set_nb_threads(int nb_t);
 void preallocation_init(void);
 void preallocation_clear(void);
 void point_init(point_t *P);
@@ -46,3 +53,4 @@ int equal(point_t P1, point_t P2);
 int add(point_t *P3, point_t P1, point_t P2, elliptic_curve_t E);
 int _double(point_t * R, point_t P, elliptic_curve_t E);
 int double_and_add(point_t *R, point_t P, mpz_t s, elliptic_curve_t E);
+#endif
@@ -1,6 +1,9 @@
 /** @file pcs_exec.c
  *  @brief The main execution file. Contains code for experiments management. 
  *
+ *	The options are checked against the table of the modes, and the
+ *	chosen mode is run by its driver in a pcs_exec_*.c file.
+ *
  *	Created by Monika Trimoska on 03/12/2015.
  *	Copyright © 2015 Monika Trimoska. All rights reserved.
  */
@@ -9,37 +12,123 @@
 #include <omp.h>
 #include <inttypes.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <sys/time.h>
 #include <time.h>
 #include "pcs_elliptic_curve_operations.h"
-#include "pcs_pollard_rho.h"
-#include "pcs_storage.h"
 #include "pcs.h"
+#include "pcs_lanes.h"
+#include "pcs_orbit.h"
+#include "pcs_limbs.h"
+#include "pcs_binary.h"
+#include "pcs_group.h"
+#include "pcs_field.h"
+#include "pcs_collide.h"
+#include "pcs_curves.h"
+#include "pcs_struct_shm.h"
+#include "pcs_struct_net.h"
+#include "pcs_struct_frozen.h"
+#include "pcs_struct_fingerprint.h"
 #include "pcs_vect_bin.h"
+#include "pcs_exec.h"
+
+#define __MIN_TRAILS_PER_THREAD__ 64
+#define __DEFAULT_CHECKPOINT_INTERVAL__ 600
+
+/* Codes of the long options, out of the range of the short ones */
+#define __OPT_CHECKPOINT__ 256
+#define __OPT_CHECKPOINT_INTERVAL__ 257
+#define __OPT_RESUME__ 258
+#define __OPT_SHM_CREATE__ 259
+#define __OPT_SHM_ATTACH__ 260
+#define __OPT_SHM_POINTS__ 261
+#define __OPT_TCP_LISTEN__ 262
+#define __OPT_TCP_CONNECT__ 263
+#define __OPT_BATCH__ 264
+#define __OPT_COMPRESS__ 265
+#define __OPT_TARGETS__ 266
+#define __OPT_PRECOMPUTE__ 267
+#define __OPT_TABLE_SIZE__ 268
+#define __OPT_TABLE__ 269
+#define __OPT_FREEZE__ 270
+#define __OPT_FROZEN_CHECK__ 271
+#define __OPT_KANGAROO__ 272
+#define __OPT_INTERVAL_LOW__ 273
+#define __OPT_INTERVAL_HIGH__ 274
+#define __OPT_GAUDRY_SCHOST__ 275
+#define __OPT_BOX_BASE__ 276
+#define __OPT_BOX_WIDTH__ 277
+#define __OPT_BOX_HEIGHT__ 278
+#define __OPT_BOX_LAMBDA__ 279
+#define __OPT_POHLIG_HELLMAN__ 280
+#define __OPT_J_INVARIANT__ 281
+#define __OPT_NO_ORBIT__ 282
+#define __OPT_LEAN_STEP__ 283
+#define __OPT_LANES__ 284
+#define __OPT_LIMBS_STEP__ 285
+#define __OPT_BINARY__ 286
+#define __OPT_FP__ 287
+#define __OPT_COLLIDE__ 288
+#define __OPT_GOLDEN__ 289
+#define __OPT_VERSION_POINTS__ 290
+#define __OPT_ADAPTIVE_D__ 291
+#define __OPT_FINGERPRINT__ 292
+
+/* Modes of a run, at most one of them chosen on the command line */
+#define __MODE_TESTS__ 0
+#define __MODE_FINGERPRINT__ 1
+#define __MODE_TARGETS__ 2
+#define __MODE_PRECOMPUTE__ 3
+#define __MODE_TABLE__ 4
+#define __MODE_KANGAROO__ 5
+#define __MODE_GAUDRY_SCHOST__ 6
+#define __MODE_POHLIG_HELLMAN__ 7
+#define __MODE_COLLIDE__ 8
+#define __MODE_SHM_CREATE__ 9
+#define __MODE_SHM_ATTACH__ 10
+#define __MODE_TCP_LISTEN__ 11
+#define __MODE_TCP_CONNECT__ 12
+#define __MODE_RESUME__ 13
+#define __MODE_FROZEN_CHECK__ 14
+#define __NB_MODES__ 15
 
-#define RESULTS_PATH "./results/"
-#define __NB_STRUCTURES__ 2
+/* Options a mode may accept, each one a bit of a mask */
+#define __USE_GROUPS__ 0
+#define __USE_STRUCTS__ 1
+#define __USE_CHECKPOINT__ 2
+#define __USE_FREEZE__ 3
+#define __USE_J_INVARIANT__ 4
+#define __USE_STEP__ 5
+#define __USE_BINARY__ 6
+#define __USE_FP__ 7
+#define __USE_ADAPTIVE__ 8
+#define __USE_INTERVAL__ 9
+#define __USE_BOX__ 10
+#define __USE_GOLDEN__ 11
+#define __USE_SHM_POINTS__ 12
+#define __USE_TABLE_SIZE__ 13
+#define __USE_BATCH__ 14
+#define __NB_USES__ 15
+#define __BIT__(i) (1 << (i))
 
 /** Generates random number of EXACTLY nb_bits bits stored as an mpz_t type.
+ * 	
+ * 	@brief The number is reduced modulo n when it is not below it, which
+ * 	happens on the binary curves, whose n is smaller than the field.
  * 	
  * 	@param[out]	s			Will hold the resulting number.
  * 	@param[in]	nb_bits		The number of bits (size of the number). 
+ * 	@param[in]	n			The order of the points.
+ * 	@param[in]	r_state		The random state of the calling test group.
  */
-void generate_random_key(mpz_t s, int nb_bits)
+void generate_random_key(mpz_t s, int nb_bits, mpz_t n, gmp_randstate_t r_state)
 {
-	time_t t;
 	mpz_t min;
 	mpz_t max;
 	mpz_t interval;
-	unsigned long int seed;
-	gmp_randstate_t r_state;
-	srand((unsigned) time(&t));
-	seed = rand();
-	gmp_randinit_default(r_state);
-	gmp_randseed_ui(r_state, seed);
 	
 	mpz_inits(min, max, interval, NULL);
 	mpz_ui_pow_ui(min, 2, (nb_bits - 1));
@@ -51,8 +140,33 @@ void generate_random_key(mpz_t s, int nb_bits)
 	{
 		mpz_add(s, s, interval);
 	}
+	if(mpz_cmp(s, n) >= 0)
+	{
+		mpz_mod(s, s, n);
+	}
 	mpz_clears(min, max, interval, NULL);
-	gmp_randclear(r_state);
+}
+
+/** Draw a seed for the random keys of the tests.
+ *
+ *	@brief From /dev/urandom, so that the tests of processes started in
+ *	the same second are independent, or from the time, the process and
+ *	salt if it can not be read.
+ */
+unsigned long int random_seed(unsigned long int salt)
+{
+	unsigned long int seed;
+	FILE *f = fopen("/dev/urandom", "rb");
+	if(f != NULL)
+	{
+		if(fread(&seed, sizeof(seed), 1, f) == 1)
+		{
+			fclose(f);
+			return seed ^ salt;
+		}
+		fclose(f);
+	}
+	return (unsigned long int)time(NULL) ^ ((unsigned long int)getpid() << 16) ^ (salt << 40);
 }
 
 /** Generates 20 sets for the adding walks.
@@ -75,10 +189,48 @@ void generate_adding_sets(mpz_t A[20], mpz_t B[20], mpz_t max)
 	gmp_randclear(r_state);
 }
 
+/** Chooses the number of threads of a test group.
+ * 
+ * 	@brief At the end of a run, each thread has walked on average 2^d 
+ * 	steps on a trail that will never be stored. A group gets as many threads
+ * 	as possible while each thread is still expected to complete at least
+ * 	__MIN_TRAILS_PER_THREAD__ trails out of the sqrt(pi*n/2) expected steps.
+ * 
+ * 	@param[in]	n				The group order.
+ * 	@param[in]	trailling_bits	Number of trailling zero bits in a distinguished point.
+ * 	@param[in]	nb_threads		Total number of threads.
+ * 	@return		The number of threads of a group.
+ */
+int group_nb_threads(mpz_t n, uint8_t trailling_bits, int nb_threads)
+{
+	mpz_t work;
+	int group_threads;
+	mpz_init(work);
+	mpz_mul_ui(work, n, __PI_NUMERATOR__);
+	mpz_tdiv_q_ui(work, work, 2 * __PI_DENOMINATOR__);
+	mpz_sqrt(work, work);
+	mpz_tdiv_q_2exp(work, work, trailling_bits);
+	mpz_tdiv_q_ui(work, work, __MIN_TRAILS_PER_THREAD__);
+	if(mpz_cmp_ui(work, nb_threads) >= 0)
+	{
+		group_threads = nb_threads;
+	}
+	else
+	{
+		group_threads = mpz_get_ui(work);
+	}
+	if(group_threads < 1)
+	{
+		group_threads = 1;
+	}
+	mpz_clear(work);
+	return group_threads;
+}
+
 /** Print out executable usage.
  */
 void print_usage() {
-    printf("Usage: \n-f : choose an f-bit elliptic curve (default is 35 and currently possible values are 5k with k=7,...,23)\n-t : number of threads to use (default is the number of cores avaliable)\n-n : number of runs with different random secret keys (default is 10)\n-s : storage structure (PRTL - default or hash_unix)\n-l : level of the absract radix tree (default is 7 - see paper on how to choose this optimally)\n-d : number of trailling zero bits in a distinguished point (default is floor(f/4))\n-c : number of collisions that need to be found (default is one - for solving the ECDLP)\n");
+    printf("Usage: \n-f : choose an f-bit elliptic curve (default is 35 and currently possible values are 5k with k=7,...,23, and 128, 160, 192, 224 and 255)\n-t : number of threads to use (default is the number of cores avaliable)\n-n : number of runs with different random secret keys (default is 10)\n-s : storage structure (PRTL - default or hash_unix)\n-l : level of the absract radix tree (default is 7 - see paper on how to choose this optimally)\n-d : number of trailling zero bits in a distinguished point (default is floor(f/4))\n-c : number of collisions that need to be found (default is one - for solving the ECDLP)\n-g : number of tests run concurrently, each by its own group of threads (default is 1, 0 chooses it from the expected work)\n--checkpoint FILE : write a checkpoint of the running solve to FILE periodically\n--checkpoint-interval SEC : time between two checkpoints, in seconds (default is %d)\n--resume FILE : resume the solve saved in the checkpoint FILE, with -t threads and -c collisions, and go on writing checkpoints to FILE unless --checkpoint is given\n--shm-create NAME : coordinate the tests through a store in the shared memory segment NAME, fed by this process and by the ones started with --shm-attach NAME\n--shm-attach NAME : work on the tests of the coordinator of the shared memory segment NAME, with -t threads, until it exits\n--shm-points N : number of points the shared store can hold (default is four times the expected number of distinguished points)\n--tcp-listen PORT : coordinate the tests as a TCP server on PORT, storing the points sent by the workers started with --tcp-connect in the first chosen structure\n--tcp-connect HOST:PORT : work on the tests of the coordinator at HOST:PORT, with -t threads, until it exits\n--batch N : number of distinguished points a worker sends in one frame (default is %d)\n--compress : send the distinguished points sorted and delta-encoded\n--targets K : solve K targets per test on the same point, keeping the distinguished points from one target to the next, and report the time and steps of each target\n--precompute FILE : build a table of distinguished points of known logarithm for the curve and the point of the first test, and write it to FILE\n--table-size T : number of points of the table (default is the cube root of the order of P)\n--table FILE : solve the tests with the table FILE, on its point P\n--freeze FILE : write the distinguished points stored at the end of the last test to the read-only store FILE\n--frozen-check FILE : map the read-only store FILE and measure its lookups\n--kangaroo : solve the tests with the parallel kangaroo method, for keys drawn in an interval\n--interval-low L : lower bound of the interval of the keys (default is 2^(f-2))\n--interval-high H : upper bound of the interval of the keys (default is 2^(f-1) - 1, or n - 1 if less)\n--gaudry-schost : solve the tests with the Gaudry-Schost method, for keys base + i + j*lambda drawn in a box 0 <= i < width, 0 <= j < height\n--box-base X : base of the box (default is 2^(f-2))\n--box-width W : width of the box (default is 2^(f-4))\n--box-height H : height of the box (default is 1, for an interval)\n--box-lambda L : factor of j, needed if the height is more than 1\n--pohlig-hellman : solve the tests on the quadratic twist of the curve, whose order is composite, by solving in its prime power subgroups concurrently\n--j-invariant J : use the curves with j-invariant J, 0 or 1728, of the files curves_jJ and points_jJ, on which the walk works on the orbits of their automorphisms\n--no-orbit : walk on points on the curves with automorphisms of --j-invariant\n--lean-step : step with f_lean, which computes the next point with fewer operations, and check the distinguished points from the low bits of x only\n--lanes : walk many trails per thread in the lanes of vector registers, with one inversion for all of them\n--limbs-step : step on a fixed number of limbs, in Montgomery form (default above %d bits)\n--binary : use the curves over GF(2^f) of the files curves_binary and points_binary, whose points are added with carry-less multiplication\n--fp : solve the DLP in the subgroup of prime order (p-1)/2 of F_p^*, for the f-bit primes p of the files curves_fp and points_fp\n--collide NAME : search -c collisions per test of the f-bit function NAME instead of logarithms, sha256 (SHA-256 truncated to f bits) or cipher (candidate keys of a double encryption with keys of f-1 bits, by meet in the middle)\n--golden W : search the collision the predicate of the function accepts, the keys of the double encryption for cipher, with a table of W points and versions of the function\n--version-points N : number of distinguished points of a version of the function in the golden collision search (default is 10W)\n--adaptive-d N : start with -d trailling zero bits (default is floor(f/8)) and add one each time more than N points are stored, keeping the points that still qualify\n--fingerprint K : store the points in a table of K-bit fingerprints of x and their a coefficient, twice as large as the expected number of points, the false matches being told by the re-walk\n", __DEFAULT_CHECKPOINT_INTERVAL__, __NET_DEFAULT_BATCH__, __LIMBS_DEFAULT_BITS__);
 }
 
 /**	Add a structure to the list of structures to be used.
@@ -96,51 +248,509 @@ void add_to_struct_options(uint8_t structs[], char **struct_i_str, char *opt, ui
 	}
 }
 
-int main(int argc,char * argv[])
-{	
-	elliptic_curve_t E;
-	char str_A[4], str_B[4], str_p[40], str_large_prime[40], str_X[40],str_Y[40];
-	char *struct_i_str[] = {"PRTL", "hash_unix"};
-	point_t P;
-	point_t Q;
-	mpz_t large_prime;
-	mpz_t A[__NB_ENSEMBLES__];
-	mpz_t B[__NB_ENSEMBLES__];
-	FILE *file_res;
-	FILE *file_curves;
-	FILE *file_points;
+/** Update the lists of parameter values used in the experiments.
+ * 
+ * 	@brief These lists are read by the results/refresh_avg.sh script.
+ */
+void update_conf_files(uint8_t nb_bits, uint8_t structs[], char **struct_i_str, int nb_threads, uint8_t trailling_bits, uint8_t level)
+{
 	FILE *file_conf;
 	char conf_str[1000] = {0};
 	char conf_str_cpy[1000] = {0};
-	char *conf_value;
+	char *conf_value = NULL;
 	uint8_t update = 0;
+	uint8_t struct_i;
+	
+	/*** Update possible values of argument f (field/nb_bits) in experiments ***/
+	file_conf = fopen(RESULTS_PATH"conf_avg/f.conf","r");
+	if (file_conf == NULL) 
+	{
+		fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+		exit(1);
+	}
+	memset(conf_str, 0, 1000);
+	if(fgets(conf_str, 1000, file_conf) != NULL)
+	{
+		strncpy(conf_str_cpy, conf_str, 1000);
+		conf_value = strtok(conf_str_cpy, " ");
+	}
+	fclose(file_conf);
+	update = 1;
+	while(conf_value != NULL)
+	{
+		if(atoi(conf_value) == nb_bits)
+		{
+			update = 0;
+		}
+		conf_value = strtok(NULL, " ");
+	}
+	if(update)
+	{
+		file_conf=fopen(RESULTS_PATH"conf_avg/f.conf","w");
+		if (file_conf == NULL) 
+		{
+			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+			exit(1);
+		}
+		fprintf(file_conf, "%s %2" SCNu8, conf_str, nb_bits);
+		fclose(file_conf);
+	}
+	
+	/*** Update possible values of argument s (storage structure) in experiments ***/
+	for(struct_i = 0; struct_i < __NB_STRUCTURES__; struct_i++)
+	{
+		if(structs[struct_i] == 1)
+		{
+			file_conf = fopen(RESULTS_PATH"conf_avg/s.conf","r");
+			if (file_conf == NULL) 
+			{
+				fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+				exit(1);
+			}
+			memset(conf_str, 0, 1000);
+			if(fgets(conf_str, 1000, file_conf) != NULL)
+			{
+				strncpy(conf_str_cpy, conf_str, 1000);
+				conf_value = strtok(conf_str_cpy, " ");
+			}
+			fclose(file_conf);
+			update = 1;
+			while(conf_value != NULL)
+			{
+				if(strncmp(conf_value, struct_i_str[struct_i], strlen(conf_value)) == 0 && strlen(conf_value) == strlen(struct_i_str[struct_i]))
+				{
+					update = 0;
+				}
+				conf_value = strtok(NULL, " ");
+			}
+			if(update)
+			{
+				file_conf=fopen(RESULTS_PATH"conf_avg/s.conf","w");
+				if (file_conf == NULL) 
+				{
+					fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+					exit(1);
+				}
+				fprintf(file_conf, "%s %s", conf_str, struct_i_str[struct_i]);
+				fclose(file_conf);
+			}
+		}
+	}
+	
+	/*** Update possible values of argument t (thread number) in experiments ***/
+	file_conf = fopen(RESULTS_PATH"conf_avg/t.conf","r");
+	if (file_conf == NULL) 
+	{
+		fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+		exit(1);
+	}
+	memset(conf_str, 0, 1000);
+	if(fgets(conf_str, 1000, file_conf) != NULL)
+	{
+		strncpy(conf_str_cpy, conf_str, 1000);
+		conf_value = strtok(conf_str_cpy, " ");
+	}
+	fclose(file_conf);
+	update = 1;
+	while(conf_value != NULL)
+	{
+		if(atoi(conf_value) == nb_threads)
+		{
+			update = 0;
+		}
+		conf_value = strtok(NULL, " ");
+	}
+	if(update)
+	{
+		file_conf=fopen(RESULTS_PATH"conf_avg/t.conf","w");
+		if (file_conf == NULL) 
+		{
+			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+			exit(1);
+		}
+		fprintf(file_conf, "%s %d", conf_str, nb_threads);
+		fclose(file_conf);
+	}
+	
+	/*** Update possible values of argument d (number of trailling bits to zero) in experiments ***/
+	file_conf = fopen(RESULTS_PATH"conf_avg/theta.conf","r");
+	if (file_conf == NULL) 
+	{
+		fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+		exit(1);
+	}
+	memset(conf_str, 0, 1000);
+	if(fgets(conf_str, 1000, file_conf) != NULL)
+	{
+		strncpy(conf_str_cpy, conf_str, 1000);
+		conf_value = strtok(conf_str_cpy, " ");
+	}
+	fclose(file_conf);
+	update = 1;
+	while(conf_value != NULL)
+	{
+		if(atoi(conf_value) == trailling_bits)
+		{
+			update = 0;
+		}
+		conf_value = strtok(NULL, " ");
+	}
+	if(update)
+	{
+		file_conf=fopen(RESULTS_PATH"conf_avg/theta.conf","w");
+		if (file_conf == NULL) 
+		{
+			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+			exit(1);
+		}
+		fprintf(file_conf, "%s %2" SCNu8, conf_str, trailling_bits);
+		fclose(file_conf);
+	}
+	
+	/*** Update possible values of argument l (level of the abstract radix tree) in experiments ***/
+	file_conf = fopen(RESULTS_PATH"conf_avg/l.conf","r");
+	if (file_conf == NULL)
+	{
+		fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+		exit(1);
+	}
+	memset(conf_str, 0, 1000);
+	if(fgets(conf_str, 1000, file_conf) != NULL)
+	{
+		strncpy(conf_str_cpy, conf_str, 1000);
+		conf_value = strtok(conf_str_cpy, " ");
+	}
+	fclose(file_conf);
+	update = 1;
+	while(conf_value != NULL)
+	{
+		if(atoi(conf_value) == level)
+		{
+			update = 0;
+		}
+		conf_value = strtok(NULL, " ");
+	}
+	if(update)
+	{
+		file_conf=fopen(RESULTS_PATH"conf_avg/l.conf","w");
+		if (file_conf == NULL)
+		{
+			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+			exit(1);
+		}
+		fprintf(file_conf, "%s %2" SCNu8, conf_str, level);
+		fclose(file_conf);
+	}
+}
+
+/** Write one measurement of a test in a results file.
+ * 
+ */
+void write_result(char *file_name, experiment_t *exp, uint8_t struct_i, char *value)
+{
+	FILE *file_res;
+	char path[100];
+	snprintf(path, 100, RESULTS_PATH"%s", file_name);
+	file_res=fopen(path,"a");
+	if (file_res == NULL) 
+	{
+		fprintf(stderr, "Can not open file %s (see constant RESULTS_PATH in main.c)\n", file_name);
+		exit(1);
+	}
+	fprintf(file_res,"%d %s %d %d %"SCNu8" %s\n", exp->nb_bits, exp->struct_i_str[struct_i], exp->nb_threads, exp->trailling_bits, exp->level, value);
+	fclose(file_res);
+}
+
+/** Read the point P of a test in the file points.
+ * 
+ */
+void read_point(experiment_t *exp, int test_i, point_t *P)
+{
+	if(curves_read_point(exp->points_path, exp->nb_bits, test_i, P))
+	{
+		fprintf(stderr, "Can not read a point of the %d-bit curve in file %s.\n", exp->nb_bits, exp->points_path);
+		exit(1);
+	}
+}
+
+/** Write the storage structure of a context to a frozen store file.
+ * 
+ */
+void freeze_store(pcs_ctx_t *ctx, char *freeze_path)
+{
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time1, time2;
+	unsigned long int nb_points;
+	gettimeofday(&tv1,NULL);
+	if(pcs_freeze(ctx, freeze_path, &nb_points) != 0)
+	{
+		exit(1);
+	}
+	gettimeofday(&tv2, NULL);
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	printf("Froze %lu points to %s in %llu microseconds.\n", nb_points, freeze_path, time2 - time1);
+}
+
+/** Get the name of the step a context walks with, for the results files.
+ * 
+ */
+const char *step_name(pcs_ctx_t *ctx)
+{
+	if(ctx->step_type == __STEP_LANES__ && lanes_supported(ctx))
+	{
+		return "lanes";
+	}
+	if(ctx->step_type == __STEP_LIMBS__ && limbs_supported(ctx))
+	{
+		return "limbs";
+	}
+	return (ctx->step_type == __STEP_ADD__) ? "add" : "lean";
+}
+
+/** Check if a context walks on the same curve with the same adding sets.
+ * 
+ * 	@return 	1 if the context can be reset for the new problem, 0 otherwise.
+ */
+int same_walk(pcs_ctx_t *ctx, elliptic_curve_t E, mpz_t n, mpz_t *A, mpz_t *B)
+{
+	int j;
+	int same = (ctx->E.field == E.field && mpz_cmp(ctx->E.p, E.p) == 0 && mpz_cmp(ctx->E.A, E.A) == 0 && mpz_cmp(ctx->E.B, E.B) == 0 && mpz_cmp(ctx->n, n) == 0);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		same = same && mpz_cmp(ctx->A[j], A[j]) == 0 && mpz_cmp(ctx->B[j], B[j]) == 0;
+	}
+	return same;
+}
+
+/** Get the default size of a shared store.
+ * 
+ * 	@return 	Four times the expected number of distinguished points.
+ */
+unsigned long int shm_default_points(mpz_t n, uint8_t trailling_bits, int nb_collisions)
+{
+	mpz_t work;
+	unsigned long int nb_cells;
+	mpz_init(work);
+	mpz_mul_ui(work, n, __PI_NUMERATOR__);
+	mpz_tdiv_q_ui(work, work, 2 * __PI_DENOMINATOR__);
+	mpz_sqrt(work, work);
+	mpz_tdiv_q_2exp(work, work, trailling_bits);
+	nb_cells = 4 * mpz_get_ui(work) * sqrt(nb_collisions) + 4096;
+	mpz_clear(work);
+	return nb_cells;
+}
+
+/** Name of a mode, and the options it accepts.
+ */
+typedef struct
+{
+	const char *name;
+	int accepts;
+}exec_mode_t;
+
+/** Name of an option, and the options it can not be used with, whatever the mode.
+ */
+typedef struct
+{
+	const char *name;
+	int excludes;
+}exec_use_t;
+
+static const exec_mode_t exec_modes[__NB_MODES__] =
+{
+	{"the tests of logarithms", __BIT__(__USE_GROUPS__) | __BIT__(__USE_STRUCTS__) | __BIT__(__USE_CHECKPOINT__) | __BIT__(__USE_FREEZE__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_FP__) | __BIT__(__USE_ADAPTIVE__)},
+	{"--fingerprint", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_FP__)},
+	{"--targets", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_FREEZE__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__)},
+	{"--precompute", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_TABLE_SIZE__)},
+	{"--table", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__)},
+	{"--kangaroo", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_FREEZE__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_INTERVAL__)},
+	{"--gaudry-schost", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_FREEZE__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_BOX__)},
+	{"--pohlig-hellman", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__)},
+	{"--collide", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_GOLDEN__)},
+	{"--shm-create", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__) | __BIT__(__USE_SHM_POINTS__)},
+	{"--shm-attach", 0},
+	{"--tcp-listen", __BIT__(__USE_STRUCTS__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_BINARY__)},
+	{"--tcp-connect", __BIT__(__USE_BATCH__)},
+	{"--resume", __BIT__(__USE_CHECKPOINT__)},
+	{"--frozen-check", 0},
+};
+
+static const exec_use_t exec_uses[__NB_USES__] =
+{
+	{"-g other than 1", 0},
+	{"more than one structure (-s)", 0},
+	{"--checkpoint", __BIT__(__USE_GROUPS__) | __BIT__(__USE_STRUCTS__)},
+	{"--freeze", __BIT__(__USE_GROUPS__) | __BIT__(__USE_STRUCTS__)},
+	{"--j-invariant", 0},
+	{"--lean-step, --lanes or --limbs-step", 0},
+	{"--binary", __BIT__(__USE_J_INVARIANT__)},
+	{"--fp", __BIT__(__USE_BINARY__) | __BIT__(__USE_J_INVARIANT__) | __BIT__(__USE_STEP__) | __BIT__(__USE_CHECKPOINT__)},
+	{"--adaptive-d", __BIT__(__USE_CHECKPOINT__)},
+	{"--interval-low or --interval-high", 0},
+	{"--box-base, --box-width, --box-height or --box-lambda", 0},
+	{"--golden or --version-points", 0},
+	{"--shm-points", 0},
+	{"--table-size", 0},
+	{"--batch or --compress", 0},
+};
+
+/** Check the chosen options against the table of the modes.
+ * 
+ * 	@brief Exits with an error naming the two options that do not go
+ * 	together: two modes, an option the mode does not accept, or two
+ * 	options that exclude each other.
+ * 
+ * 	@param[in]	modes	Bits of the chosen modes.
+ * 	@param[in]	uses	Bits of the chosen options.
+ * 	@return 	The chosen mode, __MODE_TESTS__ if none is chosen.
+ */
+int check_options(int modes, int uses)
+{
+	int mode = __MODE_TESTS__;
+	int m, u, v;
+	for(m = 0; m < __NB_MODES__; m++)
+	{
+		if(modes & __BIT__(m))
+		{
+			if(mode != __MODE_TESTS__)
+			{
+				fprintf(stderr, "%s can not be used with %s.\n", exec_modes[m].name, exec_modes[mode].name);
+				exit(1);
+			}
+			mode = m;
+		}
+	}
+	for(u = 0; u < __NB_USES__; u++)
+	{
+		if(!(uses & __BIT__(u)))
+		{
+			continue;
+		}
+		if(!(exec_modes[mode].accepts & __BIT__(u)))
+		{
+			fprintf(stderr, "%s is not used by %s.\n", exec_uses[u].name, exec_modes[mode].name);
+			exit(1);
+		}
+		for(v = 0; v < __NB_USES__; v++)
+		{
+			if((uses & __BIT__(v)) && (exec_uses[u].excludes & __BIT__(v)))
+			{
+				fprintf(stderr, "%s can not be used with %s.\n", exec_uses[u].name, exec_uses[v].name);
+				exit(1);
+			}
+		}
+	}
+	return mode;
+}
+
+int main(int argc,char * argv[])
+{	
+	experiment_t exp;
+	char *struct_i_str[] = {"PRTL", "hash_unix", "fingerprint"};
 	uint8_t struct_chosen = 0;
 	struct timeval tv1;
 	struct timeval tv2;
 	unsigned long long int time, time1, time2;
-	unsigned long long int memory;
-	unsigned long int nb_points;
-	float rate_of_use, rate_slots;
-	mpz_t key;
-	mpz_t x;
-	char option;
-	uint8_t nb_bits, trailling_bits, nb_curve, line_file_curves, line_file_points, nb_points_file, nb_point, j, struct_i, level;
-	int test_i, nb_tests, nb_threads;
+	int option;
+	uint8_t trailling_bits, j, level;
+	int nb_bits;
+	int nb_tests, nb_threads;
 	int nb_collisions = 1;
 	int trailling_bits_is_set = 0;
 	int correct_data_size_in_bytes;
 	uint8_t structs[__NB_STRUCTURES__] = {0};
-    rate_slots = 0.0;
+	int nb_groups = 1;
+	int group_threads;
+	char *checkpoint_path = NULL;
+	char *resume_path = NULL;
+	int checkpoint_interval = __DEFAULT_CHECKPOINT_INTERVAL__;
+	char *shm_create_name = NULL;
+	char *shm_attach_name = NULL;
+	unsigned long int shm_points = 0;
+	int tcp_port = 0;
+	char *tcp_address = NULL;
+	int batch_size = __NET_DEFAULT_BATCH__;
+	int compress = 0;
+	int nb_targets = 0;
+	char *precompute_path = NULL;
+	char *table_path = NULL;
+	unsigned long int table_size = 0;
+	char *freeze_path = NULL;
+	char *frozen_check_path = NULL;
+	char *interval_low = NULL;
+	char *interval_high = NULL;
+	char *box_base = NULL;
+	char *box_width = NULL;
+	char *box_height = NULL;
+	char *box_lambda = NULL;
+	char *j_invariant = NULL;
+	int binary = 0;
+	int fp = 0;
+	char *collide_name = NULL;
+	unsigned long int golden_points = 0;
+	unsigned long int version_points = 0;
+	unsigned long int adaptive_points = 0;
+	int fingerprint_bits = 0;
+	unsigned long int fingerprint_points;
+	int fingerprint_max_bits;
+	char curves_path[20] = "curves";
+	char points_path[20] = "points";
+	int orbit = 1;
+	int step_type = -1;
+	int curves_bits[__CURVES_MAX_BITS__];
+	int nb_curves, nearest, nb_listed;
+	int modes = 0;
+	int uses = 0;
+	int mode;
+	struct option long_options[] = {
+		{"checkpoint", required_argument, NULL, __OPT_CHECKPOINT__},
+		{"checkpoint-interval", required_argument, NULL, __OPT_CHECKPOINT_INTERVAL__},
+		{"resume", required_argument, NULL, __OPT_RESUME__},
+		{"shm-create", required_argument, NULL, __OPT_SHM_CREATE__},
+		{"shm-attach", required_argument, NULL, __OPT_SHM_ATTACH__},
+		{"shm-points", required_argument, NULL, __OPT_SHM_POINTS__},
+		{"tcp-listen", required_argument, NULL, __OPT_TCP_LISTEN__},
+		{"tcp-connect", required_argument, NULL, __OPT_TCP_CONNECT__},
+		{"batch", required_argument, NULL, __OPT_BATCH__},
+		{"compress", no_argument, NULL, __OPT_COMPRESS__},
+		{"targets", required_argument, NULL, __OPT_TARGETS__},
+		{"precompute", required_argument, NULL, __OPT_PRECOMPUTE__},
+		{"table-size", required_argument, NULL, __OPT_TABLE_SIZE__},
+		{"table", required_argument, NULL, __OPT_TABLE__},
+		{"freeze", required_argument, NULL, __OPT_FREEZE__},
+		{"frozen-check", required_argument, NULL, __OPT_FROZEN_CHECK__},
+		{"kangaroo", no_argument, NULL, __OPT_KANGAROO__},
+		{"interval-low", required_argument, NULL, __OPT_INTERVAL_LOW__},
+		{"interval-high", required_argument, NULL, __OPT_INTERVAL_HIGH__},
+		{"gaudry-schost", no_argument, NULL, __OPT_GAUDRY_SCHOST__},
+		{"box-base", required_argument, NULL, __OPT_BOX_BASE__},
+		{"box-width", required_argument, NULL, __OPT_BOX_WIDTH__},
+		{"box-height", required_argument, NULL, __OPT_BOX_HEIGHT__},
+		{"box-lambda", required_argument, NULL, __OPT_BOX_LAMBDA__},
+		{"pohlig-hellman", no_argument, NULL, __OPT_POHLIG_HELLMAN__},
+		{"j-invariant", required_argument, NULL, __OPT_J_INVARIANT__},
+		{"no-orbit", no_argument, NULL, __OPT_NO_ORBIT__},
+		{"lean-step", no_argument, NULL, __OPT_LEAN_STEP__},
+		{"lanes", no_argument, NULL, __OPT_LANES__},
+		{"limbs-step", no_argument, NULL, __OPT_LIMBS_STEP__},
+		{"binary", no_argument, NULL, __OPT_BINARY__},
+		{"fp", no_argument, NULL, __OPT_FP__},
+		{"collide", required_argument, NULL, __OPT_COLLIDE__},
+		{"golden", required_argument, NULL, __OPT_GOLDEN__},
+		{"version-points", required_argument, NULL, __OPT_VERSION_POINTS__},
+		{"adaptive-d", required_argument, NULL, __OPT_ADAPTIVE_D__},
+		{"fingerprint", required_argument, NULL, __OPT_FINGERPRINT__},
+		{NULL, 0, NULL, 0}
+	};
     level = 7;
 	nb_bits = 35;
     trailling_bits = 0;
 	nb_threads =  omp_get_max_threads();
 	nb_tests = 10;
-	line_file_curves = 84;
-	line_file_points = 80;
-	nb_points_file = 10;
 
-	while ((option = getopt(argc, argv,"f:t:n:s:l:d:c:h")) != -1) {
+	while ((option = getopt_long(argc, argv,"f:t:n:s:l:d:c:g:h", long_options, NULL)) != -1) {
         switch (option) {
 			case 'f' : nb_bits = atoi(optarg);
 				break;
@@ -156,21 +766,216 @@ int main(int argc,char * argv[])
 				break;
 			case 'd' : trailling_bits = atoi(optarg); trailling_bits_is_set = 1;
 				break;
+			case 'g' : nb_groups = atoi(optarg);
+				break;
+			case __OPT_CHECKPOINT__ : checkpoint_path = optarg; uses |= __BIT__(__USE_CHECKPOINT__);
+				break;
+			case __OPT_CHECKPOINT_INTERVAL__ : checkpoint_interval = atoi(optarg);
+				break;
+			case __OPT_RESUME__ : resume_path = optarg; modes |= __BIT__(__MODE_RESUME__);
+				break;
+			case __OPT_SHM_CREATE__ : shm_create_name = optarg; modes |= __BIT__(__MODE_SHM_CREATE__);
+				break;
+			case __OPT_SHM_ATTACH__ : shm_attach_name = optarg; modes |= __BIT__(__MODE_SHM_ATTACH__);
+				break;
+			case __OPT_SHM_POINTS__ : shm_points = strtoul(optarg, NULL, 10); uses |= __BIT__(__USE_SHM_POINTS__);
+				break;
+			case __OPT_TCP_LISTEN__ : tcp_port = atoi(optarg); modes |= __BIT__(__MODE_TCP_LISTEN__);
+				break;
+			case __OPT_TCP_CONNECT__ : tcp_address = optarg; modes |= __BIT__(__MODE_TCP_CONNECT__);
+				break;
+			case __OPT_BATCH__ : batch_size = atoi(optarg); uses |= __BIT__(__USE_BATCH__);
+				break;
+			case __OPT_COMPRESS__ : compress = 1; uses |= __BIT__(__USE_BATCH__);
+				break;
+			case __OPT_TARGETS__ : nb_targets = atoi(optarg); modes |= __BIT__(__MODE_TARGETS__);
+				break;
+			case __OPT_PRECOMPUTE__ : precompute_path = optarg; modes |= __BIT__(__MODE_PRECOMPUTE__);
+				break;
+			case __OPT_TABLE_SIZE__ : table_size = strtoul(optarg, NULL, 10); uses |= __BIT__(__USE_TABLE_SIZE__);
+				break;
+			case __OPT_TABLE__ : table_path = optarg; modes |= __BIT__(__MODE_TABLE__);
+				break;
+			case __OPT_FREEZE__ : freeze_path = optarg; uses |= __BIT__(__USE_FREEZE__);
+				break;
+			case __OPT_FROZEN_CHECK__ : frozen_check_path = optarg; modes |= __BIT__(__MODE_FROZEN_CHECK__);
+				break;
+			case __OPT_KANGAROO__ : modes |= __BIT__(__MODE_KANGAROO__);
+				break;
+			case __OPT_INTERVAL_LOW__ : interval_low = optarg; uses |= __BIT__(__USE_INTERVAL__);
+				break;
+			case __OPT_INTERVAL_HIGH__ : interval_high = optarg; uses |= __BIT__(__USE_INTERVAL__);
+				break;
+			case __OPT_GAUDRY_SCHOST__ : modes |= __BIT__(__MODE_GAUDRY_SCHOST__);
+				break;
+			case __OPT_BOX_BASE__ : box_base = optarg; uses |= __BIT__(__USE_BOX__);
+				break;
+			case __OPT_BOX_WIDTH__ : box_width = optarg; uses |= __BIT__(__USE_BOX__);
+				break;
+			case __OPT_BOX_HEIGHT__ : box_height = optarg; uses |= __BIT__(__USE_BOX__);
+				break;
+			case __OPT_BOX_LAMBDA__ : box_lambda = optarg; uses |= __BIT__(__USE_BOX__);
+				break;
+			case __OPT_POHLIG_HELLMAN__ : modes |= __BIT__(__MODE_POHLIG_HELLMAN__);
+				break;
+			case __OPT_J_INVARIANT__ : j_invariant = optarg; uses |= __BIT__(__USE_J_INVARIANT__);
+				break;
+			case __OPT_NO_ORBIT__ : orbit = 0;
+				break;
+			case __OPT_LEAN_STEP__ : step_type = __STEP_LEAN__; uses |= __BIT__(__USE_STEP__);
+				break;
+			case __OPT_LANES__ : step_type = __STEP_LANES__; uses |= __BIT__(__USE_STEP__);
+				break;
+			case __OPT_LIMBS_STEP__ : step_type = __STEP_LIMBS__; uses |= __BIT__(__USE_STEP__);
+				break;
+			case __OPT_BINARY__ : binary = 1; uses |= __BIT__(__USE_BINARY__);
+				break;
+			case __OPT_FP__ : fp = 1; uses |= __BIT__(__USE_FP__);
+				break;
+			case __OPT_COLLIDE__ : collide_name = optarg; modes |= __BIT__(__MODE_COLLIDE__);
+				break;
+			case __OPT_GOLDEN__ : golden_points = strtoul(optarg, NULL, 10); uses |= __BIT__(__USE_GOLDEN__);
+				break;
+			case __OPT_VERSION_POINTS__ : version_points = strtoul(optarg, NULL, 10); uses |= __BIT__(__USE_GOLDEN__);
+				break;
+			case __OPT_ADAPTIVE_D__ : adaptive_points = strtoul(optarg, NULL, 10); uses |= __BIT__(__USE_ADAPTIVE__);
+				break;
+			case __OPT_FINGERPRINT__ : fingerprint_bits = atoi(optarg); modes |= __BIT__(__MODE_FINGERPRINT__);
+				break;
 			case 'h' : {print_usage();exit(0);}
 				break;
 		}
 	}
 	
 	/*** BEGIN: check input parameters boundary conditions */
-	if(nb_bits < 35 || nb_bits > 115 || nb_bits%5 != 0)
-	{
-		fprintf(stdout, "\n********\n\033[0;31mWarning:\033[0m There is no example curve of %2" SCNu8 " bits available in the current implementation.\n", nb_bits);
-		fprintf(stdout, "Available choices for the -f parameter are: 35,40,45,50,55,60,65,70,75,80,85,90,95,100,105,110,115.\n");
-		nb_bits = (nb_bits / 5) * 5;
-		if(nb_bits < 35) nb_bits = 35;
-		if(nb_bits > 115) nb_bits = 115;
-		fprintf(stdout, "\033[0;31mThis execution will use a %2" SCNu8 "-bit curve.\033[0m For a different choice, please restart the program.\n********\n\n", nb_bits);
-		
+	if(nb_groups != 1)
+	{
+		uses |= __BIT__(__USE_GROUPS__);
+	}
+	if(structs[0] + structs[1] > 1)
+	{
+		uses |= __BIT__(__USE_STRUCTS__);
+	}
+	mode = check_options(modes, uses);
+	
+	if(j_invariant != NULL)
+	{
+		if(strcmp(j_invariant, "0") != 0 && strcmp(j_invariant, "1728") != 0)
+		{
+			fprintf(stderr, "The curves with automorphisms have a j-invariant of 0 or 1728.\n");
+			exit(1);
+		}
+		snprintf(curves_path, 20, "curves_j%s", j_invariant);
+		snprintf(points_path, 20, "points_j%s", j_invariant);
+	}
+	if(binary)
+	{
+		snprintf(curves_path, 20, "curves_binary");
+		snprintf(points_path, 20, "points_binary");
+	}
+	if(fp)
+	{
+		snprintf(curves_path, 20, "curves_fp");
+		snprintf(points_path, 20, "points_fp");
+		step_type = __STEP_ADD__;
+	}
+	
+	if(mode == __MODE_FINGERPRINT__ && (fingerprint_bits < 1 || fingerprint_bits > __FINGERPRINT_MAX_BITS__))
+	{
+		fprintf(stderr, "Invalid fingerprint size: %d. Choose a value in the [1;%d] interval.\n", fingerprint_bits, __FINGERPRINT_MAX_BITS__);
+		exit(1);
+	}
+	if(mode == __MODE_COLLIDE__)
+	{
+		if(strcmp(collide_name, "sha256") != 0 && strcmp(collide_name, "cipher") != 0)
+		{
+			fprintf(stderr, "Unknown function %s: the collisions are searched in sha256 or cipher.\n", collide_name);
+			exit(1);
+		}
+		if(nb_bits < 9 || nb_bits > __COLLIDE_MAX_BITS__ || nb_threads < 1 || nb_threads > 2000 || nb_tests < 1 || nb_collisions < 1)
+		{
+			fprintf(stderr, "A collision search works on 9 to %d bits, with 1 to 2000 threads, at least one test and one collision.\n", __COLLIDE_MAX_BITS__);
+			exit(1);
+		}
+		if(golden_points > 0 && nb_collisions != 1)
+		{
+			fprintf(stderr, "The golden collision search looks for one collision (-c 1).\n");
+			exit(1);
+		}
+		if(trailling_bits_is_set == 0 && golden_points > 0)
+		{
+			//a fraction 2.25 sqrt(w/2^f) of the points is distinguished
+			trailling_bits = (uint8_t)fmax(0, round(log2(1.0 / (2.25 * sqrt(golden_points / pow(2, nb_bits))))));
+		}
+		if(trailling_bits_is_set == 0 && golden_points == 0)
+			trailling_bits = nb_bits / 4;
+		if(trailling_bits >= nb_bits || (structs[0] == 1 && level > nb_bits - trailling_bits))
+		{
+			fprintf(stderr, "The number of trailling zero bits has to be less than %d, and the level at most the length of a stored word.\n", nb_bits);
+			exit(1);
+		}
+		if(!struct_chosen)
+		{
+			add_to_struct_options(structs, struct_i_str, "PRTL", &struct_chosen);
+		}
+		exp.nb_bits = nb_bits;
+		exp.trailling_bits = trailling_bits;
+		exp.level = level;
+		exp.structs = structs;
+		exp.struct_i_str = struct_i_str;
+		exp.nb_threads = nb_threads;
+		exp.nb_tests = nb_tests;
+		exp.nb_collisions = nb_collisions;
+		run_collide(&exp, collide_name, golden_points, version_points, structs[0] ? 0 : 1);
+		preallocation_clear();
+		return 0;
+	}
+	
+	nb_curves = curves_list(curves_path, curves_bits, __CURVES_MAX_BITS__);
+	if(nb_curves < 0)
+	{
+		fprintf(stderr, "Can not open file %s.\n", curves_path);
+		exit(1);
+	}
+	if(nb_curves > __CURVES_MAX_BITS__)
+	{
+		nb_curves = __CURVES_MAX_BITS__;
+	}
+	nearest = -1;
+	for(j = 0; j < nb_curves; j++)
+	{
+		if(curves_bits[j] >= 35 && curves_bits[j] <= __CURVES_MAX_BITS__ && (nearest < 0 || abs(curves_bits[j] - nb_bits) < abs(nearest - nb_bits)))
+		{
+			nearest = curves_bits[j];
+		}
+	}
+	if(nearest < 0)
+	{
+		fprintf(stderr, "There is no curve of 35 to %d bits in file %s.\n", __CURVES_MAX_BITS__, curves_path);
+		exit(1);
+	}
+	if(nearest != nb_bits)
+	{
+		fprintf(stdout, "\n********\n\033[0;31mWarning:\033[0m There is no example curve of %d bits available in file %s.\n", nb_bits, curves_path);
+		fprintf(stdout, "Available choices for the -f parameter are:");
+		nb_listed = 0;
+		for(j = 0; j < nb_curves; j++)
+		{
+			if(curves_bits[j] >= 35 && curves_bits[j] <= __CURVES_MAX_BITS__)
+			{
+				fprintf(stdout, "%s%d", (nb_listed++ == 0) ? " " : ",", curves_bits[j]);
+			}
+		}
+		nb_bits = nearest;
+		fprintf(stdout, ".\n\033[0;31mThis execution will use a %d-bit curve.\033[0m For a different choice, please restart the program.\n********\n\n", nb_bits);
+	}
+	if(step_type < 0 && binary)
+	{
+		step_type = __STEP_ADD__;
+	}
+	if(step_type < 0)
+	{
+		step_type = (nb_bits > __LIMBS_DEFAULT_BITS__) ? __STEP_LIMBS__ : __STEP_ADD__;
 	}
 	
 	if(nb_threads < 1 || nb_threads > 2000)
@@ -179,6 +984,32 @@ int main(int argc,char * argv[])
 		exit(1);
 	}
 	
+	if(mode == __MODE_FROZEN_CHECK__)
+	{
+		frozen_check(frozen_check_path);
+		preallocation_clear();
+		return 0;
+	}
+	
+	if(mode == __MODE_SHM_ATTACH__)
+	{
+		run_shm_worker(shm_attach_name, nb_threads);
+		preallocation_clear();
+		return 0;
+	}
+	
+	if(mode == __MODE_TCP_CONNECT__)
+	{
+		if(batch_size < 1 || batch_size > 65536)
+		{
+			fprintf(stderr, "Invalid batch size: %d. Choose a value in the [1;65536] interval.\n", batch_size);
+			exit(1);
+		}
+		run_tcp_worker(tcp_address, nb_threads, batch_size, compress);
+		preallocation_clear();
+		return 0;
+	}
+	
 	if(nb_threads > omp_get_max_threads())
 	{
 		fprintf(stdout, "\n********\n\033[0;31mWarning:\033[0m Using %d threads on this machine may result in slower running times. Recommended number of threads: %d. Continuing execution with %d...\n********\n\n", nb_threads, omp_get_max_threads(), nb_threads);
@@ -191,13 +1022,21 @@ int main(int argc,char * argv[])
 	}
 	
     if(trailling_bits_is_set == 0)
-	   trailling_bits = nb_bits / 4;
+	   trailling_bits = (adaptive_points > 0) ? nb_bits / 8 : nb_bits / 4;
 	if(trailling_bits > nb_bits)
 	{
 		fprintf(stderr, "The number of trailling zero bits can not be greater than the number of bits of the x-coordinate.\n");
 		exit(1);
 	}
 	
+	if(mode == __MODE_SHM_CREATE__)
+	{
+		//the shared store packs the points as the PRTL structure does
+		structs[0] = 1;
+		structs[1] = 0;
+		struct_chosen = 1;
+	}
+	
 	if(!struct_chosen)
 	{
 		fprintf(stdout, "\n********\n\033[0;31mWarning:\033[0m There are no chosen storage structures. Adding PRTL by default.\n********\n\n");
@@ -224,6 +1063,37 @@ int main(int argc,char * argv[])
 		exit(1);
 	}
 	
+	if(nb_groups < 0 || nb_groups > nb_threads)
+	{
+		fprintf(stderr, "Invalid number of test groups: %d. Choose a value in the [0;%d] interval.\n", nb_groups, nb_threads);
+		exit(1);
+	}
+	
+	if(checkpoint_interval < 1)
+	{
+		fprintf(stderr, "Invalid checkpoint interval: %d.\n", checkpoint_interval);
+		exit(1);
+	}
+	
+	if(mode == __MODE_RESUME__)
+	{
+		resume_test(resume_path, (checkpoint_path != NULL) ? checkpoint_path : resume_path, checkpoint_interval, nb_threads, nb_collisions);
+		preallocation_clear();
+		return 0;
+	}
+	
+	if(mode == __MODE_TCP_LISTEN__ && (tcp_port < 1 || tcp_port > 65535))
+	{
+		fprintf(stderr, "Invalid port: %d. Choose a value in the [1;65535] interval.\n", tcp_port);
+		exit(1);
+	}
+	
+	if(mode == __MODE_TARGETS__ && nb_targets < 1)
+	{
+		fprintf(stderr, "Invalid number of targets: %d.\n", nb_targets);
+		exit(1);
+	}
+	
 	/*** END: check input parameters boundary conditions */
 	
 	/***BEGIN: check if the __DATA_SIZE_IN_BYTES__ constant is properly set for the chosen parameters */
@@ -244,329 +1114,163 @@ int main(int argc,char * argv[])
 	
 	/***END: check if the __DATA_SIZE_IN_BYTES__ constant is properly set for the chosen parameters */
 	
-	/*** set the number of threads for preallocation***/
-	set_nb_threads(nb_threads);
-	
-	curve_init(&E);
-	point_init(&P);
-	point_init(&Q);
-	mpz_inits(x,large_prime, key, NULL);
+	curve_init(&exp.E);
+	mpz_init(exp.large_prime);
 	for(j=0;j<__NB_ENSEMBLES__;j++)
 	{
-		mpz_inits(A[j],B[j],NULL);
+		mpz_inits(exp.A[j],exp.B[j],NULL);
 	}
 
-	nb_curve = nb_bits / 5 - 3;
-
 	/*** read curve ***/
-	file_curves = fopen("curves","r");
-	if (file_curves == NULL) 
+	if(curves_read(curves_path, nb_bits, &exp.E, exp.large_prime))
 	{
-		fprintf(stderr, "Can not open file curves.\n");
+		fprintf(stderr, "Can not read the %d-bit curve in file %s.\n", nb_bits, curves_path);
 		exit(1);
 	}
-	fseek(file_curves, nb_curve * line_file_curves, SEEK_SET);
-   	if(fscanf(file_curves, "%2" SCNu8 "%s %s %s %s", &nb_bits, str_A, str_B, str_p, str_large_prime) < 5)
-   	{
-		fprintf(stderr, "Can not read file curves.\n");
-		exit(1);
+	if(binary)
+	{
+		exp.E.field = __CURVE_FIELD_BINARY__;
 	}
-	fclose(file_curves);
-	mpz_set_str(E.A, str_A, 10);
-	mpz_set_str(E.B, str_B, 10);
-	mpz_set_str(E.p, str_p, 10);
-	mpz_set_str(large_prime, str_large_prime, 10);
-		
-	generate_adding_sets(A, B, large_prime);
-    
-	test_i = 0;
-	while(test_i < nb_tests)
+	if(j_invariant != NULL && orbit_size(exp.E, exp.large_prime) > 1)
 	{
-		/*** read point P ***/
-		nb_point = test_i % 10 + 1;
-		file_points = fopen("points","r");
-		if (file_points == NULL) 
-		{
-			fprintf(stderr, "Can not open file points.\n");
-			exit(1);
-		}
-		fseek(file_points, nb_curve * (nb_points_file + 1) * line_file_points + (nb_point * line_file_points), SEEK_SET);
-		if(fscanf(file_points, "%s %s",str_X, str_Y) < 2)
+		if(orbit)
 		{
-			fprintf(stderr, "Can not read file points.\n");
-			exit(1);
-		}
-		fclose(file_points);
-		mpz_set_str(P.x, str_X, 10);
-		mpz_set_str(P.y, str_Y, 10);
-		mpz_set_ui(P.z, 1);
-		
-		//choose a key of size: nb_bits
-		generate_random_key(key, nb_bits - 1);
-		//compute Q
-		double_and_add(&Q, P, key, E);
-		
-		
-		/******* BEGIN: Setting up environment for experiment running and statistics *******/
-		
-		/*** Update possible values of argument f (field/nb_bits) in experiments ***/
-		file_conf = fopen(RESULTS_PATH"conf_avg/f.conf","r");
-		if (file_conf == NULL) 
-		{
-			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-			exit(1);
+			printf("The curve has j-invariant %s: the walk works on orbits of %d points.\n", (mpz_sgn(exp.E.A) == 0) ? "0" : "1728", orbit_size(exp.E, exp.large_prime));
 		}
-		memset(conf_str, 0, 1000);
-		if(fgets(conf_str, 1000, file_conf) != NULL)
+		else
 		{
-			strncpy(conf_str_cpy, conf_str, 1000);
-			conf_value = strtok(conf_str_cpy, " ");
-		}
-		fclose(file_conf);
-		update = 1;
-		while(conf_value != NULL)
-		{
-			if(atoi(conf_value) == nb_bits)
-			{
-				update = 0;
-			}
-			conf_value = strtok(NULL, " ");
-		}
-		if(update)
-		{
-			file_conf=fopen(RESULTS_PATH"conf_avg/f.conf","w");
-			if (file_conf == NULL) 
-			{
-				fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-				exit(1);
-			}
-			fprintf(file_conf, "%s %2" SCNu8, conf_str, nb_bits);
-			fclose(file_conf);
-		}
-		
-		/*** Update possible values of argument s (storage structure) in experiments ***/
-		for(struct_i = 0; struct_i < __NB_STRUCTURES__; struct_i++)
-		{
-			if(structs[struct_i] == 1)
-			{
-				file_conf = fopen(RESULTS_PATH"conf_avg/s.conf","r");
-				if (file_conf == NULL) 
-				{
-					fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-					exit(1);
-				}
-				memset(conf_str, 0, 1000);
-				if(fgets(conf_str, 1000, file_conf) != NULL)
-				{
-					strncpy(conf_str_cpy, conf_str, 1000);
-					conf_value = strtok(conf_str_cpy, " ");
-				}
-				fclose(file_conf);
-				update = 1;
-				while(conf_value != NULL)
-				{
-					if(strncmp(conf_value, struct_i_str[struct_i], strlen(conf_value)) == 0 && strlen(conf_value) == strlen(struct_i_str[struct_i]))
-					{
-						update = 0;
-					}
-					conf_value = strtok(NULL, " ");
-				}
-				if(update)
-				{
-					file_conf=fopen(RESULTS_PATH"conf_avg/s.conf","w");
-					if (file_conf == NULL) 
-					{
-						fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-						exit(1);
-					}
-					fprintf(file_conf, "%s %s", conf_str, struct_i_str[struct_i]);
-					fclose(file_conf);
-				}
-			}
+			printf("The curve has j-invariant %s: the walk works on points (--no-orbit).\n", (mpz_sgn(exp.E.A) == 0) ? "0" : "1728");
 		}
+	}
 		
-		/*** Update possible values of argument t (thread number) in experiments ***/
-		file_conf = fopen(RESULTS_PATH"conf_avg/t.conf","r");
-		if (file_conf == NULL) 
-		{
-			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-			exit(1);
-		}
-		memset(conf_str, 0, 1000);
-		if(fgets(conf_str, 1000, file_conf) != NULL)
-		{
-			strncpy(conf_str_cpy, conf_str, 1000);
-			conf_value = strtok(conf_str_cpy, " ");
-		}
-		fclose(file_conf);
-		update = 1;
-		while(conf_value != NULL)
-		{
-			if(atoi(conf_value) == nb_threads)
-			{
-				update = 0;
-			}
-			conf_value = strtok(NULL, " ");
-		}
-		if(update)
-		{
-			file_conf=fopen(RESULTS_PATH"conf_avg/t.conf","w");
-			if (file_conf == NULL) 
-			{
-				fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-				exit(1);
-			}
-			fprintf(file_conf, "%s %d", conf_str, nb_threads);
-			fclose(file_conf);
-		}
+	if(step_type == __STEP_LANES__)
+	{
+		printf("The walks go %d by %d in lanes, with the %s kernel.\n", __LANES_GROUPS__ * __LANES_WIDTH__, __LANES_WIDTH__, lanes_kernel_name(__LANES_KERNEL_BEST__));
+	}
+	if(step_type == __STEP_LIMBS__)
+	{
+		printf("The walks step on %d limbs of %d bits.\n", (int)mpz_size(exp.E.p), GMP_NUMB_BITS);
+	}
+	if(binary)
+	{
+		printf("The walks add on GF(2^%d), with the %s kernel.\n", (int)mpz_sizeinbase(exp.E.p, 2) - 1, binary_kernel_name(__BINARY_KERNEL_BEST__));
+	}
+	if(fp)
+	{
+		printf("The walks multiply in F_p^*, p of %d bits, with the %s field kernel.\n", (int)mpz_sizeinbase(exp.E.p, 2), (mpz_sizeinbase(exp.E.p, 2) <= 64 * __FIELD_MAX_LIMBS__) ? field_kernel_name(field_best_kernel()) : "GMP");
+	}
 		
-		/*** Update possible values of argument d (number of trailling bits to zero) in experiments ***/
-		file_conf = fopen(RESULTS_PATH"conf_avg/theta.conf","r");
-		if (file_conf == NULL) 
-		{
-			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-			exit(1);
-		}
-		memset(conf_str, 0, 1000);
-		if(fgets(conf_str, 1000, file_conf) != NULL)
-		{
-			strncpy(conf_str_cpy, conf_str, 1000);
-			conf_value = strtok(conf_str_cpy, " ");
-		}
-		fclose(file_conf);
-		update = 1;
-		while(conf_value != NULL)
-		{
-			if(atoi(conf_value) == trailling_bits)
+	generate_adding_sets(exp.A, exp.B, exp.large_prime);
+	
+	/*** split the threads into groups running different tests concurrently ***/
+	if(nb_groups == 0)
+	{
+		group_threads = group_nb_threads(exp.large_prime, trailling_bits, nb_threads);
+		nb_groups = nb_threads / group_threads;
+	}
+	if(nb_groups > nb_tests)
+	{
+		nb_groups = nb_tests;
+	}
+	nb_threads = nb_threads / nb_groups;
+	if(nb_groups > 1)
+	{
+		printf("Running %d tests at a time, %d threads each.\n", nb_groups, nb_threads);
+	}
+	
+	update_conf_files(nb_bits, structs, struct_i_str, nb_threads, trailling_bits, level);
+	
+	exp.nb_bits = nb_bits;
+	exp.trailling_bits = trailling_bits;
+	exp.level = level;
+	exp.structs = structs;
+	exp.struct_i_str = struct_i_str;
+	exp.nb_threads = nb_threads;
+	exp.nb_tests = nb_tests;
+	exp.nb_groups = nb_groups;
+	exp.nb_collisions = nb_collisions;
+	exp.checkpoint_path = checkpoint_path;
+	exp.checkpoint_interval = checkpoint_interval;
+	exp.freeze_path = freeze_path;
+	exp.points_path = points_path;
+	exp.orbit = (orbit && j_invariant != NULL);
+	exp.step_type = step_type;
+	exp.adaptive_points = adaptive_points;
+	exp.group = fp ? &pcs_group_fp : &pcs_group_ec;
+	
+	/*** each group solves its tests with its own PCS contexts, the groups share the OpenMP thread pool ***/
+	gettimeofday(&tv1,NULL);
+	switch(mode)
+	{
+		case __MODE_SHM_CREATE__ :
+			if(shm_points == 0)
 			{
-				update = 0;
+				shm_points = shm_default_points(exp.large_prime, trailling_bits, nb_collisions);
 			}
-			conf_value = strtok(NULL, " ");
-		}
-		if(update)
-		{
-			file_conf=fopen(RESULTS_PATH"conf_avg/theta.conf","w");
-			if (file_conf == NULL) 
+			if(shm_points > __SHM_MAX_CELLS__)
 			{
-				fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+				fprintf(stderr, "Invalid number of points of the shared store: %lu. A shared store holds at most %lu points.\n", shm_points, (unsigned long int)__SHM_MAX_CELLS__);
 				exit(1);
 			}
-			fprintf(file_conf, "%s %2" SCNu8, conf_str, trailling_bits);
-			fclose(file_conf);
-		}
-		
-		/*** Update possible values of argument l (level of the abstract radix tree) in experiments ***/
-		file_conf = fopen(RESULTS_PATH"conf_avg/l.conf","r");
-		if (file_conf == NULL)
-		{
-			fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
-			exit(1);
-		}
-		memset(conf_str, 0, 1000);
-		if(fgets(conf_str, 1000, file_conf) != NULL)
-		{
-			strncpy(conf_str_cpy, conf_str, 1000);
-			conf_value = strtok(conf_str_cpy, " ");
-		}
-		fclose(file_conf);
-		update = 1;
-		while(conf_value != NULL)
-		{
-			if(atoi(conf_value) == level)
+			run_shm_coordinator(&exp, shm_create_name, shm_points);
+			break;
+		case __MODE_PRECOMPUTE__ :
+			if(table_size == 0)
 			{
-				update = 0;
+				table_size = cbrt(mpz_get_d(exp.large_prime));
 			}
-			conf_value = strtok(NULL, " ");
-		}
-		if(update)
-		{
-			file_conf=fopen(RESULTS_PATH"conf_avg/l.conf","w");
-			if (file_conf == NULL)
+			run_precompute(&exp, precompute_path, table_size, structs[0] ? 0 : 1);
+			break;
+		case __MODE_TABLE__ : run_with_table(&exp, table_path, structs[0] ? 0 : 1);
+			break;
+		case __MODE_POHLIG_HELLMAN__ : run_pohlig_hellman(&exp);
+			break;
+		case __MODE_GAUDRY_SCHOST__ : run_gaudry_schost(&exp, box_base, box_width, box_height, box_lambda, structs[0] ? 0 : 1);
+			break;
+		case __MODE_KANGAROO__ : run_kangaroo(&exp, interval_low, interval_high, structs[0] ? 0 : 1);
+			break;
+		case __MODE_TARGETS__ : run_multi_target(&exp, nb_targets, structs[0] ? 0 : 1);
+			break;
+		case __MODE_FINGERPRINT__ :
+			//twice the expected number of distinguished points
+			fingerprint_points = shm_default_points(exp.large_prime, trailling_bits, nb_collisions) / 2;
+			fingerprint_max_bits = nb_bits - trailling_bits - fingerprint_bucket_bits(fingerprint_points);
+			if(fingerprint_bits > fingerprint_max_bits)
 			{
-				fprintf(stderr, "Can not open configuration file (see constant RESULTS_PATH in main.c)\n");
+				fprintf(stderr, "Invalid fingerprint size: %d. The x coordinates without their %d trailling zero bits keep %d bits above the %d bits of the bucket.\n", fingerprint_bits, trailling_bits, fingerprint_max_bits, fingerprint_bucket_bits(fingerprint_points));
 				exit(1);
 			}
-			fprintf(file_conf, "%s %2" SCNu8, conf_str, level);
-			fclose(file_conf);
-		}
-		
-		/******* END: Setting up environment for experiment running and statistics *******/
-		
-		
-		/* Test different structures */
-		printf("*** Test %d ***\n", test_i + 1);
-		for(struct_i = 0; struct_i < __NB_STRUCTURES__; struct_i++)
-		{
-			if(structs[struct_i] == 1)
+			run_fingerprint(&exp, fingerprint_bits, fingerprint_points);
+			break;
+		case __MODE_TCP_LISTEN__ : run_tcp_coordinator(&exp, tcp_port, structs[0] ? 0 : 1);
+			break;
+		default :
+			if(nb_groups > 1)
 			{
-				printf("\t**Structure %s\n", struct_i_str[struct_i]);
-				pcs_init(P, Q, E, large_prime, A, B, nb_bits, trailling_bits, struct_i, nb_threads, level);
-				gettimeofday(&tv1,NULL);
-				pcs_run(x, nb_threads, nb_collisions);
+				omp_set_max_active_levels(2);
+				#pragma omp parallel num_threads(nb_groups)
+				{
+					run_tests(&exp, omp_get_thread_num());
+				}
 				gettimeofday(&tv2, NULL);
-				time1=(tv1.tv_sec) * 1000000 + tv1.tv_usec;
+				time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
 				time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
 				time = time2 - time1;
-                memory = struct_memory(&nb_points, &rate_of_use, &rate_slots, nb_threads);
-				pcs_clear();
-                
-				if(mpz_cmp(x, key)!=0)
-				{
-					fprintf(stderr, "Error in PCS computation.\n");
-					//exit(2);
-					break;
-				}
-				
-				/*** Write execution time ***/
-				file_res=fopen(RESULTS_PATH"time.all","a");
-				if (file_res == NULL) 
-				{
-					fprintf(stderr, "Can not open file time.all (see constant RESULTS_PATH in main.c)\n");
-					exit(1);
-				}
-				fprintf(file_res,"%d %s %d %d %"SCNu8" %llu\n", nb_bits, struct_i_str[struct_i], nb_threads, trailling_bits, level, time);
-				fclose(file_res);
-				
-				/*** Write memory usage ***/
-				file_res=fopen(RESULTS_PATH"memory.all","a");
-				if (file_res == NULL) 
-				{
-					fprintf(stderr, "Can not open file memory.all (see constant RESULTS_PATH in main.c)\n");
-					exit(1);
-				}
-				fprintf(file_res,"%d %s %d %d %"SCNu8" %llu\n", nb_bits, struct_i_str[struct_i], nb_threads, trailling_bits, level, memory);
-				fclose(file_res);
-				
-				/*** Write number of stored points ***/
-				file_res=fopen(RESULTS_PATH"points.all","a");
-				if (file_res == NULL) 
-				{
-					fprintf(stderr, "Can not open file points.all (see constant RESULTS_PATH in main.c)\n");
-					exit(1);
-				}
-				fprintf(file_res,"%d %s %d %d %"SCNu8" %lu\n", nb_bits, struct_i_str[struct_i], nb_threads, trailling_bits, level, nb_points);
-				fclose(file_res);
-				
-				/*** Write rate of memory use ***/
-				file_res=fopen(RESULTS_PATH"rate.all","a");
-				if (file_res == NULL) 
-				{
-					fprintf(stderr, "Can not open file rate.all (see constant RESULTS_PATH in main.c)\n");
-					exit(1);
-				}
-				fprintf(file_res,"%d %s %d %d %"SCNu8" %.2f (%.2f)\n", nb_bits, struct_i_str[struct_i], nb_threads, trailling_bits, level, rate_of_use, rate_slots);
-				fclose(file_res);
+				printf("%d tests in %llu microseconds (%.2f tests per second).\n", nb_tests, time, (float)nb_tests * 1000000.0 / (float)time);
 			}
-		}
-		test_i++;
+			else
+			{
+				run_tests(&exp, 0);
+			}
+			break;
 	}
-	curve_clear(&E);
-	point_clear(&P);
-	point_clear(&Q);
-	mpz_clears(x, large_prime, key, NULL);
+	
+	curve_clear(&exp.E);
+	mpz_clear(exp.large_prime);
 	for(j=0;j<__NB_ENSEMBLES__;j++)
 	{
-		mpz_clears(A[j],B[j],NULL);
+		mpz_clears(exp.A[j],exp.B[j],NULL);
 	}
 	preallocation_clear();
+	return 0;
 }
@@ -0,0 +1,81 @@
+/** @file pcs_exec.h
+ *  @brief The settings of an experiment of pcs_exec, and the runs of its modes.
+ *
+ *	pcs_exec.c parses the options and runs one mode, whose driver is in
+ *	the pcs_exec_*.c file of the mode.
+ */
+#ifndef PCS_EXEC_H
+#define PCS_EXEC_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs.h"
+
+#define RESULTS_PATH "./results/"
+#define __NB_STRUCTURES__ 2
+#define __PI_NUMERATOR__ 355  	// correct to three digits
+#define __PI_DENOMINATOR__ 113	// correct to three digits
+#define __STRUCT_I_FINGERPRINT__ 2 /* name of the fingerprint store in the results files */
+
+/** Settings of an experiment, shared by all test groups.
+ */
+typedef struct
+{
+	elliptic_curve_t E;
+	const pcs_group_t *group;
+	mpz_t large_prime;
+	mpz_t A[__NB_ENSEMBLES__];
+	mpz_t B[__NB_ENSEMBLES__];
+	uint8_t nb_bits;
+	uint8_t trailling_bits;
+	uint8_t level;
+	uint8_t *structs;
+	char **struct_i_str;
+	int nb_threads;
+	int nb_tests;
+	int nb_groups;
+	int nb_collisions;
+	char *checkpoint_path;
+	int checkpoint_interval;
+	char *freeze_path;
+	char *points_path;
+	int orbit;
+	int step_type;
+	unsigned long int adaptive_points;
+}experiment_t;
+
+void generate_random_key(mpz_t s, int nb_bits, mpz_t n, gmp_randstate_t r_state);
+unsigned long int random_seed(unsigned long int salt);
+void write_result(char *file_name, experiment_t *exp, uint8_t struct_i, char *value);
+void read_point(experiment_t *exp, int test_i, point_t *P);
+void freeze_store(pcs_ctx_t *ctx, char *freeze_path);
+const char *step_name(pcs_ctx_t *ctx);
+int same_walk(pcs_ctx_t *ctx, elliptic_curve_t E, mpz_t n, mpz_t *A, mpz_t *B);
+
+/* pcs_exec_tests.c */
+void run_tests(experiment_t *exp, int group_i);
+void run_fingerprint(experiment_t *exp, int fingerprint_bits, unsigned long int fingerprint_points);
+void frozen_check(char *frozen_path);
+void resume_test(char *resume_path, char *checkpoint_path, int checkpoint_interval, int nb_threads, int nb_collisions);
+
+/* pcs_exec_table.c */
+void run_multi_target(experiment_t *exp, int nb_targets, uint8_t struct_i);
+void run_precompute(experiment_t *exp, char *table_path, unsigned long int table_size, uint8_t struct_i);
+void run_with_table(experiment_t *exp, char *table_path, uint8_t struct_i);
+
+/* pcs_exec_methods.c */
+void run_kangaroo(experiment_t *exp, char *low_str, char *high_str, uint8_t struct_i);
+void run_gaudry_schost(experiment_t *exp, char *base_str, char *width_str, char *height_str, char *lambda_str, uint8_t struct_i);
+void run_pohlig_hellman(experiment_t *exp);
+
+/* pcs_exec_collide.c */
+void run_collide(experiment_t *exp, char *name, unsigned long int golden_points, unsigned long int version_points, uint8_t struct_i);
+
+/* pcs_exec_shm.c */
+void run_shm_coordinator(experiment_t *exp, char *shm_name, unsigned long int nb_cells);
+void run_shm_worker(char *shm_name, int nb_threads);
+
+/* pcs_exec_tcp.c */
+void run_tcp_coordinator(experiment_t *exp, int port, uint8_t struct_i);
+void run_tcp_worker(char *address, int nb_threads, int batch_size, int compress);
+#endif
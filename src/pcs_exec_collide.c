@@ -0,0 +1,162 @@
+/** @file pcs_exec_collide.c
+ *  @brief The collision searches of pcs_exec, in the functions of pcs_collide_demo.c.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <gmp.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_collide.h"
+#include "pcs_collide_demo.h"
+
+/** Run the tests with the collision search of the function name.
+ * 
+ * 	@brief Each test searches another instance of the function: SHA-256
+ * 	with another salt, or the double encryption with other keys and
+ * 	plaintexts, for -c collisions: any collision of SHA-256, and a
+ * 	candidate pair of keys, E_k1(P) = D_k2(C), for the double encryption,
+ * 	which is then checked on the other pairs. The first collision is
+ * 	expected after sqrt(pi*2^f/2) steps. The time, the steps of
+ * 	the walks and of the re-walks locating the collisions, the collisions
+ * 	located and rejected, and the points stored by each test are written
+ * 	in the results file collide.all.
+ * 
+ * 	With golden_points w > 0, each test is a golden collision search with
+ * 	a table of w points and a new version of the function after
+ * 	version_points distinguished points (10w if 0), for a collision the
+ * 	predicate accepts: the keys right on all the pairs for the double
+ * 	encryption. It is expected after 2.5 sqrt(2^3f/w) steps. The results
+ * 	go to golden.all, with w, the number of distinguished points per
+ * 	version and the number of versions, and the work of each version to
+ * 	golden_versions.all (test, version, distinguished points, collisions,
+ * 	useless collisions, Robin Hoods).
+ */
+void run_collide(experiment_t *exp, char *name, unsigned long int golden_points, unsigned long int version_points, uint8_t struct_i)
+{
+	char value[100];
+	collide_ctx_t *ctx = NULL;
+	collide_function_t fn;
+	collide_sha256_t h;
+	collide_cipher_t c;
+	uint64_t P[__COLLIDE_CIPHER_PAIRS__], k1, k2;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, nb_locate_steps, steps_sum = 0, time_sum = 0;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	double expected_steps = sqrt(M_PI * pow(2, exp->nb_bits) / 2);
+	const char *expected_str = "sqrt(pi 2^f/2)";
+	const collide_version_t *version;
+	unsigned long int version_i, nb_versions;
+	int cipher = (strcmp(name, "cipher") == 0);
+	int test_i, i, nb_found = 0;
+	
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	if(cipher)
+	{
+		printf("Meet in the middle on a double encryption with keys of %d bits: %.0f steps expected for the first collision.\n", exp->nb_bits - 1, expected_steps);
+	}
+	else
+	{
+		printf("SHA-256 truncated to %d bits: %.0f steps expected for the first collision.\n", exp->nb_bits, expected_steps);
+	}
+	if(golden_points > 0)
+	{
+		expected_steps = 2.5 * sqrt(pow(2, 3 * exp->nb_bits) / golden_points);
+		expected_str = "2.5 sqrt(2^3f/w)";
+		if(version_points == 0)
+		{
+			version_points = __COLLIDE_VERSION_FACTOR__ * golden_points;
+		}
+		printf("Golden collision search with a table of %lu points and %lu distinguished points per version, 1/2^%d of the points: %.0f steps expected.\n", golden_points, version_points, exp->trailling_bits, expected_steps);
+	}
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		if(cipher)
+		{
+			k1 = gmp_urandomb_ui(r_state, exp->nb_bits - 1);
+			k2 = gmp_urandomb_ui(r_state, exp->nb_bits - 1);
+			for(i = 0; i < __COLLIDE_CIPHER_PAIRS__; i++)
+			{
+				P[i] = gmp_urandomb_ui(r_state, exp->nb_bits - 1);
+			}
+			collide_cipher_init(&fn, &c, exp->nb_bits, k1, k2, P);
+		}
+		else
+		{
+			collide_sha256_init(&fn, &h, exp->nb_bits, gmp_urandomb_ui(r_state, 64));
+		}
+		if(cipher && golden_points > 0)
+		{
+			fn.useful = collide_cipher_golden;
+		}
+		printf("*** Test %d ***\n", test_i + 1);
+		if(ctx == NULL)
+		{
+			ctx = collide_create(fn, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+			if(golden_points > 0)
+			{
+				collide_set_golden(ctx, golden_points, version_points);
+			}
+		}
+		else
+		{
+			collide_reset(ctx, fn);
+		}
+		
+		gettimeofday(&tv1,NULL);
+		collide_run(ctx, exp->nb_collisions);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = collide_steps(ctx, &nb_locate_steps);
+		collide_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+		if(ctx->x1 == ctx->x2 || (fn.f(ctx->x1, fn.arg) != fn.f(ctx->x2, fn.arg)) || (fn.useful != NULL && !fn.useful(ctx->x1, ctx->x2, fn.arg)))
+		{
+			fprintf(stderr, "Error in the collision search.\n");
+			continue;
+		}
+		printf("\t\t%llu microseconds, %llu steps (%.3f of %s) and %llu to locate the collisions, %llu collisions (%llu useless, %llu Robin Hoods), %lu points\n", time_run, nb_steps, (double)nb_steps / expected_steps, expected_str, nb_locate_steps, ctx->nb_collisions, ctx->nb_useless, ctx->nb_robin_hoods, nb_points);
+		if(cipher)
+		{
+			collide_cipher_keys(&c, ctx->x1, ctx->x2, &k1, &k2);
+			printf("\t\tlast candidate keys %#" PRIx64 " %#" PRIx64 ": %s\n", k1, k2, collide_cipher_check(&c, k1, k2) ? "right on all the pairs" : "wrong on the other pairs");
+		}
+		steps_sum += nb_steps + nb_locate_steps;
+		time_sum += time_run;
+		nb_found++;
+		if(golden_points == 0)
+		{
+			snprintf(value, 100, "%s %llu %llu %llu %llu %llu %lu", name, time_run, nb_steps, nb_locate_steps, ctx->nb_collisions, ctx->nb_useless, nb_points);
+			write_result("collide.all", exp, struct_i, value);
+			continue;
+		}
+		nb_versions = collide_nb_versions(ctx);
+		printf("\t\t%lu versions of the function, %.2f collisions per version\n", nb_versions, (double)ctx->nb_collisions / nb_versions);
+		snprintf(value, 100, "%s %lu %lu %llu %llu %llu %lu %llu %llu", name, golden_points, version_points, time_run, nb_steps, nb_locate_steps, nb_versions, ctx->nb_collisions, ctx->nb_useless);
+		write_result("golden.all", exp, struct_i, value);
+		for(version_i = 0; version_i < nb_versions; version_i++)
+		{
+			version = &ctx->versions[version_i];
+			snprintf(value, 100, "%s %d %lu %llu %llu %llu %llu", name, test_i + 1, version_i, version->nb_points, version->nb_collisions, version->nb_useless, version->nb_robin_hoods);
+			write_result("golden_versions.all", exp, struct_i, value);
+		}
+	}
+	if(nb_found > 0)
+	{
+		printf("Average over %d tests: %llu steps (%.3f of %s), %llu microseconds\n", nb_found, steps_sum / nb_found, (double)steps_sum / nb_found / expected_steps, expected_str, time_sum / nb_found);
+	}
+	
+	if(ctx != NULL)
+	{
+		collide_destroy(ctx);
+	}
+	gmp_randclear(r_state);
+}
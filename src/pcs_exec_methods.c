@@ -0,0 +1,317 @@
+/** @file pcs_exec_methods.c
+ *  @brief The tests of pcs_exec with the kangaroo, Gaudry-Schost and Pohlig-Hellman methods.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gmp.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_kangaroo.h"
+#include "pcs_gaudry_schost.h"
+#include "pcs_pohlig_hellman.h"
+
+/** Run the tests with the parallel kangaroo method.
+ * 
+ * 	@brief The keys are drawn in [low, high], given in base 10 (by default
+ * 	the keys of f - 1 bits drawn by run_tests, less than n), and the storage structure
+ * 	is the first chosen one. The time and steps of each test are written
+ * 	in the results file kangaroo.all, with the number of bits of the width
+ * 	w of the interval. The steps are compared to the 2*sqrt(w) expected 
+ * 	in total, that is 2*sqrt(w)/t per thread.
+ */
+void run_kangaroo(experiment_t *exp, char *low_str, char *high_str, uint8_t struct_i)
+{
+	char value[100];
+	pcs_ctx_t *ctx = NULL;
+	point_t P, Q;
+	mpz_t low, high, width, key, x;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, steps_sum = 0, time_sum = 0;
+	double expected_steps;
+	int test_i, nb_solved = 0;
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(low, high, width, key, x, NULL);
+	mpz_ui_pow_ui(low, 2, exp->nb_bits - 2);
+	mpz_ui_pow_ui(high, 2, exp->nb_bits - 1);
+	if(mpz_cmp(high, exp->large_prime) > 0)
+	{
+		mpz_set(high, exp->large_prime);
+	}
+	mpz_sub_ui(high, high, 1);
+	if((low_str != NULL && mpz_set_str(low, low_str, 10) != 0) || (high_str != NULL && mpz_set_str(high, high_str, 10) != 0))
+	{
+		fprintf(stderr, "Invalid interval bounds.\n");
+		exit(1);
+	}
+	mpz_sub(width, high, low);
+	if(mpz_sgn(low) < 0 || mpz_sgn(width) < 0 || mpz_cmp(high, exp->large_prime) >= 0 || mpz_sizeinbase(width, 2) > (size_t)(exp->nb_bits - 2))
+	{
+		fprintf(stderr, "The interval of the keys has to be in [0;n-1], with a width of at most 2^%d.\n", exp->nb_bits - 2);
+		exit(1);
+	}
+	mpz_add_ui(width, width, 1);
+	expected_steps = 2.0 * sqrt(mpz_get_d(width));
+	gmp_printf("Interval [%Zd;%Zd], width 2^%.2f: %.0f steps expected, %.0f per thread.\n", low, high, log2(mpz_get_d(width)), expected_steps, expected_steps / exp->nb_threads);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		mpz_urandomm(key, r_state, width);
+		mpz_add(key, key, low);
+		double_and_add(&Q, P, key, exp->E);
+		printf("*** Test %d ***\n", test_i + 1);
+		if(ctx == NULL)
+		{
+			ctx = pcs_create(P, Q, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+		}
+		else
+		{
+			pcs_reset(ctx, P, Q);
+		}
+		
+		gettimeofday(&tv1,NULL);
+		pcs_run_kangaroo(ctx, low, high, x);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = pcs_steps(ctx);
+		if(mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\t%llu microseconds, %llu steps (%.3f of 2 sqrt(w)), %llu per thread\n", time_run, nb_steps, (double)nb_steps / expected_steps, nb_steps / exp->nb_threads);
+		steps_sum += nb_steps;
+		time_sum += time_run;
+		nb_solved++;
+		snprintf(value, 100, "%lu %llu %llu", (unsigned long int)mpz_sizeinbase(width, 2), time_run, nb_steps);
+		write_result("kangaroo.all", exp, struct_i, value);
+	}
+	if(nb_solved > 0)
+	{
+		printf("Average over %d tests: %llu steps (%.3f of 2 sqrt(w)), %llu per thread against %.0f expected, %llu microseconds\n", nb_solved, steps_sum / nb_solved, (double)steps_sum / nb_solved / expected_steps, steps_sum / nb_solved / exp->nb_threads, expected_steps / exp->nb_threads, time_sum / nb_solved);
+	}
+	
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(low, high, width, key, x, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Run the tests with the Gaudry-Schost method.
+ * 
+ * 	@brief The keys base + i + j*lambda are drawn with 0 <= i < width and
+ * 	0 <= j < height, given in base 10, and the storage structure is the 
+ * 	first chosen one. The time and steps of each test are written in the
+ * 	results file gaudry_schost.all, with the number of bits of the size
+ * 	N = width*height of the box. The steps are compared to the 
+ * 	__GS_EXPECTED_1D__*sqrt(N) (interval) or __GS_EXPECTED_2D__*sqrt(N) 
+ * 	(two-dimensional box) expected in total.
+ */
+void run_gaudry_schost(experiment_t *exp, char *base_str, char *width_str, char *height_str, char *lambda_str, uint8_t struct_i)
+{
+	char value[100];
+	pcs_ctx_t *ctx = NULL;
+	point_t P, Q;
+	mpz_t base, width, height, lambda, size, key, x;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, steps_sum = 0, time_sum = 0;
+	double expected_steps;
+	int test_i, nb_solved = 0;
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(base, width, height, lambda, size, key, x, NULL);
+	mpz_ui_pow_ui(base, 2, exp->nb_bits - 2);
+	mpz_ui_pow_ui(width, 2, exp->nb_bits - 4);
+	mpz_set_ui(height, 1);
+	mpz_set_ui(lambda, 0);
+	if((base_str != NULL && mpz_set_str(base, base_str, 10) != 0) || (width_str != NULL && mpz_set_str(width, width_str, 10) != 0)
+		|| (height_str != NULL && mpz_set_str(height, height_str, 10) != 0) || (lambda_str != NULL && mpz_set_str(lambda, lambda_str, 10) != 0))
+	{
+		fprintf(stderr, "Invalid box.\n");
+		exit(1);
+	}
+	if(mpz_sgn(base) < 0 || mpz_sgn(lambda) < 0 || mpz_cmp_ui(width, 1) < 0 || mpz_cmp_ui(height, 1) < 0 || (mpz_cmp_ui(height, 1) > 0 && mpz_sgn(lambda) == 0))
+	{
+		fprintf(stderr, "A box needs a base and a lambda of at least 0, a width and a height of at least 1, and a lambda if the height is more than 1.\n");
+		exit(1);
+	}
+	if(gs_coefficient_bits(width, height) > exp->nb_bits)
+	{
+		fprintf(stderr, "The box is too large for the coefficients of %d bits stored with the points: its positions take %d bits.\n", exp->nb_bits, gs_coefficient_bits(width, height));
+		exit(1);
+	}
+	mpz_mul(size, width, height);
+	expected_steps = ((mpz_cmp_ui(height, 1) > 0) ? __GS_EXPECTED_2D__ : __GS_EXPECTED_1D__) * sqrt(mpz_get_d(size));
+	gmp_printf("Box %Zd + i + j*%Zd, 0 <= i < %Zd, 0 <= j < %Zd, size 2^%.2f: %.0f steps expected, %.0f per thread.\n", base, lambda, width, height, log2(mpz_get_d(size)), expected_steps, expected_steps / exp->nb_threads);
+	if(ldexp(4.0 * exp->nb_threads, exp->trailling_bits) > expected_steps)
+	{
+		fprintf(stdout, "\n********\n\033[0;31mWarning:\033[0m The walks of about 2^%d steps are long for this box: the steps of the last walk of each thread, after the collision, will add to the expected steps. Choose a smaller d.\n********\n\n", exp->trailling_bits);
+	}
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		mpz_urandomm(key, r_state, height);
+		mpz_mul(key, key, lambda);
+		mpz_urandomm(x, r_state, width);
+		mpz_add(key, key, x);
+		mpz_add(key, key, base);
+		mpz_mod(key, key, exp->large_prime);
+		double_and_add(&Q, P, key, exp->E);
+		printf("*** Test %d ***\n", test_i + 1);
+		if(ctx == NULL)
+		{
+			ctx = pcs_create(P, Q, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+		}
+		else
+		{
+			pcs_reset(ctx, P, Q);
+		}
+		
+		gettimeofday(&tv1,NULL);
+		pcs_run_gaudry_schost(ctx, base, lambda, width, height, x);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = pcs_steps(ctx);
+		if(mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\t%llu microseconds, %llu steps (%.3f of the expected steps), %llu per thread\n", time_run, nb_steps, (double)nb_steps / expected_steps, nb_steps / exp->nb_threads);
+		steps_sum += nb_steps;
+		time_sum += time_run;
+		nb_solved++;
+		snprintf(value, 100, "%lu %llu %llu", (unsigned long int)mpz_sizeinbase(size, 2), time_run, nb_steps);
+		write_result("gaudry_schost.all", exp, struct_i, value);
+	}
+	if(nb_solved > 0)
+	{
+		printf("Average over %d tests: %llu steps (%.3f sqrt(N), %.3f of the expected steps), %llu per thread against %.0f expected, %llu microseconds\n", nb_solved, steps_sum / nb_solved, (double)steps_sum / nb_solved / sqrt(mpz_get_d(size)), (double)steps_sum / nb_solved / expected_steps, steps_sum / nb_solved / exp->nb_threads, expected_steps / exp->nb_threads, time_sum / nb_solved);
+	}
+	
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(base, width, height, lambda, size, key, x, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Run the tests with the Pohlig-Hellman front end.
+ * 
+ * 	@brief The curves of the file curves have a prime order, so the tests
+ * 	are run on the quadratic twist of the chosen curve, whose order 
+ * 	2(p + 1) - n is composite. The order is factored once, and each test 
+ * 	draws a point of the twist, finds its order and solves the logarithm 
+ * 	of a random key in the prime power subgroups, with the hash_unix 
+ * 	structure. The time and steps of each test are written in the results
+ * 	file pohlig_hellman.all, with the number of bits of the largest prime 
+ * 	factor q of the order. The steps are compared to the sqrt(pi*q/2) 
+ * 	of the largest subproblem and to the sqrt(pi*N/2) of a solve in the 
+ * 	whole group of order N.
+ */
+void run_pohlig_hellman(experiment_t *exp)
+{
+	char value[100];
+	elliptic_curve_t E;
+	ph_factor_t *factors, *order_factors;
+	point_t P, Q;
+	mpz_t N, order, key, x, q_max;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, steps_sum = 0, time_sum = 0;
+	int test_i, i, nb_factors, nb_order_factors, nb_solved = 0;
+	
+	curve_init(&E);
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(N, order, key, x, q_max, NULL);
+	ph_quadratic_twist(&E, N, exp->E, exp->large_prime);
+	gettimeofday(&tv1,NULL);
+	nb_factors = ph_factor(N, &factors);
+	gettimeofday(&tv2, NULL);
+	if(nb_factors < 0)
+	{
+		gmp_fprintf(stderr, "Can not factor the order %Zd of the twist.\n", N);
+		exit(1);
+	}
+	gmp_printf("Twist y^2 = x^3 + %Zdx + %Zd of order %Zd =", E.A, E.B, N);
+	for(i = 0; i < nb_factors; i++)
+	{
+		gmp_printf(" %Zd^%d", factors[i].q, factors[i].e);
+	}
+	printf(", factored in %llu microseconds.\n", (unsigned long long int)((tv2.tv_sec - tv1.tv_sec) * 1000000 + tv2.tv_usec - tv1.tv_usec));
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		ph_random_point(&P, E, r_state);
+		nb_order_factors = ph_point_order(order, P, E, N, factors, nb_factors, &order_factors);
+		mpz_urandomm(key, r_state, order);
+		double_and_add(&Q, P, key, E);
+		mpz_set(q_max, order_factors[nb_order_factors - 1].q);
+		printf("*** Test %d ***\n", test_i + 1);
+		
+		gettimeofday(&tv1,NULL);
+		if(pcs_pohlig_hellman(x, P, Q, E, order, order_factors, nb_order_factors, 1, exp->nb_threads, exp->level) != 0 || mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			ph_free_factors(order_factors, nb_order_factors);
+			continue;
+		}
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = 0;
+		for(i = 0; i < nb_order_factors; i++)
+		{
+			gmp_printf("\t%Zd^%d: %d threads, %llu steps, %llu microseconds\n", order_factors[i].q, order_factors[i].e, order_factors[i].nb_threads, order_factors[i].nb_steps, order_factors[i].time);
+			nb_steps += order_factors[i].nb_steps;
+		}
+		printf("\t\t%llu microseconds, %llu steps (%.3f of sqrt(pi q/2) for the largest q, %.2e of sqrt(pi N/2) for the order N)\n", time_run, nb_steps, nb_steps / sqrt(M_PI * mpz_get_d(q_max) / 2), nb_steps / sqrt(M_PI * mpz_get_d(order) / 2));
+		steps_sum += nb_steps;
+		time_sum += time_run;
+		nb_solved++;
+		snprintf(value, 100, "%lu %llu %llu", (unsigned long int)mpz_sizeinbase(q_max, 2), time_run, nb_steps);
+		write_result("pohlig_hellman.all", exp, 1, value);
+		ph_free_factors(order_factors, nb_order_factors);
+	}
+	if(nb_solved > 0)
+	{
+		printf("Average over %d tests: %llu steps, %llu microseconds\n", nb_solved, steps_sum / nb_solved, time_sum / nb_solved);
+	}
+	
+	ph_free_factors(factors, nb_factors);
+	curve_clear(&E);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(N, order, key, x, q_max, NULL);
+	gmp_randclear(r_state);
+}
@@ -0,0 +1,197 @@
+/** @file pcs_exec_shm.c
+ *  @brief The tests of pcs_exec shared by processes through a store in shared memory, as the coordinator or as a worker.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include <omp.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_struct_shm.h"
+
+/** Work on one problem of a shared store, until it is solved.
+ * 
+ * 	@brief Waits for a new problem, then walks with the threads of this 
+ * 	process until the collisions found by all the processes are enough.
+ * 	The context is kept for the next problem if the curve and the adding
+ * 	walk are the same.
+ * 
+ * 	@param[in,out]	ctx			The context of this process, NULL at first.
+ * 	@param[in,out]	problem_id	The last problem solved.
+ * 	@param[out]		nb_steps	The number of steps walked by this process.
+ * 	@return			1 if a problem was solved, 0 if the coordinator shut down.
+ */
+int shm_solve(shm_t *shm, pcs_ctx_t **ctx, int nb_threads, uint32_t *problem_id, unsigned long long int *nb_steps)
+{
+	elliptic_curve_t E;
+	point_t P, Q;
+	mpz_t n, x, A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	pcs_storage_t storage;
+	uint8_t nb_bits, trailling_bits, level;
+	int nb_collisions, j;
+	
+	if(!shm_join(shm, problem_id))
+	{
+		return 0;
+	}
+	curve_init(&E);
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(n, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_inits(A[j], B[j], NULL);
+	}
+	shm_read_problem(shm, &E, n, &P, &Q, A, B, &nb_collisions);
+	
+	if(*ctx != NULL && !same_walk(*ctx, E, n, A, B))
+	{
+		pcs_destroy(*ctx);
+		*ctx = NULL;
+	}
+	if(*ctx == NULL)
+	{
+		shm_get_settings(shm, &nb_bits, &trailling_bits, &level);
+		storage.type = __STRUCT_SHM__;
+		storage.structure = shm;
+		*ctx = pcs_create_with_storage(P, Q, E, &pcs_group_ec, n, A, B, nb_bits, trailling_bits, storage, nb_threads, level);
+		(*ctx)->stop = shm_done(shm);
+	}
+	else
+	{
+		pcs_reset(*ctx, P, Q);
+	}
+	
+	*nb_steps = 0;
+	while(!*shm_done(shm))
+	{
+		if(pcs_run(*ctx, x, 1) > 0)
+		{
+			shm_report_collision(shm, x);
+		}
+		*nb_steps += pcs_steps(*ctx);
+	}
+	shm_leave(shm, *nb_steps);
+	
+	curve_clear(&E);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(n, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_clears(A[j], B[j], NULL);
+	}
+	return 1;
+}
+
+/** Run the tests through a shared store, as the coordinator.
+ * 
+ * 	@brief The coordinator creates the store, publishes the problem of
+ * 	each test and works on it like the other processes. The steps per 
+ * 	second are counted over all the processes.
+ */
+void run_shm_coordinator(experiment_t *exp, char *shm_name, unsigned long int nb_cells)
+{
+	shm_t *shm;
+	pcs_ctx_t *ctx = NULL;
+	point_t P, Q;
+	mpz_t key, x;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, nb_steps_local, memory;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	uint32_t problem_id = 0;
+	int test_i, worker;
+	
+	shm = shm_create(shm_name, exp->nb_bits, exp->trailling_bits, exp->level, nb_cells);
+	if(shm == NULL)
+	{
+		exit(1);
+	}
+	printf("Shared store %s created for %lu points. Start the workers with: pcs_exec --shm-attach %s -t <threads>\n", shm_name, nb_cells, shm_name);
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(key, x, NULL);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		generate_random_key(key, exp->nb_bits - 1, exp->large_prime, r_state);
+		double_and_add(&Q, P, key, exp->E);
+		printf("*** Test %d ***\n", test_i + 1);
+		
+		shm_publish(shm, exp->E, exp->large_prime, P, Q, exp->A, exp->B, exp->nb_collisions);
+		gettimeofday(&tv1,NULL);
+		shm_solve(shm, &ctx, exp->nb_threads, &problem_id, &nb_steps_local);
+		gettimeofday(&tv2, NULL);
+		shm_wait_idle(shm);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = shm_steps(shm);
+		memory = pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+		
+		if(!shm_get_collision(shm, exp->nb_collisions - 1, x, &worker) || mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\tSolved by process %d in %llu microseconds, %d processes attached\n", worker, time_run, shm_nb_workers(shm));
+		printf("\t\tSteps: %llu (%llu by the coordinator), %.0f steps per second\n", nb_steps, nb_steps_local, (double)nb_steps * 1000000.0 / (double)time_run);
+		printf("\t\tMemory: %llu bytes (%.2f%% used)\n", memory, rate_of_use);
+	}
+	
+	shm_shutdown(shm);
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	shm_detach(shm);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(key, x, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Work on the tests of a coordinator, until it shuts down.
+ * 
+ */
+void run_shm_worker(char *shm_name, int nb_threads)
+{
+	shm_t *shm;
+	pcs_ctx_t *ctx = NULL;
+	uint32_t problem_id = 0;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps;
+	
+	shm = shm_attach(shm_name);
+	if(shm == NULL)
+	{
+		exit(1);
+	}
+	printf("Attached to shared store %s as process %d.\n", shm_name, shm_worker_id(shm));
+	fflush(stdout);
+	gettimeofday(&tv1,NULL);
+	while(shm_solve(shm, &ctx, nb_threads, &problem_id, &nb_steps))
+	{
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		printf("Problem %u: %llu steps, %llu microseconds since the last one.\n", problem_id, nb_steps, time_run);
+		fflush(stdout);
+		tv1 = tv2;
+	}
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	shm_detach(shm);
+}
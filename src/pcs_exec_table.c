@@ -0,0 +1,236 @@
+/** @file pcs_exec_table.c
+ *  @brief The tests of pcs_exec that solve several targets on one point: the multi-target mode, and the build and use of a precomputed table.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gmp.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_multi.h"
+#include "pcs_precomp.h"
+
+/** Run the tests in the multi-target mode.
+ * 
+ * 	@brief For each test, nb_targets keys are drawn and their targets are
+ * 	solved one after the other on the point P of the test, keeping the 
+ * 	storage structure (the first chosen one). The time and steps of each
+ * 	target are written in the results file targets.all, and their 
+ * 	averages over the tests are printed at the end.
+ */
+void run_multi_target(experiment_t *exp, int nb_targets, uint8_t struct_i)
+{
+	char value[100];
+	pcs_ctx_t *ctx = NULL;
+	point_t P, Q;
+	mpz_t key, x;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps;
+	unsigned long long int *time_sum, *steps_sum;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	double expected_steps;
+	int test_i, target_i, nb_solved = 0;
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(key, x, NULL);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	time_sum = calloc(nb_targets, sizeof(unsigned long long int));
+	steps_sum = calloc(nb_targets, sizeof(unsigned long long int));
+	expected_steps = sqrt(mpz_get_d(exp->large_prime) * __PI_NUMERATOR__ / (2.0 * __PI_DENOMINATOR__));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		printf("*** Test %d ***\n", test_i + 1);
+		if(ctx == NULL)
+		{
+			ctx = pcs_create(P, P, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+		}
+		else
+		{
+			pcs_reset(ctx, P, P);
+		}
+		pcs_set_targets(ctx, nb_targets);
+		for(target_i = 0; target_i < nb_targets; target_i++)
+		{
+			generate_random_key(key, exp->nb_bits - 1, exp->large_prime, r_state);
+			double_and_add(&Q, P, key, exp->E);
+			
+			gettimeofday(&tv1,NULL);
+			pcs_run_target(ctx, target_i, Q, x);
+			gettimeofday(&tv2, NULL);
+			time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+			time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+			time_run = time2 - time1;
+			nb_steps = pcs_steps(ctx);
+			pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+			
+			if(mpz_cmp(x, key) != 0)
+			{
+				fprintf(stderr, "Error in PCS computation.\n");
+				break;
+			}
+			printf("\t\tTarget %d: %llu microseconds, %llu steps (%.3f sqrt(pi*n/2)), %lu points stored\n", target_i + 1, time_run, nb_steps, (double)nb_steps / expected_steps, nb_points);
+			time_sum[target_i] += time_run;
+			steps_sum[target_i] += nb_steps;
+			snprintf(value, 100, "%d %llu %llu", target_i + 1, time_run, nb_steps);
+			write_result("targets.all", exp, struct_i, value);
+		}
+		nb_solved += (target_i == nb_targets);
+	}
+	
+	if(nb_solved > 0)
+	{
+		printf("Average over %d tests:\n", nb_solved);
+		for(target_i = 0; target_i < nb_targets; target_i++)
+		{
+			printf("\tTarget %d: %llu microseconds, %llu steps (%.3f sqrt(pi*n/2), %.3f of the first target)\n", target_i + 1, time_sum[target_i] / nb_solved, steps_sum[target_i] / nb_solved, (double)steps_sum[target_i] / nb_solved / expected_steps, steps_sum[0] ? (double)steps_sum[target_i] / (double)steps_sum[0] : 0.0);
+		}
+	}
+	
+	if(ctx != NULL && exp->freeze_path != NULL)
+	{
+		freeze_store(ctx, exp->freeze_path);
+	}
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	free(time_sum);
+	free(steps_sum);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(key, x, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Build a table of distinguished points for the curve and the point P of the first test.
+ * 
+ */
+void run_precompute(experiment_t *exp, char *table_path, unsigned long int table_size, uint8_t struct_i)
+{
+	pcs_ctx_t *ctx;
+	point_t P;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps;
+	unsigned long int nb_distinct;
+	int nb_points;
+	
+	point_init(&P);
+	read_point(exp, 0, &P);
+	ctx = pcs_create(P, P, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+	printf("Building a table of %lu points with %d walks per point...\n", table_size, __PRECOMP_OVERSAMPLE__);
+	fflush(stdout);
+	gettimeofday(&tv1,NULL);
+	nb_points = pcs_precompute(ctx, table_path, table_size, &nb_steps, &nb_distinct);
+	gettimeofday(&tv2, NULL);
+	if(nb_points < 0)
+	{
+		exit(1);
+	}
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_run = time2 - time1;
+	printf("Table %s: %d points kept out of %lu distinct ones, %llu steps in %llu microseconds.\n", table_path, nb_points, nb_distinct, nb_steps, time_run);
+	pcs_destroy(ctx);
+	point_clear(&P);
+}
+
+/** Run the tests with a precomputed table.
+ * 
+ * 	@brief The tests are solved on the curve, point P and adding set of 
+ * 	the table, with the storage structure (the first chosen one) emptied 
+ * 	between two tests. The online time and steps of each test are written
+ * 	in the results file table.all, with the size T of the table.
+ */
+void run_with_table(experiment_t *exp, char *table_path, uint8_t struct_i)
+{
+	char value[100];
+	pcs_table_t *table;
+	pcs_ctx_t *ctx;
+	elliptic_curve_t E;
+	point_t P, Q;
+	mpz_t n, key, x, A[__NB_ENSEMBLES__];
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, steps_sum = 0, time_sum = 0;
+	unsigned long int table_size;
+	uint8_t nb_bits, trailling_bits;
+	int test_i, j, nb_solved = 0;
+	
+	curve_init(&E);
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(n, key, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_init(A[j]);
+	}
+	table = pcs_table_load(table_path, &E, n, &P, A, &nb_bits, &trailling_bits);
+	if(table == NULL)
+	{
+		exit(1);
+	}
+	if(E.field != exp->E.field || mpz_cmp(E.p, exp->E.p) != 0 || mpz_cmp(n, exp->large_prime) != 0 || trailling_bits != exp->trailling_bits)
+	{
+		fprintf(stderr, "The table %s was built for another curve or another number of trailling zero bits (-f %d -d %d).\n", table_path, nb_bits, trailling_bits);
+		exit(1);
+	}
+	table_size = pcs_table_size(table);
+	printf("Table %s: %lu points.\n", table_path, table_size);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	ctx = pcs_create(P, P, E, exp->group, n, A, exp->B, nb_bits, trailling_bits, struct_i, exp->nb_threads, exp->level);
+	pcs_set_table(ctx, table);
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		generate_random_key(key, nb_bits - 1, n, r_state);
+		double_and_add(&Q, P, key, E);
+		printf("*** Test %d ***\n", test_i + 1);
+		
+		pcs_set_targets(ctx, 1);
+		gettimeofday(&tv1,NULL);
+		pcs_run_target(ctx, 0, Q, x);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = pcs_steps(ctx);
+		if(mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\t%llu microseconds, %llu online steps\n", time_run, nb_steps);
+		steps_sum += nb_steps;
+		time_sum += time_run;
+		nb_solved++;
+		snprintf(value, 100, "%lu %llu %llu", table_size, time_run, nb_steps);
+		write_result("table.all", exp, struct_i, value);
+	}
+	if(nb_solved > 0)
+	{
+		printf("T = %lu: %llu online steps on average (%.3f sqrt(n/T), %.3f sqrt(pi*n/2)), %llu microseconds\n", table_size, steps_sum / nb_solved, (double)steps_sum / nb_solved / sqrt(mpz_get_d(n) / (double)table_size), (double)steps_sum / nb_solved / sqrt(mpz_get_d(n) * __PI_NUMERATOR__ / (2.0 * __PI_DENOMINATOR__)), time_sum / nb_solved);
+	}
+	
+	pcs_destroy(ctx);
+	pcs_table_free(table);
+	curve_clear(&E);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(n, key, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_clear(A[j]);
+	}
+	gmp_randclear(r_state);
+}
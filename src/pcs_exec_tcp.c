@@ -0,0 +1,366 @@
+/** @file pcs_exec_tcp.c
+ *  @brief The tests of pcs_exec spread over machines by a TCP coordinator and its workers.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include <omp.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_struct_net.h"
+
+#define __TCP_MAX_WORKERS__ 256
+#define __TCP_READ_SIZE__ 65536
+
+/** A worker connected to a TCP coordinator.
+ */
+typedef struct
+{
+	int fd;
+	uint32_t id;
+	unsigned char *buffer;
+	size_t len;
+	size_t size;
+}tcp_worker_t;
+
+/** State of the coordinator while it solves one problem.
+ */
+typedef struct
+{
+	pcs_ctx_t *ctx;
+	mpz_t x;
+	mpz_t x_found;
+	int nb_collisions;
+	uint32_t problem_id;
+	uint32_t frame_problem;
+	uint32_t worker;
+	uint32_t solved_by;
+	unsigned long long int nb_points;
+	unsigned long long int nb_stale;
+}tcp_problem_t;
+
+/** Add a point received from a worker to the store of the coordinator.
+ * 
+ */
+void tcp_add_point(mpz_t xDist, mpz_t a, void *arg)
+{
+	tcp_problem_t *pb = arg;
+	if(pb->frame_problem != pb->problem_id)
+	{
+		//sent before the worker heard that its problem was solved
+		pb->nb_stale++;
+		return;
+	}
+	pb->nb_points++;
+	if(pcs_add_point(pb->ctx, xDist, a, pb->x_found))
+	{
+		if(pb->nb_collisions == 0)
+		{
+			mpz_set(pb->x, pb->x_found);
+			pb->solved_by = pb->worker;
+		}
+		pb->nb_collisions++;
+	}
+}
+
+/** Run the tests with remote workers, as a TCP coordinator.
+ * 
+ * 	@brief The coordinator does not walk: it sends the problem of each 
+ * 	test to the workers, puts the points they send in its storage 
+ * 	structure and looks for collisions. Workers can connect at any time.
+ * 	The ingest rate and the share of time spent reading and storing the
+ * 	points tell if the coordinator is the bottleneck.
+ */
+void run_tcp_coordinator(experiment_t *exp, int port, uint8_t struct_i)
+{
+	pcs_ctx_t *ctx = NULL;
+	tcp_worker_t workers[__TCP_MAX_WORKERS__];
+	struct pollfd fds[__TCP_MAX_WORKERS__ + 1];
+	tcp_problem_t pb;
+	point_t P, Q;
+	mpz_t key;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, time_busy, memory;
+	unsigned long long int nb_frames, nb_bytes;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	const unsigned char *payload;
+	uint32_t payload_len, problem_id = 0, next_id = 0;
+	uint8_t type;
+	size_t frame_len, pos;
+	ssize_t r;
+	int listen_fd, nb_workers = 0;
+	int test_i, i, fd;
+	
+	listen_fd = net_listen(port);
+	if(listen_fd < 0)
+	{
+		fprintf(stderr, "Can not listen on port %d.\n", port);
+		exit(1);
+	}
+	printf("Listening on port %d. Start the workers with: pcs_exec --tcp-connect <host>:%d -t <threads>\n", port, port);
+	fflush(stdout);
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_init(key);
+	mpz_inits(pb.x, pb.x_found, NULL);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		generate_random_key(key, exp->nb_bits - 1, exp->large_prime, r_state);
+		double_and_add(&Q, P, key, exp->E);
+		printf("*** Test %d ***\n", test_i + 1);
+		fflush(stdout);
+		if(ctx == NULL)
+		{
+			ctx = pcs_create(P, Q, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, 1, exp->level);
+		}
+		else
+		{
+			pcs_reset(ctx, P, Q);
+		}
+		problem_id++;
+		for(i = 0; i < nb_workers; i++)
+		{
+			net_send_problem(workers[i].fd, problem_id, workers[i].id, exp->E, exp->large_prime, P, Q, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, exp->level);
+		}
+		pb.ctx = ctx;
+		pb.problem_id = problem_id;
+		pb.nb_collisions = 0;
+		pb.nb_points = 0;
+		pb.nb_stale = 0;
+		nb_frames = 0;
+		nb_bytes = 0;
+		time_busy = 0;
+		gettimeofday(&tv1,NULL);
+		
+		while(pb.nb_collisions < exp->nb_collisions)
+		{
+			fds[0].fd = listen_fd;
+			fds[0].events = POLLIN;
+			for(i = 0; i < nb_workers; i++)
+			{
+				fds[i + 1].fd = workers[i].fd;
+				fds[i + 1].events = POLLIN;
+			}
+			if(poll(fds, nb_workers + 1, 1000) <= 0)
+			{
+				continue;
+			}
+			gettimeofday(&tv2, NULL);
+			time1 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+			for(i = nb_workers - 1; i >= 0; i--)
+			{
+				if(!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)))
+				{
+					continue;
+				}
+				if(workers[i].size - workers[i].len < __TCP_READ_SIZE__)
+				{
+					workers[i].size = 2 * workers[i].size + __TCP_READ_SIZE__;
+					workers[i].buffer = realloc(workers[i].buffer, workers[i].size);
+				}
+				r = recv(workers[i].fd, workers[i].buffer + workers[i].len, workers[i].size - workers[i].len, 0);
+				if(r <= 0)
+				{
+					printf("\t\tWorker %u disconnected.\n", workers[i].id);
+					close(workers[i].fd);
+					free(workers[i].buffer);
+					workers[i] = workers[--nb_workers];
+					continue;
+				}
+				workers[i].len += r;
+				nb_bytes += r;
+				pos = 0;
+				while((frame_len = net_parse_frame(workers[i].buffer + pos, workers[i].len - pos, &type, &payload, &payload_len)) > 0)
+				{
+					pos += frame_len;
+					if(type != __NET_FRAME_POINTS__)
+					{
+						continue;
+					}
+					nb_frames++;
+					if(net_decode_points(payload, payload_len, &pb.frame_problem, &pb.worker, tcp_add_point, &pb) < 0)
+					{
+						fprintf(stderr, "Malformed frame received from worker %u.\n", workers[i].id);
+					}
+				}
+				memmove(workers[i].buffer, workers[i].buffer + pos, workers[i].len - pos);
+				workers[i].len -= pos;
+			}
+			if((fds[0].revents & POLLIN) && (fd = accept(listen_fd, NULL, NULL)) >= 0)
+			{
+				if(nb_workers == __TCP_MAX_WORKERS__)
+				{
+					close(fd);
+				}
+				else
+				{
+					workers[nb_workers].fd = fd;
+					workers[nb_workers].id = next_id++;
+					workers[nb_workers].buffer = NULL;
+					workers[nb_workers].len = 0;
+					workers[nb_workers].size = 0;
+					net_send_problem(fd, problem_id, workers[nb_workers].id, exp->E, exp->large_prime, P, Q, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, exp->level);
+					printf("\t\tWorker %u connected.\n", workers[nb_workers].id);
+					nb_workers++;
+				}
+			}
+			gettimeofday(&tv2, NULL);
+			time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+			time_busy += time2 - time1;
+		}
+		gettimeofday(&tv2, NULL);
+		for(i = 0; i < nb_workers; i++)
+		{
+			net_send_id(workers[i].fd, __NET_FRAME_STOP__, problem_id);
+		}
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		memory = pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+		
+		if(mpz_cmp(pb.x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\tSolved by worker %u in %llu microseconds, %d workers connected\n", pb.solved_by, time_run, nb_workers);
+		printf("\t\tIngest: %llu points in %llu frames, %llu bytes (%.1f bytes per point)\n", pb.nb_points, nb_frames, nb_bytes, pb.nb_points ? (double)nb_bytes / (double)pb.nb_points : 0.0);
+		printf("\t\tIngest rate: %.0f points per second, %.0f bytes per second, busy %.1f%% of the time\n", (double)pb.nb_points * 1000000.0 / (double)time_run, (double)nb_bytes * 1000000.0 / (double)time_run, 100.0 * (double)time_busy / (double)time_run);
+		if(pb.nb_stale > 0)
+		{
+			printf("\t\tDropped %llu points of earlier tests\n", pb.nb_stale);
+		}
+		printf("\t\tMemory: %llu bytes, %lu points stored\n", memory, nb_points);
+		fflush(stdout);
+	}
+	
+	for(i = 0; i < nb_workers; i++)
+	{
+		net_send_frame(workers[i].fd, __NET_FRAME_BYE__, NULL, 0);
+		close(workers[i].fd);
+		free(workers[i].buffer);
+	}
+	close(listen_fd);
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clear(key);
+	mpz_clears(pb.x, pb.x_found, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Work on the tests of a TCP coordinator, until it ends the session.
+ * 
+ * 	@brief The distinguished points are sent to the coordinator instead
+ * 	of being stored, so this process never finds a collision itself and
+ * 	walks until the coordinator tells it that the problem is solved.
+ * 
+ * 	@param[in]	address		The coordinator, as host:port.
+ * 	@param[in]	batch_size	The number of points sent in one frame.
+ * 	@param[in]	compress	1 to send compressed frames.
+ */
+void run_tcp_worker(char *address, int nb_threads, int batch_size, int compress)
+{
+	net_t *net;
+	pcs_ctx_t *ctx = NULL;
+	pcs_storage_t storage;
+	elliptic_curve_t E;
+	point_t P, Q;
+	mpz_t n, x, A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	uint8_t nb_bits, trailling_bits, level;
+	uint32_t problem_id;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, nb_points, nb_bytes, nb_points_before;
+	char *host, *port;
+	int j;
+	
+	host = strdup(address);
+	port = strrchr(host, ':');
+	if(port == NULL)
+	{
+		fprintf(stderr, "The coordinator is given as host:port.\n");
+		exit(1);
+	}
+	*port++ = '\0';
+	net = net_connect(host, atoi(port), nb_threads, batch_size, compress);
+	if(net == NULL)
+	{
+		exit(1);
+	}
+	printf("Connected to coordinator %s.\n", address);
+	fflush(stdout);
+	
+	curve_init(&E);
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(n, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_inits(A[j], B[j], NULL);
+	}
+	nb_points_before = 0;
+	while(net_wait_problem(net, &E, n, &P, &Q, A, B, &nb_bits, &trailling_bits, &level, &problem_id))
+	{
+		if(ctx != NULL && (!same_walk(ctx, E, n, A, B) || ctx->nb_bits != nb_bits || ctx->trailling_bits != trailling_bits))
+		{
+			pcs_destroy(ctx);
+			ctx = NULL;
+		}
+		if(ctx == NULL)
+		{
+			storage.type = __STRUCT_NET__;
+			storage.structure = net;
+			ctx = pcs_create_with_storage(P, Q, E, &pcs_group_ec, n, A, B, nb_bits, trailling_bits, storage, nb_threads, level);
+			ctx->stop = net_stop(net);
+		}
+		else
+		{
+			pcs_reset(ctx, P, Q);
+		}
+		gettimeofday(&tv1,NULL);
+		pcs_run(ctx, x, 1);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = pcs_steps(ctx);
+		net_sent(net, &nb_points, &nb_bytes);
+		printf("Problem %u: %llu steps in %llu microseconds, %llu points sent.\n", problem_id, nb_steps, time_run, nb_points - nb_points_before);
+		fflush(stdout);
+		nb_points_before = nb_points;
+	}
+	net_sent(net, &nb_points, &nb_bytes);
+	printf("Session over: %llu points sent in %llu bytes.\n", nb_points, nb_bytes);
+	
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	net_close(net);
+	free(host);
+	curve_clear(&E);
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(n, x, NULL);
+	for(j = 0; j < __NB_ENSEMBLES__; j++)
+	{
+		mpz_clears(A[j], B[j], NULL);
+	}
+}
@@ -0,0 +1,433 @@
+/** @file pcs_exec_tests.c
+ *  @brief The tests of logarithms of pcs_exec, with the chosen structures or with a fingerprint store, and the runs on a checkpoint or a frozen store.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include <omp.h>
+#include <inttypes.h>
+#include <sys/time.h>
+#include "pcs_exec.h"
+#include "pcs_checkpoint.h"
+#include "pcs_adaptive.h"
+#include "pcs_orbit.h"
+#include "pcs_struct_frozen.h"
+#include "pcs_struct_fingerprint.h"
+
+/** Run the tests of one group.
+ * 
+ * 	@brief Group g runs the tests g, g + G, g + 2G... where G is the number 
+ * 	of groups. A group owns one PCS context per structure, which is reset 
+ * 	in place between two tests.
+ * 
+ * 	@param[in]	exp			The experiment settings.
+ * 	@param[in]	group_i		The index of the group.
+ */
+void run_tests(experiment_t *exp, int group_i)
+{
+	char value[100];
+	char schedule[1000];
+	point_t P;
+	point_t Q;
+	mpz_t key;
+	mpz_t x;
+	pcs_ctx_t *ctx[__NB_STRUCTURES__] = {NULL};
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, time_setup;
+	unsigned long long int memory;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	uint8_t struct_i;
+	int test_i, i, len;
+	rate_slots = 0.0;
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(x, key, NULL);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed((unsigned long int)group_i + 1));
+	
+	test_i = group_i;
+	while(test_i < exp->nb_tests)
+	{
+		/*** read point P ***/
+		read_point(exp, test_i, &P);
+		
+		//choose a key of size: nb_bits
+		generate_random_key(key, exp->nb_bits - 1, exp->large_prime, r_state);
+		//compute Q
+		exp->group->exp(&Q, P, key, exp->E);
+		
+		/* Test different structures */
+		printf("*** Test %d ***\n", test_i + 1);
+		for(struct_i = 0; struct_i < __NB_STRUCTURES__; struct_i++)
+		{
+			if(exp->structs[struct_i] == 1)
+			{
+				printf("\t**Structure %s\n", exp->struct_i_str[struct_i]);
+				
+				/*** The structure and the walkers are built once and reset in place between tests ***/
+				gettimeofday(&tv1,NULL);
+				if(ctx[struct_i] != NULL)
+				{
+					pcs_reset(ctx[struct_i], P, Q);
+				}
+				else
+				{
+					ctx[struct_i] = pcs_create(P, Q, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, struct_i, exp->nb_threads, exp->level);
+					if(exp->orbit)
+					{
+						orbit_enable(ctx[struct_i]);
+					}
+					pcs_set_step(ctx[struct_i], exp->step_type);
+					if(exp->checkpoint_path != NULL)
+					{
+						pcs_set_checkpoint(ctx[struct_i], exp->checkpoint_path, exp->checkpoint_interval);
+					}
+					if(exp->adaptive_points > 0)
+					{
+						pcs_set_adaptive(ctx[struct_i], exp->adaptive_points);
+					}
+				}
+				gettimeofday(&tv2, NULL);
+				time1=(tv1.tv_sec) * 1000000 + tv1.tv_usec;
+				time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+				time_setup = time2 - time1;
+				
+				gettimeofday(&tv1,NULL);
+				pcs_run(ctx[struct_i], x, exp->nb_collisions);
+				gettimeofday(&tv2, NULL);
+				time1=(tv1.tv_sec) * 1000000 + tv1.tv_usec;
+				time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+				time_run = time2 - time1;
+                memory = pcs_memory(ctx[struct_i], &nb_points, &rate_of_use, &rate_slots);
+                
+				if(mpz_cmp(x, key)!=0)
+				{
+					fprintf(stderr, "Error in PCS computation.\n");
+					//exit(2);
+					break;
+				}
+				
+				#pragma omp critical (results)
+				{
+					/*** Write execution time ***/
+					snprintf(value, 100, "%llu", time_run);
+					write_result("time.all", exp, struct_i, value);
+					
+					/*** Write setup time ***/
+					snprintf(value, 100, "%llu", time_setup);
+					write_result("setup.all", exp, struct_i, value);
+					
+					/*** Write memory usage ***/
+					snprintf(value, 100, "%llu", memory);
+					write_result("memory.all", exp, struct_i, value);
+					
+					/*** Write number of steps ***/
+					snprintf(value, 100, "%llu %d %s", pcs_steps(ctx[struct_i]), ctx[struct_i]->orbit, step_name(ctx[struct_i]));
+					write_result("steps.all", exp, struct_i, value);
+					
+					/*** Write number of stored points ***/
+					snprintf(value, 100, "%lu", nb_points);
+					write_result("points.all", exp, struct_i, value);
+					
+					/*** Write rate of memory use ***/
+					snprintf(value, 100, "%.2f (%.2f)", rate_of_use, rate_slots);
+					write_result("rate.all", exp, struct_i, value);
+					
+					/*** Write the schedule of the number of trailling zero bits, as d:time:steps:points from the start ***/
+					if(exp->adaptive_points > 0)
+					{
+						len = snprintf(schedule, 1000, "%lu %d %llu %llu %lu", exp->adaptive_points, ctx[struct_i]->trailling_bits, time_run, memory, nb_points);
+						for(i = 0; i < ctx[struct_i]->schedule_size && len < 1000; i++)
+						{
+							len += snprintf(schedule + len, 1000 - len, " %d:%llu:%llu:%lu", ctx[struct_i]->schedule[i].trailling_bits, ctx[struct_i]->schedule[i].time, ctx[struct_i]->schedule[i].nb_steps, ctx[struct_i]->schedule[i].nb_points);
+						}
+						write_result("d_schedule.all", exp, struct_i, schedule);
+					}
+				}
+			}
+		}
+		test_i += exp->nb_groups;
+	}
+	for(struct_i = 0; struct_i < __NB_STRUCTURES__; struct_i++)
+	{
+		if(ctx[struct_i] != NULL && exp->freeze_path != NULL)
+		{
+			freeze_store(ctx[struct_i], exp->freeze_path);
+		}
+		if(ctx[struct_i] != NULL)
+		{
+			pcs_destroy(ctx[struct_i]);
+		}
+	}
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(x, key, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Run the tests with a fingerprint store of k-bit fingerprints.
+ * 
+ * 	@brief The store of nb_points records is created once and emptied
+ * 	between two tests. The time, steps and points of each test are written
+ * 	in the results file fingerprint.all, with the false matches told by
+ * 	the re-walks, their steps and the points dropped by full buckets. The
+ * 	points per GB and the share of the steps spent on false matches are
+ * 	printed at the end.
+ */
+void run_fingerprint(experiment_t *exp, int fingerprint_bits, unsigned long int fingerprint_points)
+{
+	char value[200];
+	pcs_ctx_t *ctx = NULL;
+	pcs_storage_t storage;
+	point_t P, Q;
+	mpz_t key, x;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_run, time1, time2, nb_steps, memory;
+	unsigned long long int steps_sum = 0, false_steps_sum = 0, false_sum = 0, memory_sum = 0;
+	unsigned long int nb_points, points_sum = 0, dropped, nb_slots = 0;
+	float rate_of_use, rate_slots;
+	int test_i, nb_solved = 0;
+	
+	point_init(&P);
+	point_init(&Q);
+	mpz_inits(key, x, NULL);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, random_seed(0));
+	for(test_i = 0; test_i < exp->nb_tests; test_i++)
+	{
+		read_point(exp, test_i, &P);
+		generate_random_key(key, exp->nb_bits - 1, exp->large_prime, r_state);
+		exp->group->exp(&Q, P, key, exp->E);
+		printf("*** Test %d ***\n", test_i + 1);
+		if(ctx == NULL)
+		{
+			storage.type = __STRUCT_FINGERPRINT__;
+			storage.structure = fingerprint_create(exp->nb_bits, fingerprint_bits, fingerprint_points);
+			ctx = pcs_create_with_storage(P, Q, exp->E, exp->group, exp->large_prime, exp->A, exp->B, exp->nb_bits, exp->trailling_bits, storage, exp->nb_threads, exp->level);
+			if(exp->orbit)
+			{
+				orbit_enable(ctx);
+			}
+			pcs_set_step(ctx, exp->step_type);
+			nb_slots = fingerprint_slots(storage.structure);
+			printf("Fingerprints of %d bits, records of %d bytes, %lu records.\n", fingerprint_bits, fingerprint_record_bytes(storage.structure), nb_slots);
+		}
+		else
+		{
+			pcs_reset(ctx, P, Q);
+		}
+		gettimeofday(&tv1,NULL);
+		pcs_run(ctx, x, exp->nb_collisions);
+		gettimeofday(&tv2, NULL);
+		time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+		time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+		time_run = time2 - time1;
+		nb_steps = pcs_steps(ctx);
+		memory = pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+		dropped = fingerprint_dropped(ctx->storage.structure);
+		if(mpz_cmp(x, key) != 0)
+		{
+			fprintf(stderr, "Error in PCS computation.\n");
+			continue;
+		}
+		printf("\t\t%llu microseconds, %llu steps, %lu points, %llu false matches (%llu steps), %lu dropped\n", time_run, nb_steps, nb_points, ctx->nb_false_matches, ctx->nb_false_steps, dropped);
+		steps_sum += nb_steps;
+		false_steps_sum += ctx->nb_false_steps;
+		false_sum += ctx->nb_false_matches;
+		points_sum += nb_points;
+		memory_sum += memory;
+		nb_solved++;
+		snprintf(value, 200, "%d %llu %llu %lu %llu %llu %llu %lu", fingerprint_bits, time_run, nb_steps, nb_points, memory, ctx->nb_false_matches, ctx->nb_false_steps, dropped);
+		write_result("fingerprint.all", exp, __STRUCT_I_FINGERPRINT__, value);
+	}
+	if(nb_solved > 0 && points_sum > 0)
+	{
+		printf("k = %d: %.0f points per GB when full, %.0f at the end of the tests (%.1f bytes per point), %.4f false matches per point, re-walks of false matches %.3f%% of the steps.\n", fingerprint_bits, (double)nb_slots * nb_solved / (double)memory_sum * (1 << 30), (double)points_sum / (double)memory_sum * (1 << 30), (double)memory_sum / (double)points_sum, (double)false_sum / (double)points_sum, 100.0 * (double)false_steps_sum / (double)steps_sum);
+	}
+	if(ctx != NULL)
+	{
+		pcs_destroy(ctx);
+	}
+	point_clear(&P);
+	point_clear(&Q);
+	mpz_clears(key, x, NULL);
+	gmp_randclear(r_state);
+}
+
+/** Point gathered from a frozen store by frozen_check.
+ */
+typedef struct
+{
+	mpz_t *xDist;
+	mpz_t *a;
+	unsigned long int nb_points;
+}frozen_keys_t;
+
+/** Keep one point of a frozen store, called by struct_foreach.
+ * 
+ */
+void frozen_keep(mpz_t xDist, mpz_t a, void *arg)
+{
+	frozen_keys_t *keys = arg;
+	mpz_init_set(keys->xDist[keys->nb_points], xDist);
+	mpz_init_set(keys->a[keys->nb_points], a);
+	keys->nb_points++;
+}
+
+/** Map a frozen store and measure its lookups.
+ * 
+ * 	@brief Every stored point is looked up and its a coefficient checked,
+ * 	then as many random x coordinates of the same size, which are almost
+ * 	never stored.
+ */
+void frozen_check(char *frozen_path)
+{
+	pcs_storage_t storage;
+	frozen_keys_t keys;
+	mpz_t a_out, *misses;
+	gmp_randstate_t r_state;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_open, time_hits, time_misses, time1, time2, memory;
+	unsigned long int nb_points, i, nb_errors = 0, nb_found = 0;
+	float rate_of_use, rate_slots;
+	uint8_t nb_bits, trailling_bits;
+	size_t x_bits = 1;
+	
+	gettimeofday(&tv1,NULL);
+	storage.type = __STRUCT_FROZEN__;
+	storage.structure = frozen_open(frozen_path);
+	gettimeofday(&tv2, NULL);
+	if(storage.structure == NULL)
+	{
+		exit(1);
+	}
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_open = time2 - time1;
+	frozen_settings(storage.structure, &nb_bits, &trailling_bits);
+	printf("Frozen store %s (-f %d -d %d), opened in %llu microseconds:\n", frozen_path, nb_bits, trailling_bits, time_open);
+	memory = struct_memory(&storage, &nb_points, &rate_of_use, &rate_slots);
+	printf("\t\tFile size: %llu bytes (%.2f bytes per point)\n", memory, nb_points ? (double)memory / nb_points : 0.0);
+	
+	keys.xDist = malloc(sizeof(mpz_t) * (nb_points + 1));
+	keys.a = malloc(sizeof(mpz_t) * (nb_points + 1));
+	misses = malloc(sizeof(mpz_t) * (nb_points + 1));
+	keys.nb_points = 0;
+	struct_foreach(&storage, frozen_keep, &keys);
+	mpz_init(a_out);
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, (unsigned long int)time(NULL));
+	for(i = 0; i < nb_points; i++)
+	{
+		if(mpz_sizeinbase(keys.xDist[i], 2) > x_bits)
+		{
+			x_bits = mpz_sizeinbase(keys.xDist[i], 2);
+		}
+	}
+	for(i = 0; i < nb_points; i++)
+	{
+		mpz_init(misses[i]);
+		mpz_urandomb(misses[i], r_state, x_bits);
+	}
+	
+	gettimeofday(&tv1,NULL);
+	for(i = 0; i < nb_points; i++)
+	{
+		if(!struct_add(&storage, a_out, NULL, keys.xDist[i], NULL) || mpz_cmp(a_out, keys.a[i]) != 0)
+		{
+			nb_errors++;
+		}
+	}
+	gettimeofday(&tv2, NULL);
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_hits = time2 - time1;
+	
+	gettimeofday(&tv1,NULL);
+	for(i = 0; i < nb_points; i++)
+	{
+		nb_found += struct_add(&storage, a_out, NULL, misses[i], NULL);
+	}
+	gettimeofday(&tv2, NULL);
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_misses = time2 - time1;
+	
+	printf("\t\tStored points: %.1f ns per lookup, %lu not found or with a wrong coefficient\n", nb_points ? 1000.0 * time_hits / nb_points : 0.0, nb_errors);
+	printf("\t\tRandom points: %.1f ns per lookup, %lu found\n", nb_points ? 1000.0 * time_misses / nb_points : 0.0, nb_found);
+	if(nb_errors > 0)
+	{
+		fprintf(stderr, "Error in the frozen store %s.\n", frozen_path);
+	}
+	
+	for(i = 0; i < nb_points; i++)
+	{
+		mpz_clears(keys.xDist[i], keys.a[i], misses[i], NULL);
+	}
+	free(keys.xDist);
+	free(keys.a);
+	free(misses);
+	mpz_clear(a_out);
+	gmp_randclear(r_state);
+	struct_free(&storage);
+}
+
+/** Resume a solve from a checkpoint.
+ * 
+ * 	@brief The solve goes on until the requested number of collisions is 
+ * 	found and the result is checked against Q. Nothing is written in the 
+ * 	results files, since the run does not cover the whole solve.
+ */
+void resume_test(char *resume_path, char *checkpoint_path, int checkpoint_interval, int nb_threads, int nb_collisions)
+{
+	pcs_ctx_t *ctx;
+	mpz_t x;
+	point_t R;
+	struct timeval tv1;
+	struct timeval tv2;
+	unsigned long long int time_load, time_run, time1, time2;
+	unsigned long int nb_points;
+	float rate_of_use, rate_slots;
+	
+	gettimeofday(&tv1,NULL);
+	ctx = pcs_checkpoint_load(resume_path, nb_threads, &nb_points);
+	if(ctx == NULL)
+	{
+		exit(1);
+	}
+	gettimeofday(&tv2, NULL);
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_load = time2 - time1;
+	printf("Resumed %lu points of a %d-bit curve (d = %d) from %s in %llu microseconds.\n", nb_points, ctx->nb_bits, ctx->trailling_bits, resume_path, time_load);
+	pcs_set_checkpoint(ctx, checkpoint_path, checkpoint_interval);
+	
+	mpz_init(x);
+	point_init(&R);
+	gettimeofday(&tv1,NULL);
+	pcs_run(ctx, x, nb_collisions);
+	gettimeofday(&tv2, NULL);
+	time1 = (tv1.tv_sec) * 1000000 + tv1.tv_usec;
+	time2 = (tv2.tv_sec) * 1000000 + tv2.tv_usec;
+	time_run = time2 - time1;
+	pcs_memory(ctx, &nb_points, &rate_of_use, &rate_slots);
+	
+	double_and_add(&R, ctx->P, x, ctx->E);
+	if(!equal(R, ctx->Q))
+	{
+		fprintf(stderr, "Error in PCS computation.\n");
+	}
+	gmp_printf("x = %Zd, found in %llu microseconds after resuming.\n", x, time_run);
+	
+	pcs_destroy(ctx);
+	mpz_clear(x);
+	point_clear(&R);
+}
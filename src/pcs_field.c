@@ -0,0 +1,606 @@
+/** @file pcs_field.c
+ *  @brief Montgomery arithmetic on 1 to 3 words, with kernels chosen from the processor.
+ *
+ *	The elements of a field of p < 2^(64n), n = 1, 2 or 3, are kept in
+ *	Montgomery form aR mod p, R = 2^(64n), as n words. A multiplication
+ *	interleaves the product and the reduction word by word (CIOS).
+ *
+ *	The generic kernel is portable C on 128-bit integers, and squares
+ *	with its multiplication. The MULX kernel is x86-64 assembly, one block
+ *	per operation and number of words, with the BMI2 and ADX instructions:
+ *	mulx leaves the flags alone and adcx and adox carry on two separate
+ *	flags, so that the low and the high halves of a row of products are
+ *	added with two carry chains that do not wait for each other. Its
+ *	squaring computes the n(n-1)/2 cross products once, doubles them and
+ *	adds the squares, then reduces the double-length product (SOS). The
+ *	best kernel is found once, with CPUID, the first time it is asked for.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "pcs_field.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define __FIELD_MULX_BUILD__
+#include <cpuid.h>
+#include <immintrin.h>
+#define __FIELD_MULX_TARGET__ __attribute__((target("bmi2,adx")))
+#endif
+
+#define __FIELD_INLINE__ static inline __attribute__((always_inline))
+
+/** Subtract p from t[0..n-1] + t[n]2^(64n), below 2p, if it is not below p.
+ *
+ *	@brief The choice is made with a mask rather than a branch, which
+ *	would be mispredicted about once every two calls.
+ */
+__FIELD_INLINE__ void mont_final(uint64_t *r, const uint64_t *t, const field_t *F, int n)
+{
+	uint64_t s[__FIELD_MAX_LIMBS__];
+	unsigned __int128 d;
+	uint64_t borrow = 0, mask;
+	int j;
+	for(j = 0; j < n; j++)
+	{
+		d = (unsigned __int128)t[j] - F->p[j] - borrow;
+		s[j] = (uint64_t)d;
+		borrow = (uint64_t)(d >> 64) & 1;
+	}
+	mask = -(uint64_t)((t[n] != 0) | (borrow ^ 1));
+	for(j = 0; j < n; j++)
+	{
+		r[j] = (s[j] & mask) | (t[j] & ~mask);
+	}
+}
+
+__FIELD_INLINE__ void mont_mul_generic(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F, int n)
+{
+	uint64_t t[__FIELD_MAX_LIMBS__ + 2];
+	unsigned __int128 c;
+	uint64_t m;
+	int i, j;
+	for(j = 0; j < n + 2; j++)
+	{
+		t[j] = 0;
+	}
+	for(i = 0; i < n; i++)
+	{
+		c = 0;
+		for(j = 0; j < n; j++)
+		{
+			c = (unsigned __int128)a[j] * b[i] + t[j] + (uint64_t)(c >> 64);
+			t[j] = (uint64_t)c;
+		}
+		c = (unsigned __int128)t[n] + (uint64_t)(c >> 64);
+		t[n] = (uint64_t)c;
+		t[n + 1] = (uint64_t)(c >> 64);
+		m = t[0] * F->pinv;
+		c = (unsigned __int128)m * F->p[0] + t[0];
+		for(j = 1; j < n; j++)
+		{
+			c = (unsigned __int128)m * F->p[j] + t[j] + (uint64_t)(c >> 64);
+			t[j - 1] = (uint64_t)c;
+		}
+		c = (unsigned __int128)t[n] + (uint64_t)(c >> 64);
+		t[n - 1] = (uint64_t)c;
+		t[n] = t[n + 1] + (uint64_t)(c >> 64);
+	}
+	mont_final(r, t, F, n);
+}
+
+static void mul_generic_1(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	mont_mul_generic(r, a, b, F, 1);
+}
+
+static void mul_generic_2(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	mont_mul_generic(r, a, b, F, 2);
+}
+
+static void mul_generic_3(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	mont_mul_generic(r, a, b, F, 3);
+}
+
+static void sqr_generic_1(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	(void)b;
+	mont_mul_generic(r, a, a, F, 1);
+}
+
+static void sqr_generic_2(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	(void)b;
+	mont_mul_generic(r, a, a, F, 2);
+}
+
+static void sqr_generic_3(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	(void)b;
+	mont_mul_generic(r, a, a, F, 3);
+}
+
+#ifdef __FIELD_MULX_BUILD__
+
+/** The rows of a multiplication on n = 1, 2 or 3 words, added to t[0..n+1] with t[n+1] = 0.
+ *
+ */
+#define __MUL_ROW_1__(v) \
+		"xorl %k[lo], %k[lo]\n\t" \
+		__ROW_STEP__(0, 1, v) \
+		__ROW_CARRY__(1, 2)
+#define __MUL_ROW_2__(v) \
+		"xorl %k[lo], %k[lo]\n\t" \
+		__ROW_STEP__(0, 1, v) \
+		__ROW_STEP__(1, 2, v) \
+		__ROW_CARRY__(2, 3)
+#define __MUL_ROW_3__(v) \
+		"xorl %k[lo], %k[lo]\n\t" \
+		__ROW_STEP__(0, 1, v) \
+		__ROW_STEP__(1, 2, v) \
+		__ROW_STEP__(2, 3, v) \
+		__ROW_CARRY__(3, 4)
+#define __ROW_STEP__(j, k, v) \
+		"mulxq " #j "*8(%[" v "]), %[lo], %[hi]\n\t" \
+		"adcxq %[lo], %[t" #j "]\n\t" \
+		"adoxq %[hi], %[t" #k "]\n\t"
+#define __ROW_CARRY__(n, m) \
+		"adcxq %[z], %[t" #n "]\n\t" \
+		"adoxq %[z], %[t" #m "]\n\t" \
+		"adcxq %[z], %[t" #m "]\n\t"
+
+/** One step of CIOS: t = (t + a b[i] + m p)/2^64, with m = (t + a b[i]) p^-1 mod 2^64.
+ *
+ *	@brief t[0] is 0 once m p is added, the words are moved down by one
+ *	and t[n+1] is set back to 0.
+ */
+#define __MUL_STEP_1__(i) \
+		"movq " #i "*8(%[b]), %%rdx\n\t" \
+		__MUL_ROW_1__("a") \
+		"movq %[t0], %%rdx\n\t" \
+		"imulq %[pinv], %%rdx\n\t" \
+		__MUL_ROW_1__("p") \
+		"movq %[t1], %[t0]\n\t" \
+		"movq %[t2], %[t1]\n\t" \
+		"xorl %k[t2], %k[t2]\n\t"
+#define __MUL_STEP_2__(i) \
+		"movq " #i "*8(%[b]), %%rdx\n\t" \
+		__MUL_ROW_2__("a") \
+		"movq %[t0], %%rdx\n\t" \
+		"imulq %[pinv], %%rdx\n\t" \
+		__MUL_ROW_2__("p") \
+		"movq %[t1], %[t0]\n\t" \
+		"movq %[t2], %[t1]\n\t" \
+		"movq %[t3], %[t2]\n\t" \
+		"xorl %k[t3], %k[t3]\n\t"
+#define __MUL_STEP_3__(i) \
+		"movq " #i "*8(%[b]), %%rdx\n\t" \
+		__MUL_ROW_3__("a") \
+		"movq %[t0], %%rdx\n\t" \
+		"imulq %[pinv], %%rdx\n\t" \
+		__MUL_ROW_3__("p") \
+		"movq %[t1], %[t0]\n\t" \
+		"movq %[t2], %[t1]\n\t" \
+		"movq %[t3], %[t2]\n\t" \
+		"movq %[t4], %[t3]\n\t" \
+		"xorl %k[t4], %k[t4]\n\t"
+
+/** Multiplication on 1 to 3 words, in one block of assembly.
+ *
+ *	@brief t stays in registers from the first row to the final
+ *	subtraction of p, which is done with sbb and kept or not with cmov:
+ *	the borrow out of t[n] is set exactly when t is below p.
+ */
+__FIELD_MULX_TARGET__ static void mul_mulx_1(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t0, t1, t2, lo, hi, z;
+	__asm__("xorl %k[z], %k[z]\n\t"
+		"xorl %k[t0], %k[t0]\n\t"
+		"xorl %k[t1], %k[t1]\n\t"
+		"xorl %k[t2], %k[t2]\n\t"
+		__MUL_STEP_1__(0)
+		"movq %[t0], %[lo]\n\t"
+		"subq 0*8(%[p]), %[lo]\n\t"
+		"sbbq $0, %[t1]\n\t"
+		"cmovncq %[lo], %[t0]\n\t"
+		: [t0] "=&r" (t0), [t1] "=&r" (t1), [t2] "=&r" (t2), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+		: [a] "r" (a), [b] "r" (b), [p] "r" (F->p), [pinv] "m" (F->pinv)
+		: "rdx", "cc", "memory");
+	r[0] = t0;
+}
+
+__FIELD_MULX_TARGET__ static void mul_mulx_2(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t0, t1, t2, t3, lo, hi, z;
+	__asm__("xorl %k[z], %k[z]\n\t"
+		"xorl %k[t0], %k[t0]\n\t"
+		"xorl %k[t1], %k[t1]\n\t"
+		"xorl %k[t2], %k[t2]\n\t"
+		"xorl %k[t3], %k[t3]\n\t"
+		__MUL_STEP_2__(0)
+		__MUL_STEP_2__(1)
+		"movq %[t0], %[lo]\n\t"
+		"subq 0*8(%[p]), %[lo]\n\t"
+		"movq %[t1], %[hi]\n\t"
+		"sbbq 1*8(%[p]), %[hi]\n\t"
+		"sbbq $0, %[t2]\n\t"
+		"cmovncq %[lo], %[t0]\n\t"
+		"cmovncq %[hi], %[t1]\n\t"
+		: [t0] "=&r" (t0), [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+		: [a] "r" (a), [b] "r" (b), [p] "r" (F->p), [pinv] "m" (F->pinv)
+		: "rdx", "cc", "memory");
+	r[0] = t0;
+	r[1] = t1;
+}
+
+__FIELD_MULX_TARGET__ static void mul_mulx_3(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t0, t1, t2, t3, t4, lo, hi, z;
+	__asm__("xorl %k[z], %k[z]\n\t"
+		"xorl %k[t0], %k[t0]\n\t"
+		"xorl %k[t1], %k[t1]\n\t"
+		"xorl %k[t2], %k[t2]\n\t"
+		"xorl %k[t3], %k[t3]\n\t"
+		"xorl %k[t4], %k[t4]\n\t"
+		__MUL_STEP_3__(0)
+		__MUL_STEP_3__(1)
+		__MUL_STEP_3__(2)
+		"movq %[t0], %[lo]\n\t"
+		"subq 0*8(%[p]), %[lo]\n\t"
+		"movq %[t1], %[hi]\n\t"
+		"sbbq 1*8(%[p]), %[hi]\n\t"
+		"movq %[t2], %[z]\n\t"
+		"sbbq 2*8(%[p]), %[z]\n\t"
+		"sbbq $0, %[t3]\n\t"
+		"cmovncq %[lo], %[t0]\n\t"
+		"cmovncq %[hi], %[t1]\n\t"
+		"cmovncq %[z], %[t2]\n\t"
+		: [t0] "=&r" (t0), [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), [t4] "=&r" (t4), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+		: [a] "r" (a), [b] "r" (b), [p] "r" (F->p), [pinv] "m" (F->pinv)
+		: "rdx", "cc", "memory");
+	r[0] = t0;
+	r[1] = t1;
+	r[2] = t2;
+}
+
+/** A row of the reduction of a square on 3 words: t[i..] += m p, m = t[i] p^-1 mod 2^64.
+ *
+ *	@brief Both carry chains are carried up to t6, which the sum never
+ *	overflows.
+ */
+#define __SQR_REDUCE_3__(i, j, k, l) \
+		"movq %[t" #i "], %%rdx\n\t" \
+		"imulq %[pinv], %%rdx\n\t" \
+		"xorl %k[lo], %k[lo]\n\t" \
+		"mulxq 0*8(%[p]), %[lo], %[hi]\n\t" \
+		"adcxq %[lo], %[t" #i "]\n\t" \
+		"adoxq %[hi], %[t" #j "]\n\t" \
+		"mulxq 1*8(%[p]), %[lo], %[hi]\n\t" \
+		"adcxq %[lo], %[t" #j "]\n\t" \
+		"adoxq %[hi], %[t" #k "]\n\t" \
+		"mulxq 2*8(%[p]), %[lo], %[hi]\n\t" \
+		"adcxq %[lo], %[t" #k "]\n\t" \
+		"adoxq %[hi], %[t" #l "]\n\t" \
+		"adcxq %[z], %[t" #l "]\n\t"
+#define __SQR_CARRY__(j) \
+		"adcxq %[z], %[t" #j "]\n\t" \
+		"adoxq %[z], %[t" #j "]\n\t"
+
+/** Squaring on 2 and 3 words, in one block of assembly.
+ *
+ *	@brief The cross products a[i]a[j], i < j, are computed once and
+ *	doubled, the squares a[i]^2 are added, and the 2n words are reduced
+ *	with n rows of m p, then p is subtracted as in mul_mulx_3.
+ */
+__FIELD_MULX_TARGET__ static void sqr_mulx_2(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t0, t1, t2, t3, t4, lo, hi, z;
+	(void)b;
+	__asm__("xorl %k[z], %k[z]\n\t"
+		"xorl %k[t4], %k[t4]\n\t"
+		//cross product
+		"movq 0*8(%[a]), %%rdx\n\t"
+		"mulxq 1*8(%[a]), %[t1], %[t2]\n\t"
+		//doubled
+		"xorl %k[t3], %k[t3]\n\t"
+		"addq %[t1], %[t1]\n\t"
+		"adcq %[t2], %[t2]\n\t"
+		"adcq %[z], %[t3]\n\t"
+		//plus the squares
+		"mulxq %%rdx, %[t0], %[hi]\n\t"
+		"addq %[hi], %[t1]\n\t"
+		"movq 1*8(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %[lo], %[hi]\n\t"
+		"adcq %[lo], %[t2]\n\t"
+		"adcq %[hi], %[t3]\n\t"
+		//reduced
+		"movq %[t0], %%rdx\n\t"
+		"imulq %[pinv], %%rdx\n\t"
+		"xorl %k[lo], %k[lo]\n\t"
+		"mulxq 0*8(%[p]), %[lo], %[hi]\n\t"
+		"adcxq %[lo], %[t0]\n\t"
+		"adoxq %[hi], %[t1]\n\t"
+		"mulxq 1*8(%[p]), %[lo], %[hi]\n\t"
+		"adcxq %[lo], %[t1]\n\t"
+		"adoxq %[hi], %[t2]\n\t"
+		"adcxq %[z], %[t2]\n\t"
+		__SQR_CARRY__(3)
+		__SQR_CARRY__(4)
+		"movq %[t1], %%rdx\n\t"
+		"imulq %[pinv], %%rdx\n\t"
+		"xorl %k[lo], %k[lo]\n\t"
+		"mulxq 0*8(%[p]), %[lo], %[hi]\n\t"
+		"adcxq %[lo], %[t1]\n\t"
+		"adoxq %[hi], %[t2]\n\t"
+		"mulxq 1*8(%[p]), %[lo], %[hi]\n\t"
+		"adcxq %[lo], %[t2]\n\t"
+		"adoxq %[hi], %[t3]\n\t"
+		"adcxq %[z], %[t3]\n\t"
+		__SQR_CARRY__(4)
+		//minus p
+		"movq %[t2], %[lo]\n\t"
+		"subq 0*8(%[p]), %[lo]\n\t"
+		"movq %[t3], %[hi]\n\t"
+		"sbbq 1*8(%[p]), %[hi]\n\t"
+		"sbbq $0, %[t4]\n\t"
+		"cmovncq %[lo], %[t2]\n\t"
+		"cmovncq %[hi], %[t3]\n\t"
+		: [t0] "=&r" (t0), [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), [t4] "=&r" (t4), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+		: [a] "r" (a), [p] "r" (F->p), [pinv] "m" (F->pinv)
+		: "rdx", "cc", "memory");
+	r[0] = t2;
+	r[1] = t3;
+}
+
+__FIELD_MULX_TARGET__ static void sqr_mulx_3(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t0, t1, t2, t3, t4, t5, t6, lo, hi, z;
+	(void)b;
+	__asm__("xorl %k[z], %k[z]\n\t"
+		"xorl %k[t5], %k[t5]\n\t"
+		"xorl %k[t6], %k[t6]\n\t"
+		//cross products
+		"movq 0*8(%[a]), %%rdx\n\t"
+		"mulxq 1*8(%[a]), %[t1], %[t2]\n\t"
+		"mulxq 2*8(%[a]), %[lo], %[t3]\n\t"
+		"addq %[lo], %[t2]\n\t"
+		"movq 1*8(%[a]), %%rdx\n\t"
+		"mulxq 2*8(%[a]), %[lo], %[t4]\n\t"
+		"adcq %[lo], %[t3]\n\t"
+		"adcq %[z], %[t4]\n\t"
+		//doubled
+		"addq %[t1], %[t1]\n\t"
+		"adcq %[t2], %[t2]\n\t"
+		"adcq %[t3], %[t3]\n\t"
+		"adcq %[t4], %[t4]\n\t"
+		"adcq %[z], %[t5]\n\t"
+		//plus the squares
+		"movq 0*8(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %[t0], %[hi]\n\t"
+		"addq %[hi], %[t1]\n\t"
+		"movq 1*8(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %[lo], %[hi]\n\t"
+		"adcq %[lo], %[t2]\n\t"
+		"adcq %[hi], %[t3]\n\t"
+		"movq 2*8(%[a]), %%rdx\n\t"
+		"mulxq %%rdx, %[lo], %[hi]\n\t"
+		"adcq %[lo], %[t4]\n\t"
+		"adcq %[hi], %[t5]\n\t"
+		//reduced
+		__SQR_REDUCE_3__(0, 1, 2, 3)
+		__SQR_CARRY__(4)
+		__SQR_CARRY__(5)
+		__SQR_CARRY__(6)
+		__SQR_REDUCE_3__(1, 2, 3, 4)
+		__SQR_CARRY__(5)
+		__SQR_CARRY__(6)
+		__SQR_REDUCE_3__(2, 3, 4, 5)
+		__SQR_CARRY__(6)
+		//minus p
+		"movq %[t3], %[lo]\n\t"
+		"subq 0*8(%[p]), %[lo]\n\t"
+		"movq %[t4], %[hi]\n\t"
+		"sbbq 1*8(%[p]), %[hi]\n\t"
+		"movq %[t5], %[z]\n\t"
+		"sbbq 2*8(%[p]), %[z]\n\t"
+		"sbbq $0, %[t6]\n\t"
+		"cmovncq %[lo], %[t3]\n\t"
+		"cmovncq %[hi], %[t4]\n\t"
+		"cmovncq %[z], %[t5]\n\t"
+		: [t0] "=&r" (t0), [t1] "=&r" (t1), [t2] "=&r" (t2), [t3] "=&r" (t3), [t4] "=&r" (t4), [t5] "=&r" (t5), [t6] "=&r" (t6), [lo] "=&r" (lo), [hi] "=&r" (hi), [z] "=&r" (z)
+		: [a] "r" (a), [p] "r" (F->p), [pinv] "m" (F->pinv)
+		: "rdx", "cc", "memory");
+	r[0] = t3;
+	r[1] = t4;
+	r[2] = t5;
+}
+
+__FIELD_MULX_TARGET__ static void sqr_mulx_1(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	(void)b;
+	mul_mulx_1(r, a, a, F);
+}
+
+#endif
+
+static const field_kernel_t field_kernels[__FIELD_NB_KERNELS__] =
+{
+	{"generic", {NULL, mul_generic_1, mul_generic_2, mul_generic_3}, {NULL, sqr_generic_1, sqr_generic_2, sqr_generic_3}},
+#ifdef __FIELD_MULX_BUILD__
+	{"mulx", {NULL, mul_mulx_1, mul_mulx_2, mul_mulx_3}, {NULL, sqr_mulx_1, sqr_mulx_2, sqr_mulx_3}},
+#else
+	{"mulx", {NULL, NULL, NULL, NULL}, {NULL, NULL, NULL, NULL}},
+#endif
+};
+
+static int field_mulx_present = 0;
+static pthread_once_t field_dispatch_once = PTHREAD_ONCE_INIT;
+
+/** Look for BMI2 and ADX in CPUID leaf 7.
+ *
+ */
+static void field_dispatch(void)
+{
+#ifdef __FIELD_MULX_BUILD__
+	unsigned int eax, ebx, ecx, edx;
+	if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		field_mulx_present = ((ebx >> 8) & 1) && ((ebx >> 19) & 1);
+	}
+#endif
+}
+
+/** Check whether a kernel runs on this processor.
+ *
+ */
+int field_kernel_available(int kernel)
+{
+	pthread_once(&field_dispatch_once, field_dispatch);
+	switch(kernel)
+	{
+		case __FIELD_GENERIC__: return 1;
+		case __FIELD_MULX__: return field_mulx_present;
+		default: return 0;
+	}
+}
+
+/** Get the fastest kernel that runs on this processor.
+ *
+ */
+int field_best_kernel(void)
+{
+	return field_kernel_available(__FIELD_MULX__) ? __FIELD_MULX__ : __FIELD_GENERIC__;
+}
+
+const char *field_kernel_name(int kernel)
+{
+	return field_kernels[kernel].name;
+}
+
+/** Set up the field of a prime p below 2^192.
+ *
+ *	@param[in]	kernel	__FIELD_GENERIC__, __FIELD_MULX__ or __FIELD_BEST__.
+ */
+void field_init(field_t *F, mpz_t p, int kernel)
+{
+	mpz_t t;
+	uint64_t inv;
+	int i;
+	if(mpz_sizeinbase(p, 2) > 64 * __FIELD_MAX_LIMBS__ || mpz_even_p(p))
+	{
+		fprintf(stderr, "Error: the field kernels work on odd primes of at most %d bits.\n", 64 * __FIELD_MAX_LIMBS__);
+		exit(1);
+	}
+	if(kernel == __FIELD_BEST__)
+	{
+		kernel = field_best_kernel();
+	}
+	if(!field_kernel_available(kernel))
+	{
+		fprintf(stderr, "Error: the %s field kernel does not run on this processor.\n", field_kernel_name(kernel));
+		exit(1);
+	}
+	memset(F, 0, sizeof(field_t));
+	F->nb_limbs = (mpz_sizeinbase(p, 2) + 63) / 64;
+	F->kernel = kernel;
+	F->mul = field_kernels[kernel].mul[F->nb_limbs];
+	F->sqr = field_kernels[kernel].sqr[F->nb_limbs];
+	field_from_mpz(F->p, p, F);
+	//p^-1 mod 2^64 by Newton's iteration, each step doubling the bits
+	inv = F->p[0];
+	for(i = 0; i < 5; i++)
+	{
+		inv *= 2 - F->p[0] * inv;
+	}
+	F->pinv = -inv;
+	mpz_init(t);
+	mpz_setbit(t, 128 * F->nb_limbs);
+	mpz_mod(t, t, p);
+	field_from_mpz(F->r2, t, F);
+	mpz_clear(t);
+}
+
+/** Write a number below 2^(64 nb_limbs) as nb_limbs words.
+ *
+ */
+void field_from_mpz(uint64_t *r, mpz_t z, const field_t *F)
+{
+	size_t count;
+	int j;
+	for(j = 0; j < F->nb_limbs; j++)
+	{
+		r[j] = 0;
+	}
+	mpz_export(r, &count, -1, sizeof(uint64_t), 0, 0, z);
+}
+
+void field_to_mpz(mpz_t z, const uint64_t *a, const field_t *F)
+{
+	mpz_import(z, F->nb_limbs, -1, sizeof(uint64_t), 0, 0, a);
+}
+
+/** Get the Montgomery form of z, below p.
+ *
+ */
+void field_set(uint64_t *r, mpz_t z, const field_t *F)
+{
+	uint64_t a[__FIELD_MAX_LIMBS__];
+	field_from_mpz(a, z, F);
+	F->mul(r, a, F->r2, F);
+}
+
+/** Get the number of Montgomery form a.
+ *
+ */
+void field_get(mpz_t z, const uint64_t *a, const field_t *F)
+{
+	uint64_t r[__FIELD_MAX_LIMBS__];
+	field_canonical(r, a, F);
+	field_to_mpz(z, r, F);
+}
+
+/** Get the words of the number of Montgomery form a.
+ *
+ */
+void field_canonical(uint64_t *r, const uint64_t *a, const field_t *F)
+{
+	static const uint64_t unit[__FIELD_MAX_LIMBS__] = {1, 0, 0};
+	F->mul(r, a, unit, F);
+}
+
+void field_add(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	uint64_t t[__FIELD_MAX_LIMBS__ + 1];
+	unsigned __int128 c = 0;
+	int j;
+	for(j = 0; j < F->nb_limbs; j++)
+	{
+		c = (unsigned __int128)a[j] + b[j] + (uint64_t)(c >> 64);
+		t[j] = (uint64_t)c;
+	}
+	t[F->nb_limbs] = (uint64_t)(c >> 64);
+	mont_final(r, t, F, F->nb_limbs);
+}
+
+void field_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F)
+{
+	unsigned __int128 d, c = 0;
+	uint64_t borrow = 0, mask;
+	int j;
+	for(j = 0; j < F->nb_limbs; j++)
+	{
+		d = (unsigned __int128)a[j] - b[j] - borrow;
+		r[j] = (uint64_t)d;
+		borrow = (uint64_t)(d >> 64) & 1;
+	}
+	//p is added back where a < b
+	mask = -borrow;
+	for(j = 0; j < F->nb_limbs; j++)
+	{
+		c = (unsigned __int128)r[j] + (F->p[j] & mask) + (uint64_t)(c >> 64);
+		r[j] = (uint64_t)c;
+	}
+}
@@ -0,0 +1,58 @@
+/** @file pcs_field.h
+ *
+ */
+#ifndef PCS_FIELD_H
+#define PCS_FIELD_H
+
+#include <gmp.h>
+#include <inttypes.h>
+
+#define __FIELD_MAX_LIMBS__ 3
+#define __FIELD_GENERIC__ 0
+#define __FIELD_MULX__ 1
+#define __FIELD_NB_KERNELS__ 2
+#define __FIELD_BEST__ -1
+
+typedef struct field field_t;
+typedef void (*field_op_t)(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F);
+
+/** Montgomery multiplication and squaring for 1 to __FIELD_MAX_LIMBS__ limbs.
+ *
+ *	@brief mul[n] and sqr[n] work on n limbs, sqr ignoring b.
+ */
+typedef struct
+{
+	const char *name;
+	field_op_t mul[__FIELD_MAX_LIMBS__ + 1];
+	field_op_t sqr[__FIELD_MAX_LIMBS__ + 1];
+}field_kernel_t;
+
+/** A prime field in Montgomery form, aR mod p with R = 2^(64 nb_limbs).
+ *
+ *	@brief The elements are nb_limbs words, least significant first, and
+ *	below p. The limbs above nb_limbs of an array of __FIELD_MAX_LIMBS__
+ *	words are left untouched.
+ */
+struct field
+{
+	int nb_limbs;
+	uint64_t p[__FIELD_MAX_LIMBS__];
+	uint64_t pinv;
+	uint64_t r2[__FIELD_MAX_LIMBS__];
+	int kernel;
+	field_op_t mul;
+	field_op_t sqr;
+};
+
+int field_best_kernel(void);
+int field_kernel_available(int kernel);
+const char *field_kernel_name(int kernel);
+void field_init(field_t *F, mpz_t p, int kernel);
+void field_from_mpz(uint64_t *r, mpz_t z, const field_t *F);
+void field_to_mpz(mpz_t z, const uint64_t *a, const field_t *F);
+void field_set(uint64_t *r, mpz_t z, const field_t *F);
+void field_get(mpz_t z, const uint64_t *a, const field_t *F);
+void field_canonical(uint64_t *r, const uint64_t *a, const field_t *F);
+void field_add(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F);
+void field_sub(uint64_t *r, const uint64_t *a, const uint64_t *b, const field_t *F);
+#endif
@@ -0,0 +1,308 @@
+/** @file pcs_gaudry_schost.c
+ *  @brief The Gaudry-Schost method, for a logarithm x = base + i + j*lambda in a box 0 <= i < width, 0 <= j < height.
+ *
+ *	The box is one-dimensional (an interval) when height is 1. A tame walk
+ *	starts at a random point of the box, (base + i + j*lambda)P, and a wild
+ *	walk at a random point of the box translated to Q, Q + ((i - width/2)
+ *	+ (j - height/2)*lambda)P. Both follow the adding walk on P only, with
+ *	small jumps (s + t*lambda)P: each walk moves about 1/__GS_DRIFT__ of
+ *	the box in each dimension before it reaches a distinguished point, so
+ *	the tame walks stay around the box and the wild ones around its
+ *	translate. A box less high than __GS_DRIFT__ * 2^d needs a move along
+ *	j of less than one per step: the jumps are then (s + 0*lambda)P, and
+ *	lambda*P is added after the steps whose point has a hash of x below a
+ *	threshold, so that the walk stays a function of the point. A new walk
+ *	is started after each distinguished point (Gaudry and Schost, "A
+ *	low-memory parallel version of Matsuo, Chao and Tsujii's algorithm",
+ *	ANTS 2004).
+ *
+ *	The distinguished points are kept in the storage structure of the
+ *	context with a = (i << (j_bits + 1)) + (j << 1) + wild, where (i, j)
+ *	is the position of the walk in its box. A tame and a wild walk on the
+ *	same point give the logarithm of Q. The expected number of steps is
+ *	about __GS_EXPECTED_1D__*sqrt(width) in one dimension and
+ *	__GS_EXPECTED_2D__*sqrt(width*height) in two (Galbraith and Ruprai,
+ *	"An improvement to the Gaudry-Schost algorithm for multidimensional
+ *	discrete logarithm problems", IMA 2009), plus the steps of the walks
+ *	after the collision.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <stdint.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_multi.h"
+#include "pcs_gaudry_schost.h"
+
+/** The box and the jumps of a run, shared by the walkers.
+ */
+typedef struct
+{
+	mpz_t base;
+	mpz_t lambda;
+	mpz_t size[2];
+	mpz_t half[2];
+	mpz_t jump[2][__NB_ENSEMBLES__];
+	int j_bits;
+	point_t lambda_P;
+	uint32_t j_threshold; //0 if the moves along j are in the jumps
+}gs_box_t;
+
+/** Position of one walk in its box.
+ */
+typedef struct
+{
+	point_t R;
+	mpz_t i;
+	mpz_t j;
+	mpz_t s;
+	int wild;
+}gs_walk_t;
+
+/** Get the number of bits a position j takes in a stored coefficient.
+ *
+ *	@brief A walk moves about 1/__GS_DRIFT__ of the box before it is
+ *	distinguished, and at most 20/__GS_DRIFT__ on average before it is
+ *	given up, so it stays within four times the box.
+ */
+static int gs_j_bits(mpz_t height)
+{
+	if(mpz_cmp_ui(height, 1) <= 0)
+	{
+		return 0;
+	}
+	return mpz_sizeinbase(height, 2) + 2;
+}
+
+/** Get the number of bits of the coefficients stored for a box.
+ *
+ *	@brief They have to fit in the nb_bits bits of a stored coefficient.
+ */
+int gs_coefficient_bits(mpz_t width, mpz_t height)
+{
+	return mpz_sizeinbase(width, 2) + 2 + gs_j_bits(height) + 1;
+}
+
+/** Start a walk at a random point of the box (tame) or of its translate to Q (wild).
+ *
+ */
+static void gs_start(pcs_ctx_t *ctx, pcs_walker_t *w, gs_box_t *box, gs_walk_t *g)
+{
+	g->wild = gmp_urandomb_ui(w->r_state, 1);
+	mpz_urandomm(g->i, w->r_state, box->size[0]);
+	mpz_urandomm(g->j, w->r_state, box->size[1]);
+	if(g->wild)
+	{
+		mpz_sub(g->s, g->j, box->half[1]);
+		mpz_mul(g->s, g->s, box->lambda);
+		mpz_add(g->s, g->s, g->i);
+		mpz_sub(g->s, g->s, box->half[0]);
+		mpz_mod(g->s, g->s, ctx->n);
+		fixed_base_mul(ctx, &g->R, g->s);
+		add(&g->R, g->R, ctx->Q, ctx->E);
+	}
+	else
+	{
+		mpz_mul(g->s, g->j, box->lambda);
+		mpz_add(g->s, g->s, g->i);
+		mpz_add(g->s, g->s, box->base);
+		mpz_mod(g->s, g->s, ctx->n);
+		fixed_base_mul(ctx, &g->R, g->s);
+	}
+	w->trail_length = 0;
+}
+
+/** Get the logarithm of Q from a tame walk at (i1, j1) and a wild one at (i2, j2) on the same x coordinate.
+ *
+ *	@brief (base + i1 + j1*lambda)P = +-(Q + (i2 - width/2 + (j2 - height/2)*lambda)P).
+ *
+ *	@return 	1 if x was found, 0 otherwise.
+ */
+static int gs_solve(pcs_ctx_t *ctx, gs_box_t *box, mpz_t x, mpz_t i1, mpz_t j1, mpz_t i2, mpz_t j2)
+{
+	point_t S;
+	mpz_t tame, wild;
+	int retval;
+	point_init(&S);
+	mpz_inits(tame, wild, NULL);
+	mpz_mul(tame, j1, box->lambda);
+	mpz_add(tame, tame, i1);
+	mpz_add(tame, tame, box->base);
+	mpz_sub(wild, j2, box->half[1]);
+	mpz_mul(wild, wild, box->lambda);
+	mpz_add(wild, wild, i2);
+	mpz_sub(wild, wild, box->half[0]);
+
+	mpz_sub(x, tame, wild);
+	mpz_mod(x, x, ctx->n);
+	double_and_add(&S, ctx->P, x, ctx->E);
+	retval = equal(S, ctx->Q);
+	if(!retval)
+	{
+		mpz_add(x, tame, wild);
+		mpz_neg(x, x);
+		mpz_mod(x, x, ctx->n);
+		double_and_add(&S, ctx->P, x, ctx->E);
+		retval = equal(S, ctx->Q);
+	}
+	point_clear(&S);
+	mpz_clears(tame, wild, NULL);
+	return retval;
+}
+
+/** Hash the x coordinate of a point on 32 bits, to choose the steps followed by a move along j.
+ *
+ */
+static uint32_t gs_j_hash(point_t R)
+{
+	return (uint32_t)(((uint64_t)mpz_getlimbn(R.x, 0) * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+/** Walk until the run is over, starting a new walk after each distinguished point.
+ *
+ */
+static void gs_walk(pcs_ctx_t *ctx, pcs_walker_t *w, gs_box_t *box, gs_walk_t *g, mpz_t x_res, int *collision_count)
+{
+	int trail_length_max = pow(2, ctx->trailling_bits) * 20;
+	char xDist_str[100];
+	mpz_t i2, j2;
+	uint8_t r;
+
+	mpz_inits(i2, j2, NULL);
+	w->nb_steps = 0;
+	gs_start(ctx, w, box, g);
+	while(!run_done(ctx, collision_count, 1))
+	{
+		if(!is_distinguished(g->R, ctx->trailling_bits, &w->xDist))
+		{
+			r = hash(g->R.y);
+			f(g->R, ctx->M[r], &g->R, ctx->E);
+			mpz_add(g->i, g->i, box->jump[0][r]);
+			mpz_add(g->j, g->j, box->jump[1][r]);
+			if(box->j_threshold != 0 && gs_j_hash(g->R) < box->j_threshold)
+			{
+				add(&g->R, g->R, box->lambda_P, ctx->E);
+				mpz_add_ui(g->j, g->j, 1);
+			}
+			w->nb_steps++;
+			w->trail_length++;
+			if(w->trail_length > trail_length_max)
+			{
+				gs_start(ctx, w, box, g);
+			}
+			continue;
+		}
+		mpz_mul_2exp(w->a, g->i, box->j_bits);
+		mpz_add(w->a, w->a, g->j);
+		mpz_mul_2exp(w->a, w->a, 1);
+		mpz_add_ui(w->a, w->a, g->wild);
+		if(mpz_sizeinbase(w->a, 2) <= ctx->nb_bits && (box->j_bits == 0 || mpz_sizeinbase(g->j, 2) <= (size_t)box->j_bits) && struct_add(&ctx->storage, w->a2, w->a, w->xDist, xDist_str) && (mpz_odd_p(w->a2) != 0) != g->wild)
+		{
+			mpz_tdiv_q_2exp(w->a2, w->a2, 1);
+			mpz_tdiv_r_2exp(j2, w->a2, box->j_bits);
+			mpz_tdiv_q_2exp(i2, w->a2, box->j_bits);
+			if((g->wild && gs_solve(ctx, box, w->x, i2, j2, g->i, g->j)) || (!g->wild && gs_solve(ctx, box, w->x, g->i, g->j, i2, j2)))
+			{
+				#pragma omp critical
+				{
+					(*collision_count)++;
+					mpz_set(x_res, w->x);
+				}
+			}
+		}
+		gs_start(ctx, w, box, g);
+	}
+	mpz_clears(i2, j2, NULL);
+}
+
+/** Solve Q = xP for x = base + i + j*lambda, with 0 <= i < width and 0 <= j < height, by the Gaudry-Schost method.
+ *
+ *	@brief The adding walk of the context is replaced by jumps drawn for
+ *	the box, and the storage structure is emptied. The box is an interval
+ *	when height is 1. The coefficients stored have gs_coefficient_bits
+ *	bits, which should not be more than nb_bits.
+ *
+ *	@return	1 if x was found, 0 if the run was stopped through ctx->stop.
+ */
+long long int pcs_run_gaudry_schost(pcs_ctx_t *ctx, mpz_t base, mpz_t lambda, mpz_t width, mpz_t height, mpz_t x_res)
+{
+	int collision_count = 0;
+	gs_box_t box;
+	mpz_t mean;
+	int i, k;
+
+	mpz_init(mean);
+	mpz_init_set(box.base, base);
+	mpz_init_set(box.lambda, lambda);
+	mpz_init_set(box.size[0], width);
+	mpz_init_set(box.size[1], height);
+	box.j_bits = gs_j_bits(height);
+	box.j_threshold = 0;
+	point_init(&box.lambda_P);
+	for(k = 0; k < 2; k++)
+	{
+		mpz_init(box.half[k]);
+		mpz_tdiv_q_2exp(box.half[k], box.size[k], 1);
+		//a walk of 2^trailling_bits steps moves 1/__GS_DRIFT__ of the box
+		mpz_tdiv_q_2exp(mean, box.size[k], ctx->trailling_bits);
+		mpz_tdiv_q_ui(mean, mean, __GS_DRIFT__);
+		if(mpz_sgn(mean) == 0 && k == 1 && mpz_cmp_ui(box.size[k], 1) > 0)
+		{
+			//a move of height / (__GS_DRIFT__ * 2^d) per step on average, 1 after a share of the steps
+			box.j_threshold = (uint32_t)ldexp(mpz_get_d(box.size[k]) / __GS_DRIFT__, 32 - ctx->trailling_bits);
+			if(box.j_threshold == 0)
+			{
+				box.j_threshold = 1;
+			}
+			mpz_mod(mean, box.lambda, ctx->n);
+			double_and_add(&box.lambda_P, ctx->P, mean, ctx->E);
+			mpz_set_ui(mean, 0);
+		}
+		else if(mpz_sgn(mean) == 0 && k == 0)
+		{
+			mpz_set_ui(mean, 1);
+		}
+		//the jumps are drawn in [1, 2*mean] along i, so that none is 0, and in [0, 2*mean] along j
+		mpz_mul_2exp(mean, mean, 1);
+		mpz_add_ui(mean, mean, k);
+		for(i = 0; i < __NB_ENSEMBLES__; i++)
+		{
+			mpz_init(box.jump[k][i]);
+			mpz_urandomm(box.jump[k][i], ctx->walkers[0].r_state, mean);
+			mpz_add_ui(box.jump[k][i], box.jump[k][i], 1 - k);
+		}
+	}
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_mul(ctx->A[i], box.jump[1][i], box.lambda);
+		mpz_add(ctx->A[i], ctx->A[i], box.jump[0][i]);
+		mpz_mod(ctx->A[i], ctx->A[i], ctx->n);
+	}
+	walk_on_P(ctx);
+	struct_reset(&ctx->storage);
+
+	#pragma omp parallel shared(collision_count, x_res) num_threads(ctx->nb_threads)
+	{
+		gs_walk_t g;
+		point_init(&g.R);
+		mpz_inits(g.i, g.j, g.s, NULL);
+		gs_walk(ctx, &ctx->walkers[omp_get_thread_num()], &box, &g, x_res, &collision_count);
+		point_clear(&g.R);
+		mpz_clears(g.i, g.j, g.s, NULL);
+	}
+
+	for(k = 0; k < 2; k++)
+	{
+		mpz_clears(box.size[k], box.half[k], NULL);
+		for(i = 0; i < __NB_ENSEMBLES__; i++)
+		{
+			mpz_clear(box.jump[k][i]);
+		}
+	}
+	point_clear(&box.lambda_P);
+	mpz_clears(box.base, box.lambda, mean, NULL);
+	return collision_count;
+}
@@ -0,0 +1,15 @@
+/** @file pcs_gaudry_schost.h
+ *
+ */
+#ifndef PCS_GAUDRY_SCHOST_H
+#define PCS_GAUDRY_SCHOST_H
+
+#include "pcs.h"
+
+#define __GS_DRIFT__ 16
+#define __GS_EXPECTED_1D__ 2.08
+#define __GS_EXPECTED_2D__ 2.43
+
+int gs_coefficient_bits(mpz_t width, mpz_t height);
+long long int pcs_run_gaudry_schost(pcs_ctx_t *ctx, mpz_t base, mpz_t lambda, mpz_t width, mpz_t height, mpz_t x_res);
+#endif
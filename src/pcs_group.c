@@ -0,0 +1,161 @@
+/** @file pcs_group.c
+ *  @brief The groups the walk works in: the points of an elliptic curve,
+ *  and the multiplicative group of a prime field.
+ *
+ *	pcs_run, is_collision, same_point and lin_comb reach the elements of a
+ *	context only through the operations of its group (see pcs_group.h),
+ *	so that the walkers, the storage structures and the recovery of the
+ *	logarithm from a collision work in any of them.
+ *
+ *	The group F_p^* is chosen by giving pcs_group_fp to pcs_create, with
+ *	p in the elliptic_curve_t, whose A and B are not read. Its elements g
+ *	are held as points (g, 0, 1), g being their own encoding, and the walk
+ *	solves h = g^x in the subgroup of order n of g. The products are Montgomery multiplications
+ *	with the kernels of pcs_field.h, for p of up to 64 * __FIELD_MAX_LIMBS__
+ *	bits, and are left to GMP above.
+ */
+#include <string.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_field.h"
+#include "pcs.h"
+#include "pcs_group.h"
+
+static void ec_identity(point_t *R)
+{
+	mpz_set_ui(R->x, 0);
+	mpz_set_ui(R->y, 1);
+	mpz_set_ui(R->z, 0);
+}
+
+/** Tell R from -R, which have the same x.
+ *
+ */
+static int ec_same(point_t R, point_t S)
+{
+	return (mpz_cmp(R.y, S.y) == 0);
+}
+
+static int ec_partition(point_t R)
+{
+	return hash(R.y);
+}
+
+const pcs_group_t pcs_group_ec = {"ec", ec_identity, add, double_and_add, ec_same, ec_partition, is_distinguished};
+
+/** Get the Montgomery field of p, set up once per thread and prime.
+ *
+ *	@return 	The field, or NULL if p is too large for the kernels.
+ */
+static const field_t *fp_field(elliptic_curve_t E)
+{
+	static __thread field_t F;
+	static __thread uint64_t prime[__FIELD_MAX_LIMBS__];
+	static __thread int state = 0;
+	uint64_t p[__FIELD_MAX_LIMBS__];
+	int i;
+	if(mpz_sizeinbase(E.p, 2) > 64 * __FIELD_MAX_LIMBS__)
+	{
+		return NULL;
+	}
+	for(i = 0; i < __FIELD_MAX_LIMBS__; i++)
+	{
+		p[i] = mpz_getlimbn(E.p, i);
+	}
+	if(state == 0 || memcmp(p, prime, sizeof(p)) != 0)
+	{
+		memcpy(prime, p, sizeof(p));
+		field_init(&F, E.p, __FIELD_BEST__);
+		state = 1;
+	}
+	return &F;
+}
+
+static void fp_identity(point_t *R)
+{
+	mpz_set_ui(R->x, 1);
+	mpz_set_ui(R->y, 0);
+	mpz_set_ui(R->z, 1);
+}
+
+/** Multiply two elements of F_p^*.
+ *
+ *	@brief The Montgomery product of the Montgomery form of S, Sr, and of
+ *	T is Sr * T / r = S * T, so that neither the elements nor the product
+ *	stay in Montgomery form.
+ *
+ *	@return		0.
+ */
+static int fp_op(point_t *R, point_t S, point_t T, elliptic_curve_t E)
+{
+	const field_t *F = fp_field(E);
+	uint64_t a[__FIELD_MAX_LIMBS__], b[__FIELD_MAX_LIMBS__], r[__FIELD_MAX_LIMBS__];
+	if(F == NULL)
+	{
+		mpz_mul(R->x, S.x, T.x);
+		mpz_mod(R->x, R->x, E.p);
+	}
+	else
+	{
+		field_set(a, S.x, F);
+		field_from_mpz(b, T.x, F);
+		F->mul(r, a, b, F);
+		field_to_mpz(R->x, r, F);
+	}
+	mpz_set_ui(R->y, 0);
+	mpz_set_ui(R->z, 1);
+	return 0;
+}
+
+/** Raise an element of F_p^* to the power s.
+ *
+ *	@brief Left to right, on the Montgomery forms, for s >= 0; a negative
+ *	s is left to mpz_powm, which inverts S.
+ *
+ *	@return		0.
+ */
+static int fp_exp(point_t *R, point_t S, mpz_t s, elliptic_curve_t E)
+{
+	static const uint64_t unit[__FIELD_MAX_LIMBS__] = {1, 0, 0};
+	const field_t *F = fp_field(E);
+	uint64_t b[__FIELD_MAX_LIMBS__], r[__FIELD_MAX_LIMBS__];
+	mp_bitcnt_t i;
+	if(F == NULL || mpz_sgn(s) < 0)
+	{
+		mpz_powm(R->x, S.x, s, E.p);
+	}
+	else
+	{
+		field_set(b, S.x, F);
+		//r2 / r = r mod p, the Montgomery form of 1
+		F->mul(r, F->r2, unit, F);
+		for(i = (mpz_sgn(s) == 0) ? 0 : mpz_sizeinbase(s, 2); i-- > 0; )
+		{
+			F->sqr(r, r, r, F);
+			if(mpz_tstbit(s, i))
+			{
+				F->mul(r, r, b, F);
+			}
+		}
+		field_get(R->x, r, F);
+	}
+	mpz_set_ui(R->y, 0);
+	mpz_set_ui(R->z, 1);
+	return 0;
+}
+
+/** Compare two elements of F_p^*, whose encodings are the elements themselves.
+ *
+ */
+static int fp_same(point_t R, point_t S)
+{
+	return (mpz_cmp(R.x, S.x) == 0);
+}
+
+static int fp_partition(point_t R)
+{
+	return hash(R.x);
+}
+
+const pcs_group_t pcs_group_fp = {"fp", fp_identity, fp_op, fp_exp, fp_same, fp_partition, is_distinguished};
@@ -0,0 +1,36 @@
+/** @file pcs_group.h
+ *
+ */
+#ifndef PCS_GROUP_H
+#define PCS_GROUP_H
+
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+
+/** The operations of a group the walk works in.
+ *
+ *	@brief The elements are held in point_t and the group is chosen by the
+ *	caller of pcs_create, with an elliptic_curve_t whose numbers each
+ *	group reads as it needs, only p for F_p^*. op
+ *	and exp compute S*T and S^s (S + T and sS on a curve). x is the
+ *	canonical encoding of an element: distinguished tells whether it has
+ *	trailling_bits trailling zero bits and gives the rest of it, which is
+ *	what the storage structures keep, and partition chooses its adding set
+ *	among __NB_ENSEMBLES__. same tells whether R = S rather than R = S^-1,
+ *	for the groups where both have the same encoding.
+ */
+typedef struct pcs_group
+{
+	const char *name;
+	void (*identity)(point_t *R);
+	int (*op)(point_t *R, point_t S, point_t T, elliptic_curve_t E);
+	int (*exp)(point_t *R, point_t S, mpz_t s, elliptic_curve_t E);
+	int (*same)(point_t R, point_t S);
+	int (*partition)(point_t R);
+	int (*distinguished)(point_t R, int trailling_bits, mpz_t *q);
+}pcs_group_t;
+
+extern const pcs_group_t pcs_group_ec;
+extern const pcs_group_t pcs_group_fp;
+
+#endif
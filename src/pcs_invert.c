@@ -0,0 +1,400 @@
+/** @file pcs_invert.c
+ *  @brief Inversion modulo odd numbers of up to two words, without GMP.
+ *
+ *	The inverse is computed with the divsteps of Bernstein and Yang, in
+ *	their variable-time form: f and g start as the modulus m and the
+ *	number a to invert, and each divstep either halves g, or replaces
+ *	(f, g) by (g, (g - f)/2), until g is 0 and f is the gcd, +-1. The
+ *	divsteps are done 62 at a time on the low word of f and g only,
+ *	which gives a 2x2 matrix t of small integers, then t is applied to the
+ *	whole of f and g, and to d and e, with d a = f and e a = g modulo m,
+ *	divided by 2^62 modulo m. At the end, the inverse of a is d or -d.
+ *
+ *	The numbers are kept on the stack in radix 2^62, __INVERT_LIMBS__
+ *	signed limbs, or single words for moduli below 2^62, and the only
+ *	divisions are shifts. On the moduli of one or two words of the walks,
+ *	this is only on par with mpz_invert, whose Lehmer gcd spends about as
+ *	many cycles per bit (see pcs_bench), so the walks keep mpz_invert.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "pcs_invert.h"
+
+#define __INVERT_LIMBS__ 3
+#define __LIMB_62__ ((int64_t)(UINT64_MAX >> 2))
+
+#if defined(__SIZEOF_INT128__) && GMP_NUMB_BITS == 64
+
+/** A transition matrix of 62 divsteps, times 2^62.
+ */
+typedef struct
+{
+	int64_t u, v, q, r;
+}trans_t;
+
+/** Do 62 divsteps on the low words of f and g.
+ *
+ *	@brief After them, 2^62 (f, g) = (u f + v g, q f + r g). Runs of
+ *	zeros of g are skipped at once, and the multiple of f added to g is
+ *	chosen to clear up to 6 of its low bits at once.
+ *
+ *	@return	The new value of eta, which is minus delta.
+ */
+static int64_t divsteps_62(int64_t eta, uint64_t f0, uint64_t g0, trans_t *t)
+{
+	uint64_t u = 1, v = 0, q = 0, r = 1;
+	uint64_t f = f0, g = g0, m, w, x;
+	int i = 62, limit, zeros;
+	for(;;)
+	{
+		//the bit set above bit i stops the count of zeros at i
+		zeros = __builtin_ctzll(g | (UINT64_MAX << i));
+		g >>= zeros;
+		u <<= zeros;
+		v <<= zeros;
+		eta -= zeros;
+		i -= zeros;
+		if(i == 0)
+		{
+			break;
+		}
+		//f and g odd now
+		if(eta < 0)
+		{
+			eta = -eta;
+			x = f; f = g; g = -x;
+			x = u; u = q; q = -x;
+			x = v; v = r; r = -x;
+			limit = ((int)eta + 1 > i) ? i : (int)eta + 1;
+			m = (UINT64_MAX >> (64 - limit)) & 63U;
+			//w = -g/f mod 2^6, f(f^2 - 2) being 1/f mod 2^6
+			w = (f * g * (f * f - 2)) & m;
+		}
+		else
+		{
+			limit = ((int)eta + 1 > i) ? i : (int)eta + 1;
+			m = (UINT64_MAX >> (64 - limit)) & 15U;
+			//w = -g/f mod 2^4
+			w = f + (((f + 1) & 4) << 1);
+			w = (-w * g) & m;
+		}
+		g += f * w;
+		q += u * w;
+		r += v * w;
+	}
+	t->u = (int64_t)u;
+	t->v = (int64_t)v;
+	t->q = (int64_t)q;
+	t->r = (int64_t)r;
+	return eta;
+}
+
+/** (d, e) = t (d, e) / 2^62 modulo m.
+ *
+ *	@brief The multiples md and me of m added make the low 62 bits zero;
+ *	they also add m to d and e where they are negative, so that d and e
+ *	stay between -2m and m.
+ */
+static void update_de(int64_t *d, int64_t *e, const trans_t *t, const int64_t *m, uint64_t minv)
+{
+	const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+	int64_t md, me, sd, se;
+	__int128 cd, ce;
+	int i;
+	sd = d[__INVERT_LIMBS__ - 1] >> 63;
+	se = e[__INVERT_LIMBS__ - 1] >> 63;
+	md = (u & sd) + (v & se);
+	me = (q & sd) + (r & se);
+	cd = (__int128)u * d[0] + (__int128)v * e[0];
+	ce = (__int128)q * d[0] + (__int128)r * e[0];
+	md -= (minv * (uint64_t)cd + md) & __LIMB_62__;
+	me -= (minv * (uint64_t)ce + me) & __LIMB_62__;
+	cd += (__int128)m[0] * md;
+	ce += (__int128)m[0] * me;
+	cd >>= 62;
+	ce >>= 62;
+	for(i = 1; i < __INVERT_LIMBS__; i++)
+	{
+		cd += (__int128)u * d[i] + (__int128)v * e[i] + (__int128)m[i] * md;
+		ce += (__int128)q * d[i] + (__int128)r * e[i] + (__int128)m[i] * me;
+		d[i - 1] = (int64_t)cd & __LIMB_62__;
+		e[i - 1] = (int64_t)ce & __LIMB_62__;
+		cd >>= 62;
+		ce >>= 62;
+	}
+	d[__INVERT_LIMBS__ - 1] = (int64_t)cd;
+	e[__INVERT_LIMBS__ - 1] = (int64_t)ce;
+}
+
+/** (f, g) = t (f, g) / 2^62, on the len low limbs.
+ *
+ */
+static void update_fg(int len, int64_t *f, int64_t *g, const trans_t *t)
+{
+	const int64_t u = t->u, v = t->v, q = t->q, r = t->r;
+	__int128 cf, cg;
+	int i;
+	cf = (__int128)u * f[0] + (__int128)v * g[0];
+	cg = (__int128)q * f[0] + (__int128)r * g[0];
+	cf >>= 62;
+	cg >>= 62;
+	for(i = 1; i < len; i++)
+	{
+		cf += (__int128)u * f[i] + (__int128)v * g[i];
+		cg += (__int128)q * f[i] + (__int128)r * g[i];
+		f[i - 1] = (int64_t)cf & __LIMB_62__;
+		g[i - 1] = (int64_t)cg & __LIMB_62__;
+		cf >>= 62;
+		cg >>= 62;
+	}
+	f[len - 1] = (int64_t)cf;
+	g[len - 1] = (int64_t)cg;
+}
+
+/** Bring the limbs of x back to 62 bits, the top one keeping the sign.
+ *
+ */
+static void carry_62(int64_t *x)
+{
+	int i;
+	for(i = 0; i < __INVERT_LIMBS__ - 1; i++)
+	{
+		x[i + 1] += x[i] >> 62;
+		x[i] &= __LIMB_62__;
+	}
+}
+
+/** Get d or -d, from the sign of f, between 0 and m, for d between -2m and m.
+ *
+ */
+static void normalize(int64_t *d, int64_t sign, const int64_t *m)
+{
+	int64_t c;
+	int i;
+	c = d[__INVERT_LIMBS__ - 1] >> 63;
+	for(i = 0; i < __INVERT_LIMBS__; i++)
+	{
+		d[i] += m[i] & c;
+	}
+	c = sign >> 63;
+	for(i = 0; i < __INVERT_LIMBS__; i++)
+	{
+		d[i] = (d[i] ^ c) - c;
+	}
+	carry_62(d);
+	c = d[__INVERT_LIMBS__ - 1] >> 63;
+	for(i = 0; i < __INVERT_LIMBS__; i++)
+	{
+		d[i] += m[i] & c;
+	}
+	carry_62(d);
+}
+
+/** m^-1 modulo 2^64, for m odd, by Newton's iteration from 5 correct bits.
+ *
+ */
+static uint64_t inverse_64(uint64_t m)
+{
+	uint64_t x = (3 * m) ^ 2;
+	int i;
+	for(i = 0; i < 4; i++)
+	{
+		x *= 2 - m * x;
+	}
+	return x;
+}
+
+/** invert_words for m below 2^62: f, g, d and e are then single words.
+ *
+ */
+static int invert_62(uint64_t *r, uint64_t a, uint64_t m)
+{
+	const uint64_t minv = inverse_64(m);
+	int64_t d = 0, e = 1, f = (int64_t)m, g = (int64_t)a, eta = -1, md, me;
+	__int128 cd, ce;
+	trans_t t;
+	while(g != 0)
+	{
+		eta = divsteps_62(eta, (uint64_t)f, (uint64_t)g, &t);
+		md = (t.u & (d >> 63)) + (t.v & (e >> 63));
+		me = (t.q & (d >> 63)) + (t.r & (e >> 63));
+		cd = (__int128)t.u * d + (__int128)t.v * e;
+		ce = (__int128)t.q * d + (__int128)t.r * e;
+		md -= (minv * (uint64_t)cd + md) & __LIMB_62__;
+		me -= (minv * (uint64_t)ce + me) & __LIMB_62__;
+		d = (int64_t)((cd + (__int128)m * md) >> 62);
+		e = (int64_t)((ce + (__int128)m * me) >> 62);
+		cd = (__int128)t.u * f + (__int128)t.v * g;
+		ce = (__int128)t.q * f + (__int128)t.r * g;
+		f = (int64_t)(cd >> 62);
+		g = (int64_t)(ce >> 62);
+	}
+	if(f != 1 && f != -1)
+	{
+		return 0;
+	}
+	//d between -2m and m
+	d += (int64_t)m & (d >> 63);
+	d = (d ^ (f >> 63)) - (f >> 63);
+	d += (int64_t)m & (d >> 63);
+	*r = (uint64_t)d;
+	return 1;
+}
+
+static void to_62(int64_t *x, const uint64_t w[2])
+{
+	x[0] = (int64_t)(w[0] & __LIMB_62__);
+	x[1] = (int64_t)(((w[0] >> 62) | (w[1] << 2)) & __LIMB_62__);
+	x[2] = (int64_t)(w[1] >> 60);
+}
+
+static void from_62(uint64_t w[2], const int64_t *x)
+{
+	w[0] = (uint64_t)x[0] | ((uint64_t)x[1] << 62);
+	w[1] = ((uint64_t)x[1] >> 2) | ((uint64_t)x[2] << 60);
+}
+
+#endif
+
+/** Invert a modulo m, for m odd below 2^__INVERT_MAX_BITS__ and a below m.
+ *
+ *	@param[out]	r	The inverse, below m, if there is one.
+ *	@param[in]	a	The number to invert, two words, least significant first.
+ *	@param[in]	m	The modulus, two words, least significant first.
+ *	@return		1 if a is invertible, 0 otherwise, as mpz_invert.
+ */
+int invert_words(uint64_t r[2], const uint64_t a[2], const uint64_t m[2])
+{
+#if defined(__SIZEOF_INT128__) && GMP_NUMB_BITS == 64
+	int64_t d[__INVERT_LIMBS__] = {0, 0, 0}, e[__INVERT_LIMBS__] = {1, 0, 0};
+	int64_t f[__INVERT_LIMBS__], g[__INVERT_LIMBS__], M[__INVERT_LIMBS__];
+	int64_t eta = -1, fn, gn, cond;
+	uint64_t minv;
+	trans_t t;
+	int len = __INVERT_LIMBS__, i;
+	if(m[1] == 0 && m[0] <= (uint64_t)__LIMB_62__)
+	{
+		r[1] = 0;
+		return invert_62(r, a[0], m[0]);
+	}
+	minv = inverse_64(m[0]);
+	to_62(M, m);
+	to_62(f, m);
+	to_62(g, a);
+	for(;;)
+	{
+		eta = divsteps_62(eta, f[0], g[0], &t);
+		update_de(d, e, &t, M, minv);
+		update_fg(len, f, g, &t);
+		if(g[0] == 0)
+		{
+			cond = 0;
+			for(i = 1; i < len; i++)
+			{
+				cond |= g[i];
+			}
+			if(cond == 0)
+			{
+				break;
+			}
+		}
+		//once the top limbs of f and g are both 0 or -1, they are folded into the one below
+		fn = f[len - 1];
+		gn = g[len - 1];
+		cond = ((int64_t)len - 2) >> 63;
+		cond |= fn ^ (fn >> 63);
+		cond |= gn ^ (gn >> 63);
+		if(cond == 0)
+		{
+			f[len - 2] |= (int64_t)((uint64_t)fn << 62);
+			g[len - 2] |= (int64_t)((uint64_t)gn << 62);
+			len--;
+		}
+	}
+	//f is +-gcd(a, m), -1 being all ones below a top limb of -1
+	if(len == 1)
+	{
+		cond = (f[0] == 1 || f[0] == -1);
+	}
+	else if(f[len - 1] < 0)
+	{
+		cond = (f[len - 1] == -1);
+		for(i = 0; i < len - 1; i++)
+		{
+			cond &= (f[i] == __LIMB_62__);
+		}
+	}
+	else
+	{
+		cond = (f[0] == 1);
+		for(i = 1; i < len; i++)
+		{
+			cond &= (f[i] == 0);
+		}
+	}
+	if(!cond)
+	{
+		return 0;
+	}
+	normalize(d, f[len - 1], M);
+	from_62(r, d);
+	return 1;
+#else
+	(void)r;
+	(void)a;
+	(void)m;
+	fprintf(stderr, "Error: invert_words needs 128-bit integers and 64-bit limbs of GMP.\n");
+	exit(1);
+#endif
+}
+
+/** Invert a modulo m, as mpz_invert.
+ *
+ *	@brief For m odd of at most __INVERT_MAX_BITS__ bits, the inverse is
+ *	computed with invert_words, and a is first reduced modulo m if it is
+ *	not between -m and m. For other moduli, mpz_invert is called.
+ *
+ *	@return		Non-zero if a is invertible, 0 otherwise.
+ */
+int invert_mod(mpz_t r, mpz_t a, mpz_t m)
+{
+#if defined(__SIZEOF_INT128__) && GMP_NUMB_BITS == 64
+	uint64_t w[2], v[2], x[2];
+	unsigned __int128 y;
+	mp_limb_t *l;
+	int sign;
+	if(mpz_even_p(m) || mpz_sizeinbase(m, 2) > __INVERT_MAX_BITS__)
+	{
+		return mpz_invert(r, a, m);
+	}
+	if(mpz_cmpabs(a, m) >= 0)
+	{
+		mpz_mod(r, a, m);
+		a = r;
+	}
+	//a between -m and m, the inverse of -a being minus the one of a
+	sign = mpz_sgn(a);
+	v[0] = mpz_getlimbn(m, 0);
+	v[1] = mpz_getlimbn(m, 1);
+	w[0] = mpz_getlimbn(a, 0);
+	w[1] = mpz_getlimbn(a, 1);
+	if(!invert_words(x, w, v))
+	{
+		return 0;
+	}
+	if(sign < 0)
+	{
+		y = (((unsigned __int128)v[1] << 64) | v[0]) - (((unsigned __int128)x[1] << 64) | x[0]);
+		x[0] = (uint64_t)y;
+		x[1] = (uint64_t)(y >> 64);
+	}
+	l = mpz_limbs_write(r, 2);
+	l[0] = x[0];
+	l[1] = x[1];
+	mpz_limbs_finish(r, 2);
+	return 1;
+#else
+	return mpz_invert(r, a, m);
+#endif
+}
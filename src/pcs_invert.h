@@ -0,0 +1,14 @@
+/** @file pcs_invert.h
+ *
+ */
+#ifndef PCS_INVERT_H
+#define PCS_INVERT_H
+
+#include <gmp.h>
+#include <inttypes.h>
+
+#define __INVERT_MAX_BITS__ 127
+
+int invert_words(uint64_t r[2], const uint64_t a[2], const uint64_t m[2]);
+int invert_mod(mpz_t r, mpz_t a, mpz_t m);
+#endif
@@ -0,0 +1,242 @@
+/** @file pcs_kangaroo.c
+ *  @brief The parallel kangaroo method, for a logarithm known to lie in an interval [low, high].
+ *
+ *	Each thread walks __KANGAROOS_PER_THREAD__ kangaroos, half of them
+ *	tame and half of them wild (van Oorschot and Wiener, "Parallel
+ *	collision search with cryptanalytic applications", J. Cryptology
+ *	1999). A tame kangaroo starts at (low + w/2 + s)P and a wild one at
+ *	Q + sP, where w is the width of the interval and s is drawn in
+ *	[0, m). Both jump forward by the adding walk on P only: the jumps
+ *	A[i] are drawn in [1, 2m], so that their mean m is N*sqrt(w)/4 for N
+ *	kangaroos, and M[i] = A[i]P.
+ *
+ *	The distinguished points are kept in the storage structure of the
+ *	context with a = 2v + wild, where v is the distance of the kangaroo
+ *	from low (tame) or from Q (wild). A tame and a wild kangaroo on the
+ *	same point give the logarithm of Q. Two kangaroos of the same herd on
+ *	the same point walk the same path from there, so the last one is moved
+ *	forward by a random distance in [1, m].
+ *
+ *	The expected number of steps is about 2*sqrt(w), that is 2*sqrt(w)/t
+ *	per thread with t threads, plus the steps from the collision to the
+ *	next distinguished point.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_multi.h"
+#include "pcs_kangaroo.h"
+
+/** State of one kangaroo.
+ */
+typedef struct
+{
+	point_t R;
+	mpz_t v;
+	int wild;
+}kangaroo_t;
+
+/** Put a kangaroo at low + v (tame) or at Q + v (wild).
+ *
+ */
+static void kangaroo_place(pcs_ctx_t *ctx, kangaroo_t *k, mpz_t low)
+{
+	if(k->wild)
+	{
+		fixed_base_mul(ctx, &k->R, k->v);
+		add(&k->R, k->R, ctx->Q, ctx->E);
+	}
+	else
+	{
+		mpz_add(k->v, k->v, low);
+		fixed_base_mul(ctx, &k->R, k->v);
+		mpz_sub(k->v, k->v, low);
+	}
+}
+
+/** Draw the starting point of a kangaroo.
+ *
+ */
+static void kangaroo_start(pcs_ctx_t *ctx, pcs_walker_t *w, kangaroo_t *k, mpz_t low, mpz_t width, mpz_t mean)
+{
+	mpz_urandomm(k->v, w->r_state, mean);
+	if(!k->wild)
+	{
+		mpz_tdiv_q_2exp(w->x, width, 1);
+		mpz_add(k->v, k->v, w->x);
+	}
+	kangaroo_place(ctx, k, low);
+}
+
+/** Move a kangaroo forward by a random distance in [1, mean].
+ *
+ */
+static void kangaroo_shift(pcs_ctx_t *ctx, pcs_walker_t *w, kangaroo_t *k, mpz_t low, mpz_t mean)
+{
+	mpz_urandomm(w->x, w->r_state, mean);
+	mpz_add_ui(w->x, w->x, 1);
+	mpz_add(k->v, k->v, w->x);
+	kangaroo_place(ctx, k, low);
+}
+
+/** Get the logarithm of Q from a tame and a wild kangaroo on the same x coordinate.
+ *
+ *	@brief (low + t)P = +-(Q + uP), so x = low + t - u or x = -(low + t) - u.
+ *
+ *	@return 	1 if x was found, 0 otherwise.
+ */
+static int kangaroo_solve(pcs_ctx_t *ctx, mpz_t x, mpz_t low, mpz_t t, mpz_t u)
+{
+	point_t S;
+	int retval = 0;
+	point_init(&S);
+	mpz_add(x, low, t);
+	mpz_sub(x, x, u);
+	mpz_mod(x, x, ctx->n);
+	double_and_add(&S, ctx->P, x, ctx->E);
+	if(equal(S, ctx->Q))
+	{
+		retval = 1;
+	}
+	else
+	{
+		mpz_add(x, low, t);
+		mpz_add(x, x, u);
+		mpz_neg(x, x);
+		mpz_mod(x, x, ctx->n);
+		double_and_add(&S, ctx->P, x, ctx->E);
+		retval = equal(S, ctx->Q);
+	}
+	point_clear(&S);
+	return retval;
+}
+
+/** Walk the kangaroos of one thread until the run is over.
+ *
+ */
+static void kangaroo_walk(pcs_ctx_t *ctx, pcs_walker_t *w, kangaroo_t *herd, mpz_t low, mpz_t width, mpz_t mean, mpz_t x_res, int *collision_count)
+{
+	kangaroo_t *k;
+	char xDist_str[100];
+	uint8_t r;
+	int i, found;
+
+	w->nb_steps = 0;
+	for(i = 0; i < __KANGAROOS_PER_THREAD__; i++)
+	{
+		kangaroo_start(ctx, w, &herd[i], low, width, mean);
+	}
+	i = 0;
+	while(!run_done(ctx, collision_count, 1))
+	{
+		k = &herd[i];
+		i = (i + 1) % __KANGAROOS_PER_THREAD__;
+		r = hash(k->R.y);
+		f(k->R, ctx->M[r], &k->R, ctx->E);
+		mpz_add(k->v, k->v, ctx->A[r]);
+		w->nb_steps++;
+		if(!is_distinguished(k->R, ctx->trailling_bits, &w->xDist))
+		{
+			continue;
+		}
+		mpz_mul_2exp(w->a, k->v, 1);
+		mpz_add_ui(w->a, w->a, k->wild);
+		if(mpz_sizeinbase(w->a, 2) > ctx->nb_bits) //too far past the interval to be stored
+		{
+			kangaroo_start(ctx, w, k, low, width, mean);
+			continue;
+		}
+		if(!struct_add(&ctx->storage, w->a2, w->a, w->xDist, xDist_str))
+		{
+			continue;
+		}
+		if((mpz_odd_p(w->a2) != 0) == k->wild) //same herd, same path from here
+		{
+			kangaroo_shift(ctx, w, k, low, mean);
+			continue;
+		}
+		mpz_tdiv_q_2exp(w->a2, w->a2, 1);
+		if(k->wild)
+		{
+			found = kangaroo_solve(ctx, w->x, low, w->a2, k->v);
+		}
+		else
+		{
+			found = kangaroo_solve(ctx, w->x, low, k->v, w->a2);
+		}
+		if(found)
+		{
+			#pragma omp critical
+			{
+				(*collision_count)++;
+				mpz_set(x_res, w->x);
+			}
+		}
+		else
+		{
+			kangaroo_shift(ctx, w, k, low, mean);
+		}
+	}
+}
+
+/** Solve Q = xP for x in [low, high] with the parallel kangaroo method.
+ *
+ *	@brief The adding walk of the context is replaced by the jumps of the
+ *	kangaroos, which are drawn for the width of the interval, and the
+ *	storage structure is emptied. The stored coefficients are less than
+ *	2^nb_bits, so the width should be less than 2^(nb_bits - 2).
+ *
+ *	@return	1 if x was found, 0 if the run was stopped through ctx->stop.
+ */
+long long int pcs_run_kangaroo(pcs_ctx_t *ctx, mpz_t low, mpz_t high, mpz_t x_res)
+{
+	int collision_count = 0;
+	int nb_kangaroos = ctx->nb_threads * __KANGAROOS_PER_THREAD__;
+	mpz_t width, mean;
+	int i;
+
+	mpz_inits(width, mean, NULL);
+	mpz_sub(width, high, low);
+	mpz_add_ui(width, width, 1);
+	mpz_sqrt(mean, width);
+	mpz_mul_ui(mean, mean, nb_kangaroos);
+	mpz_tdiv_q_2exp(mean, mean, 2);
+	if(mpz_sgn(mean) == 0)
+	{
+		mpz_set_ui(mean, 1);
+	}
+	mpz_mul_2exp(width, mean, 1);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_urandomm(ctx->A[i], ctx->walkers[0].r_state, width);
+		mpz_add_ui(ctx->A[i], ctx->A[i], 1);
+	}
+	walk_on_P(ctx);
+	struct_reset(&ctx->storage);
+	mpz_sub(width, high, low);
+	mpz_add_ui(width, width, 1);
+
+	#pragma omp parallel shared(collision_count, x_res) num_threads(ctx->nb_threads)
+	{
+		kangaroo_t herd[__KANGAROOS_PER_THREAD__];
+		pcs_walker_t *w = &ctx->walkers[omp_get_thread_num()];
+		int j;
+		for(j = 0; j < __KANGAROOS_PER_THREAD__; j++)
+		{
+			point_init(&herd[j].R);
+			mpz_init(herd[j].v);
+			herd[j].wild = j % 2;
+		}
+		kangaroo_walk(ctx, w, herd, low, width, mean, x_res, &collision_count);
+		for(j = 0; j < __KANGAROOS_PER_THREAD__; j++)
+		{
+			point_clear(&herd[j].R);
+			mpz_clear(herd[j].v);
+		}
+	}
+	mpz_clears(width, mean, NULL);
+	return collision_count;
+}
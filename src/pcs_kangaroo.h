@@ -0,0 +1,12 @@
+/** @file pcs_kangaroo.h
+ *
+ */
+#ifndef PCS_KANGAROO_H
+#define PCS_KANGAROO_H
+
+#include "pcs.h"
+
+#define __KANGAROOS_PER_THREAD__ 2
+
+long long int pcs_run_kangaroo(pcs_ctx_t *ctx, mpz_t low, mpz_t high, mpz_t x_res);
+#endif
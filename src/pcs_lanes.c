@@ -0,0 +1,967 @@
+/** @file pcs_lanes.c
+ *  @brief Walking several trails per thread in the lanes of vector registers.
+ *
+ *	Each thread walks __LANES_GROUPS__ groups of __LANES_WIDTH__ trails.
+ *	The coordinates are kept in Montgomery form, __LANES_LIMBS__ limbs
+ *	per coordinate, in the representation of one of three kernels:
+ *	- __LANES_KERNEL_IFMA__ works in radix 2^52, so that a multiplication
+ *	  modulo p is a handful of 52-bit multiply-adds. A group of 8 walks is
+ *	  one vector per limb and the multiply-adds are the AVX-512 IFMA
+ *	  instructions vpmadd52luq and vpmadd52huq.
+ *	- __LANES_KERNEL_MULX__ and __LANES_KERNEL_GENERIC__ work in radix
+ *	  2^64, one lane at a time, with the field kernels of pcs_field.h of
+ *	  the same names.
+ *	The fastest kernel that runs on the processor is chosen at run time,
+ *	unless lanes_set_kernel asks for another one.
+ *
+ *	A step of every walk needs the inverse of xM - xR. The inversions of
+ *	all the walks of a thread are batched with Montgomery's trick: the
+ *	differences are multiplied together, the product is inverted once
+ *	with mpz_invert and each inverse is recovered with two more
+ *	multiplications. The adding set and the distinguished property are
+ *	read from the coordinates themselves, which are computed at each step
+ *	from the Montgomery form, so the walks are the same as with f and the
+ *	trails are walked again with f in is_collision.
+ *
+ *	The rare steps add does not handle with the slope formula (xR = xM)
+ *	end the trail of the walk, and a new one is started.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_field.h"
+#include "pcs_lanes.h"
+
+#define __LIMB_MASK__ ((1ULL << __LANES_RADIX__) - 1)
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define __LANES_IFMA__
+#include <immintrin.h>
+#define __LANES_IFMA_TARGET__ __attribute__((target("avx512f,avx512ifma")))
+#endif
+
+#ifdef __SIZEOF_INT128__
+
+static void fe_get(uint64_t r[__LANES_LIMBS__], const lanes_fe_t *a, int k)
+{
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		r[j] = a->v[j][k];
+	}
+}
+
+static void fe_set(lanes_fe_t *a, int k, const uint64_t r[__LANES_LIMBS__])
+{
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		a->v[j][k] = r[j];
+	}
+}
+
+#ifdef __LANES_IFMA__
+
+/** Write a number below 2^156 in radix 2^52.
+ *
+ */
+static void fe_from_mpz(uint64_t r[__LANES_LIMBS__], mpz_t z)
+{
+	uint64_t w[__LANES_LIMBS__] = {0, 0, 0};
+	size_t count;
+	mpz_export(w, &count, -1, sizeof(uint64_t), 0, 0, z);
+	r[0] = w[0] & __LIMB_MASK__;
+	r[1] = ((w[0] >> 52) | (w[1] << 12)) & __LIMB_MASK__;
+	r[2] = ((w[1] >> 40) | (w[2] << 24)) & __LIMB_MASK__;
+}
+
+/** Read a number written in radix 2^52.
+ *
+ */
+static void fe_to_mpz(mpz_t z, const uint64_t a[__LANES_LIMBS__])
+{
+	uint64_t w[__LANES_LIMBS__];
+	w[0] = a[0] | (a[1] << 52);
+	w[1] = (a[1] >> 12) | (a[2] << 40);
+	w[2] = a[2] >> 24;
+	mpz_import(z, __LANES_LIMBS__, -1, sizeof(uint64_t), 0, 0, w);
+}
+
+/** Montgomery multiplication, r = ab/2^156 mod p.
+ *
+ *	@brief For a and b below 8p, r is below 2p.
+ */
+static void fe_mul(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const uint64_t b[__LANES_LIMBS__], const lanes_field_t *F)
+{
+	unsigned __int128 t0 = 0, t1 = 0, t2 = 0;
+	uint64_t m;
+	int i;
+	for(i = 0; i < __LANES_LIMBS__; i++)
+	{
+		t0 += (unsigned __int128)a[i] * b[0];
+		t1 += (unsigned __int128)a[i] * b[1];
+		t2 += (unsigned __int128)a[i] * b[2];
+		m = ((uint64_t)t0 * F->pinv) & __LIMB_MASK__;
+		t0 += (unsigned __int128)m * F->p[0];
+		t1 += (unsigned __int128)m * F->p[1];
+		t2 += (unsigned __int128)m * F->p[2];
+		t0 = t1 + (t0 >> 52);
+		t1 = t2;
+		t2 = 0;
+	}
+	r[0] = (uint64_t)t0 & __LIMB_MASK__;
+	t1 += t0 >> 52;
+	r[1] = (uint64_t)t1 & __LIMB_MASK__;
+	r[2] = (uint64_t)(t1 >> 52);
+}
+
+/** r = a + kp - b, for a + kp >= b.
+ *
+ */
+static void fe_sub(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const uint64_t b[__LANES_LIMBS__], const uint64_t kp[__LANES_LIMBS__])
+{
+	int64_t t0, t1, t2;
+	t0 = (int64_t)(a[0] + kp[0]) - (int64_t)b[0];
+	t1 = (int64_t)(a[1] + kp[1]) - (int64_t)b[1];
+	t2 = (int64_t)(a[2] + kp[2]) - (int64_t)b[2];
+	t1 += t0 >> 52;
+	t2 += t1 >> 52;
+	r[0] = (uint64_t)t0 & __LIMB_MASK__;
+	r[1] = (uint64_t)t1 & __LIMB_MASK__;
+	r[2] = (uint64_t)t2;
+}
+
+/** r = a - kp if a >= kp, a otherwise.
+ *
+ */
+static void fe_cond_sub(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const uint64_t kp[__LANES_LIMBS__])
+{
+	static const uint64_t zero[__LANES_LIMBS__] = {0, 0, 0};
+	uint64_t s[__LANES_LIMBS__];
+	int j;
+	fe_sub(s, a, kp, zero);
+	if((int64_t)s[2] >= 0)
+	{
+		a = s;
+	}
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		r[j] = a[j];
+	}
+}
+
+/** Get the coordinate itself, below p, from its Montgomery form.
+ *
+ */
+static void fe_canonical(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const lanes_field_t *F)
+{
+	static const uint64_t unit[__LANES_LIMBS__] = {1, 0, 0};
+	fe_mul(r, a, unit, F);
+	fe_cond_sub(r, r, F->p);
+}
+
+/** Get the Montgomery form, below p, of a coordinate.
+ *
+ */
+static void fe_montgomery(uint64_t r[__LANES_LIMBS__], mpz_t z, const lanes_field_t *F)
+{
+	uint64_t a[__LANES_LIMBS__];
+	fe_from_mpz(a, z);
+	fe_mul(r, a, F->r2, F);
+	fe_cond_sub(r, r, F->p);
+}
+
+/** Set the constants of the field in radix 2^52.
+ *
+ */
+static void fe_field_init(lanes_field_t *F, pcs_ctx_t *ctx)
+{
+	mpz_t t;
+	mpz_init(t);
+	fe_from_mpz(F->p, ctx->E.p);
+	mpz_mul_2exp(t, ctx->E.p, 1);
+	fe_from_mpz(F->p2, t);
+	mpz_mul_2exp(t, ctx->E.p, 2);
+	fe_from_mpz(F->p4, t);
+	mpz_set_ui(t, 0);
+	mpz_setbit(t, __LANES_RADIX__);
+	mpz_invert(t, ctx->E.p, t);
+	F->pinv = ((1ULL << __LANES_RADIX__) - mpz_get_ui(t)) & __LIMB_MASK__;
+	mpz_set_ui(t, 0);
+	mpz_setbit(t, 2 * __LANES_LIMBS__ * __LANES_RADIX__);
+	mpz_mod(t, t, ctx->E.p);
+	fe_from_mpz(F->r2, t);
+	mpz_clear(t);
+}
+
+#endif
+
+/** Write a coordinate in the representation of the kernel.
+ *
+ */
+static void lanes_from_mpz(uint64_t r[__LANES_LIMBS__], mpz_t z, const lanes_field_t *F)
+{
+#ifdef __LANES_IFMA__
+	if(F->kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_from_mpz(r, z);
+		return;
+	}
+#endif
+	r[0] = r[1] = r[2] = 0;
+	field_from_mpz(r, z, &F->field);
+}
+
+static void lanes_to_mpz(mpz_t z, const uint64_t a[__LANES_LIMBS__], const lanes_field_t *F)
+{
+#ifdef __LANES_IFMA__
+	if(F->kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_to_mpz(z, a);
+		return;
+	}
+#endif
+	field_to_mpz(z, a, &F->field);
+}
+
+/** Get the Montgomery form, below p, of a coordinate.
+ *
+ */
+static void lanes_montgomery(uint64_t r[__LANES_LIMBS__], mpz_t z, const lanes_field_t *F)
+{
+#ifdef __LANES_IFMA__
+	if(F->kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_montgomery(r, z, F);
+		return;
+	}
+#endif
+	r[0] = r[1] = r[2] = 0;
+	field_set(r, z, &F->field);
+}
+
+/** Get the coordinate itself, below p, from its Montgomery form.
+ *
+ */
+static void lanes_canonical(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const lanes_field_t *F)
+{
+#ifdef __LANES_IFMA__
+	if(F->kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_canonical(r, a, F);
+		return;
+	}
+#endif
+	field_canonical(r, a, &F->field);
+}
+
+static void lanes_mul(uint64_t r[__LANES_LIMBS__], const uint64_t a[__LANES_LIMBS__], const uint64_t b[__LANES_LIMBS__], const lanes_field_t *F)
+{
+#ifdef __LANES_IFMA__
+	if(F->kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_mul(r, a, b, F);
+		return;
+	}
+#endif
+	F->field.mul(r, a, b, &F->field);
+}
+
+/** Set the constants of the field and of the adding walk of a context, for a kernel.
+ *
+ */
+static void lanes_field_init(lanes_field_t *F, pcs_ctx_t *ctx, int kernel)
+{
+	uint64_t a[__LANES_LIMBS__];
+	mpz_t t;
+	int r, j;
+	F->kernel = kernel;
+#ifdef __LANES_IFMA__
+	if(kernel == __LANES_KERNEL_IFMA__)
+	{
+		fe_field_init(F, ctx);
+	}
+	else
+#endif
+	{
+		field_init(&F->field, ctx->E.p, (kernel == __LANES_KERNEL_MULX__) ? __FIELD_MULX__ : __FIELD_GENERIC__);
+	}
+	mpz_init_set_ui(t, 1);
+	lanes_montgomery(F->one, t, F);
+	F->dmask = (1ULL << ctx->trailling_bits) - 1;
+	for(r = 0; r < __NB_ENSEMBLES__; r++)
+	{
+		lanes_from_mpz(a, ctx->M[r].x, F);
+		for(j = 0; j < __LANES_LIMBS__; j++)
+		{
+			F->Mcx[j][r] = a[j];
+		}
+		lanes_montgomery(a, ctx->M[r].x, F);
+		for(j = 0; j < __LANES_LIMBS__; j++)
+		{
+			F->Mx[j][r] = a[j];
+		}
+		lanes_montgomery(a, ctx->M[r].y, F);
+		for(j = 0; j < __LANES_LIMBS__; j++)
+		{
+			F->My[j][r] = a[j];
+		}
+	}
+	mpz_clear(t);
+}
+
+/** The adding set of a point, hash(y) written for radix 2^64.
+ *
+ *	@brief 2^64 = 2^128 = 16 mod 20.
+ */
+static uint64_t lanes_hash(const uint64_t y[__LANES_LIMBS__])
+{
+	return (y[0] % __NB_ENSEMBLES__ + 16 * (y[1] % __NB_ENSEMBLES__ + y[2] % __NB_ENSEMBLES__)) % __NB_ENSEMBLES__;
+}
+
+/** Choose the adding set of each walk of a group and multiply its xM - xR into the running product.
+ *
+ *	@brief A walk with xR = xM is flagged in L->eq, and 1 is used in
+ *	place of its difference.
+ */
+static void lanes_prepare_field(const lanes_field_t *F, lanes_t *L, int g)
+{
+	const field_t *K = &F->field;
+	uint64_t cx[__LANES_LIMBS__], cy[__LANES_LIMBS__], x[__LANES_LIMBS__], xM[__LANES_LIMBS__];
+	uint64_t dx[__LANES_LIMBS__] = {0, 0, 0}, c[__LANES_LIMBS__] = {0, 0, 0};
+	uint64_t r;
+	int k, j;
+	L->eq[g] = 0;
+	for(k = 0; k < __LANES_WIDTH__; k++)
+	{
+		fe_get(cx, &L->cx[g], k);
+		fe_get(cy, &L->cy[g], k);
+		fe_get(x, &L->x[g], k);
+		r = lanes_hash(cy);
+		L->r[g][k] = r;
+		for(j = 0; j < __LANES_LIMBS__; j++)
+		{
+			xM[j] = F->Mx[j][r];
+		}
+		if(cx[0] == F->Mcx[0][r] && cx[1] == F->Mcx[1][r] && cx[2] == F->Mcx[2][r])
+		{
+			L->eq[g] |= 1 << k;
+			fe_set(&L->dx[g], k, F->one);
+		}
+		else
+		{
+			field_sub(dx, xM, x, K);
+			fe_set(&L->dx[g], k, dx);
+		}
+		if(g > 0)
+		{
+			fe_get(c, &L->c[g - 1], k);
+			fe_get(dx, &L->dx[g], k);
+			K->mul(c, c, dx, K);
+			fe_set(&L->c[g], k, c);
+		}
+		else
+		{
+			L->c[g] = L->dx[g];
+		}
+	}
+}
+
+/** Replace xM - xR by its inverse, for every walk, given the inverse of the running product of the last group.
+ *
+ */
+static void lanes_inverses_field(const lanes_field_t *F, lanes_t *L, lanes_fe_t *inv)
+{
+	const field_t *K = &F->field;
+	uint64_t i[__LANES_LIMBS__], u[__LANES_LIMBS__], dx[__LANES_LIMBS__];
+	int g, k;
+	for(k = 0; k < __LANES_WIDTH__; k++)
+	{
+		fe_get(i, inv, k);
+		for(g = __LANES_GROUPS__ - 1; g > 0; g--)
+		{
+			fe_get(u, &L->c[g - 1], k);
+			fe_get(dx, &L->dx[g], k);
+			K->mul(u, i, u, K);
+			K->mul(i, i, dx, K);
+			fe_set(&L->dx[g], k, u);
+		}
+		fe_set(&L->dx[0], k, i);
+	}
+}
+
+/** Step the walks of all groups, once L->dx holds the inverses of xM - xR.
+ *
+ *	@brief The distinguished points reached are flagged in L->dp.
+ */
+static void lanes_steps_field(const lanes_field_t *F, lanes_t *L)
+{
+	const field_t *K = &F->field;
+	uint64_t x[__LANES_LIMBS__], y[__LANES_LIMBS__], xM[__LANES_LIMBS__], yM[__LANES_LIMBS__], i[__LANES_LIMBS__];
+	uint64_t u[__LANES_LIMBS__] = {0, 0, 0}, l[__LANES_LIMBS__] = {0, 0, 0}, x3[__LANES_LIMBS__] = {0, 0, 0}, y3[__LANES_LIMBS__] = {0, 0, 0};
+	uint64_t r;
+	int g, k, j;
+	for(g = 0; g < __LANES_GROUPS__; g++)
+	{
+		L->dp[g] = 0;
+		for(k = 0; k < __LANES_WIDTH__; k++)
+		{
+			r = L->r[g][k];
+			for(j = 0; j < __LANES_LIMBS__; j++)
+			{
+				xM[j] = F->Mx[j][r];
+				yM[j] = F->My[j][r];
+			}
+			fe_get(i, &L->dx[g], k);
+			fe_get(x, &L->x[g], k);
+			fe_get(y, &L->y[g], k);
+			//l = (yM - yR)/(xM - xR)
+			field_sub(u, yM, y, K);
+			K->mul(l, u, i, K);
+			//x3 = l^2 - xR - xM
+			K->sqr(u, l, l, K);
+			field_sub(u, u, x, K);
+			field_sub(x3, u, xM, K);
+			//y3 = l(xR - x3) - yR
+			field_sub(u, x, x3, K);
+			K->mul(u, l, u, K);
+			field_sub(y3, u, y, K);
+			fe_set(&L->x[g], k, x3);
+			fe_set(&L->y[g], k, y3);
+			field_canonical(u, x3, K);
+			fe_set(&L->cx[g], k, u);
+			if((u[0] & F->dmask) == 0 && !(L->eq[g] & (1 << k)))
+			{
+				L->dp[g] |= 1 << k;
+			}
+			field_canonical(u, y3, K);
+			fe_set(&L->cy[g], k, u);
+		}
+	}
+}
+
+#ifdef __LANES_IFMA__
+
+/** A field element of the 8 walks of a group, one vector per limb.
+ */
+typedef struct
+{
+	__m512i l[__LANES_LIMBS__];
+}vfe_t;
+
+__LANES_IFMA_TARGET__ static inline vfe_t v_load(const lanes_fe_t *a)
+{
+	vfe_t r;
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		r.l[j] = _mm512_loadu_si512((const void *)a->v[j]);
+	}
+	return r;
+}
+
+__LANES_IFMA_TARGET__ static inline void v_store(lanes_fe_t *a, vfe_t r)
+{
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		_mm512_storeu_si512((void *)a->v[j], r.l[j]);
+	}
+}
+
+__LANES_IFMA_TARGET__ static inline vfe_t v_set1(const uint64_t c[__LANES_LIMBS__])
+{
+	vfe_t r;
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		r.l[j] = _mm512_set1_epi64((long long int)c[j]);
+	}
+	return r;
+}
+
+__LANES_IFMA_TARGET__ static inline vfe_t v_gather(__m512i r, const uint64_t t[__LANES_LIMBS__][__NB_ENSEMBLES__])
+{
+	vfe_t v;
+	int j;
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		v.l[j] = _mm512_i64gather_epi64(r, (const void *)t[j], 8);
+	}
+	return v;
+}
+
+/** Montgomery multiplication of 8 pairs, as fe_mul.
+ *
+ */
+__LANES_IFMA_TARGET__ static inline vfe_t v_mul(vfe_t a, vfe_t b, vfe_t p, __m512i pinv)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i mask = _mm512_set1_epi64(__LIMB_MASK__);
+	__m512i t0 = zero, t1 = zero, t2 = zero, t3 = zero, m;
+	vfe_t r;
+	int i;
+	for(i = 0; i < __LANES_LIMBS__; i++)
+	{
+		t0 = _mm512_madd52lo_epu64(t0, a.l[i], b.l[0]);
+		t1 = _mm512_madd52lo_epu64(t1, a.l[i], b.l[1]);
+		t2 = _mm512_madd52lo_epu64(t2, a.l[i], b.l[2]);
+		t1 = _mm512_madd52hi_epu64(t1, a.l[i], b.l[0]);
+		t2 = _mm512_madd52hi_epu64(t2, a.l[i], b.l[1]);
+		t3 = _mm512_madd52hi_epu64(t3, a.l[i], b.l[2]);
+		m = _mm512_madd52lo_epu64(zero, t0, pinv);
+		t0 = _mm512_madd52lo_epu64(t0, m, p.l[0]);
+		t1 = _mm512_madd52lo_epu64(t1, m, p.l[1]);
+		t2 = _mm512_madd52lo_epu64(t2, m, p.l[2]);
+		t1 = _mm512_madd52hi_epu64(t1, m, p.l[0]);
+		t2 = _mm512_madd52hi_epu64(t2, m, p.l[1]);
+		t3 = _mm512_madd52hi_epu64(t3, m, p.l[2]);
+		t0 = _mm512_add_epi64(t1, _mm512_srli_epi64(t0, 52));
+		t1 = t2;
+		t2 = t3;
+		t3 = zero;
+	}
+	r.l[0] = _mm512_and_si512(t0, mask);
+	t1 = _mm512_add_epi64(t1, _mm512_srli_epi64(t0, 52));
+	r.l[1] = _mm512_and_si512(t1, mask);
+	r.l[2] = _mm512_add_epi64(t2, _mm512_srli_epi64(t1, 52));
+	return r;
+}
+
+/** a + kp - b for 8 triples, as fe_sub.
+ *
+ */
+__LANES_IFMA_TARGET__ static inline vfe_t v_sub(vfe_t a, vfe_t b, vfe_t kp)
+{
+	const __m512i mask = _mm512_set1_epi64(__LIMB_MASK__);
+	__m512i t0, t1, t2;
+	vfe_t r;
+	t0 = _mm512_sub_epi64(_mm512_add_epi64(a.l[0], kp.l[0]), b.l[0]);
+	t1 = _mm512_sub_epi64(_mm512_add_epi64(a.l[1], kp.l[1]), b.l[1]);
+	t2 = _mm512_sub_epi64(_mm512_add_epi64(a.l[2], kp.l[2]), b.l[2]);
+	t1 = _mm512_add_epi64(t1, _mm512_srai_epi64(t0, 52));
+	t2 = _mm512_add_epi64(t2, _mm512_srai_epi64(t1, 52));
+	r.l[0] = _mm512_and_si512(t0, mask);
+	r.l[1] = _mm512_and_si512(t1, mask);
+	r.l[2] = t2;
+	return r;
+}
+
+/** a - kp where a >= kp, a elsewhere, as fe_cond_sub.
+ *
+ */
+__LANES_IFMA_TARGET__ static inline vfe_t v_cond_sub(vfe_t a, vfe_t kp)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	vfe_t z, s;
+	__mmask8 ge;
+	int j;
+	z.l[0] = z.l[1] = z.l[2] = zero;
+	s = v_sub(a, kp, z);
+	ge = _mm512_cmpge_epi64_mask(s.l[2], zero);
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		a.l[j] = _mm512_mask_blend_epi64(ge, a.l[j], s.l[j]);
+	}
+	return a;
+}
+
+/** The adding sets of 8 points, as fe_hash.
+ *
+ *	@brief y[0] + 16(y[1] + y[2]) is folded below 2^52, then divided by
+ *	20 with a multiplication by ceil(2^52/20), which gives the quotient
+ *	or the quotient plus one.
+ */
+__LANES_IFMA_TARGET__ static inline __m512i v_hash(vfe_t y)
+{
+	const __m512i zero = _mm512_setzero_si512();
+	const __m512i mask = _mm512_set1_epi64(__LIMB_MASK__);
+	const __m512i twenty = _mm512_set1_epi64(__NB_ENSEMBLES__);
+	const __m512i magic = _mm512_set1_epi64(((1ULL << 52) + __NB_ENSEMBLES__ - 1) / __NB_ENSEMBLES__);
+	__m512i s, q, r;
+	s = _mm512_add_epi64(y.l[0], _mm512_slli_epi64(_mm512_add_epi64(y.l[1], y.l[2]), 4));
+	s = _mm512_add_epi64(_mm512_and_si512(s, mask), _mm512_slli_epi64(_mm512_srli_epi64(s, 52), 4));
+	s = _mm512_add_epi64(_mm512_and_si512(s, mask), _mm512_slli_epi64(_mm512_srli_epi64(s, 52), 4));
+	q = _mm512_madd52hi_epu64(zero, s, magic);
+	r = _mm512_sub_epi64(s, _mm512_add_epi64(_mm512_slli_epi64(q, 4), _mm512_slli_epi64(q, 2)));
+	return _mm512_mask_add_epi64(r, _mm512_cmplt_epi64_mask(r, zero), r, twenty);
+}
+
+/** lanes_prepare_field, for the 8 walks of a group at once.
+ *
+ */
+__LANES_IFMA_TARGET__ static void lanes_prepare_ifma(const lanes_field_t *F, lanes_t *L, int g)
+{
+	vfe_t x, cx, cxM, dx, one;
+	__m512i r;
+	__mmask8 eq;
+	int j;
+	one = v_set1(F->one);
+	x = v_load(&L->x[g]);
+	cx = v_load(&L->cx[g]);
+	r = v_hash(v_load(&L->cy[g]));
+	_mm512_storeu_si512((void *)L->r[g], r);
+	cxM = v_gather(r, F->Mcx);
+	eq = _mm512_cmpeq_epi64_mask(cx.l[0], cxM.l[0]) & _mm512_cmpeq_epi64_mask(cx.l[1], cxM.l[1]) & _mm512_cmpeq_epi64_mask(cx.l[2], cxM.l[2]);
+	dx = v_sub(v_gather(r, F->Mx), x, v_set1(F->p2));
+	for(j = 0; j < __LANES_LIMBS__; j++)
+	{
+		dx.l[j] = _mm512_mask_blend_epi64(eq, dx.l[j], one.l[j]);
+	}
+	L->eq[g] = eq;
+	v_store(&L->dx[g], dx);
+	if(g > 0)
+	{
+		v_store(&L->c[g], v_mul(v_load(&L->c[g - 1]), dx, v_set1(F->p), _mm512_set1_epi64(F->pinv)));
+	}
+	else
+	{
+		v_store(&L->c[g], dx);
+	}
+}
+
+/** lanes_inverses_field, for the 8 walks of a group at once.
+ *
+ */
+__LANES_IFMA_TARGET__ static void lanes_inverses_ifma(const lanes_field_t *F, lanes_t *L, lanes_fe_t *inv)
+{
+	const vfe_t p = v_set1(F->p);
+	const __m512i pinv = _mm512_set1_epi64(F->pinv);
+	vfe_t i, u;
+	int g;
+	i = v_load(inv);
+	for(g = __LANES_GROUPS__ - 1; g > 0; g--)
+	{
+		u = v_mul(i, v_load(&L->c[g - 1]), p, pinv);
+		i = v_mul(i, v_load(&L->dx[g]), p, pinv);
+		v_store(&L->dx[g], u);
+	}
+	v_store(&L->dx[0], i);
+}
+
+/** Step the 8 walks of a group, as lanes_steps_field.
+ *
+ */
+__LANES_IFMA_TARGET__ __attribute__((always_inline)) static inline void v_step(const lanes_field_t *F, lanes_t *L, int g)
+{
+	static const uint64_t unit_limbs[__LANES_LIMBS__] = {1, 0, 0};
+	const vfe_t p = v_set1(F->p), p2 = v_set1(F->p2), p4 = v_set1(F->p4), unit = v_set1(unit_limbs);
+	const __m512i pinv = _mm512_set1_epi64(F->pinv);
+	vfe_t zero, x, y, xM, yM, l, u, x3, y3, cx;
+	__m512i r;
+	zero.l[0] = zero.l[1] = zero.l[2] = _mm512_setzero_si512();
+	r = _mm512_loadu_si512((const void *)L->r[g]);
+	xM = v_gather(r, F->Mx);
+	yM = v_gather(r, F->My);
+	x = v_load(&L->x[g]);
+	y = v_load(&L->y[g]);
+	//l = (yM - yR)/(xM - xR)
+	l = v_mul(v_sub(yM, y, p2), v_load(&L->dx[g]), p, pinv);
+	//x3 = l^2 - xR - xM
+	u = v_sub(v_mul(l, l, p, pinv), x, p4);
+	x3 = v_cond_sub(v_cond_sub(v_sub(u, xM, zero), p4), p2);
+	//y3 = l(xR - x3) - yR
+	u = v_mul(l, v_sub(x, x3, p2), p, pinv);
+	y3 = v_cond_sub(v_sub(u, y, p2), p2);
+	v_store(&L->x[g], x3);
+	v_store(&L->y[g], y3);
+	cx = v_cond_sub(v_mul(x3, unit, p, pinv), p);
+	v_store(&L->cx[g], cx);
+	v_store(&L->cy[g], v_cond_sub(v_mul(y3, unit, p, pinv), p));
+	L->dp[g] = _mm512_testn_epi64_mask(cx.l[0], _mm512_set1_epi64(F->dmask)) & ~L->eq[g];
+}
+
+/** lanes_steps_field, two groups at a time.
+ *
+ *	@brief The multiplications of a group depend on each other, and the
+ *	latency of the multiply-adds is better hidden by stepping two
+ *	independent groups together.
+ */
+__LANES_IFMA_TARGET__ static void lanes_steps_ifma(const lanes_field_t *F, lanes_t *L)
+{
+	int g;
+	for(g = 0; g < __LANES_GROUPS__; g += 2)
+	{
+		v_step(F, L, g);
+		v_step(F, L, g + 1);
+	}
+}
+
+#endif
+
+/** Invert the running products of the last group, one per lane.
+ *
+ *	@brief The 8 products are themselves multiplied together, so that
+ *	mpz_invert is called once per step of all the walks of a thread.
+ */
+static void lanes_invert(const lanes_field_t *F, lanes_t *L, lanes_fe_t *inv, mpz_t t, mpz_t p)
+{
+	uint64_t c[__LANES_WIDTH__][__LANES_LIMBS__], s[__LANES_WIDTH__][__LANES_LIMBS__];
+	uint64_t i[__LANES_LIMBS__] = {0, 0, 0}, u[__LANES_LIMBS__] = {0, 0, 0};
+	int k;
+	for(k = 0; k < __LANES_WIDTH__; k++)
+	{
+		fe_get(c[k], &L->c[__LANES_GROUPS__ - 1], k);
+		if(k > 0)
+		{
+			lanes_mul(s[k], s[k - 1], c[k], F);
+		}
+		else
+		{
+			fe_get(s[k], &L->c[__LANES_GROUPS__ - 1], k);
+		}
+	}
+	lanes_canonical(u, s[__LANES_WIDTH__ - 1], F);
+	lanes_to_mpz(t, u, F);
+	if(!mpz_invert(t, t, p))
+	{
+		fprintf(stderr, "Error: a step of the lanes has no inverse.\n");
+		exit(1);
+	}
+	lanes_montgomery(i, t, F);
+	for(k = __LANES_WIDTH__ - 1; k > 0; k--)
+	{
+		lanes_mul(u, i, s[k - 1], F);
+		fe_set(inv, k, u);
+		lanes_mul(i, i, c[k], F);
+	}
+	fe_set(inv, 0, i);
+}
+
+/** Start a new trail on a lane.
+ *
+ *	@brief Starting points at infinity are drawn again, and distinguished
+ *	ones are handled as the walk does, before drawing another one.
+ */
+static void lanes_start(pcs_ctx_t *ctx, pcs_walker_t *w, const lanes_field_t *F, lanes_t *L, int g, int k, mpz_t x_res, int *collision_count)
+{
+	uint64_t a[__LANES_LIMBS__];
+	for(;;)
+	{
+		start_trail(ctx, w);
+		if(mpz_cmp_ui(w->R.z, 1) != 0)
+		{
+			continue;
+		}
+		if(!is_distinguished_lean(w->R, ctx->trailling_bits, &w->xDist))
+		{
+			break;
+		}
+		walk_distinguished(ctx, w, x_res, collision_count);
+	}
+	lanes_from_mpz(a, w->R.x, F);
+	fe_set(&L->cx[g], k, a);
+	lanes_from_mpz(a, w->R.y, F);
+	fe_set(&L->cy[g], k, a);
+	lanes_montgomery(a, w->R.x, F);
+	fe_set(&L->x[g], k, a);
+	lanes_montgomery(a, w->R.y, F);
+	fe_set(&L->y[g], k, a);
+	mpz_set(L->a[g][k], w->a);
+	L->trail_length[g][k] = 0;
+}
+
+/** Handle the distinguished point reached by a lane.
+ *
+ */
+static void lanes_distinguished(pcs_ctx_t *ctx, pcs_walker_t *w, const lanes_field_t *F, lanes_t *L, int g, int k, mpz_t x_res, int *collision_count)
+{
+	uint64_t a[__LANES_LIMBS__];
+	fe_get(a, &L->cx[g], k);
+	lanes_to_mpz(w->R.x, a, F);
+	fe_get(a, &L->cy[g], k);
+	lanes_to_mpz(w->R.y, a, F);
+	mpz_set_ui(w->R.z, 1);
+	mpz_set(w->a, L->a[g][k]);
+	mpz_tdiv_q_2exp(w->xDist, w->R.x, ctx->trailling_bits);
+	walk_distinguished(ctx, w, x_res, collision_count);
+}
+
+#endif
+
+static const char *lanes_kernel_names[__LANES_NB_KERNELS__] = {"avx512ifma", "mulx", "generic"};
+
+/** Check whether a kernel of the lanes runs on this processor.
+ *
+ */
+int lanes_kernel_available(int kernel)
+{
+#ifdef __SIZEOF_INT128__
+	switch(kernel)
+	{
+#ifdef __LANES_IFMA__
+		case __LANES_KERNEL_IFMA__:
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512ifma");
+#endif
+		case __LANES_KERNEL_MULX__: return field_kernel_available(__FIELD_MULX__);
+		case __LANES_KERNEL_GENERIC__: return 1;
+		default: return 0;
+	}
+#else
+	(void)kernel;
+	return 0;
+#endif
+}
+
+/** Get the fastest kernel of the lanes that runs on this processor.
+ *
+ */
+int lanes_best_kernel(void)
+{
+	if(lanes_kernel_available(__LANES_KERNEL_IFMA__))
+	{
+		return __LANES_KERNEL_IFMA__;
+	}
+	return lanes_kernel_available(__LANES_KERNEL_MULX__) ? __LANES_KERNEL_MULX__ : __LANES_KERNEL_GENERIC__;
+}
+
+const char *lanes_kernel_name(int kernel)
+{
+	if(kernel == __LANES_KERNEL_BEST__)
+	{
+		kernel = lanes_best_kernel();
+	}
+	return lanes_kernel_names[kernel];
+}
+
+/** Choose the kernel the walkers of a context walk in lanes with.
+ *
+ *	@param[in]	kernel	__LANES_KERNEL_BEST__ (the default), or a kernel
+ *	lanes_kernel_available says runs on this processor.
+ */
+void lanes_set_kernel(pcs_ctx_t *ctx, int kernel)
+{
+	if(kernel != __LANES_KERNEL_BEST__ && !lanes_kernel_available(kernel))
+	{
+		fprintf(stderr, "Error: the %s kernel of the lanes does not run on this processor.\n", lanes_kernel_names[kernel]);
+		exit(1);
+	}
+	ctx->lanes_kernel = kernel;
+}
+
+/** Check whether the walkers of a context can walk in lanes.
+ *
+ *	@brief The lanes walk on the points of a curve, without checkpoints nor an adaptive
+ *	number of trailling zero bits, for p odd below
+ *	2^__LANES_MAX_BITS__ and distinguished points of at most 52 trailling
+ *	zero bits, with adding sets that are not at infinity.
+ */
+int lanes_supported(pcs_ctx_t *ctx)
+{
+#ifdef __SIZEOF_INT128__
+	int r;
+	if(ctx->group != &pcs_group_ec || ctx->orbit > 1 || ctx->checkpoint_path != NULL || ctx->adaptive_points > 0 || ctx->trailling_bits > __LANES_RADIX__ || ctx->E.field != __CURVE_FIELD_PRIME__ || mpz_sizeinbase(ctx->E.p, 2) > __LANES_MAX_BITS__)
+	{
+		return 0;
+	}
+	for(r = 0; r < __NB_ENSEMBLES__; r++)
+	{
+		if(mpz_cmp_ui(ctx->M[r].z, 1) != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+#else
+	(void)ctx;
+	return 0;
+#endif
+}
+
+/** Walk __LANES_GROUPS__ * __LANES_WIDTH__ trails until the run is over.
+ *
+ *	@brief The distinguished points are handled as in walk, with the walker
+ *	w holding the point and the starting coefficient of the lane that
+ *	reached it. The trails in progress are dropped at the end of the run.
+ */
+void lanes_walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions)
+{
+#ifdef __SIZEOF_INT128__
+	int trail_length_max = pow(2, ctx->trailling_bits) * 20;
+	int kernel = (ctx->lanes_kernel == __LANES_KERNEL_BEST__) ? lanes_best_kernel() : ctx->lanes_kernel;
+	void (*prepare)(const lanes_field_t *, lanes_t *, int) = lanes_prepare_field;
+	void (*inverses)(const lanes_field_t *, lanes_t *, lanes_fe_t *) = lanes_inverses_field;
+	void (*steps)(const lanes_field_t *, lanes_t *) = lanes_steps_field;
+	lanes_field_t F;
+	lanes_fe_t inv;
+	lanes_t *L;
+	mpz_t t;
+	int g, k;
+
+#ifdef __LANES_IFMA__
+	if(kernel == __LANES_KERNEL_IFMA__)
+	{
+		prepare = lanes_prepare_ifma;
+		inverses = lanes_inverses_ifma;
+		steps = lanes_steps_ifma;
+	}
+#endif
+	L = malloc(sizeof(lanes_t));
+	if(L == NULL)
+	{
+		fprintf(stderr, "Error: cannot allocate the lanes.\n");
+		exit(1);
+	}
+	mpz_init(t);
+	lanes_field_init(&F, ctx, kernel);
+	w->nb_steps = 0;
+	w->resume = 0;
+	for(g = 0; g < __LANES_GROUPS__; g++)
+	{
+		for(k = 0; k < __LANES_WIDTH__; k++)
+		{
+			mpz_init(L->a[g][k]);
+			lanes_start(ctx, w, &F, L, g, k, x_res, collision_count);
+		}
+	}
+
+	while(!run_done(ctx, collision_count, nb_collisions))
+	{
+		for(g = 0; g < __LANES_GROUPS__; g++)
+		{
+			prepare(&F, L, g);
+		}
+		lanes_invert(&F, L, &inv, t, ctx->E.p);
+		inverses(&F, L, &inv);
+		steps(&F, L);
+		for(g = 0; g < __LANES_GROUPS__; g++)
+		{
+			for(k = 0; k < __LANES_WIDTH__; k++)
+			{
+				if(L->eq[g] & (1 << k))
+				{
+					lanes_start(ctx, w, &F, L, g, k, x_res, collision_count);
+					continue;
+				}
+				w->nb_steps++;
+				L->trail_length[g][k]++;
+				if(L->dp[g] & (1 << k))
+				{
+					lanes_distinguished(ctx, w, &F, L, g, k, x_res, collision_count);
+					lanes_start(ctx, w, &F, L, g, k, x_res, collision_count);
+				}
+				else if(L->trail_length[g][k] > trail_length_max)
+				{
+					lanes_start(ctx, w, &F, L, g, k, x_res, collision_count);
+				}
+			}
+		}
+	}
+
+	for(g = 0; g < __LANES_GROUPS__; g++)
+	{
+		for(k = 0; k < __LANES_WIDTH__; k++)
+		{
+			mpz_clear(L->a[g][k]);
+		}
+	}
+	mpz_clear(t);
+	free(L);
+#else
+	walk(ctx, w, x_res, collision_count, nb_collisions);
+#endif
+}
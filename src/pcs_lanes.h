@@ -0,0 +1,86 @@
+/** @file pcs_lanes.h
+ *
+ */
+#ifndef PCS_LANES_H
+#define PCS_LANES_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs.h"
+#include "pcs_field.h"
+
+#define __LANES_WIDTH__ 8
+#define __LANES_LIMBS__ 3
+#define __LANES_RADIX__ 52
+#define __LANES_GROUPS__ 64 /* even, see lanes_steps_ifma */
+#define __LANES_MAX_BITS__ 150
+#define __LANES_KERNEL_BEST__ -1
+#define __LANES_KERNEL_IFMA__ 0
+#define __LANES_KERNEL_MULX__ 1
+#define __LANES_KERNEL_GENERIC__ 2
+#define __LANES_NB_KERNELS__ 3
+
+/** Field elements of the walks of one group, limb by limb, one walk per lane.
+ */
+typedef struct
+{
+	uint64_t v[__LANES_LIMBS__][__LANES_WIDTH__];
+}lanes_fe_t;
+
+/** Constants of the field and of the adding walk, for one kernel.
+ *
+ *	@brief With __LANES_KERNEL_IFMA__, the coordinates of the walks are
+ *	kept in radix 2^52, in Montgomery form aR mod p with R = 2^156, and
+ *	below 2p; p to pinv are the constants of this representation. With
+ *	the other kernels, they are kept in radix 2^64, in the Montgomery form
+ *	of field, and below p. Mx and My are the adding sets in Montgomery
+ *	form, Mcx the x-coordinates of the adding sets and one is R mod p, in
+ *	the representation of the kernel.
+ */
+typedef struct
+{
+	uint64_t p[__LANES_LIMBS__];
+	uint64_t p2[__LANES_LIMBS__];
+	uint64_t p4[__LANES_LIMBS__];
+	uint64_t r2[__LANES_LIMBS__];
+	uint64_t one[__LANES_LIMBS__];
+	uint64_t pinv;
+	uint64_t dmask;
+	uint64_t Mx[__LANES_LIMBS__][__NB_ENSEMBLES__];
+	uint64_t My[__LANES_LIMBS__][__NB_ENSEMBLES__];
+	uint64_t Mcx[__LANES_LIMBS__][__NB_ENSEMBLES__];
+	int kernel;
+	field_t field;
+}lanes_field_t;
+
+/** The walks of one thread.
+ *
+ *	@brief x and y are in Montgomery form, cx and cy are the coordinates
+ *	themselves. dx holds xM - xR for each walk, then its inverse, and c
+ *	the running products of dx over the groups, so that one inversion
+ *	serves all the walks.
+ *	r holds the adding set of each walk, eq and dp flag the walks that
+ *	met xR = xM and those that reached a distinguished point.
+ */
+typedef struct
+{
+	lanes_fe_t x[__LANES_GROUPS__];
+	lanes_fe_t y[__LANES_GROUPS__];
+	lanes_fe_t cx[__LANES_GROUPS__];
+	lanes_fe_t cy[__LANES_GROUPS__];
+	lanes_fe_t dx[__LANES_GROUPS__];
+	lanes_fe_t c[__LANES_GROUPS__];
+	uint64_t r[__LANES_GROUPS__][__LANES_WIDTH__];
+	uint8_t eq[__LANES_GROUPS__];
+	uint8_t dp[__LANES_GROUPS__];
+	int trail_length[__LANES_GROUPS__][__LANES_WIDTH__];
+	mpz_t a[__LANES_GROUPS__][__LANES_WIDTH__];
+}lanes_t;
+
+int lanes_kernel_available(int kernel);
+int lanes_best_kernel(void);
+const char *lanes_kernel_name(int kernel);
+void lanes_set_kernel(pcs_ctx_t *ctx, int kernel);
+int lanes_supported(pcs_ctx_t *ctx);
+void lanes_walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions);
+#endif
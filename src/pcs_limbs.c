@@ -0,0 +1,310 @@
+/** @file pcs_limbs.c
+ *  @brief Walking on a fixed number of limbs, with the mpn functions of GMP.
+ *
+ *	f_lean works on mpz_t values, whose size changes from one operation
+ *	to the next: each operation normalizes its result, and may reallocate
+ *	it. Here the coordinates of the point walked are kept in arrays of
+ *	nb_limbs limbs, the size of p, on the stack of the walker, so that a
+ *	step allocates nothing and always calls the mpn functions on the same
+ *	sizes. The products are reduced in Montgomery form with mpn_addmul_1,
+ *	and the inverse of xM - xR is taken with mpn_gcdext. This is the walk
+ *	of the curves too large for the lanes (see pcs_lanes.h), of up to
+ *	__LIMBS_MAX_BITS__ bits.
+ *
+ *	The adding set and the distinguished property are read from the
+ *	coordinates themselves, which are computed at each step from the
+ *	Montgomery form, so the walk is the same as with f and f_lean and the
+ *	trails are walked again with f in is_collision. As in f_lean, the
+ *	rare steps with xR = xM are left to f.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_limbs.h"
+
+static void limbs_from_mpz(mp_limb_t *r, mpz_t z, mp_size_t n)
+{
+	mp_size_t i;
+	for(i = 0; i < n; i++)
+	{
+		r[i] = mpz_getlimbn(z, i);
+	}
+}
+
+static void limbs_to_mpz(mpz_t z, const mp_limb_t *a, mp_size_t n)
+{
+	mpn_copyi(mpz_limbs_write(z, n), a, n);
+	mpz_limbs_finish(z, n);
+}
+
+/** r = t/R mod p, for t of 2 nb_limbs limbs below pR, which is destroyed.
+ *
+ */
+static void limbs_redc(mp_limb_t *r, mp_limb_t *t, const limbs_field_t *F)
+{
+	const mp_size_t n = F->nb_limbs;
+	mp_size_t i;
+	mp_limb_t cy;
+	for(i = 0; i < n; i++)
+	{
+		//the limb i of t is cleared, and the carry out of its row is kept in its place
+		t[i] = mpn_addmul_1(t + i, F->p, n, t[i] * F->pinv);
+	}
+	cy = mpn_add_n(r, t + n, t, n);
+	if(cy || mpn_cmp(r, F->p, n) >= 0)
+	{
+		mpn_sub_n(r, r, F->p, n);
+	}
+}
+
+static void limbs_mul(mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b, const limbs_field_t *F)
+{
+	mp_limb_t t[2 * __LIMBS_MAX__];
+	mpn_mul_n(t, a, b, F->nb_limbs);
+	limbs_redc(r, t, F);
+}
+
+static void limbs_sqr(mp_limb_t *r, const mp_limb_t *a, const limbs_field_t *F)
+{
+	mp_limb_t t[2 * __LIMBS_MAX__];
+	mpn_sqr(t, a, F->nb_limbs);
+	limbs_redc(r, t, F);
+}
+
+static void limbs_sub(mp_limb_t *r, const mp_limb_t *a, const mp_limb_t *b, const limbs_field_t *F)
+{
+	mpn_cnd_add_n(mpn_sub_n(r, a, b, F->nb_limbs), r, r, F->p, F->nb_limbs);
+}
+
+/** Get a coordinate itself from its Montgomery form.
+ *
+ */
+static void limbs_canonical(mp_limb_t *r, const mp_limb_t *a, const limbs_field_t *F)
+{
+	mp_limb_t t[2 * __LIMBS_MAX__];
+	mpn_copyi(t, a, F->nb_limbs);
+	mpn_zero(t + F->nb_limbs, F->nb_limbs);
+	limbs_redc(r, t, F);
+}
+
+/** Get the Montgomery form of the inverse of the number a stands for, 1/a R^2 mod p.
+ *
+ *	@brief mpn_gcdext needs its first operand to be at least the second
+ *	one, and destroys both, which must have room for one more limb than
+ *	the first: it is given copies of a + p and p.
+ *
+ *	@return 	0 if a is not invertible, 1 otherwise.
+ */
+static int limbs_invert(mp_limb_t *r, const mp_limb_t *a, const limbs_field_t *F)
+{
+	const mp_size_t n = F->nb_limbs;
+	mp_limb_t u[__LIMBS_MAX__ + 2], v[__LIMBS_MAX__ + 2], g[__LIMBS_MAX__], s[__LIMBS_MAX__ + 2], i[__LIMBS_MAX__];
+	mp_size_t un, sn;
+	u[n] = mpn_add_n(u, a, F->p, n);
+	un = n + (u[n] != 0);
+	mpn_copyi(v, F->p, n);
+	if(mpn_gcdext(g, s, &sn, u, un, v, n) != 1 || g[0] != 1)
+	{
+		return 0;
+	}
+	//|s| < p/2, and s is the inverse of a modulo p
+	mpn_zero(i, n);
+	if(sn < 0)
+	{
+		mpn_copyi(i, s, -sn);
+		mpn_sub_n(i, F->p, i, n);
+	}
+	else
+	{
+		mpn_copyi(i, s, sn);
+	}
+	limbs_mul(r, i, F->r3, F);
+	return 1;
+}
+
+static void limbs_field_init(limbs_field_t *F, pcs_ctx_t *ctx)
+{
+	const mp_size_t n = mpz_size(ctx->E.p);
+	mp_limb_t c[__LIMBS_MAX__], inv;
+	mpz_t t;
+	int i;
+	F->nb_limbs = n;
+	limbs_from_mpz(F->p, ctx->E.p, n);
+	//1/p modulo 2^GMP_NUMB_BITS by Newton's iteration, from 3 correct bits
+	inv = F->p[0];
+	for(i = 0; i < 6; i++)
+	{
+		inv *= 2 - F->p[0] * inv;
+	}
+	F->pinv = -inv;
+	mpz_init(t);
+	mpz_setbit(t, 2 * n * GMP_NUMB_BITS);
+	mpz_mod(t, t, ctx->E.p);
+	limbs_from_mpz(F->r2, t, n);
+	mpz_set_ui(t, 0);
+	mpz_setbit(t, 3 * n * GMP_NUMB_BITS);
+	mpz_mod(t, t, ctx->E.p);
+	limbs_from_mpz(F->r3, t, n);
+	mpz_clear(t);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		limbs_from_mpz(c, ctx->M[i].x, n);
+		limbs_mul(F->Mx[i], c, F->r2, F);
+		limbs_from_mpz(c, ctx->M[i].y, n);
+		limbs_mul(F->My[i], c, F->r2, F);
+	}
+}
+
+/** Load a point of the walker, which is not at infinity.
+ *
+ */
+static void limbs_load(const limbs_field_t *F, limbs_point_t *R, point_t *P)
+{
+	limbs_from_mpz(R->cx, P->x, F->nb_limbs);
+	limbs_from_mpz(R->cy, P->y, F->nb_limbs);
+	limbs_mul(R->x, R->cx, F->r2, F);
+	limbs_mul(R->y, R->cy, F->r2, F);
+}
+
+static void limbs_store(const limbs_field_t *F, const limbs_point_t *R, point_t *P)
+{
+	limbs_to_mpz(P->x, R->cx, F->nb_limbs);
+	limbs_to_mpz(P->y, R->cy, F->nb_limbs);
+	mpz_set_ui(P->z, 1);
+}
+
+/** Check whether a point is distinguished, as is_distinguished_lean does.
+ *
+ */
+static int limbs_distinguished(const limbs_field_t *F, const limbs_point_t *R, int trailling_bits)
+{
+	return mpn_zero_p(R->cx, F->nb_limbs) || mpn_scan1(R->cx, 0) >= (mp_bitcnt_t)trailling_bits;
+}
+
+/** Step from R to R + M[r], as f_lean does.
+ *
+ *	@return 	0 if the step was made, 1 if xR = xM, which is left to f.
+ */
+static int limbs_step(const limbs_field_t *F, limbs_point_t *R, int r)
+{
+	mp_limb_t t[__LIMBS_MAX__], l[__LIMBS_MAX__], x3[__LIMBS_MAX__];
+	limbs_sub(t, F->Mx[r], R->x, F);
+	if(mpn_zero_p(t, F->nb_limbs) || !limbs_invert(t, t, F))
+	{
+		return 1;
+	}
+	limbs_sub(l, F->My[r], R->y, F);
+	limbs_mul(l, l, t, F);
+	//x3 = l^2 - xR - xM
+	limbs_sqr(x3, l, F);
+	limbs_sub(x3, x3, R->x, F);
+	limbs_sub(x3, x3, F->Mx[r], F);
+	//y3 = l(xR - x3) - yR
+	limbs_sub(t, R->x, x3, F);
+	limbs_mul(t, t, l, F);
+	limbs_sub(R->y, t, R->y, F);
+	mpn_copyi(R->x, x3, F->nb_limbs);
+	limbs_canonical(R->cx, R->x, F);
+	limbs_canonical(R->cy, R->y, F);
+	return 0;
+}
+
+/** Start a new trail, drawn again while its starting point is at infinity.
+ *
+ */
+static void limbs_start(pcs_ctx_t *ctx, pcs_walker_t *w, const limbs_field_t *F, limbs_point_t *R)
+{
+	do
+	{
+		start_trail(ctx, w);
+	}while(mpz_cmp_ui(w->R.z, 1) != 0);
+	limbs_load(F, R, &w->R);
+}
+
+/** Check whether the walkers of a context can walk on limbs.
+ *
+ *	@brief They walk on the points of a curve, for p odd below 2^__LIMBS_MAX_BITS__, with
+ *	adding sets that are not at infinity, and a fixed number of trailling zero bits.
+ */
+int limbs_supported(pcs_ctx_t *ctx)
+{
+	int r;
+	if(GMP_NAIL_BITS != 0 || ctx->group != &pcs_group_ec || ctx->orbit > 1 || ctx->adaptive_points > 0 || ctx->E.field != __CURVE_FIELD_PRIME__ || mpz_sizeinbase(ctx->E.p, 2) > __LIMBS_MAX_BITS__)
+	{
+		return 0;
+	}
+	for(r = 0; r < __NB_ENSEMBLES__; r++)
+	{
+		if(mpz_cmp_ui(ctx->M[r].z, 1) != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** Walk until the run is over, as walk does, with the point of the walker on limbs.
+ *
+ *	@brief w->R is only kept up to date when it is needed: for the
+ *	distinguished points, the checkpoints and at the end of the run.
+ */
+void limbs_walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions)
+{
+	int trail_length_max = pow(2, ctx->trailling_bits) * 20;
+	limbs_field_t F;
+	limbs_point_t R;
+	int r;
+
+	limbs_field_init(&F, ctx);
+	w->checkpoint_seen = ctx->checkpoint_request;
+	w->nb_steps = 0;
+	if(w->resume && mpz_cmp_ui(w->R.z, 1) == 0)
+	{
+		w->resume = 0;
+		limbs_load(&F, &R, &w->R);
+	}
+	else
+	{
+		w->resume = 0;
+		limbs_start(ctx, w, &F, &R);
+	}
+
+	while(!run_done(ctx, collision_count, nb_collisions))
+	{
+		if(w->checkpoint_seen != ctx->checkpoint_request)
+		{
+			limbs_store(&F, &R, &w->R);
+			walker_save(ctx, w);
+		}
+		if(limbs_distinguished(&F, &R, ctx->trailling_bits))
+		{
+			limbs_store(&F, &R, &w->R);
+			mpz_tdiv_q_2exp(w->xDist, w->R.x, ctx->trailling_bits);
+			walk_distinguished(ctx, w, x_res, collision_count);
+			limbs_start(ctx, w, &F, &R);
+			continue;
+		}
+		r = mpn_mod_1(R.cy, F.nb_limbs, __NB_ENSEMBLES__);
+		if(limbs_step(&F, &R, r))
+		{
+			limbs_store(&F, &R, &w->R);
+			f(w->R, ctx->M[r], &w->R, ctx->E);
+			if(mpz_cmp_ui(w->R.z, 1) != 0)
+			{
+				limbs_start(ctx, w, &F, &R);
+				continue;
+			}
+			limbs_load(&F, &R, &w->R);
+		}
+		w->nb_steps++;
+		w->trail_length++;
+		if(w->trail_length > trail_length_max)
+		{
+			limbs_start(ctx, w, &F, &R);
+		}
+	}
+	limbs_store(&F, &R, &w->R);
+}
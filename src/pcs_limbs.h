@@ -0,0 +1,48 @@
+/** @file pcs_limbs.h
+ *
+ */
+#ifndef PCS_LIMBS_H
+#define PCS_LIMBS_H
+
+#include <gmp.h>
+#include "pcs.h"
+
+#define __LIMBS_MAX_BITS__ 256
+#define __LIMBS_MAX__ (__LIMBS_MAX_BITS__ / GMP_NUMB_BITS)
+#define __LIMBS_DEFAULT_BITS__ 128 /* pcs_exec walks on limbs by default above this size */
+
+/** A prime field in Montgomery form on nb_limbs limbs, and the adding sets of a walk.
+ *
+ *	@brief The elements are nb_limbs limbs, least significant first, and
+ *	below p, aR mod p standing for a with R = 2^(GMP_NUMB_BITS nb_limbs).
+ *	pinv is -1/p modulo 2^GMP_NUMB_BITS, r2 and r3 are R^2 and R^3 modulo
+ *	p, Mx and My the coordinates of the adding sets in Montgomery form.
+ */
+typedef struct
+{
+	mp_size_t nb_limbs;
+	mp_limb_t p[__LIMBS_MAX__];
+	mp_limb_t pinv;
+	mp_limb_t r2[__LIMBS_MAX__];
+	mp_limb_t r3[__LIMBS_MAX__];
+	mp_limb_t Mx[__NB_ENSEMBLES__][__LIMBS_MAX__];
+	mp_limb_t My[__NB_ENSEMBLES__][__LIMBS_MAX__];
+}limbs_field_t;
+
+/** The point of a walk.
+ *
+ *	@brief x and y are in Montgomery form, cx and cy are the coordinates
+ *	themselves, from which the adding set and the distinguished points
+ *	are found.
+ */
+typedef struct
+{
+	mp_limb_t x[__LIMBS_MAX__];
+	mp_limb_t y[__LIMBS_MAX__];
+	mp_limb_t cx[__LIMBS_MAX__];
+	mp_limb_t cy[__LIMBS_MAX__];
+}limbs_point_t;
+
+int limbs_supported(pcs_ctx_t *ctx);
+void limbs_walk(pcs_ctx_t *ctx, pcs_walker_t *w, mpz_t x_res, int *collision_count, int nb_collisions);
+#endif
@@ -0,0 +1,229 @@
+/** @file pcs_multi.c
+ *  @brief Solving several targets Q_1,...,Q_k on the same curve and point P with one storage structure.
+ *
+ *	The adding walk only uses multiples of P (M[i] = A[i]P), so a walk
+ *	does not depend on the target and the distinguished points found for
+ *	a target stay valid for the next ones. A trail of target t starts at
+ *	aQ_t, where the low target_bits bits of a hold t: the storage
+ *	structure keeps its usual (x, a) pairs and a stored trail can still be
+ *	walked again once the target has changed.
+ *
+ *	The storage structure is kept from one target to the next. Once a
+ *	target is solved, its trails are points of known logarithm, so a trail
+ *	of a new target that reaches one of them solves it: each target is
+ *	solved faster than the previous one (Kuhn and Struik, "Random walks
+ *	revisited: extensions of Pollard's rho algorithm for computing
+ *	multiple discrete logarithms", SAC 2001).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_multi.h"
+#include "pcs_orbit.h"
+
+/** Switch a context to the multi-target mode.
+ *
+ *	@brief The adding walk is made independent of Q and the storage
+ *	structure is emptied.
+ *
+ *	@param[in]	nb_targets	The number of targets that will be solved.
+ */
+void pcs_set_targets(pcs_ctx_t *ctx, int nb_targets)
+{
+	int i;
+	uint8_t target_bits = 0;
+	while((1 << target_bits) < nb_targets)
+	{
+		target_bits++;
+	}
+	if(nb_targets < 1 || ctx->nb_bits < target_bits + __MULTI_MIN_RANDOM_BITS__)
+	{
+		fprintf(stderr, "Can not solve %d targets with %d-bit starting coefficients.\n", nb_targets, ctx->nb_bits);
+		exit(1);
+	}
+	pcs_free_targets(ctx);
+	ctx->nb_targets = nb_targets;
+	ctx->target = 0;
+	ctx->target_bits = target_bits;
+	ctx->targets = malloc(sizeof(point_t) * nb_targets);
+	ctx->target_logs = malloc(sizeof(mpz_t) * nb_targets);
+	ctx->target_solved = calloc(nb_targets, 1);
+	for(i = 0; i < nb_targets; i++)
+	{
+		point_init(&ctx->targets[i]);
+		mpz_init(ctx->target_logs[i]);
+	}
+	walk_on_P(ctx);
+	struct_reset(&ctx->storage);
+}
+
+/** Make the adding walk only use multiples of P: M[i] = A[i]P.
+ *
+ *	@brief The walk works on points, since the walks that use it are
+ *	walked again without the automorphisms of the curve.
+ */
+void walk_on_P(pcs_ctx_t *ctx)
+{
+	int i;
+	orbit_disable(ctx);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_set_ui(ctx->B[i], 0);
+		fixed_base_mul(ctx, &ctx->M[i], ctx->A[i]);
+	}
+}
+
+/** Solve one target, keeping the points found for the previous ones.
+ *
+ *	@param[in]	target	The index of the target, in [0, nb_targets).
+ *	@param[in]	Q		The target.
+ *	@param[out]	x_res	The logarithm of Q.
+ *	@return 	The number of collisions found: 1, or 0 if the run was stopped.
+ */
+long long int pcs_run_target(pcs_ctx_t *ctx, int target, point_t Q, mpz_t x_res)
+{
+	long long int ret;
+	int i;
+	mpz_set(ctx->targets[target].x, Q.x);
+	mpz_set(ctx->targets[target].y, Q.y);
+	mpz_set(ctx->targets[target].z, Q.z);
+	mpz_set(ctx->Q.x, Q.x);
+	mpz_set(ctx->Q.y, Q.y);
+	mpz_set(ctx->Q.z, Q.z);
+	fixed_base_table(ctx, ctx->Q, &ctx->Q_table);
+	ctx->target = target;
+	ctx->target_solved[target] = 0;
+	for(i = 0; i < ctx->nb_threads; i++)
+	{
+		ctx->walkers[i].resume = 0;
+	}
+	ret = pcs_run(ctx, x_res, 1);
+	if(ret > 0)
+	{
+		mpz_set(ctx->target_logs[target], x_res);
+		ctx->target_solved[target] = 1;
+	}
+	return ret;
+}
+
+/** Free the targets of a context.
+ *
+ */
+void pcs_free_targets(pcs_ctx_t *ctx)
+{
+	int i;
+	if(ctx->Q_table != NULL)
+	{
+		for(i = 0; i < ctx->P_table_windows * ((1 << __FIXED_BASE_WINDOW__) - 1); i++)
+		{
+			point_clear(&ctx->Q_table[i]);
+		}
+		free(ctx->Q_table);
+		ctx->Q_table = NULL;
+	}
+	for(i = 0; i < ctx->nb_targets; i++)
+	{
+		point_clear(&ctx->targets[i]);
+		mpz_clear(ctx->target_logs[i]);
+	}
+	if(ctx->nb_targets > 0)
+	{
+		free(ctx->targets);
+		free(ctx->target_logs);
+		free(ctx->target_solved);
+	}
+	ctx->nb_targets = 0;
+}
+
+/** Draw the starting point aQ_t of a trail of the current target t.
+ *
+ */
+void start_trail_target(pcs_ctx_t *ctx, pcs_walker_t *w)
+{
+	do
+	{
+		mpz_urandomb(w->a, w->r_state, ctx->nb_bits - ctx->target_bits);
+		mpz_mul_2exp(w->a, w->a, ctx->target_bits);
+		mpz_add_ui(w->a, w->a, ctx->target);
+	}while(mpz_sgn(w->a) == 0);
+	fixed_base_table_mul(ctx, ctx->Q_table, ctx->Q, &w->R, w->a);
+}
+
+/** Walk a trail again from its start aQ_t, and write its end point as (cx + k)P.
+ *
+ *	@brief x is the logarithm of the current target. For a trail of
+ *	another target, which is solved, c is 0.
+ *
+ *	@return 	0 if the trail belongs to a target that is not solved.
+ */
+int target_trail_end(pcs_ctx_t *ctx, mpz_t a, int trailling_bits, point_t *R, mpz_t c, mpz_t k, mpz_t *xDist)
+{
+	int t = mpz_fdiv_ui(a, 1UL << ctx->target_bits);
+	uint8_t r;
+	if(t >= ctx->nb_targets || (t != ctx->target && !ctx->target_solved[t]))
+	{
+		return 0;
+	}
+	double_and_add(R, ctx->targets[t], a, ctx->E);
+	mpz_set_ui(k, 0);
+	while(!is_distinguished(*R, trailling_bits, xDist))
+	{
+		r = hash(R->y);
+		compute_a(k, ctx->A[r], ctx->n);
+		f(*R, ctx->M[r], R, ctx->E);
+	}
+	if(t == ctx->target)
+	{
+		mpz_mod(c, a, ctx->n);
+	}
+	else
+	{
+		mpz_set_ui(c, 0);
+		mpz_addmul(k, a, ctx->target_logs[t]);
+		mpz_mod(k, k, ctx->n);
+	}
+	return 1;
+}
+
+/** Checks if there is a collision, in the multi-target mode.
+ *
+ *	@brief The two trails end in c1x + k1 = +-(c2x + k2), which gives x
+ *	unless c1 = +-c2.
+ *
+ *	@param[in]	a1	The start of the trail of the current target.
+ *	@param[in]	a2	The start of the stored trail.
+ *	@return 	1 if x was found, 0 otherwise.
+ */
+int is_collision_target(pcs_ctx_t *ctx, mpz_t x, mpz_t a1, mpz_t a2, int trailling_bits)
+{
+	point_t R1, R2;
+	mpz_t c1, k1, c2, k2, xDist;
+	int retval = 0;
+	point_init(&R1);
+	point_init(&R2);
+	mpz_inits(c1, k1, c2, k2, xDist, NULL);
+
+	if(target_trail_end(ctx, a1, trailling_bits, &R1, c1, k1, &xDist) && target_trail_end(ctx, a2, trailling_bits, &R2, c2, k2, &xDist))
+	{
+		if(mpz_cmp(R1.y, R2.y) != 0) //it's the inverse point
+		{
+			mpz_neg(c2, c2);
+			mpz_neg(k2, k2);
+		}
+		mpz_sub(c1, c1, c2);
+		mpz_sub(k2, k2, k1);
+		mpz_mod(c1, c1, ctx->n);
+		if(mpz_sgn(c1) != 0 && mpz_invert(c1, c1, ctx->n))
+		{
+			mpz_mul(x, k2, c1);
+			mpz_mod(x, x, ctx->n);
+			retval = 1;
+		}
+	}
+	point_clear(&R1);
+	point_clear(&R2);
+	mpz_clears(c1, k1, c2, k2, xDist, NULL);
+	return retval;
+}
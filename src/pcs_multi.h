@@ -0,0 +1,18 @@
+/** @file pcs_multi.h
+ *
+ */
+#ifndef PCS_MULTI_H
+#define PCS_MULTI_H
+
+#include "pcs.h"
+
+#define __MULTI_MIN_RANDOM_BITS__ 16
+
+void pcs_set_targets(pcs_ctx_t *ctx, int nb_targets);
+long long int pcs_run_target(pcs_ctx_t *ctx, int target, point_t Q, mpz_t x_res);
+void pcs_free_targets(pcs_ctx_t *ctx);
+void walk_on_P(pcs_ctx_t *ctx);
+void start_trail_target(pcs_ctx_t *ctx, pcs_walker_t *w);
+int target_trail_end(pcs_ctx_t *ctx, mpz_t a, int trailling_bits, point_t *R, mpz_t c, mpz_t k, mpz_t *xDist);
+int is_collision_target(pcs_ctx_t *ctx, mpz_t x, mpz_t a1, mpz_t a2, int trailling_bits);
+#endif
@@ -0,0 +1,402 @@
+/** @file pcs_orbit.c
+ *  @brief Walking on the orbits of the automorphisms of curves with j-invariant 0 or 1728.
+ *
+ *	A curve y^2 = x^3 + B (j = 0) with p = 1 mod 3 has the automorphism
+ *	psi(x, y) = (wx, -y) of order 6, where w is a cube root of unity
+ *	modulo p, and a curve y^2 = x^3 + Ax (j = 1728) with p = 1 mod 4 has
+ *	psi(x, y) = (-x, iy) of order 4, where i^2 = -1 modulo p. On the group
+ *	of prime order n, psi is the multiplication by an eigenvalue zeta, a
+ *	root of unity of the same order modulo n, and psi^(m/2) = -1 for an
+ *	orbit of m points.
+ *
+ *	The walk of a context works on orbits once orbit_enable is called,
+ *	on points otherwise: after each step, the point is replaced
+ *	by the point of its orbit with the smallest x coordinate, and then the
+ *	smallest y coordinate, so that two walks reaching the same orbit go on
+ *	together and the collisions come sqrt(m) times sooner. The
+ *	coefficients of a point are multiplied by zeta^k when the point is
+ *	replaced by psi^k of itself. The walker itself does not track them:
+ *	they are recomputed when a trail is walked again in is_collision.
+ *
+ *	Such a walk falls into fruitless cycles, most of all 2-cycles
+ *	R -> -(R + M) -> R. The step to the next point skips the adding set
+ *	of the current point when it would be used again from the next one,
+ *	which leaves very few 2-cycles (Bernstein, Lange and Schwabe, "On the
+ *	correct use of the negation map", PKC 2011). The longer cycles are
+ *	detected by keeping the point of every __ORBIT_CYCLE_CHECK__-th step
+ *	of a trail: the walk leaves a cycle that brings it back to that point
+ *	from the double of the smallest point of the cycle, so that every walk
+ *	caught in the cycle leaves it from the same point.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_orbit.h"
+
+/** Get the number of points of the orbits of the automorphisms of a curve.
+ *
+ *	@brief 6 for j = 0 and 4 for j = 1728 when the automorphisms are
+ *	defined over the field and act on the group of order n, 1 otherwise,
+ *	and for the binary curves.
+ */
+int orbit_size(elliptic_curve_t E, mpz_t n)
+{
+	if(E.field == __CURVE_FIELD_BINARY__)
+	{
+		return 1;
+	}
+	if(mpz_sgn(E.A) == 0 && mpz_sgn(E.B) != 0 && mpz_fdiv_ui(E.p, 3) == 1 && mpz_fdiv_ui(n, 3) == 1)
+	{
+		return 6;
+	}
+	if(mpz_sgn(E.B) == 0 && mpz_sgn(E.A) != 0 && mpz_fdiv_ui(E.p, 4) == 1 && mpz_fdiv_ui(n, 4) == 1)
+	{
+		return 4;
+	}
+	return 1;
+}
+
+/** Find a root of unity of order k, 3 or 4, modulo a prime q = 1 mod k.
+ *
+ */
+static void root_of_unity(mpz_t r, mpz_t q, unsigned long int k)
+{
+	mpz_t e, g, t;
+	mpz_inits(e, g, t, NULL);
+	mpz_sub_ui(e, q, 1);
+	mpz_divexact_ui(e, e, k);
+	for(mpz_set_ui(g, 2); ; mpz_add_ui(g, g, 1))
+	{
+		mpz_powm(r, g, e, q);
+		mpz_powm_ui(t, r, 2, q);
+		if(mpz_cmp_ui(r, 1) != 0 && (k != 4 || mpz_cmp_ui(t, 1) != 0))
+		{
+			break;
+		}
+	}
+	mpz_clears(e, g, t, NULL);
+}
+
+/** Compute the automorphisms of the curve of a context, if it has some.
+ *
+ *	@brief psi multiplies x by orbit_x[1] and y by orbit_y[1], and its
+ *	eigenvalue orbit_log[1] is the root of unity modulo n for which
+ *	psi(P) = zeta*P. ctx->orbit_order is the size of the orbits, and
+ *	ctx->orbit stays 1, the walk working on points until orbit_enable.
+ */
+void orbit_init(pcs_ctx_t *ctx)
+{
+	point_t S, T;
+	mpz_t u, v, zeta;
+	int k, m;
+
+	for(k = 0; k < __ORBIT_MAX__; k++)
+	{
+		mpz_inits(ctx->orbit_x[k], ctx->orbit_y[k], ctx->orbit_log[k], NULL);
+	}
+	m = orbit_size(ctx->E, ctx->n);
+	ctx->orbit = 1;
+	ctx->orbit_order = 1;
+	if(m == 1)
+	{
+		return;
+	}
+	point_init(&S);
+	point_init(&T);
+	mpz_inits(u, v, zeta, NULL);
+	if(m == 6)
+	{
+		root_of_unity(u, ctx->E.p, 3);
+		mpz_sub_ui(v, ctx->E.p, 1);
+		root_of_unity(zeta, ctx->n, 3);
+		mpz_sub(zeta, ctx->n, zeta); //a primitive 6th root of unity
+	}
+	else
+	{
+		mpz_sub_ui(u, ctx->E.p, 1);
+		root_of_unity(v, ctx->E.p, 4);
+		root_of_unity(zeta, ctx->n, 4);
+	}
+	//psi(P) is zeta*P for one of the two roots of unity of order m
+	mpz_mul(S.x, ctx->P.x, u);
+	mpz_mod(S.x, S.x, ctx->E.p);
+	mpz_mul(S.y, ctx->P.y, v);
+	mpz_mod(S.y, S.y, ctx->E.p);
+	mpz_set_ui(S.z, 1);
+	double_and_add(&T, ctx->P, zeta, ctx->E);
+	if(!equal(S, T))
+	{
+		mpz_invert(zeta, zeta, ctx->n);
+		double_and_add(&T, ctx->P, zeta, ctx->E);
+	}
+	if(equal(S, T))
+	{
+		ctx->orbit_order = m;
+		mpz_set_ui(ctx->orbit_x[0], 1);
+		mpz_set_ui(ctx->orbit_y[0], 1);
+		mpz_set_ui(ctx->orbit_log[0], 1);
+		for(k = 1; k < m; k++)
+		{
+			mpz_mul(ctx->orbit_x[k], ctx->orbit_x[k - 1], u);
+			mpz_mod(ctx->orbit_x[k], ctx->orbit_x[k], ctx->E.p);
+			mpz_mul(ctx->orbit_y[k], ctx->orbit_y[k - 1], v);
+			mpz_mod(ctx->orbit_y[k], ctx->orbit_y[k], ctx->E.p);
+			mpz_mul(ctx->orbit_log[k], ctx->orbit_log[k - 1], zeta);
+			mpz_mod(ctx->orbit_log[k], ctx->orbit_log[k], ctx->n);
+		}
+	}
+	point_clear(&S);
+	point_clear(&T);
+	mpz_clears(u, v, zeta, NULL);
+}
+
+/** Make the walk of a context work on the orbits of the automorphisms of its curve.
+ *
+ *	@return 	The size of the orbits, 1 if the curve has no automorphisms
+ *				and the walk stays on points.
+ */
+int orbit_enable(pcs_ctx_t *ctx)
+{
+	ctx->orbit = ctx->orbit_order;
+	return ctx->orbit;
+}
+
+/** Make the walk of a context work on points again.
+ *
+ *	@brief Needed by the walks that are walked again outside of
+ *	is_collision, or that have to keep track of distances.
+ */
+void orbit_disable(pcs_ctx_t *ctx)
+{
+	ctx->orbit = 1;
+}
+
+/** Free the automorphism tables of a context.
+ *
+ */
+void orbit_clear(pcs_ctx_t *ctx)
+{
+	int k;
+	for(k = 0; k < __ORBIT_MAX__; k++)
+	{
+		mpz_clears(ctx->orbit_x[k], ctx->orbit_y[k], ctx->orbit_log[k], NULL);
+	}
+}
+
+/** Replace a point by the representative of its orbit.
+ *
+ *	@brief The representative is psi^k(R) with the smallest x coordinate,
+ *	for k < m/2, or its negative psi^(k + m/2)(R) if its y coordinate is
+ *	smaller.
+ *
+ *	@param[in,out]	a	The coefficient a of R, or NULL.
+ *	@param[in,out]	b	The coefficient b of R, or NULL.
+ *	@return 	The power k of psi that gives the representative.
+ */
+int orbit_canonical(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b)
+{
+	mpz_t *x, *x_min;
+	int j, k = 0;
+	if(ctx->orbit <= 1 || mpz_sgn(R->z) == 0)
+	{
+		return 0;
+	}
+	if(!preallocation_init_done)
+	{
+		preallocation_init();
+	}
+	x = &(temp_obj[18]);
+	x_min = &(temp_obj[19]);
+
+	mpz_set(*x_min, R->x);
+	for(j = 1; j < ctx->orbit / 2; j++)
+	{
+		mpz_mul(*x, ctx->orbit_x[j], R->x);
+		mpz_mod(*x, *x, ctx->E.p);
+		if(mpz_cmp(*x, *x_min) < 0)
+		{
+			mpz_swap(*x, *x_min);
+			k = j;
+		}
+	}
+	mpz_swap(R->x, *x_min);
+	if(k > 0)
+	{
+		mpz_mul(R->y, R->y, ctx->orbit_y[k]);
+		mpz_mod(R->y, R->y, ctx->E.p);
+	}
+	mpz_sub(*x, ctx->E.p, R->y);
+	if(mpz_cmp(*x, R->y) < 0)
+	{
+		mpz_swap(*x, R->y);
+		k += ctx->orbit / 2;
+	}
+	if(k > 0 && a != NULL)
+	{
+		compute_zeta(a, ctx->orbit_log[k], ctx->n);
+	}
+	if(k > 0 && b != NULL)
+	{
+		compute_zeta(b, ctx->orbit_log[k], ctx->n);
+	}
+	return k;
+}
+
+/** Take one step of the walk on orbits.
+ *
+ *	@brief The adding set r = hash(R) is skipped for the next one when the
+ *	representative of R + M[r] would use r again.
+ *
+ *	@return 	The number of additions done.
+ */
+static int orbit_step(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b)
+{
+	point_t *S;
+	int r, i, k = 0;
+	if(!preallocation_init_done)
+	{
+		preallocation_init();
+	}
+	S = &(temp_point[5]);
+
+	r = hash(R->y);
+	for(i = 1; i <= __NB_ENSEMBLES__; i++)
+	{
+		f(*R, ctx->M[r], S, ctx->E);
+		k = orbit_canonical(ctx, S, NULL, NULL);
+		if(i == __NB_ENSEMBLES__ || hash(S->y) != r)
+		{
+			break;
+		}
+		r = (r + 1) % __NB_ENSEMBLES__;
+	}
+	mpz_swap(R->x, S->x);
+	mpz_swap(R->y, S->y);
+	mpz_swap(R->z, S->z);
+	if(a != NULL)
+	{
+		compute_a(a, ctx->A[r], ctx->n);
+		compute_zeta(a, ctx->orbit_log[k], ctx->n);
+	}
+	if(b != NULL)
+	{
+		compute_b(b, ctx->B[r], ctx->n);
+		compute_zeta(b, ctx->orbit_log[k], ctx->n);
+	}
+	return i;
+}
+
+/** Leave a fruitless cycle.
+ *
+ *	@brief The cycle is walked once more from R to find its smallest
+ *	point, and the walk goes on from the representative of its double.
+ *
+ *	@return 	The number of additions done.
+ */
+static int orbit_escape(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b)
+{
+	point_t S, R_min;
+	mpz_t a_min, b_min;
+	int nb_additions = 1;
+	point_init(&S);
+	point_init(&R_min);
+	mpz_inits(a_min, b_min, NULL);
+	mpz_set(S.x, R->x);
+	mpz_set(S.y, R->y);
+	mpz_set(S.z, R->z);
+	mpz_set(R_min.x, R->x);
+	mpz_set(R_min.y, R->y);
+	mpz_set(R_min.z, R->z);
+	if(a != NULL)
+	{
+		mpz_set(a_min, a);
+	}
+	if(b != NULL)
+	{
+		mpz_set(b_min, b);
+	}
+	do
+	{
+		nb_additions += orbit_step(ctx, &S, a, b);
+		if(mpz_cmp(S.x, R_min.x) < 0)
+		{
+			mpz_set(R_min.x, S.x);
+			mpz_set(R_min.y, S.y);
+			mpz_set(R_min.z, S.z);
+			if(a != NULL)
+			{
+				mpz_set(a_min, a);
+			}
+			if(b != NULL)
+			{
+				mpz_set(b_min, b);
+			}
+		}
+	}while(!equal(S, *R));
+	add(R, R_min, R_min, ctx->E);
+	if(a != NULL)
+	{
+		mpz_mul_2exp(a, a_min, 1);
+		mpz_mmod(a, a, ctx->n);
+	}
+	if(b != NULL)
+	{
+		mpz_mul_2exp(b, b_min, 1);
+		mpz_mmod(b, b, ctx->n);
+	}
+	orbit_canonical(ctx, R, a, b);
+	point_clear(&S);
+	point_clear(&R_min);
+	mpz_clears(a_min, b_min, NULL);
+	return nb_additions;
+}
+
+/** Take one step of the walk on orbits, leaving the fruitless cycles.
+ *
+ *	@param[in,out]	R		The representative of the current orbit.
+ *	@param[in,out]	a		The coefficient a of R, or NULL.
+ *	@param[in,out]	b		The coefficient b of R, or NULL.
+ *	@param[in,out]	C		The point kept for the cycle check, with z = 0
+ *							at the start of a trail.
+ *	@param[in]		step	The index of the step in the trail, from 1.
+ *	@return 	The number of additions done.
+ */
+int orbit_walk(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b, point_t *C, int step)
+{
+	int nb_additions = orbit_step(ctx, R, a, b);
+	if(equal(*R, *C))
+	{
+		nb_additions += orbit_escape(ctx, R, a, b);
+		mpz_set_ui(C->z, 0);
+	}
+	else if(step % __ORBIT_CYCLE_CHECK__ == 0)
+	{
+		mpz_set(C->x, R->x);
+		mpz_set(C->y, R->y);
+		mpz_set(C->z, R->z);
+	}
+	return nb_additions;
+}
+
+/** Walk a trail again from its starting point, computing the coefficients of its distinguished point.
+ *
+ *	@param[in,out]	R		The starting point aP + bQ, then the distinguished point.
+ *	@param[out]		xDist	The x coordinate of the distinguished point, without the trailling zeros.
+ *	@return 		The number of steps of the trail.
+ */
+int orbit_trail(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b, int trailling_bits, mpz_t *xDist)
+{
+	point_t C;
+	int step = 0;
+	point_init(&C);
+	orbit_canonical(ctx, R, a, b);
+	while(!is_distinguished(*R, trailling_bits, xDist))
+	{
+		step++;
+		orbit_walk(ctx, R, a, b, &C, step);
+	}
+	point_clear(&C);
+	return step;
+}
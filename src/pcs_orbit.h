@@ -0,0 +1,19 @@
+/** @file pcs_orbit.h
+ *
+ */
+#ifndef PCS_ORBIT_H
+#define PCS_ORBIT_H
+
+#include "pcs.h"
+
+#define __ORBIT_CYCLE_CHECK__ 64
+
+int orbit_size(elliptic_curve_t E, mpz_t n);
+void orbit_init(pcs_ctx_t *ctx);
+int orbit_enable(pcs_ctx_t *ctx);
+void orbit_disable(pcs_ctx_t *ctx);
+void orbit_clear(pcs_ctx_t *ctx);
+int orbit_canonical(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b);
+int orbit_walk(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b, point_t *C, int step);
+int orbit_trail(pcs_ctx_t *ctx, point_t *R, mpz_t a, mpz_t b, int trailling_bits, mpz_t *xDist);
+#endif
@@ -0,0 +1,528 @@
+/** @file pcs_pohlig_hellman.c
+ *  @brief Reducing a logarithm in a group of composite order to logarithms in groups of prime order.
+ *
+ *	The order N of P is factored by trial division up to __PH_TRIAL_BOUND__
+ *	and Pollard's rho method (with Brent's cycle detection) for the
+ *	cofactor. For each prime power q^e dividing N, P and Q are projected
+ *	to the subgroup of order q^e, and the logarithm modulo q^e is found
+ *	one base-q digit at a time, each digit being a logarithm in the
+ *	subgroup of order q (Pohlig and Hellman, "An improved algorithm for
+ *	computing logarithms over GF(p) and its cryptographic significance",
+ *	IEEE Trans. Inf. Theory 1978). The digits are found by exhaustive
+ *	search below __PH_BRUTE_FORCE__, and with a PCS context of order q
+ *	above. The results are combined by the Chinese remainder theorem.
+ *
+ *	The prime powers are solved at the same time, each one with a share of
+ *	the threads in proportion to its expected cost e*sqrt(q), so the time
+ *	is governed by the largest prime factor of N instead of N.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <math.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs.h"
+#include "pcs_pohlig_hellman.h"
+
+/** Split a composite number with Pollard's rho method and Brent's cycle detection.
+ *
+ *	@param[out]	d	A factor of n.
+ *	@param[in]	c	The constant of the map y -> y^2 + c.
+ *	@return 	1 if a proper factor was found, 0 otherwise.
+ */
+static int rho_split(mpz_t d, mpz_t n, unsigned long int c)
+{
+	mpz_t x, y, ys, q, t;
+	unsigned long long int r = 1, k, i, m = 128, nb_iterations = 0;
+	int found;
+	mpz_inits(x, y, ys, q, t, NULL);
+	mpz_set_ui(y, 2);
+	mpz_set_ui(q, 1);
+	mpz_set_ui(d, 1);
+	while(mpz_cmp_ui(d, 1) == 0 && nb_iterations < __PH_RHO_ITERATIONS__)
+	{
+		mpz_set(x, y);
+		for(i = 0; i < r; i++)
+		{
+			mpz_mul(y, y, y);
+			mpz_add_ui(y, y, c);
+			mpz_mod(y, y, n);
+		}
+		for(k = 0; k < r && mpz_cmp_ui(d, 1) == 0; k += m)
+		{
+			mpz_set(ys, y);
+			for(i = 0; i < m && i < r - k; i++)
+			{
+				mpz_mul(y, y, y);
+				mpz_add_ui(y, y, c);
+				mpz_mod(y, y, n);
+				mpz_sub(t, x, y);
+				mpz_mul(q, q, t);
+				mpz_mod(q, q, n);
+			}
+			mpz_gcd(d, q, n);
+		}
+		nb_iterations += 2 * r;
+		r *= 2;
+	}
+	if(mpz_cmp(d, n) == 0) //several factors at once, step back one by one
+	{
+		do
+		{
+			mpz_mul(ys, ys, ys);
+			mpz_add_ui(ys, ys, c);
+			mpz_mod(ys, ys, n);
+			mpz_sub(t, x, ys);
+			mpz_gcd(d, t, n);
+		}while(mpz_cmp_ui(d, 1) == 0);
+	}
+	found = (mpz_cmp_ui(d, 1) > 0 && mpz_cmp(d, n) < 0);
+	mpz_clears(x, y, ys, q, t, NULL);
+	return found;
+}
+
+/** Add a prime to a factorization, keeping it sorted.
+ *
+ */
+static void add_prime(ph_factor_t *factors, int *nb_factors, mpz_t q)
+{
+	int i, j;
+	for(i = 0; i < *nb_factors && mpz_cmp(factors[i].q, q) < 0; i++);
+	if(i < *nb_factors && mpz_cmp(factors[i].q, q) == 0)
+	{
+		factors[i].e++;
+		return;
+	}
+	mpz_init(factors[*nb_factors].q);
+	for(j = *nb_factors; j > i; j--)
+	{
+		mpz_swap(factors[j].q, factors[j - 1].q);
+		factors[j].e = factors[j - 1].e;
+	}
+	mpz_set(factors[i].q, q);
+	factors[i].e = 1;
+	(*nb_factors)++;
+}
+
+/** Factor a number.
+ *
+ *	@param[out]	factors	The prime powers of N, sorted by increasing prime, to
+ *						be freed with ph_free_factors.
+ *	@return 	The number of primes, or -1 if N could not be factored.
+ */
+int ph_factor(mpz_t N, ph_factor_t **factors)
+{
+	mpz_t m, q, stack[__PH_MAX_FACTORS__];
+	unsigned long int d, c;
+	int nb_factors = 0, nb_stack = 0, i, error = 0;
+
+	*factors = calloc(__PH_MAX_FACTORS__, sizeof(ph_factor_t));
+	mpz_init_set(m, N);
+	mpz_init(q);
+	for(d = 2; d < __PH_TRIAL_BOUND__ && mpz_cmp_ui(m, 1) > 0; d += (d == 2) ? 1 : 2)
+	{
+		while(mpz_divisible_ui_p(m, d))
+		{
+			mpz_set_ui(q, d);
+			add_prime(*factors, &nb_factors, q);
+			mpz_divexact_ui(m, m, d);
+		}
+	}
+	if(mpz_cmp_ui(m, 1) > 0)
+	{
+		mpz_init_set(stack[nb_stack++], m);
+	}
+	while(nb_stack > 0 && !error)
+	{
+		nb_stack--;
+		if(mpz_probab_prime_p(stack[nb_stack], 30))
+		{
+			add_prime(*factors, &nb_factors, stack[nb_stack]);
+			mpz_clear(stack[nb_stack]);
+			continue;
+		}
+		for(c = 1; c < 20 && !rho_split(q, stack[nb_stack], c); c++);
+		if(c == 20 || nb_stack + 2 > __PH_MAX_FACTORS__)
+		{
+			error = 1;
+			break;
+		}
+		mpz_divexact(stack[nb_stack], stack[nb_stack], q);
+		mpz_init_set(stack[nb_stack + 1], q);
+		nb_stack += 2;
+	}
+	for(i = 0; i < nb_stack; i++)
+	{
+		mpz_clear(stack[i]);
+	}
+	mpz_clears(m, q, NULL);
+	if(error)
+	{
+		ph_free_factors(*factors, nb_factors);
+		*factors = NULL;
+		return -1;
+	}
+	return nb_factors;
+}
+
+/** Free a factorization.
+ *
+ */
+void ph_free_factors(ph_factor_t *factors, int nb_factors)
+{
+	int i;
+	for(i = 0; i < nb_factors; i++)
+	{
+		mpz_clear(factors[i].q);
+	}
+	free(factors);
+}
+
+/** Get the order of a point from a multiple N of it.
+ *
+ *	@param[in]	factors			The factorization of N.
+ *	@param[out]	order_factors	The factorization of the order, to be freed
+ *								with ph_free_factors.
+ *	@return 	The number of primes of the order.
+ */
+int ph_point_order(mpz_t order, point_t P, elliptic_curve_t E, mpz_t N, ph_factor_t *factors, int nb_factors, ph_factor_t **order_factors)
+{
+	point_t R;
+	mpz_t t;
+	int i, k, nb_order_factors = 0;
+	point_init(&R);
+	mpz_init(t);
+	mpz_set(order, N);
+	*order_factors = calloc(nb_factors + 1, sizeof(ph_factor_t));
+	for(i = 0; i < nb_factors; i++)
+	{
+		for(k = factors[i].e; k > 0; k--)
+		{
+			mpz_divexact(t, order, factors[i].q);
+			double_and_add(&R, P, t, E);
+			if(mpz_sgn(R.z) != 0)
+			{
+				break;
+			}
+			mpz_set(order, t);
+		}
+		if(k > 0)
+		{
+			mpz_init_set((*order_factors)[nb_order_factors].q, factors[i].q);
+			(*order_factors)[nb_order_factors].e = k;
+			nb_order_factors++;
+		}
+	}
+	point_clear(&R);
+	mpz_clear(t);
+	return nb_order_factors;
+}
+
+/** Compute a square root modulo an odd prime with the Tonelli-Shanks algorithm.
+ *
+ *	@param[in]	a	A quadratic residue modulo p.
+ */
+static void sqrt_mod(mpz_t r, mpz_t a, mpz_t p)
+{
+	mpz_t q, z, c, t, b;
+	unsigned long int s = 0, m, i, j;
+	mpz_inits(q, z, c, t, b, NULL);
+	mpz_sub_ui(q, p, 1);
+	while(mpz_even_p(q))
+	{
+		mpz_tdiv_q_2exp(q, q, 1);
+		s++;
+	}
+	mpz_set_ui(z, 2);
+	while(mpz_legendre(z, p) != -1)
+	{
+		mpz_add_ui(z, z, 1);
+	}
+	mpz_powm(c, z, q, p);
+	mpz_add_ui(b, q, 1);
+	mpz_tdiv_q_2exp(b, b, 1);
+	mpz_powm(r, a, b, p);
+	mpz_powm(t, a, q, p);
+	m = s;
+	while(mpz_cmp_ui(t, 1) != 0)
+	{
+		mpz_set(b, t);
+		for(i = 0; mpz_cmp_ui(b, 1) != 0; i++)
+		{
+			mpz_mul(b, b, b);
+			mpz_mod(b, b, p);
+		}
+		mpz_set(b, c);
+		for(j = 0; j + i + 1 < m; j++)
+		{
+			mpz_mul(b, b, b);
+			mpz_mod(b, b, p);
+		}
+		mpz_mul(r, r, b);
+		mpz_mod(r, r, p);
+		mpz_mul(c, b, b);
+		mpz_mod(c, c, p);
+		mpz_mul(t, t, c);
+		mpz_mod(t, t, p);
+		m = i;
+	}
+	mpz_clears(q, z, c, t, b, NULL);
+}
+
+/** Build the quadratic twist of a curve of prime order n.
+ *
+ *	@brief The twist y^2 = x^3 + Ad^2x + Bd^3, for d not a square modulo p,
+ *	has order 2(p + 1) - n, which is even or composite in general.
+ */
+void ph_quadratic_twist(elliptic_curve_t *E_twist, mpz_t N_twist, elliptic_curve_t E, mpz_t n)
+{
+	mpz_t d;
+	mpz_init_set_ui(d, 2);
+	while(mpz_legendre(d, E.p) != -1)
+	{
+		mpz_add_ui(d, d, 1);
+	}
+	mpz_set(E_twist->p, E.p);
+	E_twist->field = E.field;
+	mpz_mul(E_twist->A, E.A, d);
+	mpz_mul(E_twist->A, E_twist->A, d);
+	mpz_mod(E_twist->A, E_twist->A, E.p);
+	mpz_mul(E_twist->B, E.B, d);
+	mpz_mul(E_twist->B, E_twist->B, d);
+	mpz_mul(E_twist->B, E_twist->B, d);
+	mpz_mod(E_twist->B, E_twist->B, E.p);
+	mpz_add_ui(N_twist, E.p, 1);
+	mpz_mul_2exp(N_twist, N_twist, 1);
+	mpz_sub(N_twist, N_twist, n);
+	mpz_clear(d);
+}
+
+/** Draw a random point of a curve.
+ *
+ */
+void ph_random_point(point_t *P, elliptic_curve_t E, gmp_randstate_t r_state)
+{
+	mpz_t rhs;
+	mpz_init(rhs);
+	do
+	{
+		mpz_urandomm(P->x, r_state, E.p);
+		mpz_mul(rhs, P->x, P->x);
+		mpz_add(rhs, rhs, E.A);
+		mpz_mul(rhs, rhs, P->x);
+		mpz_add(rhs, rhs, E.B);
+		mpz_mod(rhs, rhs, E.p);
+	}while(mpz_legendre(rhs, E.p) != 1);
+	sqrt_mod(P->y, rhs, E.p);
+	mpz_set_ui(P->z, 1);
+	mpz_clear(rhs);
+}
+
+/** Solve H = dG in the subgroup of prime order q.
+ *
+ *	@brief By exhaustive search below __PH_BRUTE_FORCE__, and with a PCS
+ *	context using the hash_unix structure above, since the sizes of the
+ *	records of the PRTL structure are fixed at compile time.
+ *
+ *	@return 	0 if d was found, 1 otherwise.
+ */
+static int ph_solve_prime(mpz_t d, point_t G, point_t H, elliptic_curve_t E, mpz_t q, int type_struct, int nb_threads, uint8_t level, unsigned long long int *nb_steps)
+{
+	pcs_ctx_t *ctx;
+	point_t R;
+	mpz_t A[__NB_ENSEMBLES__], B[__NB_ENSEMBLES__];
+	gmp_randstate_t r_state;
+	int i, tries, retval = 1;
+
+	point_init(&R);
+	mpz_set_ui(d, 0);
+	if(mpz_sgn(H.z) == 0)
+	{
+		point_clear(&R);
+		return 0;
+	}
+	if(mpz_cmp_ui(q, __PH_BRUTE_FORCE__) < 0)
+	{
+		mpz_set(R.x, G.x);
+		mpz_set(R.y, G.y);
+		mpz_set(R.z, G.z);
+		for(mpz_set_ui(d, 1); mpz_cmp(d, q) < 0 && retval; mpz_add_ui(d, d, 1))
+		{
+			if(equal(R, H))
+			{
+				retval = 0;
+				break;
+			}
+			add(&R, R, G, E);
+			(*nb_steps)++;
+		}
+		point_clear(&R);
+		return retval;
+	}
+
+	gmp_randinit_default(r_state);
+	gmp_randseed_ui(r_state, (unsigned long int)time(NULL) ^ mpz_get_ui(q));
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_inits(A[i], B[i], NULL);
+		mpz_urandomm(A[i], r_state, q);
+		mpz_urandomm(B[i], r_state, q);
+	}
+	ctx = pcs_create(G, H, E, &pcs_group_ec, q, A, B, mpz_sizeinbase(E.p, 2), mpz_sizeinbase(q, 2) / 4, type_struct, nb_threads, level);
+	for(tries = 0; tries < 3 && retval; tries++)
+	{
+		if(tries > 0)
+		{
+			pcs_reset(ctx, G, H);
+		}
+		pcs_run(ctx, d, 1);
+		*nb_steps += pcs_steps(ctx);
+		double_and_add(&R, G, d, E);
+		retval = !equal(R, H);
+	}
+	pcs_destroy(ctx);
+	for(i = 0; i < __NB_ENSEMBLES__; i++)
+	{
+		mpz_clears(A[i], B[i], NULL);
+	}
+	gmp_randclear(r_state);
+	point_clear(&R);
+	return retval;
+}
+
+/** Find x modulo q^e, one base-q digit at a time.
+ *
+ *	@brief With m = order/q^e, P' = mP and Q' = mQ have order q^e, and the
+ *	digit i is the logarithm of q^(e-1-i)(Q' - x_i P') in base q^(e-1)P',
+ *	where x_i holds the digits found before.
+ *
+ *	@return 	0 if x was found, 1 otherwise.
+ */
+static int ph_solve_power(mpz_t x, point_t P, point_t Q, elliptic_curve_t E, mpz_t order, ph_factor_t *factor, int type_struct, uint8_t level)
+{
+	point_t Pq, Qq, G, H;
+	mpz_t qe, m, t, d, qi;
+	struct timeval tv1;
+	struct timeval tv2;
+	int i, retval = 0;
+
+	gettimeofday(&tv1, NULL);
+	point_init(&Pq);
+	point_init(&Qq);
+	point_init(&G);
+	point_init(&H);
+	mpz_inits(qe, m, t, d, qi, NULL);
+	mpz_pow_ui(qe, factor->q, factor->e);
+	mpz_divexact(m, order, qe);
+	double_and_add(&Pq, P, m, E);
+	double_and_add(&Qq, Q, m, E);
+	mpz_divexact(t, qe, factor->q);
+	double_and_add(&G, Pq, t, E);
+	mpz_set_ui(x, 0);
+	mpz_set_ui(qi, 1);
+	factor->nb_steps = 0;
+	for(i = 0; i < factor->e && !retval; i++)
+	{
+		mpz_sub(t, qe, x);
+		double_and_add(&H, Pq, t, E);
+		add(&H, H, Qq, E);
+		mpz_pow_ui(t, factor->q, factor->e - 1 - i);
+		double_and_add(&H, H, t, E);
+		retval = ph_solve_prime(d, G, H, E, factor->q, type_struct, factor->nb_threads, level, &factor->nb_steps);
+		mpz_addmul(x, d, qi);
+		mpz_mul(qi, qi, factor->q);
+	}
+	point_clear(&Pq);
+	point_clear(&Qq);
+	point_clear(&G);
+	point_clear(&H);
+	mpz_clears(qe, m, t, d, qi, NULL);
+	gettimeofday(&tv2, NULL);
+	factor->time = (tv2.tv_sec - tv1.tv_sec) * 1000000ULL + tv2.tv_usec - tv1.tv_usec;
+	return retval;
+}
+
+/** Solve Q = xP when the order of P is composite.
+ *
+ *	@brief The prime powers of the order are solved at the same time. Each
+ *	one gets a share of the nb_threads threads in proportion to e*sqrt(q),
+ *	and at least one. The threads given to each prime power and its steps
+ *	and time are written in factors.
+ *
+ *	@param[in]	order		The order of P.
+ *	@param[in]	factors		The factorization of the order.
+ *	@return 	0 if x was found, 1 otherwise.
+ */
+int pcs_pohlig_hellman(mpz_t x, point_t P, point_t Q, elliptic_curve_t E, mpz_t order, ph_factor_t *factors, int nb_factors, int type_struct, int nb_threads, uint8_t level)
+{
+	mpz_t *x_q, modulus, qe, t;
+	point_t R;
+	double *cost, total_cost = 0.0;
+	int *by_cost;
+	int i, j, error = 0;
+
+	x_q = malloc(sizeof(mpz_t) * nb_factors);
+	cost = malloc(sizeof(double) * nb_factors);
+	by_cost = malloc(sizeof(int) * nb_factors);
+	for(i = 0; i < nb_factors; i++)
+	{
+		mpz_init(x_q[i]);
+		cost[i] = (mpz_cmp_ui(factors[i].q, __PH_BRUTE_FORCE__) < 0) ? 0.0 : factors[i].e * sqrt(mpz_get_d(factors[i].q));
+		total_cost += cost[i];
+	}
+	for(i = 0; i < nb_factors; i++)
+	{
+		factors[i].nb_threads = (total_cost > 0.0) ? (int)(nb_threads * cost[i] / total_cost + 0.5) : 1;
+		if(factors[i].nb_threads < 1)
+		{
+			factors[i].nb_threads = 1;
+		}
+		//the most expensive prime powers are started first
+		for(j = i; j > 0 && cost[by_cost[j - 1]] < cost[i]; j--)
+		{
+			by_cost[j] = by_cost[j - 1];
+		}
+		by_cost[j] = i;
+	}
+
+	omp_set_max_active_levels(2);
+	#pragma omp parallel for schedule(dynamic) num_threads(nb_factors) reduction(|:error)
+	for(j = 0; j < nb_factors; j++)
+	{
+		error |= ph_solve_power(x_q[by_cost[j]], P, Q, E, order, &factors[by_cost[j]], type_struct, level);
+	}
+
+	//Chinese remainder theorem
+	mpz_inits(modulus, qe, t, NULL);
+	point_init(&R);
+	mpz_set_ui(x, 0);
+	mpz_set_ui(modulus, 1);
+	for(i = 0; i < nb_factors && !error; i++)
+	{
+		mpz_pow_ui(qe, factors[i].q, factors[i].e);
+		mpz_sub(t, x_q[i], x);
+		mpz_invert(R.x, modulus, qe);
+		mpz_mul(t, t, R.x);
+		mpz_mod(t, t, qe);
+		mpz_addmul(x, t, modulus);
+		mpz_mul(modulus, modulus, qe);
+	}
+	if(!error)
+	{
+		mpz_mod(x, x, order);
+		double_and_add(&R, P, x, E);
+		error = !equal(R, Q);
+	}
+	for(i = 0; i < nb_factors; i++)
+	{
+		mpz_clear(x_q[i]);
+	}
+	point_clear(&R);
+	mpz_clears(modulus, qe, t, NULL);
+	free(x_q);
+	free(cost);
+	free(by_cost);
+	return error;
+}
@@ -0,0 +1,32 @@
+/** @file pcs_pohlig_hellman.h
+ *
+ */
+#ifndef PCS_POHLIG_HELLMAN_H
+#define PCS_POHLIG_HELLMAN_H
+
+#include <gmp.h>
+#include "pcs_elliptic_curve_operations.h"
+
+#define __PH_TRIAL_BOUND__ 65536
+#define __PH_RHO_ITERATIONS__ (1ULL << 32)
+#define __PH_BRUTE_FORCE__ 4096
+#define __PH_MAX_FACTORS__ 128
+
+/** A prime power q^e of a group order, and the work done on its subproblem.
+ */
+typedef struct
+{
+	mpz_t q;
+	int e;
+	int nb_threads;
+	unsigned long long int nb_steps;
+	unsigned long long int time;
+}ph_factor_t;
+
+int ph_factor(mpz_t N, ph_factor_t **factors);
+void ph_free_factors(ph_factor_t *factors, int nb_factors);
+int ph_point_order(mpz_t order, point_t P, elliptic_curve_t E, mpz_t N, ph_factor_t *factors, int nb_factors, ph_factor_t **order_factors);
+void ph_quadratic_twist(elliptic_curve_t *E_twist, mpz_t N_twist, elliptic_curve_t E, mpz_t n);
+void ph_random_point(point_t *P, elliptic_curve_t E, gmp_randstate_t r_state);
+int pcs_pohlig_hellman(mpz_t x, point_t P, point_t Q, elliptic_curve_t E, mpz_t order, ph_factor_t *factors, int nb_factors, int type_struct, int nb_threads, uint8_t level);
+#endif
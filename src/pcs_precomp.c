@@ -0,0 +1,455 @@
+/** @file pcs_precomp.c
+ *  @brief A table of distinguished points of known logarithm, precomputed once per curve and point P.
+ *
+ *	The offline phase walks from random points aP with the adding walk on
+ *	P only (M[i] = A[i]P), so that the logarithm of each distinguished
+ *	point reached is known. It does __PRECOMP_OVERSAMPLE__ times more walks
+ *	than the size T of the table and keeps the T distinguished points
+ *	reached by the most walks, which are the most likely to be reached
+ *	again (Bernstein and Lange, "Computing small discrete logarithms
+ *	faster", INDOCRYPT 2012).
+ *
+ *	The online phase maps the table in memory and solves each target with
+ *	the multi-target walk of pcs_multi.c: a walk reaching a point of the
+ *	table solves the target at once.
+ *
+ *	A table file holds, in this order:
+ *	- the magic string __PRECOMP_MAGIC__;
+ *	- nb_bits, trailling_bits, the sizes in bytes of an x coordinate and
+ *	  a logarithm and the field of the curve (one byte each), the number of points and the number of
+ *	  walks done (uint64_t) and the offset of the points (uint64_t);
+ *	- the curve A, B, p, the order n, the point P and the adding set A[],
+ *	  in the portable format of mpz_out_raw;
+ *	- the points at the offset, sorted, as fixed-size big-endian x
+ *	  coordinates (without the trailling zeros) followed by their
+ *	  logarithm.
+ *	The integers of fixed size are written in the byte order of the host.
+ */
+#define _GNU_SOURCE //qsort_r
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <gmp.h>
+#include <omp.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_pollard_rho.h"
+#include "pcs_multi.h"
+#include "pcs_precomp.h"
+
+/** Header of a table file, before the numbers.
+ */
+typedef struct
+{
+	char magic[8];
+	uint8_t nb_bits;
+	uint8_t trailling_bits;
+	uint8_t x_bytes;
+	uint8_t log_bytes;
+	uint8_t field;
+	uint64_t nb_points;
+	uint64_t nb_walks;
+	uint64_t offset;
+}precomp_header_t;
+
+/** A table mapped in memory.
+ */
+struct pcs_table
+{
+	unsigned char *map;
+	size_t map_size;
+	const unsigned char *points;
+	uint64_t nb_points;
+	int x_bytes;
+	int log_bytes;
+};
+
+/** Distinguished points reached by the walks of one thread.
+ */
+typedef struct
+{
+	unsigned char *records;
+	size_t nb_records;
+	size_t size;
+}precomp_buffer_t;
+
+/** Distinct distinguished point, with the number of walks that reached it.
+ */
+typedef struct
+{
+	size_t first;
+	size_t count;
+}precomp_run_t;
+
+/** Compare two records by their x coordinate, whose size in bytes is given through qsort_r.
+ *
+ */
+static int compare_records(const void *r1, const void *r2, void *key_size)
+{
+	return memcmp(r1, r2, *(size_t *)key_size);
+}
+
+static int compare_runs(const void *r1, const void *r2)
+{
+	const precomp_run_t *u1 = r1, *u2 = r2;
+	if(u1->count != u2->count)
+	{
+		return (u1->count < u2->count) ? 1 : -1;
+	}
+	return (u1->first > u2->first) - (u1->first < u2->first);
+}
+
+static int compare_runs_first(const void *r1, const void *r2)
+{
+	const precomp_run_t *u1 = r1, *u2 = r2;
+	return (u1->first > u2->first) - (u1->first < u2->first);
+}
+
+/** Write a number on a fixed number of bytes, most significant first.
+ *
+ */
+static void put_fixed(unsigned char *buffer, size_t nb_bytes, mpz_t value)
+{
+	size_t count = (mpz_sizeinbase(value, 2) + 7) / 8;
+	memset(buffer, 0, nb_bytes);
+	if(mpz_sgn(value) != 0)
+	{
+		mpz_export(buffer + nb_bytes - count, NULL, 1, 1, 1, 0, value);
+	}
+}
+
+/** Sizes in bytes of an x coordinate and a logarithm.
+ *
+ */
+static void precomp_sizes(pcs_ctx_t *ctx, int *x_bytes, int *log_bytes)
+{
+	*x_bytes = (mpz_sizeinbase(ctx->E.p, 2) - ctx->trailling_bits + 7) / 8;
+	*log_bytes = (mpz_sizeinbase(ctx->n, 2) + 7) / 8;
+}
+
+/** Build a table of distinguished points and write it to a file.
+ *
+ *	@brief The walks are done by the threads of the context, with its
+ *	adding set A[] (the adding walk is switched to P only). The storage
+ *	structure of the context is not used.
+ *
+ *	@param[in]	table_size	The number of points T of the table.
+ *	@param[out]	nb_steps	The number of steps walked.
+ *	@param[out]	nb_distinct	The number of distinct points reached.
+ *	@return 	The number of points written, or -1 on a write error.
+ */
+int pcs_precompute(pcs_ctx_t *ctx, const char *path, unsigned long int table_size, unsigned long long int *nb_steps, unsigned long int *nb_distinct)
+{
+	precomp_buffer_t *buffers;
+	precomp_run_t *runs;
+	precomp_header_t header;
+	unsigned char *records;
+	unsigned long long int nb_walks = (unsigned long long int)table_size * __PRECOMP_OVERSAMPLE__;
+	unsigned long long int walks_done = 0, steps = 0;
+	size_t nb_records = 0, nb_runs, i, j, record_size, key_size;
+	int x_bytes, log_bytes, t;
+	long pos;
+	char *tmp_path;
+	FILE *file;
+	int error = 0;
+
+	walk_on_P(ctx);
+	precomp_sizes(ctx, &x_bytes, &log_bytes);
+	record_size = x_bytes + log_bytes;
+	key_size = x_bytes;
+	buffers = calloc(ctx->nb_threads, sizeof(precomp_buffer_t));
+
+	#pragma omp parallel num_threads(ctx->nb_threads) reduction(+:steps)
+	{
+		pcs_walker_t *w = &ctx->walkers[omp_get_thread_num()];
+		precomp_buffer_t *b = &buffers[omp_get_thread_num()];
+		int trail_length_max = (1 << ctx->trailling_bits) * 20;
+		unsigned long long int walk_i;
+		uint8_t r;
+
+		while(1)
+		{
+			#pragma omp atomic capture
+			walk_i = walks_done++;
+			if(walk_i >= nb_walks)
+			{
+				break;
+			}
+			do
+			{
+				mpz_urandomb(w->a, w->r_state, ctx->nb_bits);
+				fixed_base_mul(ctx, &w->R, w->a);
+				w->trail_length = 0;
+				while(!is_distinguished(w->R, ctx->trailling_bits, &w->xDist) && w->trail_length <= trail_length_max)
+				{
+					r = hash(w->R.y);
+					compute_a(w->a, ctx->A[r], ctx->n);
+					f(w->R, ctx->M[r], &w->R, ctx->E);
+					w->trail_length++;
+				}
+				steps += w->trail_length;
+			}while(w->trail_length > trail_length_max);
+			if(b->nb_records == b->size)
+			{
+				b->size = 2 * b->size + 1024;
+				b->records = realloc(b->records, b->size * record_size);
+			}
+			mpz_mod(w->a, w->a, ctx->n);
+			put_fixed(b->records + b->nb_records * record_size, x_bytes, w->xDist);
+			put_fixed(b->records + b->nb_records * record_size + x_bytes, log_bytes, w->a);
+			b->nb_records++;
+		}
+	}
+	*nb_steps = steps;
+
+	//merge the points of the threads and count the walks reaching each one
+	for(t = 0; t < ctx->nb_threads; t++)
+	{
+		nb_records += buffers[t].nb_records;
+	}
+	records = malloc(nb_records * record_size + 1);
+	nb_records = 0;
+	for(t = 0; t < ctx->nb_threads; t++)
+	{
+		memcpy(records + nb_records * record_size, buffers[t].records, buffers[t].nb_records * record_size);
+		nb_records += buffers[t].nb_records;
+		free(buffers[t].records);
+	}
+	free(buffers);
+	qsort_r(records, nb_records, record_size, compare_records, &key_size);
+	runs = malloc(sizeof(precomp_run_t) * (nb_records + 1));
+	nb_runs = 0;
+	for(i = 0; i < nb_records; i = j)
+	{
+		for(j = i + 1; j < nb_records && memcmp(records + i * record_size, records + j * record_size, key_size) == 0; j++);
+		runs[nb_runs].first = i;
+		runs[nb_runs].count = j - i;
+		nb_runs++;
+	}
+	*nb_distinct = nb_runs;
+	qsort(runs, nb_runs, sizeof(precomp_run_t), compare_runs);
+	if(nb_runs > table_size)
+	{
+		nb_runs = table_size;
+	}
+	qsort(runs, nb_runs, sizeof(precomp_run_t), compare_runs_first);
+
+	tmp_path = malloc(strlen(path) + 5);
+	sprintf(tmp_path, "%s.tmp", path);
+	file = fopen(tmp_path, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Can not open file %s.\n", tmp_path);
+		free(tmp_path);
+		free(records);
+		free(runs);
+		return -1;
+	}
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, __PRECOMP_MAGIC__, 8);
+	header.nb_bits = ctx->nb_bits;
+	header.trailling_bits = ctx->trailling_bits;
+	header.x_bytes = x_bytes;
+	header.log_bytes = log_bytes;
+	header.field = ctx->E.field;
+	header.nb_points = nb_runs;
+	header.nb_walks = nb_walks;
+	error |= (fwrite(&header, sizeof(header), 1, file) != 1);
+	error |= !mpz_out_raw(file, ctx->E.A) || !mpz_out_raw(file, ctx->E.B) || !mpz_out_raw(file, ctx->E.p) || !mpz_out_raw(file, ctx->n);
+	error |= !mpz_out_raw(file, ctx->P.x) || !mpz_out_raw(file, ctx->P.y);
+	for(t = 0; t < __NB_ENSEMBLES__; t++)
+	{
+		error |= !mpz_out_raw(file, ctx->A[t]);
+	}
+	//the points start on a page, so that they can be mapped aligned
+	pos = ftell(file);
+	header.offset = (pos + 4095) & ~4095L;
+	for(; pos < (long)header.offset; pos++)
+	{
+		error |= (fputc(0, file) == EOF);
+	}
+	for(i = 0; i < nb_runs; i++)
+	{
+		error |= (fwrite(records + runs[i].first * record_size, record_size, 1, file) != 1);
+	}
+	error |= (fseek(file, 0, SEEK_SET) != 0) || (fwrite(&header, sizeof(header), 1, file) != 1);
+	error |= (fflush(file) != 0) || (fsync(fileno(file)) != 0);
+	error |= (fclose(file) != 0);
+	if(!error && rename(tmp_path, path) != 0)
+	{
+		error = 1;
+	}
+	if(error)
+	{
+		fprintf(stderr, "Can not write file %s.\n", path);
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+	free(records);
+	free(runs);
+	return error ? -1 : (int)nb_runs;
+}
+
+/** Map a table file in memory.
+ *
+ *	@param[out]	E, n, P, A, nb_bits, trailling_bits	The settings the table
+ *				was built with, which the online phase has to use.
+ *	@return 	The table, or NULL if the file can not be read.
+ */
+pcs_table_t *pcs_table_load(const char *path, elliptic_curve_t *E, mpz_t n, point_t *P, mpz_t *A, uint8_t *nb_bits, uint8_t *trailling_bits)
+{
+	precomp_header_t header;
+	pcs_table_t *table;
+	struct stat st;
+	FILE *file;
+	int ok, i, fd;
+
+	file = fopen(path, "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Can not open file %s.\n", path);
+		return NULL;
+	}
+	ok = (fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, __PRECOMP_MAGIC__, 8) == 0);
+	ok = ok && mpz_inp_raw(E->A, file) && mpz_inp_raw(E->B, file) && mpz_inp_raw(E->p, file) && mpz_inp_raw(n, file);
+	ok = ok && mpz_inp_raw(P->x, file) && mpz_inp_raw(P->y, file);
+	for(i = 0; ok && i < __NB_ENSEMBLES__; i++)
+	{
+		ok = mpz_inp_raw(A[i], file);
+	}
+	ok = ok && fstat(fileno(file), &st) == 0 && (uint64_t)st.st_size >= header.offset + header.nb_points * (header.x_bytes + header.log_bytes);
+	if(!ok)
+	{
+		fprintf(stderr, "File %s is not a table of distinguished points.\n", path);
+		fclose(file);
+		return NULL;
+	}
+	mpz_set_ui(P->z, 1);
+	E->field = header.field;
+	*nb_bits = header.nb_bits;
+	*trailling_bits = header.trailling_bits;
+
+	table = malloc(sizeof(pcs_table_t));
+	table->map_size = st.st_size;
+	fd = fileno(file);
+	table->map = mmap(NULL, table->map_size, PROT_READ, MAP_SHARED, fd, 0);
+	fclose(file);
+	if(table->map == MAP_FAILED)
+	{
+		fprintf(stderr, "Can not map file %s.\n", path);
+		free(table);
+		return NULL;
+	}
+	table->points = table->map + header.offset;
+	table->nb_points = header.nb_points;
+	table->x_bytes = header.x_bytes;
+	table->log_bytes = header.log_bytes;
+	return table;
+}
+
+/** Get the number of points of a table.
+ *
+ */
+unsigned long int pcs_table_size(pcs_table_t *table)
+{
+	return table->nb_points;
+}
+
+/** Unmap a table.
+ *
+ */
+void pcs_table_free(pcs_table_t *table)
+{
+	munmap(table->map, table->map_size);
+	free(table);
+}
+
+/** Use a table in the runs of a context.
+ *
+ *	@brief The context has to be in the multi-target mode, on the curve,
+ *	point P, adding set A[] and trailling_bits of the table. The table is
+ *	not freed with the context.
+ */
+void pcs_set_table(pcs_ctx_t *ctx, pcs_table_t *table)
+{
+	ctx->table = table;
+}
+
+/** Look a distinguished point up in the table of the context.
+ *
+ *	@brief If it is found with the logarithm L, the trail of the walker
+ *	ends in (cx + k)P = +-LP, and the sign is the one for which xP = Q.
+ *
+ *	@param[out]	x		The logarithm of the current target, if found.
+ *	@param[in]	a		The start of the trail of the walker.
+ *	@param[in]	xDist	The x coordinate, without the trailling zeros.
+ *	@return 	1 if x was found, 0 otherwise.
+ */
+int table_collision(pcs_ctx_t *ctx, mpz_t x, mpz_t a, mpz_t xDist)
+{
+	pcs_table_t *table = ctx->table;
+	size_t size = table->x_bytes + table->log_bytes;
+	unsigned char key[256];
+	const unsigned char *record = NULL;
+	uint64_t low = 0, high = table->nb_points;
+	uint64_t middle;
+	point_t R, S;
+	mpz_t c, k, L, xDist_;
+	int sign, cmp, retval = 0;
+
+	if(mpz_sizeinbase(xDist, 2) > (size_t)table->x_bytes * 8 || table->x_bytes > (int)sizeof(key))
+	{
+		return 0;
+	}
+	put_fixed(key, table->x_bytes, xDist);
+	while(low < high)
+	{
+		middle = low + (high - low) / 2;
+		cmp = memcmp(table->points + middle * size, key, table->x_bytes);
+		if(cmp == 0)
+		{
+			record = table->points + middle * size;
+			break;
+		}
+		if(cmp < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+	if(record == NULL)
+	{
+		return 0;
+	}
+
+	point_init(&R);
+	point_init(&S);
+	mpz_inits(c, k, L, xDist_, NULL);
+	mpz_import(L, table->log_bytes, 1, 1, 1, 0, record + table->x_bytes);
+	if(target_trail_end(ctx, a, ctx->trailling_bits, &R, c, k, &xDist_) && mpz_invert(c, c, ctx->n))
+	{
+		for(sign = 1; sign >= -1 && !retval; sign -= 2)
+		{
+			if(sign < 0)
+			{
+				mpz_neg(L, L);
+			}
+			mpz_sub(x, L, k);
+			mpz_mul(x, x, c);
+			mpz_mod(x, x, ctx->n);
+			fixed_base_mul(ctx, &S, x);
+			retval = equal(S, ctx->Q);
+		}
+	}
+	point_clear(&R);
+	point_clear(&S);
+	mpz_clears(c, k, L, xDist_, NULL);
+	return retval;
+}
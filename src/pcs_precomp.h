@@ -0,0 +1,18 @@
+/** @file pcs_precomp.h
+ *
+ */
+#ifndef PCS_PRECOMP_H
+#define PCS_PRECOMP_H
+
+#include "pcs.h"
+
+#define __PRECOMP_MAGIC__ "PCSPRE02"
+#define __PRECOMP_OVERSAMPLE__ 8
+
+int pcs_precompute(pcs_ctx_t *ctx, const char *path, unsigned long int table_size, unsigned long long int *nb_steps, unsigned long int *nb_distinct);
+pcs_table_t *pcs_table_load(const char *path, elliptic_curve_t *E, mpz_t n, point_t *P, mpz_t *A, uint8_t *nb_bits, uint8_t *trailling_bits);
+unsigned long int pcs_table_size(pcs_table_t *table);
+void pcs_table_free(pcs_table_t *table);
+void pcs_set_table(pcs_ctx_t *ctx, pcs_table_t *table);
+int table_collision(pcs_ctx_t *ctx, mpz_t x, mpz_t a, mpz_t xDist);
+#endif
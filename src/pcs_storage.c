@@ -6,24 +6,40 @@
  */
 
 #include<gmp.h>
+#include<stdio.h>
+#include<stdlib.h>
 #include "pcs_storage.h"
 #include "pcs_struct_hash.h"
 #include "pcs_struct_PRTL.h"
-
-uint8_t struct_type;
+#include "pcs_struct_shm.h"
+#include "pcs_struct_net.h"
+#include "pcs_struct_frozen.h"
+#include "pcs_struct_fingerprint.h"
 
 /** Initialize the distinguished-point-storing structure.
  * 
  */
-void struct_init(uint8_t type, mpz_t n, uint8_t trailling_bits, uint8_t nb_bits, int nb_threads, uint8_t level)
+void struct_init(pcs_storage_t *storage, uint8_t type, mpz_t n, uint8_t trailling_bits, uint8_t nb_bits, int nb_threads, uint8_t level)
 {
-    struct_type = type;
-	switch(struct_type)
+    storage->type = type;
+	switch(storage->type)
 	{
-		case 0: struct_init_PRTL(nb_bits, trailling_bits, nb_threads, level);
+		case 0: storage->structure = struct_init_PRTL(nb_bits, trailling_bits, nb_threads, level);
 			break;
+		case __STRUCT_SHM__:
+			fprintf(stderr, "The shared store is created by shm_create and given to pcs_create_with_storage.\n");
+			exit(1);
+		case __STRUCT_NET__:
+			fprintf(stderr, "The connection to a coordinator is created by net_connect and given to pcs_create_with_storage.\n");
+			exit(1);
+		case __STRUCT_FROZEN__:
+			fprintf(stderr, "A frozen store is opened by frozen_open and given to pcs_create_with_storage.\n");
+			exit(1);
+		case __STRUCT_FINGERPRINT__:
+			fprintf(stderr, "A fingerprint store is created by fingerprint_create and given to pcs_create_with_storage.\n");
+			exit(1);
         default:
-			struct_init_hash(struct_type, n, trailling_bits, level);
+			storage->structure = struct_init_hash(storage->type, n, trailling_bits, nb_threads, level);
 	}
 }
 
@@ -37,42 +53,110 @@ void struct_init(uint8_t type, mpz_t n, uint8_t trailling_bits, uint8_t nb_bits,
  *  @param[in]	xDist	The x coordinate, without the trailling zeros.
  *  @return 	1 if the point was found, 0 otherwise.
  */
-int struct_add(mpz_t a_out, mpz_t a_in, mpz_t xDist, char xDist_str[])
+int struct_add(pcs_storage_t *storage, mpz_t a_out, mpz_t a_in, mpz_t xDist, char xDist_str[])
+{
+	switch(storage->type)
+	{
+		case 0: return struct_add_PRTL(storage->structure, a_out, a_in, xDist);
+			break;
+		case __STRUCT_SHM__: return struct_add_shm(storage->structure, a_out, a_in, xDist);
+		case __STRUCT_NET__: return struct_add_net(storage->structure, a_in, xDist);
+		case __STRUCT_FROZEN__: return struct_add_frozen(storage->structure, a_out, xDist);
+		case __STRUCT_FINGERPRINT__: return struct_add_fingerprint(storage->structure, a_out, a_in, xDist);
+        default:
+			{mpz_get_str(xDist_str, 16, xDist); return struct_add_hash(storage->structure, a_out, a_in, xDist_str);}
+	}
+}
+
+/** Empty the distinguished-point-storing structure, keeping its memory.
+ * 
+ */
+void struct_reset(pcs_storage_t *storage)
+{
+	switch(storage->type)
+	{
+		case 0: struct_reset_PRTL(storage->structure);
+			break;
+		case __STRUCT_SHM__: //emptied by the coordinator only
+			break;
+		case __STRUCT_NET__: struct_reset_net(storage->structure);
+			break;
+		case __STRUCT_FROZEN__: //read-only
+			break;
+		case __STRUCT_FINGERPRINT__: struct_reset_fingerprint(storage->structure);
+			break;
+        default: 
+			struct_reset_hash(storage->structure);
+	}
+}
+
+/** Call a function on each point of the distinguished-point-storing structure.
+ *
+ *  @brief Each slot is locked while its points are visited, so that 
+ *  the walkers can keep adding points meanwhile. A point added during the
+ *  visit may or may not be seen.
+ *
+ *  @param[in]	fn	The function, called with the x coordinate without the 
+ *					trailling zeros and the a coefficient of the point.
+ *  @param[in]	arg	The last argument given to fn.
+ */
+void struct_foreach(pcs_storage_t *storage, struct_foreach_fn_t fn, void *arg)
 {
-	switch(struct_type)
+	switch(storage->type)
 	{
-		case 0: return struct_add_PRTL(a_out, a_in, xDist);
+		case 0: struct_foreach_PRTL(storage->structure, fn, arg);
+			break;
+		case __STRUCT_SHM__: struct_foreach_shm(storage->structure, fn, arg);
+			break;
+		case __STRUCT_NET__: //the points are kept by the coordinator
+			break;
+		case __STRUCT_FROZEN__: struct_foreach_frozen(storage->structure, fn, arg);
+			break;
+		case __STRUCT_FINGERPRINT__: //the x coordinates are not kept
 			break;
         default:
-			{mpz_get_str(xDist_str, 16, xDist); return struct_add_hash(a_out, a_in, xDist_str);}
+			struct_foreach_hash(storage->structure, fn, arg);
 	}
 }
 
 /** Free the distinguished-point-storing structure.
  * 
  */
-void struct_free()
+void struct_free(pcs_storage_t *storage)
 {
-	switch(struct_type)
+	switch(storage->type)
 	{
-		case 0: struct_free_PRTL();
+		case 0: struct_free_PRTL(storage->structure);
+			break;
+		case __STRUCT_SHM__: struct_free_shm(storage->structure);
+			break;
+		case __STRUCT_NET__: struct_free_net(storage->structure);
+			break;
+		case __STRUCT_FROZEN__: struct_free_frozen(storage->structure);
+			break;
+		case __STRUCT_FINGERPRINT__: struct_free_fingerprint(storage->structure);
 			break;
         default: 
-			struct_free_hash();
+			struct_free_hash(storage->structure);
 	}
+	storage->structure = NULL;
 }
 
 /** Get the memory occupation of the distinguished-point-storing structure.
  *  
  *  @return 	The memory occupation in bytes.
  */
-unsigned long long int struct_memory(unsigned long int *nb_points, float *rate_of_use, float *rate_slots, int nb_threads)
+unsigned long long int struct_memory(pcs_storage_t *storage, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
 {
-	switch(struct_type)
+	switch(storage->type)
 	{
-		case 0: return struct_memory_PRTL(nb_points, rate_of_use, rate_slots);
+		case 0: return struct_memory_PRTL(storage->structure, nb_points, rate_of_use, rate_slots);
 			break;
+		case __STRUCT_SHM__: return struct_memory_shm(storage->structure, nb_points, rate_of_use, rate_slots);
+		case __STRUCT_NET__: return struct_memory_net(storage->structure, nb_points, rate_of_use, rate_slots);
+		case __STRUCT_FROZEN__: return struct_memory_frozen(storage->structure, nb_points, rate_of_use, rate_slots);
+		case __STRUCT_FINGERPRINT__: return struct_memory_fingerprint(storage->structure, nb_points, rate_of_use, rate_slots);
         default:
-			return struct_memory_hash(nb_points, rate_of_use, rate_slots);
+			return struct_memory_hash(storage->structure, nb_points, rate_of_use, rate_slots);
 	}
 }
@@ -3,10 +3,29 @@
  *	Created by Monika Trimoska on 03/12/2015.
  *	Copyright © 2015 Monika Trimoska. All rights reserved.
  */
+#ifndef PCS_STORAGE_H
+#define PCS_STORAGE_H
 
 #include <inttypes.h>
+#include <gmp.h>
 
-void struct_init(uint8_t type, mpz_t n, uint8_t trailling_bits, uint8_t nb_bits, int nb_threads, uint8_t level);
-int struct_add(mpz_t a_out, mpz_t a_in, mpz_t xDist, char xDist_str[]);
-void struct_free();
-unsigned long long int struct_memory(unsigned long int *nb_points, float *rate_of_use, float *rate_slots, int nb_threads);
+/** Distinguished-point-storing structure
+ *  @brief The type selects the implementation, which keeps its own state.
+ */
+typedef struct
+{
+	uint8_t type;
+	void *structure;
+}pcs_storage_t;
+
+/** Function called for each stored point by struct_foreach.
+ */
+typedef void (*struct_foreach_fn_t)(mpz_t xDist, mpz_t a, void *arg);
+
+void struct_init(pcs_storage_t *storage, uint8_t type, mpz_t n, uint8_t trailling_bits, uint8_t nb_bits, int nb_threads, uint8_t level);
+int struct_add(pcs_storage_t *storage, mpz_t a_out, mpz_t a_in, mpz_t xDist, char xDist_str[]);
+void struct_reset(pcs_storage_t *storage);
+void struct_foreach(pcs_storage_t *storage, struct_foreach_fn_t fn, void *arg);
+void struct_free(pcs_storage_t *storage);
+unsigned long long int struct_memory(pcs_storage_t *storage, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+#endif
@@ -14,21 +14,28 @@
 #include "pcs_struct_PRTL.h"
 #include "pcs_elliptic_curve_operations.h"
 
-static uint8_t nb_bits;
-static uint8_t level;
-static _vect_bin_chain_t *chain_array;
-static int chain_array_size;
-static omp_lock_t *locks;
-static int xDist_start;
-static int xDist_end;
-static int a_start;
-static int a_end;
-static int suffix_len;
-/***Memory limiting feature is turned off
-static unsigned long long int memory_limit;
- ***/
-static unsigned long long int memory_alloc;
-static mpz_t mask;
+/** State of one Packed Radix-Tree-List.
+ */
+struct PRTL
+{
+	uint8_t nb_bits;
+	uint8_t level;
+	_vect_bin_chain_t *chain_array;
+	int chain_array_size;
+	omp_lock_t *locks;
+	int xDist_start;
+	int xDist_end;
+	int a_start;
+	int a_end;
+	int suffix_len;
+	int nb_threads;
+	/***Memory limiting feature is turned off
+	unsigned long long int memory_limit;
+	 ***/
+	unsigned long long int memory_alloc;
+	mpz_t mask;
+	_vect_bin_pool_t pool;
+};
 
 /** Initialize the Packed Radix-Tree-List.
  *
@@ -37,41 +44,44 @@ static mpz_t mask;
  *	to an index of the chain array.
  *
  */
-void struct_init_PRTL(uint8_t _nb_bits, uint8_t trailling_bits, int nb_threads, uint8_t _level)
+PRTL_t *struct_init_PRTL(uint8_t _nb_bits, uint8_t trailling_bits, int _nb_threads, uint8_t _level)
 {
 	int i;
-	nb_bits = _nb_bits;
-    uint8_t c = nb_bits - trailling_bits;
-	level = _level;
-    suffix_len = c - level;
-    xDist_start = 0;
-    xDist_end = suffix_len - 1;
-    a_start = suffix_len;
-    a_end = xDist_end + nb_bits;
-    chain_array_size = pow(2, level);
-	_vect_bin_t_initiate();
+	PRTL_t *prtl = malloc(sizeof(PRTL_t));
+	prtl->nb_bits = _nb_bits;
+    uint8_t c = prtl->nb_bits - trailling_bits;
+	prtl->level = _level;
+	prtl->nb_threads = _nb_threads;
+    prtl->suffix_len = c - prtl->level;
+    prtl->xDist_start = 0;
+    prtl->xDist_end = prtl->suffix_len - 1;
+    prtl->a_start = prtl->suffix_len;
+    prtl->a_end = prtl->xDist_end + prtl->nb_bits;
+    prtl->chain_array_size = pow(2, prtl->level);
+	_vect_bin_t_initiate(&prtl->pool, prtl->nb_threads);
     
     /* allocate chain table */
 	
     /***Memory limiting feature is turned off
-	memory_limit = 100000000;
+	prtl->memory_limit = 100000000;
 	 ***/
-    chain_array = (_vect_bin_chain_t *) malloc(sizeof(_vect_bin_chain_t) * chain_array_size);
-    _vect_bin_t_count_memory(chain_array_size);
-    locks = malloc(sizeof(omp_lock_t) * chain_array_size);
-    memory_alloc = sizeof(omp_lock_t) * chain_array_size;
-    for(i = 0; i < chain_array_size; i++)
+    prtl->chain_array = (_vect_bin_chain_t *) malloc(sizeof(_vect_bin_chain_t) * prtl->chain_array_size);
+    _vect_bin_t_count_memory(&prtl->pool, prtl->chain_array_size);
+    prtl->locks = malloc(sizeof(omp_lock_t) * prtl->chain_array_size);
+    prtl->memory_alloc = sizeof(omp_lock_t) * prtl->chain_array_size;
+    for(i = 0; i < prtl->chain_array_size; i++)
 	{
-		vect_bin_t_reset(chain_array[i].v);
-        chain_array[i].nxt = NULL;
-        omp_init_lock(&locks[i]);
+		vect_bin_t_reset(prtl->chain_array[i].v);
+        prtl->chain_array[i].nxt = NULL;
+        omp_init_lock(&prtl->locks[i]);
 	}
     
     /* create mask */
-    mpz_inits(mask, NULL);
-    mpz_set_ui(mask, 1);
-    mpz_mul_2exp(mask, mask, level); //left shift
-    mpz_sub_ui(mask, mask, 1);
+    mpz_inits(prtl->mask, NULL);
+    mpz_set_ui(prtl->mask, 1);
+    mpz_mul_2exp(prtl->mask, prtl->mask, prtl->level); //left shift
+    mpz_sub_ui(prtl->mask, prtl->mask, 1);
+    return prtl;
 }
 
 /** Search and insert function for the PRTL structure.
@@ -84,7 +94,7 @@ void struct_init_PRTL(uint8_t _nb_bits, uint8_t trailling_bits, int nb_threads,
  *  @param[in]	xDist	The x-coordinate, without the trailling zeros.
  *  @return 	1 if the point was found, 0 otherwise.
  */
-int struct_add_PRTL(mpz_t a_out, mpz_t a_in, mpz_t xDist)
+int struct_add_PRTL(PRTL_t *prtl, mpz_t a_out, mpz_t a_in, mpz_t xDist)
 {
     uint8_t retval = 0;
 	_vect_bin_chain_t *new;
@@ -97,53 +107,53 @@ int struct_add_PRTL(mpz_t a_out, mpz_t a_in, mpz_t xDist)
 	{
 		preallocation_init();
 	}
-	key_mpz = &(temp_obj[omp_get_thread_num()][14]);
+	key_mpz = &(temp_obj[14]);
 	
-    mpz_and(*key_mpz, xDist, mask);
+    mpz_and(*key_mpz, xDist, prtl->mask);
     key = mpz_get_ui(*key_mpz);
-    omp_set_lock(&locks[key]);
-    next = &chain_array[key];
+    omp_set_lock(&prtl->locks[key]);
+    next = &prtl->chain_array[key];
     if(vect_bin_is_empty(next->v))
     {
-        vect_bin_set_mpz(next->v, xDist_start, suffix_len, xDist, level);
-        vect_bin_set_mpz(next->v, a_start, nb_bits, a_in, 0);
+        vect_bin_set_mpz(next->v, prtl->xDist_start, prtl->suffix_len, xDist, prtl->level);
+        vect_bin_set_mpz(next->v, prtl->a_start, prtl->nb_bits, a_in, 0);
         next->nxt=NULL;
     }
     else
     {
-        while(next != NULL && vect_bin_cmp_mpz(next->v, xDist_start, suffix_len, xDist, level) < 0)
+        while(next != NULL && vect_bin_cmp_mpz(next->v, prtl->xDist_start, prtl->suffix_len, xDist, prtl->level) < 0)
         {
             last = next;
             next = next->nxt;
         }
-        if(next != NULL && vect_bin_cmp_mpz(next->v, xDist_start, suffix_len, xDist, level) == 0 ) //collision
+        if(next != NULL && vect_bin_cmp_mpz(next->v, prtl->xDist_start, prtl->suffix_len, xDist, prtl->level) == 0 ) //collision
         {
-            vect_bin_get_mpz(next->v, a_start, nb_bits, a_out);
+            vect_bin_get_mpz(next->v, prtl->a_start, prtl->nb_bits, a_out);
             retval = 1;
         }
         else
         {
 			/***Memory limiting feature is turned off
-            if(memory_alloc + _vect_bin_alloc_size < memory_limit)
+            if(prtl->memory_alloc + _vect_bin_t_memory(&prtl->pool) < prtl->memory_limit)
             {
 			 ***/
-                _vect_bin_chain_t_new(new);
+                _vect_bin_chain_t_new(&prtl->pool, new);
                 vect_bin_t_reset(new->v);
-                if(next == &chain_array[key]) //add at the beginning
+                if(next == &prtl->chain_array[key]) //add at the beginning
                 {
                     vect_bin_cpy(new->v, next->v);
                     new->nxt = next->nxt;
 
                     vect_bin_t_reset(next->v);
-                    vect_bin_set_mpz(next->v, xDist_start, suffix_len, xDist, level);
-                    vect_bin_set_mpz(next->v, a_start, nb_bits, a_in, 0);
+                    vect_bin_set_mpz(next->v, prtl->xDist_start, prtl->suffix_len, xDist, prtl->level);
+                    vect_bin_set_mpz(next->v, prtl->a_start, prtl->nb_bits, a_in, 0);
 
                     next->nxt = new;   
                 }
                 else
                 {
-                    vect_bin_set_mpz(new->v, xDist_start, suffix_len, xDist, level);
-                    vect_bin_set_mpz(new->v, a_start, nb_bits, a_in, 0);
+                    vect_bin_set_mpz(new->v, prtl->xDist_start, prtl->suffix_len, xDist, prtl->level);
+                    vect_bin_set_mpz(new->v, prtl->a_start, prtl->nb_bits, a_in, 0);
                     if(next != NULL) //add in the middle
                     {	
                         new->nxt = next;
@@ -153,34 +163,75 @@ int struct_add_PRTL(mpz_t a_out, mpz_t a_in, mpz_t xDist)
             //}
         }
     }
-	omp_unset_lock(&locks[key]);
+	omp_unset_lock(&prtl->locks[key]);
 	return retval;
 }
 
-/** Free the allocated memory for the Packed Radix-Tree-List.
+/** Empty the Packed Radix-Tree-List without freeing it.
+ *
+ *	@brief The slots of the chain array are cleared in parallel and
+ *	the chained cells are given back to their arenas, so that the
+ *	structure can be refilled without allocating memory again.
  *
  */
-void struct_free_PRTL(void)
+void struct_reset_PRTL(PRTL_t *prtl)
+{
+    int i;
+	#pragma omp parallel for num_threads(prtl->nb_threads)
+	for(i = 0; i < prtl->chain_array_size; i++)
+	{
+		vect_bin_t_reset(prtl->chain_array[i].v);
+        prtl->chain_array[i].nxt = NULL;
+	}
+	_vect_bin_t_reset_arenas(&prtl->pool);
+}
+
+/** Call a function on each point of the Packed Radix-Tree-List.
+ *
+ *	@brief The x coordinate of a point is rebuilt from its suffix and
+ *	the index of its slot, which holds the lower level bits.
+ *
+ */
+void struct_foreach_PRTL(PRTL_t *prtl, struct_foreach_fn_t fn, void *arg)
 {
     int i;
-	_vect_bin_chain_t *last;
 	_vect_bin_chain_t *next;
-    omp_destroy_lock(&_vect_alloc_size_lock);
-	for(i = 0; i < chain_array_size; i++)
+	mpz_t xDist, a;
+	mpz_inits(xDist, a, NULL);
+	for(i = 0; i < prtl->chain_array_size; i++)
 	{
-        omp_destroy_lock(&locks[i]);
-		next = chain_array[i].nxt;
-		while(next != NULL)
+        omp_set_lock(&prtl->locks[i]);
+		if(!vect_bin_is_empty(prtl->chain_array[i].v))
 		{
-			last = next;
-			next = next->nxt;
-			_vect_bin_chain_t_free(last);
+			for(next = &prtl->chain_array[i]; next != NULL; next = next->nxt)
+			{
+				vect_bin_get_mpz(next->v, prtl->xDist_start, prtl->suffix_len, xDist);
+				mpz_mul_2exp(xDist, xDist, prtl->level);
+				mpz_add_ui(xDist, xDist, i);
+				vect_bin_get_mpz(next->v, prtl->a_start, prtl->nb_bits, a);
+				fn(xDist, a, arg);
+			}
 		}
+        omp_unset_lock(&prtl->locks[i]);
+	}
+	mpz_clears(xDist, a, NULL);
+}
+
+/** Free the allocated memory for the Packed Radix-Tree-List.
+ *
+ */
+void struct_free_PRTL(PRTL_t *prtl)
+{
+    int i;
+	for(i = 0; i < prtl->chain_array_size; i++)
+	{
+        omp_destroy_lock(&prtl->locks[i]);
 	}
-	free(chain_array);
-    _vect_bin_t_count_memory(-chain_array_size);
-	free(locks);
-    mpz_clears(mask, NULL);
+	_vect_bin_t_terminate(&prtl->pool);
+	free(prtl->chain_array);
+	free(prtl->locks);
+    mpz_clears(prtl->mask, NULL);
+    free(prtl);
 }
 
 /** Recursive function used in struct_memory_PRTL_rec.
@@ -204,17 +255,17 @@ void struct_memory_PRTL_rec(_vect_bin_chain_t *it, unsigned long int *nb_points)
  *
  *  @return	The memory occupation in bytes.
  */
-unsigned long long int struct_memory_PRTL(unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+unsigned long long int struct_memory_PRTL(PRTL_t *prtl, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
 {
 	int i = 0;
 	unsigned long long int sum = 0;
 	unsigned long long int lost = 0;
     int empty_slots = 0;
     *nb_points = 0;
-	sum += sizeof(omp_lock_t) * chain_array_size;
-	for(i = 0; i < chain_array_size; i++)
+	sum += sizeof(omp_lock_t) * prtl->chain_array_size;
+	for(i = 0; i < prtl->chain_array_size; i++)
 	{
-		if(vect_bin_is_empty(chain_array[i].v))
+		if(vect_bin_is_empty(prtl->chain_array[i].v))
 		{
 			lost += sizeof(omp_lock_t) + sizeof(_vect_bin_chain_t);
 			empty_slots++;
@@ -222,14 +273,14 @@ unsigned long long int struct_memory_PRTL(unsigned long int *nb_points, float *r
 		else
 		{
 			(*nb_points)++;
-            if(chain_array[i].nxt != NULL)
-				struct_memory_PRTL_rec(chain_array[i].nxt, nb_points);
+            if(prtl->chain_array[i].nxt != NULL)
+				struct_memory_PRTL_rec(prtl->chain_array[i].nxt, nb_points);
 		}
 	}
     
-    sum += _vect_bin_alloc_size;
+    sum += _vect_bin_t_memory(&prtl->pool);
     *rate_of_use = (1.0 - ((float)lost) / ((float)sum)) * 100.0;
-    *rate_slots = (1.0 - ((float)empty_slots) / ((float)chain_array_size)) * 100.0;
+    *rate_slots = (1.0 - ((float)empty_slots) / ((float)prtl->chain_array_size)) * 100.0;
 	printf("\t\tPoints: %lu\n", *nb_points);
     printf("\t\tEmpty slots: %d\n", empty_slots);
     return sum;
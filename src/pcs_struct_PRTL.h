@@ -6,9 +6,13 @@
 
 #include <gmp.h>
 #include <omp.h>
+#include "pcs_storage.h"
 
-void struct_init_PRTL(uint8_t nb_bits, uint8_t trailling_bits, int nb_threads, uint8_t _level);
-int struct_add_PRTL(mpz_t a_out, mpz_t a_in, mpz_t xDist);
-void struct_free_PRTL(void);
-unsigned long long int struct_memory_PRTL(unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+typedef struct PRTL PRTL_t;
 
+PRTL_t *struct_init_PRTL(uint8_t nb_bits, uint8_t trailling_bits, int nb_threads, uint8_t _level);
+int struct_add_PRTL(PRTL_t *prtl, mpz_t a_out, mpz_t a_in, mpz_t xDist);
+void struct_reset_PRTL(PRTL_t *prtl);
+void struct_foreach_PRTL(PRTL_t *prtl, struct_foreach_fn_t fn, void *arg);
+void struct_free_PRTL(PRTL_t *prtl);
+unsigned long long int struct_memory_PRTL(PRTL_t *prtl, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
@@ -0,0 +1,245 @@
+/** @file pcs_struct_fingerprint.c
+ *  @brief A lossy distinguished-point store, which keeps a short fingerprint of x instead of x.
+ *
+ *	The store is an array of buckets of __FINGERPRINT_BUCKET_SIZE__
+ *	records, chosen by the low bits of x without the trailling zeros. A
+ *	record is the next k bits of x, its fingerprint, followed by the a
+ *	coefficient, on k + f bits rounded up to a byte, and a bucket starts
+ *	with one byte telling its used records. A point whose bucket holds a
+ *	record of the same fingerprint is reported as found, whether or not
+ *	the x coordinates are the same: is_collision then walks both trails
+ *	again and tells the false matches, at the cost of the two trails.
+ *	With b records per bucket on average, a point matches another x with
+ *	probability about b / 2^k.
+ *
+ *	The array is allocated once for the number of points given, and a
+ *	point whose bucket is full is dropped and counted. The x coordinates
+ *	are not kept, so that the points can not be visited by struct_foreach.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp.h>
+#include "pcs_struct_fingerprint.h"
+#include "pcs_elliptic_curve_operations.h"
+
+/** State of one fingerprint store.
+ */
+struct fingerprint
+{
+	uint8_t nb_bits;
+	int fingerprint_bits;
+	uint64_t fingerprint_mask;
+	int record_bytes;
+	int bucket_bits;
+	uint64_t nb_buckets;
+	size_t bucket_bytes;
+	unsigned char *buckets;
+	omp_lock_t *locks;
+	int nb_locks;
+	volatile unsigned long int nb_dropped;
+};
+
+/** Get the number of bits of x that choose the bucket in a store of nb_points records.
+ *
+ *	@brief The fingerprint is taken from the bits of x above these, so
+ *	that x without the trailling zeros needs the sum of both.
+ */
+int fingerprint_bucket_bits(unsigned long int nb_points)
+{
+	int bucket_bits = 0;
+	while(((uint64_t)__FINGERPRINT_BUCKET_SIZE__ << bucket_bits) < nb_points)
+	{
+		bucket_bits++;
+	}
+	return bucket_bits;
+}
+
+/** Create a fingerprint store of nb_points records for points of nb_bits bits.
+ *
+ *	@brief The number of buckets is rounded up to a power of two, and
+ *	there are at most __FINGERPRINT_LOCKS__ locks, one per bucket for a
+ *	small store.
+ */
+fingerprint_t *fingerprint_create(uint8_t nb_bits, int fingerprint_bits, unsigned long int nb_points)
+{
+	int i;
+	fingerprint_t *fp;
+	if(fingerprint_bits < 1 || fingerprint_bits > __FINGERPRINT_MAX_BITS__)
+	{
+		fprintf(stderr, "The fingerprints of x have 1 to %d bits.\n", __FINGERPRINT_MAX_BITS__);
+		exit(1);
+	}
+	fp = malloc(sizeof(fingerprint_t));
+	fp->nb_bits = nb_bits;
+	fp->fingerprint_bits = fingerprint_bits;
+	fp->fingerprint_mask = (1ULL << fingerprint_bits) - 1;
+	fp->record_bytes = (fingerprint_bits + nb_bits + 7) / 8;
+	fp->bucket_bits = fingerprint_bucket_bits(nb_points);
+	fp->nb_buckets = 1ULL << fp->bucket_bits;
+	fp->bucket_bytes = 1 + __FINGERPRINT_BUCKET_SIZE__ * fp->record_bytes;
+	fp->buckets = calloc(fp->nb_buckets, fp->bucket_bytes);
+	if(fp->buckets == NULL)
+	{
+		fprintf(stderr, "Can not allocate a fingerprint store of %lu points.\n", nb_points);
+		exit(1);
+	}
+	fp->nb_locks = (fp->nb_buckets < __FINGERPRINT_LOCKS__) ? fp->nb_buckets : __FINGERPRINT_LOCKS__;
+	fp->locks = malloc(sizeof(omp_lock_t) * fp->nb_locks);
+	for(i = 0; i < fp->nb_locks; i++)
+	{
+		omp_init_lock(&fp->locks[i]);
+	}
+	fp->nb_dropped = 0;
+	return fp;
+}
+
+/** Get the number of points dropped because their bucket was full, since the last reset.
+ *
+ */
+unsigned long int fingerprint_dropped(fingerprint_t *fp)
+{
+	return fp->nb_dropped;
+}
+
+/** Get the size in bytes of a record, a fingerprint and its a coefficient.
+ *
+ */
+int fingerprint_record_bytes(fingerprint_t *fp)
+{
+	return fp->record_bytes;
+}
+
+/** Get the number of records of the store.
+ *
+ */
+unsigned long int fingerprint_slots(fingerprint_t *fp)
+{
+	return fp->nb_buckets * __FINGERPRINT_BUCKET_SIZE__;
+}
+
+static uint64_t fingerprint_of_record(fingerprint_t *fp, const unsigned char *record)
+{
+	uint64_t v = 0;
+	int i;
+	for(i = 0; i < fp->record_bytes && i < 8; i++)
+	{
+		v |= (uint64_t)record[i] << (8 * i);
+	}
+	return v & fp->fingerprint_mask;
+}
+
+/** Search and insert function for the fingerprint store.
+ *
+ *	@brief The bucket is the low bits of xDist and the fingerprint the
+ *	next ones, from its lowest 64 bits.
+ *
+ *  @param[out]	a_out	The a coefficient of the record of the same fingerprint.
+ *  @param[in]	a_in	The a coefficient of the newly added point.
+ *  @param[in]	xDist	The x-coordinate, without the trailling zeros.
+ *  @return 	1 if a record of the same fingerprint was found, 0 otherwise.
+ */
+int struct_add_fingerprint(fingerprint_t *fp, mpz_t a_out, mpz_t a_in, mpz_t xDist)
+{
+	uint64_t x, bucket, print;
+	unsigned char *b, *record;
+	omp_lock_t *lock;
+	mpz_t *value;
+	int i, free_i = -1;
+	if(!preallocation_init_done)
+	{
+		preallocation_init();
+	}
+	value = &(temp_obj[14]);
+
+	x = mpz_get_ui(xDist);
+	bucket = x & (fp->nb_buckets - 1);
+	print = (x >> fp->bucket_bits) & fp->fingerprint_mask;
+	b = fp->buckets + bucket * fp->bucket_bytes;
+	lock = &fp->locks[bucket & (fp->nb_locks - 1)];
+	omp_set_lock(lock);
+	for(i = 0; i < __FINGERPRINT_BUCKET_SIZE__; i++)
+	{
+		record = b + 1 + i * fp->record_bytes;
+		if(!(b[0] & (1 << i)))
+		{
+			if(free_i < 0)
+			{
+				free_i = i;
+			}
+		}
+		else if(fingerprint_of_record(fp, record) == print)
+		{
+			mpz_import(a_out, fp->record_bytes, -1, 1, 0, 0, record);
+			omp_unset_lock(lock);
+			mpz_tdiv_q_2exp(a_out, a_out, fp->fingerprint_bits);
+			return 1;
+		}
+	}
+	if(free_i < 0)
+	{
+		omp_unset_lock(lock);
+		#pragma omp atomic
+		fp->nb_dropped++;
+		return 0;
+	}
+	record = b + 1 + free_i * fp->record_bytes;
+	mpz_mul_2exp(*value, a_in, fp->fingerprint_bits);
+	mpz_add_ui(*value, *value, print);
+	memset(record, 0, fp->record_bytes);
+	mpz_export(record, NULL, -1, 1, 0, 0, *value);
+	b[0] |= 1 << free_i;
+	omp_unset_lock(lock);
+	return 0;
+}
+
+/** Empty the fingerprint store, keeping its memory.
+ *
+ */
+void struct_reset_fingerprint(fingerprint_t *fp)
+{
+	uint64_t i;
+	for(i = 0; i < fp->nb_buckets; i++)
+	{
+		fp->buckets[i * fp->bucket_bytes] = 0;
+	}
+	fp->nb_dropped = 0;
+}
+
+/** Free the fingerprint store.
+ *
+ */
+void struct_free_fingerprint(fingerprint_t *fp)
+{
+	int i;
+	for(i = 0; i < fp->nb_locks; i++)
+	{
+		omp_destroy_lock(&fp->locks[i]);
+	}
+	free(fp->locks);
+	free(fp->buckets);
+	free(fp);
+}
+
+/** Get the memory occupation of the fingerprint store.
+ *
+ *	@brief rate_of_use is the share of the memory in used records, and
+ *	rate_slots the share of the records used.
+ *
+ *  @return 	The memory occupation in bytes.
+ */
+unsigned long long int struct_memory_fingerprint(fingerprint_t *fp, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	unsigned long long int sum;
+	uint64_t i;
+	*nb_points = 0;
+	for(i = 0; i < fp->nb_buckets; i++)
+	{
+		*nb_points += __builtin_popcount(fp->buckets[i * fp->bucket_bytes]);
+	}
+	sum = fp->nb_buckets * fp->bucket_bytes + sizeof(omp_lock_t) * fp->nb_locks;
+	*rate_of_use = ((float)(*nb_points * fp->record_bytes)) / ((float)sum) * 100.0;
+	*rate_slots = ((float)*nb_points) / ((float)(fp->nb_buckets * __FINGERPRINT_BUCKET_SIZE__)) * 100.0;
+	return sum;
+}
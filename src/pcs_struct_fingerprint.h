@@ -0,0 +1,28 @@
+/** @file pcs_struct_fingerprint.h
+ *
+ */
+#ifndef PCS_STRUCT_FINGERPRINT_H
+#define PCS_STRUCT_FINGERPRINT_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs_storage.h"
+
+#define __STRUCT_FINGERPRINT__ 5
+#define __FINGERPRINT_BUCKET_SIZE__ 8
+#define __FINGERPRINT_LOCKS__ 4096
+#define __FINGERPRINT_MAX_BITS__ 32
+
+typedef struct fingerprint fingerprint_t;
+
+int fingerprint_bucket_bits(unsigned long int nb_points);
+fingerprint_t *fingerprint_create(uint8_t nb_bits, int fingerprint_bits, unsigned long int nb_points);
+unsigned long int fingerprint_dropped(fingerprint_t *fp);
+int fingerprint_record_bytes(fingerprint_t *fp);
+unsigned long int fingerprint_slots(fingerprint_t *fp);
+
+int struct_add_fingerprint(fingerprint_t *fp, mpz_t a_out, mpz_t a_in, mpz_t xDist);
+void struct_reset_fingerprint(fingerprint_t *fp);
+void struct_free_fingerprint(fingerprint_t *fp);
+unsigned long long int struct_memory_fingerprint(fingerprint_t *fp, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+#endif
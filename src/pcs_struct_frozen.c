@@ -0,0 +1,543 @@
+/** @file pcs_struct_frozen.c
+ *  @brief A read-only distinguished-point store, written once from a finished run and mapped in memory.
+ *
+ *	The points are indexed by a minimal perfect hash function built with
+ *	the hash-and-displace method (Belazzougui, Botelho and Dietzfelbinger,
+ *	"Hash, displace, and compress", ESA 2009): the keys are spread over
+ *	buckets of about __FROZEN_BUCKET_SIZE__ keys, and the buckets are
+ *	placed from the largest to the smallest, each one with the first
+ *	displacement that sends all its keys to free slots. A bucket of one key
+ *	is placed last, directly in a free slot, whose index is kept instead of
+ *	a displacement. There are exactly as many slots as points.
+ *
+ *	A file holds, in this order:
+ *	- a header (frozen_header_t);
+ *	- at a page boundary, one uint32_t displacement per bucket;
+ *	- at a page boundary, the points in the order of their slots, as an x
+ *	  coordinate without the trailling zeros followed by its a
+ *	  coefficient, both on a fixed number of bytes, least significant byte
+ *	  first.
+ *	The integers of the header and the displacements are written in the
+ *	byte order of the host.
+ *
+ *	Opening a file only maps it: nothing is parsed or allocated. A lookup
+ *	reads one displacement, which takes about one byte per point and stays
+ *	in the cache far longer than the points, and one point.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pcs_struct_frozen.h"
+
+#define __FROZEN_SINGLETON__ 0x80000000U
+#define __FROZEN_MAX_DISPLACEMENT__ (1U << 24)
+#define __FROZEN_MAX_KEY__ 256
+#define __GOLDEN__ 0x9E3779B97F4A7C15ULL
+
+/** Header of a frozen store file.
+ */
+typedef struct
+{
+	char magic[8];
+	uint8_t nb_bits;
+	uint8_t trailling_bits;
+	uint8_t x_bytes;
+	uint8_t a_bytes;
+	uint32_t reserved;
+	uint64_t nb_points;
+	uint64_t nb_buckets;
+	uint64_t seed;
+	uint64_t displacements_offset;
+	uint64_t points_offset;
+}frozen_header_t;
+
+/** A frozen store mapped in memory.
+ */
+struct frozen
+{
+	unsigned char *map;
+	size_t map_size;
+	const frozen_header_t *header;
+	const uint32_t *displacements;
+	const unsigned char *points;
+	size_t point_size;
+};
+
+/** Points of a store being frozen, gathered by struct_foreach.
+ */
+typedef struct
+{
+	unsigned char *points;
+	size_t x_bytes;
+	size_t a_bytes;
+	unsigned long int nb_points;
+	unsigned long int size;
+	int error;
+}frozen_writer_t;
+
+/** Final mixing function of splitmix64.
+ *
+ */
+static inline uint64_t mix64(uint64_t z)
+{
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/** Hash an x coordinate written on x_bytes bytes.
+ *
+ */
+static uint64_t key_hash(const unsigned char *key, size_t x_bytes, uint64_t seed)
+{
+	uint64_t h = seed ^ x_bytes, word;
+	size_t i, len;
+	for(i = 0; i < x_bytes; i += 8)
+	{
+		len = (x_bytes - i < 8) ? x_bytes - i : 8;
+		word = 0;
+		memcpy(&word, key + i, len);
+		h = mix64(h ^ word) + __GOLDEN__;
+	}
+	return mix64(h);
+}
+
+/** Map a hash to [0, range) without a division.
+ *
+ */
+static inline uint32_t reduce(uint64_t h, uint32_t range)
+{
+	return (uint32_t)(((h >> 32) * (uint64_t)range) >> 32);
+}
+
+/** Get the slot of a key of a bucket which is not a singleton.
+ *
+ */
+static inline uint32_t displaced_slot(uint64_t h, uint32_t displacement, uint32_t nb_points)
+{
+	return reduce(mix64(h + (displacement + 1) * __GOLDEN__), nb_points);
+}
+
+/** Copy one stored point, called by struct_foreach.
+ *
+ */
+static void gather_point(mpz_t xDist, mpz_t a, void *arg)
+{
+	frozen_writer_t *writer = arg;
+	unsigned char *point;
+	size_t count;
+	if(writer->nb_points == writer->size)
+	{
+		writer->size = writer->size ? 2 * writer->size : 1024;
+		writer->points = realloc(writer->points, writer->size * (writer->x_bytes + writer->a_bytes));
+	}
+	if(mpz_sgn(xDist) < 0 || mpz_sizeinbase(xDist, 256) > writer->x_bytes || mpz_sgn(a) < 0 || mpz_sizeinbase(a, 256) > writer->a_bytes)
+	{
+		writer->error = 1;
+		return;
+	}
+	point = writer->points + writer->nb_points * (writer->x_bytes + writer->a_bytes);
+	memset(point, 0, writer->x_bytes + writer->a_bytes);
+	mpz_export(point, &count, -1, 1, 0, 0, xDist);
+	mpz_export(point + writer->x_bytes, &count, -1, 1, 0, 0, a);
+	writer->nb_points++;
+}
+
+/** Try to build the perfect hash function with one seed.
+ *
+ *	@param[out]	displacements	The displacement of each bucket.
+ *	@param[out]	slots			The slot of each point.
+ *	@return 	0 on success, 1 if the seed has to be changed.
+ */
+static int build_mph(const unsigned char *points, size_t x_bytes, size_t point_size, uint32_t nb_points, uint32_t nb_buckets, uint64_t seed, uint32_t *displacements, uint32_t *slots)
+{
+	uint64_t *hashes = malloc(sizeof(uint64_t) * nb_points);
+	uint32_t *start = calloc(nb_buckets + 1, sizeof(uint32_t));
+	uint32_t *keys = malloc(sizeof(uint32_t) * nb_points);
+	uint32_t *order = malloc(sizeof(uint32_t) * nb_buckets);
+	uint32_t *by_size, *fill;
+	uint8_t *taken = calloc(nb_points, 1);
+	uint32_t i, j, k, b, size, max_size = 0, d, pos[64], next_free = 0;
+	int error = 0, ok;
+
+	for(i = 0; i < nb_points; i++)
+	{
+		hashes[i] = key_hash(points + (size_t)i * point_size, x_bytes, seed);
+		start[reduce(hashes[i], nb_buckets) + 1]++;
+	}
+	for(b = 0; b < nb_buckets; b++)
+	{
+		if(start[b + 1] > max_size)
+		{
+			max_size = start[b + 1];
+		}
+		start[b + 1] += start[b];
+	}
+	if(max_size > 64)
+	{
+		error = 1;
+		goto end;
+	}
+	fill = calloc(nb_buckets, sizeof(uint32_t));
+	for(i = 0; i < nb_points; i++)
+	{
+		b = reduce(hashes[i], nb_buckets);
+		keys[start[b] + fill[b]++] = i;
+	}
+	free(fill);
+
+	//sort the buckets by decreasing size
+	by_size = calloc(max_size + 2, sizeof(uint32_t));
+	for(b = 0; b < nb_buckets; b++)
+	{
+		by_size[max_size - (start[b + 1] - start[b]) + 1]++;
+	}
+	for(k = 0; k <= max_size; k++)
+	{
+		by_size[k + 1] += by_size[k];
+	}
+	for(b = 0; b < nb_buckets; b++)
+	{
+		order[by_size[max_size - (start[b + 1] - start[b])]++] = b;
+	}
+	free(by_size);
+
+	for(k = 0; k < nb_buckets && !error; k++)
+	{
+		b = order[k];
+		size = start[b + 1] - start[b];
+		if(size == 0)
+		{
+			displacements[b] = 0;
+		}
+		else if(size == 1)
+		{
+			while(taken[next_free])
+			{
+				next_free++;
+			}
+			taken[next_free] = 1;
+			slots[keys[start[b]]] = next_free;
+			displacements[b] = __FROZEN_SINGLETON__ | next_free;
+		}
+		else
+		{
+			for(d = 0; d < __FROZEN_MAX_DISPLACEMENT__; d++)
+			{
+				ok = 1;
+				for(i = 0; i < size && ok; i++)
+				{
+					pos[i] = displaced_slot(hashes[keys[start[b] + i]], d, nb_points);
+					ok = !taken[pos[i]];
+					for(j = 0; j < i && ok; j++)
+					{
+						ok = (pos[j] != pos[i]);
+					}
+				}
+				if(ok)
+				{
+					break;
+				}
+			}
+			if(d == __FROZEN_MAX_DISPLACEMENT__)
+			{
+				error = 1;
+				break;
+			}
+			displacements[b] = d;
+			for(i = 0; i < size; i++)
+			{
+				taken[pos[i]] = 1;
+				slots[keys[start[b] + i]] = pos[i];
+			}
+		}
+	}
+end:
+	free(hashes);
+	free(start);
+	free(keys);
+	free(order);
+	free(taken);
+	return error;
+}
+
+/** Write zeros up to the next page boundary.
+ *
+ *	@return 	The new offset.
+ */
+static uint64_t pad_to_page(FILE *file, uint64_t offset, uint64_t page)
+{
+	while(offset % page != 0)
+	{
+		fputc(0, file);
+		offset++;
+	}
+	return offset;
+}
+
+/** Write the points of the storage structure of a context to a frozen store file.
+ *
+ *	@brief The file is written next to its final path and renamed once
+ *	complete. The points are read with struct_foreach, so the walkers
+ *	should be stopped.
+ *
+ *	@param[out]	nb_points	The number of points written.
+ *	@return 	0 on success, 1 otherwise.
+ */
+int pcs_freeze(pcs_ctx_t *ctx, const char *path, unsigned long int *nb_points)
+{
+	frozen_writer_t writer;
+	frozen_header_t header;
+	FILE *file;
+	char *path_tmp;
+	uint32_t *displacements, *slots;
+	unsigned char *sorted;
+	uint64_t offset, page = sysconf(_SC_PAGESIZE);
+	size_t point_size, a_bits = mpz_sizeinbase(ctx->n, 2);
+	uint32_t i;
+	int tries, error;
+
+	if(a_bits < ctx->nb_bits)
+	{
+		a_bits = ctx->nb_bits;
+	}
+	writer.x_bytes = (mpz_sizeinbase(ctx->E.p, 2) - ctx->trailling_bits + 7) / 8;
+	writer.a_bytes = (a_bits + 7) / 8;
+	writer.points = NULL;
+	writer.nb_points = 0;
+	writer.size = 0;
+	writer.error = 0;
+	point_size = writer.x_bytes + writer.a_bytes;
+	if(writer.x_bytes > __FROZEN_MAX_KEY__ || writer.a_bytes > __FROZEN_MAX_KEY__)
+	{
+		fprintf(stderr, "Numbers too large for a frozen store.\n");
+		return 1;
+	}
+	struct_foreach(&ctx->storage, gather_point, &writer);
+	*nb_points = writer.nb_points;
+	if(writer.error || writer.nb_points >= __FROZEN_SINGLETON__)
+	{
+		fprintf(stderr, "Can not freeze the points of the storage structure.\n");
+		free(writer.points);
+		return 1;
+	}
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, __FROZEN_MAGIC__, 8);
+	header.nb_bits = ctx->nb_bits;
+	header.trailling_bits = ctx->trailling_bits;
+	header.x_bytes = writer.x_bytes;
+	header.a_bytes = writer.a_bytes;
+	header.nb_points = writer.nb_points;
+	header.nb_buckets = (writer.nb_points + __FROZEN_BUCKET_SIZE__ - 1) / __FROZEN_BUCKET_SIZE__;
+	if(header.nb_buckets == 0)
+	{
+		header.nb_buckets = 1;
+	}
+	displacements = calloc(header.nb_buckets, sizeof(uint32_t));
+	slots = malloc(sizeof(uint32_t) * (writer.nb_points + 1));
+	error = 1;
+	for(tries = 0; tries < __FROZEN_MAX_TRIES__ && error; tries++)
+	{
+		header.seed = mix64(__GOLDEN__ * (tries + 1));
+		error = build_mph(writer.points, writer.x_bytes, point_size, writer.nb_points, header.nb_buckets, header.seed, displacements, slots);
+	}
+	if(error)
+	{
+		fprintf(stderr, "Can not build the perfect hash function of the frozen store.\n");
+		free(writer.points);
+		free(displacements);
+		free(slots);
+		return 1;
+	}
+	sorted = malloc(writer.nb_points * point_size + 1);
+	for(i = 0; i < writer.nb_points; i++)
+	{
+		memcpy(sorted + (size_t)slots[i] * point_size, writer.points + (size_t)i * point_size, point_size);
+	}
+	free(writer.points);
+	free(slots);
+
+	header.displacements_offset = (sizeof(header) + page - 1) / page * page;
+	header.points_offset = (header.displacements_offset + header.nb_buckets * sizeof(uint32_t) + page - 1) / page * page;
+
+	path_tmp = malloc(strlen(path) + 5);
+	sprintf(path_tmp, "%s.tmp", path);
+	file = fopen(path_tmp, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Can not write frozen store %s.\n", path);
+		free(path_tmp);
+		free(displacements);
+		free(sorted);
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, file);
+	offset = pad_to_page(file, sizeof(header), page);
+	fwrite(displacements, sizeof(uint32_t), header.nb_buckets, file);
+	pad_to_page(file, offset + header.nb_buckets * sizeof(uint32_t), page);
+	fwrite(sorted, point_size, writer.nb_points, file);
+	error = (fflush(file) != 0 || fsync(fileno(file)) != 0 || ferror(file));
+	fclose(file);
+	free(displacements);
+	free(sorted);
+	if(error || rename(path_tmp, path) != 0)
+	{
+		fprintf(stderr, "Can not write frozen store %s.\n", path);
+		unlink(path_tmp);
+		free(path_tmp);
+		return 1;
+	}
+	free(path_tmp);
+	return 0;
+}
+
+/** Map a frozen store file in memory.
+ *
+ *	@return 	The store, or NULL if the file can not be read.
+ */
+frozen_t *frozen_open(const char *path)
+{
+	const frozen_header_t *header;
+	frozen_t *frozen;
+	struct stat st;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if(fd < 0)
+	{
+		fprintf(stderr, "Can not open file %s.\n", path);
+		return NULL;
+	}
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(frozen_header_t))
+	{
+		fprintf(stderr, "File %s is not a frozen store.\n", path);
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+	{
+		fprintf(stderr, "Can not map file %s.\n", path);
+		return NULL;
+	}
+	header = map;
+	if(memcmp(header->magic, __FROZEN_MAGIC__, 8) != 0 || header->nb_buckets == 0
+		|| header->displacements_offset + header->nb_buckets * sizeof(uint32_t) > header->points_offset
+		|| header->points_offset + header->nb_points * (header->x_bytes + header->a_bytes) > (uint64_t)st.st_size)
+	{
+		fprintf(stderr, "File %s is not a frozen store.\n", path);
+		munmap(map, st.st_size);
+		return NULL;
+	}
+	frozen = malloc(sizeof(frozen_t));
+	frozen->map = map;
+	frozen->map_size = st.st_size;
+	frozen->header = header;
+	frozen->displacements = (const uint32_t *)(frozen->map + header->displacements_offset);
+	frozen->points = frozen->map + header->points_offset;
+	frozen->point_size = header->x_bytes + header->a_bytes;
+	return frozen;
+}
+
+/** Get the settings of the run a frozen store was written from.
+ *
+ */
+void frozen_settings(frozen_t *frozen, uint8_t *nb_bits, uint8_t *trailling_bits)
+{
+	*nb_bits = frozen->header->nb_bits;
+	*trailling_bits = frozen->header->trailling_bits;
+}
+
+/** Search a point.
+ *
+ *  @brief The store is read-only: a point that is not found is not added.
+ *
+ *  @param[out]	a_out	The a coefficient of the found point.
+ *  @param[in]	xDist	The x coordinate, without the trailling zeros.
+ *  @return 	1 if the point was found, 0 otherwise.
+ */
+int struct_add_frozen(frozen_t *frozen, mpz_t a_out, mpz_t xDist)
+{
+	const frozen_header_t *header = frozen->header;
+	const unsigned char *point;
+	unsigned char key[__FROZEN_MAX_KEY__];
+	uint64_t h;
+	uint32_t displacement, slot;
+	size_t count;
+
+	if(header->nb_points == 0 || mpz_sizeinbase(xDist, 256) > header->x_bytes)
+	{
+		return 0;
+	}
+	memset(key, 0, header->x_bytes);
+	mpz_export(key, &count, -1, 1, 0, 0, xDist);
+	h = key_hash(key, header->x_bytes, header->seed);
+	displacement = frozen->displacements[reduce(h, header->nb_buckets)];
+	if(displacement & __FROZEN_SINGLETON__)
+	{
+		slot = displacement & ~__FROZEN_SINGLETON__;
+	}
+	else
+	{
+		slot = displaced_slot(h, displacement, header->nb_points);
+	}
+	point = frozen->points + (size_t)slot * frozen->point_size;
+	if(memcmp(point, key, header->x_bytes) != 0)
+	{
+		return 0;
+	}
+	mpz_import(a_out, header->a_bytes, -1, 1, 0, 0, point + header->x_bytes);
+	return 1;
+}
+
+/** Call a function on each point of a frozen store, in the order of the slots.
+ *
+ */
+void struct_foreach_frozen(frozen_t *frozen, struct_foreach_fn_t fn, void *arg)
+{
+	const frozen_header_t *header = frozen->header;
+	const unsigned char *point;
+	mpz_t xDist, a;
+	uint64_t i;
+	mpz_inits(xDist, a, NULL);
+	for(i = 0; i < header->nb_points; i++)
+	{
+		point = frozen->points + i * frozen->point_size;
+		mpz_import(xDist, header->x_bytes, -1, 1, 0, 0, point);
+		mpz_import(a, header->a_bytes, -1, 1, 0, 0, point + header->x_bytes);
+		fn(xDist, a, arg);
+	}
+	mpz_clears(xDist, a, NULL);
+}
+
+/** Unmap a frozen store.
+ *
+ */
+void struct_free_frozen(frozen_t *frozen)
+{
+	munmap(frozen->map, frozen->map_size);
+	free(frozen);
+}
+
+/** Get the memory occupation of a frozen store.
+ *
+ *  @return 	The size of the file in bytes.
+ */
+unsigned long long int struct_memory_frozen(frozen_t *frozen, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	const frozen_header_t *header = frozen->header;
+	*nb_points = header->nb_points;
+	*rate_of_use = ((float)(header->nb_points * frozen->point_size)) / ((float)frozen->map_size) * 100.0;
+	*rate_slots = 100.0;
+	printf("\t\tPoints: %lu\n", *nb_points);
+	printf("\t\tBuckets: %lu\n", (unsigned long int)header->nb_buckets);
+	return frozen->map_size;
+}
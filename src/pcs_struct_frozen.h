@@ -0,0 +1,27 @@
+/** @file pcs_struct_frozen.h
+ *
+ */
+#ifndef PCS_STRUCT_FROZEN_H
+#define PCS_STRUCT_FROZEN_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs.h"
+#include "pcs_storage.h"
+
+#define __STRUCT_FROZEN__ 4
+#define __FROZEN_MAGIC__ "PCSFRZ01"
+#define __FROZEN_BUCKET_SIZE__ 4
+#define __FROZEN_MAX_TRIES__ 50
+
+typedef struct frozen frozen_t;
+
+int pcs_freeze(pcs_ctx_t *ctx, const char *path, unsigned long int *nb_points);
+frozen_t *frozen_open(const char *path);
+void frozen_settings(frozen_t *frozen, uint8_t *nb_bits, uint8_t *trailling_bits);
+
+int struct_add_frozen(frozen_t *frozen, mpz_t a_out, mpz_t xDist);
+void struct_foreach_frozen(frozen_t *frozen, struct_foreach_fn_t fn, void *arg);
+void struct_free_frozen(frozen_t *frozen);
+unsigned long long int struct_memory_frozen(frozen_t *frozen, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+#endif
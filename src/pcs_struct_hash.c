@@ -15,26 +15,35 @@
 
 #define __PI_NUMERATOR__ 355  	// correct to three digits
 #define __PI_DENOMINATOR__ 113	// correct to three digits
+#define __HASH_MAX_TABLE_SIZE__ (1UL << 24)	// the table is chained, it can hold more points than its size
 
-static uint8_t hash_type;
-static hashUNIX_t **table;
-static unsigned long int table_size;
-static omp_lock_t *table_locks;
-static omp_lock_t memory_alloc_lock;
-static unsigned long long int memory_alloc;
-/***Memory limiting feature is turned off
-static unsigned long long int memory_limit;
- ***/
+/** State of one hash table.
+ */
+struct hash
+{
+	uint8_t hash_type;
+	hashUNIX_t **table;
+	unsigned long int table_size;
+	omp_lock_t *table_locks;
+	omp_lock_t memory_alloc_lock;
+	unsigned long long int memory_alloc;
+	int nb_threads;
+	/***Memory limiting feature is turned off
+	unsigned long long int memory_limit;
+	 ***/
+};
 
 
 /** Calculate the hash table recommended size.
  *
  *	@brief The recommended size corresponds to the expected number
  *	of stored points. This function is used only if the size is not specified
- *	(using the level parameter).
+ *	(using the level parameter). On the large curves, where the expected
+ *	number of points is far beyond the memory of a machine, it is capped to
+ *	__HASH_MAX_TABLE_SIZE__.
  *
  */
-void set_table_size(mpz_t n, uint8_t trailling_bits)
+void set_table_size(hash_t *h_t, mpz_t n, uint8_t trailling_bits)
 {
 	unsigned long long int distinguished;
 	mpz_t table_size_inter;
@@ -44,53 +53,56 @@ void set_table_size(mpz_t n, uint8_t trailling_bits)
 	mpz_sqrt(table_size_inter, table_size_inter);
 	distinguished = (unsigned long int)pow(2, trailling_bits);
 	mpz_tdiv_q_ui(table_size_inter, table_size_inter, distinguished);
-	table_size = mpz_get_ui(table_size_inter);
+	h_t->table_size = (mpz_cmp_ui(table_size_inter, __HASH_MAX_TABLE_SIZE__) > 0) ? __HASH_MAX_TABLE_SIZE__ : mpz_get_ui(table_size_inter);
 	mpz_clear(table_size_inter);
 }
 
 /** Initialize the hash table and allocate memory.
  *
  */
-void struct_init_hash(uint8_t hash_type_init, mpz_t n, uint8_t trailling_bits, uint8_t level)
+hash_t *struct_init_hash(uint8_t hash_type_init, mpz_t n, uint8_t trailling_bits, int _nb_threads, uint8_t level)
 {
 	unsigned long int i;
-	hash_type = hash_type_init;
+	hash_t *h_t = malloc(sizeof(hash_t));
+	h_t->hash_type = hash_type_init;
+	h_t->nb_threads = _nb_threads;
     if(level != 7)
     {
-        table_size = pow(2, level);
+        h_t->table_size = pow(2, level);
     }
     else
     {
-        set_table_size(n, trailling_bits);
+        set_table_size(h_t, n, trailling_bits);
     }
 
-	printf("\t\ttable_size: %lu\n",table_size);
-	table = malloc(sizeof(*table) * table_size); //i.e. sizeof(hashUNIX_t *)
-	table_locks = malloc(sizeof(omp_lock_t) * table_size);
-    omp_init_lock(&memory_alloc_lock);
+	printf("\t\ttable_size: %lu\n",h_t->table_size);
+	h_t->table = malloc(sizeof(*h_t->table) * h_t->table_size); //i.e. sizeof(hashUNIX_t *)
+	h_t->table_locks = malloc(sizeof(omp_lock_t) * h_t->table_size);
+    omp_init_lock(&h_t->memory_alloc_lock);
 	/***Memory limiting feature is turned off
-    memory_limit = 100000000;
+    h_t->memory_limit = 100000000;
 	 ***/
-    memory_alloc = 0LL;
-    memory_alloc += sizeof(*table) * table_size;
-	memory_alloc += sizeof(omp_lock_t) * table_size;
-	for(i = 0; i < table_size; i++)
+    h_t->memory_alloc = 0LL;
+    h_t->memory_alloc += sizeof(*h_t->table) * h_t->table_size;
+	h_t->memory_alloc += sizeof(omp_lock_t) * h_t->table_size;
+	for(i = 0; i < h_t->table_size; i++)
 	{
-		table[i] = NULL;
-		omp_init_lock(&table_locks[i]);
+		h_t->table[i] = NULL;
+		omp_init_lock(&h_t->table_locks[i]);
 	}
+	return h_t;
 }
 
-unsigned long int get_hash(char *xDist)
+unsigned long int get_hash(hash_t *h_t, char *xDist)
 {
-	switch(hash_type)
+	switch(h_t->hash_type)
 	{
 		default: 
-			return (get_hash_UNIX(xDist) % table_size);
+			return (get_hash_UNIX(xDist) % h_t->table_size);
 	}
 }
 
-int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[])
+int struct_add_hash(hash_t *h_t, mpz_t a_out, mpz_t a_in, char xDist[])
 {
 	unsigned long int h = 0;
 	hashUNIX_t *new;
@@ -98,9 +110,9 @@ int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[])
 	hashUNIX_t *next;
 	uint8_t retval = 0;
 	
-	h = get_hash(xDist);
-	omp_set_lock(&table_locks[h]);
-	next = table[h];
+	h = get_hash(h_t, xDist);
+	omp_set_lock(&h_t->table_locks[h]);
+	next = h_t->table[h];
     while(next != NULL && next-> key != NULL && strncmp(xDist, next->key, strlen(xDist)) > 0)
 	{
 		last = next;
@@ -115,7 +127,7 @@ int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[])
 	else
 	{
 		/***Memory limiting feature is turned off
-		if(memory_alloc < memory_limit)
+		if(h_t->memory_alloc < h_t->memory_limit)
         {
 		 ***/
             new = malloc(sizeof(hashUNIX_t));
@@ -124,10 +136,10 @@ int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[])
             new->a_ = mpz_get_str(new->a_, 62, a_in);
             new->next = NULL;
 
-            if(next == table[h]) //add at the beginning
+            if(next == h_t->table[h]) //add at the beginning
             {
                 new->next = next;
-                table[h] = new;
+                h_t->table[h] = new;
             }
             else
             {
@@ -137,26 +149,78 @@ int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[])
                 }
                 last->next = new;
             }
-            omp_set_lock(&memory_alloc_lock);
-            memory_alloc += strlen(new->key) + 1;
-            memory_alloc += strlen(new->a_) + 1;
-            memory_alloc += sizeof(hashUNIX_t);
-            omp_unset_lock(&memory_alloc_lock);
+            omp_set_lock(&h_t->memory_alloc_lock);
+            h_t->memory_alloc += strlen(new->key) + 1;
+            h_t->memory_alloc += strlen(new->a_) + 1;
+            h_t->memory_alloc += sizeof(hashUNIX_t);
+            omp_unset_lock(&h_t->memory_alloc_lock);
         //}
 	}
-	omp_unset_lock(&table_locks[h]);
+	omp_unset_lock(&h_t->table_locks[h]);
 	return retval;
 }
-void struct_free_hash(void)
+/** Empty the hash table without freeing it.
+ *
+ *	@brief The slots are cleared in parallel. The table and its locks
+ *	are kept, so that the table can be refilled right away.
+ *
+ */
+void struct_reset_hash(hash_t *h_t)
+{
+	long int i;
+	hashUNIX_t *last;
+	hashUNIX_t *next;
+	#pragma omp parallel for private(last, next) num_threads(h_t->nb_threads)
+	for(i = 0; i < (long int)h_t->table_size; i++)
+	{
+		next = h_t->table[i];
+		while(next != NULL)
+		{
+			free(next->key);
+			free(next->a_);
+			last = next;
+			next = next->next;
+			free(last);
+		}
+		h_t->table[i] = NULL;
+	}
+	h_t->memory_alloc = sizeof(*h_t->table) * h_t->table_size;
+	h_t->memory_alloc += sizeof(omp_lock_t) * h_t->table_size;
+}
+
+/** Call a function on each point of the hash table.
+ *
+ */
+void struct_foreach_hash(hash_t *h_t, struct_foreach_fn_t fn, void *arg)
+{
+	unsigned long int i;
+	hashUNIX_t *next;
+	mpz_t xDist, a;
+	mpz_inits(xDist, a, NULL);
+	for(i = 0; i < h_t->table_size; i++)
+	{
+		omp_set_lock(&h_t->table_locks[i]);
+		for(next = h_t->table[i]; next != NULL; next = next->next)
+		{
+			mpz_set_str(xDist, next->key, 16);
+			mpz_set_str(a, next->a_, 62);
+			fn(xDist, a, arg);
+		}
+		omp_unset_lock(&h_t->table_locks[i]);
+	}
+	mpz_clears(xDist, a, NULL);
+}
+
+void struct_free_hash(hash_t *h_t)
 {
 	unsigned long int i;
 	hashUNIX_t *last;
 	hashUNIX_t *next;
-    omp_destroy_lock(&memory_alloc_lock);
-	for(i = 0; i < table_size; i++)
+    omp_destroy_lock(&h_t->memory_alloc_lock);
+	for(i = 0; i < h_t->table_size; i++)
 	{
-		next = table[i];
-		omp_destroy_lock(&table_locks[i]);
+		next = h_t->table[i];
+		omp_destroy_lock(&h_t->table_locks[i]);
 		while(next != NULL)
 		{
 			free(next->key);
@@ -166,8 +230,9 @@ void struct_free_hash(void)
 			free(last);
 		}
 	}
-	free(table);
-	free(table_locks);
+	free(h_t->table);
+	free(h_t->table_locks);
+	free(h_t);
 }
 
 unsigned long long int struct_memory_hash_rec(hashUNIX_t *it, unsigned long int *nb_points, int *link)
@@ -185,7 +250,7 @@ unsigned long long int struct_memory_hash_rec(hashUNIX_t *it, unsigned long int
 	return (sum + struct_memory_hash_rec(it->next, nb_points, link));
 }
 
-unsigned long long int struct_memory_hash(unsigned long int *nb_points, float *rate_of_use, float *rate_slots) 
+unsigned long long int struct_memory_hash(hash_t *h_t, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
 {
 	unsigned long long int sum = 0;
 	unsigned long long int lost = 0;
@@ -193,14 +258,14 @@ unsigned long long int struct_memory_hash(unsigned long int *nb_points, float *r
 	unsigned long int empty_slots = 0;
 	*nb_points = 0;
     int link;
-    sum += sizeof(*table) * table_size;
-	sum += sizeof(omp_lock_t) * table_size;
-	for(i = 0; i < table_size; i++)
+    sum += sizeof(*h_t->table) * h_t->table_size;
+	sum += sizeof(omp_lock_t) * h_t->table_size;
+	for(i = 0; i < h_t->table_size; i++)
 	{
         link = 0;
-		if(table[i] == NULL)
+		if(h_t->table[i] == NULL)
 		{
-			lost += sizeof(*table);
+			lost += sizeof(*h_t->table);
 			lost += sizeof(omp_lock_t);
 			empty_slots++;
 		}
@@ -209,17 +274,17 @@ unsigned long long int struct_memory_hash(unsigned long int *nb_points, float *r
             link = 1;
 			(*nb_points)++;
 			sum += sizeof(hashUNIX_t);
-			sum += strlen(table[i]->key) + 1;
-			sum += strlen(table[i]->a_) + 1;
-			if(table[i]->next != NULL)
-				sum += struct_memory_hash_rec(table[i]->next, nb_points, &link);
+			sum += strlen(h_t->table[i]->key) + 1;
+			sum += strlen(h_t->table[i]->a_) + 1;
+			if(h_t->table[i]->next != NULL)
+				sum += struct_memory_hash_rec(h_t->table[i]->next, nb_points, &link);
 		}
         //link_long[link]++;
 	}
      //for(i = 0; i < 60; i++)
         //printf("long %d: %d\n",i,link_long[i]);
 	*rate_of_use = (1.0 - ((float)lost) / ((float)sum)) * 100.0;
-    *rate_slots = (1.0 - ((float)empty_slots) / ((float)table_size)) * 100.0;
+    *rate_slots = (1.0 - ((float)empty_slots) / ((float)h_t->table_size)) * 100.0;
     printf("\t\tPoints: %lu\n", *nb_points);
 	printf("\t\tEmpty slots: %lu\n", empty_slots);
 	return sum;
@@ -7,6 +7,7 @@
 #include <omp.h>
 #include <gmp.h>
 #include <inttypes.h>
+#include "pcs_storage.h"
 
 typedef struct hashUNIX
 {
@@ -16,7 +17,11 @@ typedef struct hashUNIX
 	
 }hashUNIX_t;
 
-void struct_init_hash(uint8_t hash_type_init, mpz_t n, uint8_t trailling_bits, uint8_t level);
-int struct_add_hash(mpz_t a_out, mpz_t a_in, char xDist[]);
-void struct_free_hash(void);
-unsigned long long int struct_memory_hash(unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+typedef struct hash hash_t;
+
+hash_t *struct_init_hash(uint8_t hash_type_init, mpz_t n, uint8_t trailling_bits, int nb_threads, uint8_t level);
+int struct_add_hash(hash_t *h_t, mpz_t a_out, mpz_t a_in, char xDist[]);
+void struct_reset_hash(hash_t *h_t);
+void struct_foreach_hash(hash_t *h_t, struct_foreach_fn_t fn, void *arg);
+void struct_free_hash(hash_t *h_t);
+unsigned long long int struct_memory_hash(hash_t *h_t, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
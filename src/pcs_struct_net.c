@@ -0,0 +1,776 @@
+/** @file pcs_struct_net.c
+ *  @brief A distinguished-point "store" which sends the points to a coordinator over TCP.
+ *
+ *	A worker walks locally and never looks points up: each walker thread
+ *	appends its distinguished points to its own batch, and sends the
+ *	batch in one frame when it is full or when its oldest point has
+ *	waited for __NET_FLUSH_US__. The coordinator owns the real storage
+ *	structure and looks for collisions.
+ *
+ *	A frame is a type byte and a 32-bit payload length, followed by the
+ *	payload. All integers are little-endian. A frame of points holds the
+ *	problem id, the worker id, the number of points, the flags and the
+ *	widths in bytes of x and a, then the points. Uncompressed points are
+ *	fixed-width. Compressed points are sorted by x, and x is written as
+ *	the difference with the previous x in a base-128 varint, which saves
+ *	about log2 of the batch size bits per point; a is random, so it is
+ *	always written on a fixed width.
+ *
+ *	A thread of the worker reads the frames of the coordinator: a new
+ *	problem, the end of a problem or the end of the session. While it
+ *	waits for them, it sends the batches whose oldest point is due, so
+ *	that a batch is sent in time even if its walker reaches no other
+ *	distinguished point. A batch is locked by its walker while it adds a
+ *	point, and by the reader while it sends it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <omp.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "pcs_struct_net.h"
+
+#define __NET_NB_NUMBERS__ (8 + 2 * 20)
+#define __NET_POINTS_HEADER_SIZE__ 15
+
+/** Distinguished points of one walker thread, waiting to be sent.
+ */
+typedef struct
+{
+	mpz_t *x;
+	mpz_t *a;
+	mpz_t **order;
+	int count;
+	unsigned long long int first_us;
+	unsigned char *frame;
+	size_t frame_size;
+	pthread_mutex_t lock;
+}net_batch_t;
+
+/** Connection of a worker to the coordinator.
+ */
+struct net
+{
+	int fd;
+	int nb_threads;
+	int batch_size;
+	int compress;
+	net_batch_t *batches;
+	pthread_mutex_t send_lock;
+	pthread_t reader;
+	/* Written by the reader thread, under lock */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	unsigned char *problem;
+	uint32_t problem_len;
+	uint32_t stopped_id;
+	int closed;
+	/* Problem being solved */
+	uint32_t problem_id;
+	uint32_t worker;
+	int x_bytes;
+	int a_bytes;
+	volatile uint32_t stop;
+	unsigned long long int nb_points;
+	unsigned long long int nb_bytes;
+};
+
+static unsigned long long int now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long int)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+static void put_u32(unsigned char *buffer, uint32_t v)
+{
+	buffer[0] = v;
+	buffer[1] = v >> 8;
+	buffer[2] = v >> 16;
+	buffer[3] = v >> 24;
+}
+
+static uint32_t get_u32(const unsigned char *buffer)
+{
+	return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8) | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+/** Write a number on a fixed number of bytes.
+ *
+ */
+static void put_number(unsigned char *buffer, size_t *pos, mpz_t v, int nb_bytes)
+{
+	size_t count = 0;
+	memset(buffer + *pos, 0, nb_bytes);
+	mpz_export(buffer + *pos, &count, -1, 1, -1, 0, v);
+	*pos += nb_bytes;
+}
+
+/** Write a number in base-128 varint, low groups first.
+ *
+ */
+static void put_varint(unsigned char *buffer, size_t *pos, mpz_t v, mpz_t tmp)
+{
+	mpz_set(tmp, v);
+	while(mpz_cmp_ui(tmp, 0x7f) > 0)
+	{
+		buffer[(*pos)++] = (mpz_getlimbn(tmp, 0) & 0x7f) | 0x80;
+		mpz_tdiv_q_2exp(tmp, tmp, 7);
+	}
+	buffer[(*pos)++] = mpz_get_ui(tmp);
+}
+
+/** Read a base-128 varint.
+ *
+ *	@return 	0 if the buffer ends before the number.
+ */
+static int get_varint(const unsigned char *buffer, size_t len, size_t *pos, mpz_t v, mpz_t tmp)
+{
+	unsigned int shift = 0;
+	unsigned char c;
+	mpz_set_ui(v, 0);
+	do
+	{
+		if(*pos >= len)
+		{
+			return 0;
+		}
+		c = buffer[(*pos)++];
+		mpz_set_ui(tmp, c & 0x7f);
+		mpz_mul_2exp(tmp, tmp, shift);
+		mpz_ior(v, v, tmp);
+		shift += 7;
+	}while(c & 0x80);
+	return 1;
+}
+
+static int send_all(int fd, const unsigned char *buffer, size_t len)
+{
+	ssize_t r;
+	while(len > 0)
+	{
+		r = send(fd, buffer, len, MSG_NOSIGNAL);
+		if(r < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(r <= 0)
+		{
+			return 0;
+		}
+		buffer += r;
+		len -= r;
+	}
+	return 1;
+}
+
+static int recv_all(int fd, unsigned char *buffer, size_t len)
+{
+	ssize_t r;
+	while(len > 0)
+	{
+		r = recv(fd, buffer, len, 0);
+		if(r < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if(r <= 0)
+		{
+			return 0;
+		}
+		buffer += r;
+		len -= r;
+	}
+	return 1;
+}
+
+/** Send one frame.
+ *
+ *	@return 	1 on success, 0 if the connection is lost.
+ */
+int net_send_frame(int fd, uint8_t type, const unsigned char *payload, uint32_t len)
+{
+	unsigned char header[__NET_FRAME_HEADER_SIZE__];
+	header[0] = type;
+	put_u32(header + 1, len);
+	return send_all(fd, header, __NET_FRAME_HEADER_SIZE__) && (len == 0 || send_all(fd, payload, len));
+}
+
+/** Find the first complete frame of a buffer.
+ *
+ *	@return 	The size of the frame, header included, or 0 if the
+ *				buffer does not hold a complete frame yet.
+ */
+size_t net_parse_frame(const unsigned char *buffer, size_t len, uint8_t *type, const unsigned char **payload, uint32_t *payload_len)
+{
+	uint32_t l;
+	if(len < __NET_FRAME_HEADER_SIZE__)
+	{
+		return 0;
+	}
+	l = get_u32(buffer + 1);
+	if(len - __NET_FRAME_HEADER_SIZE__ < l)
+	{
+		return 0;
+	}
+	*type = buffer[0];
+	*payload = buffer + __NET_FRAME_HEADER_SIZE__;
+	*payload_len = l;
+	return __NET_FRAME_HEADER_SIZE__ + l;
+}
+
+/** Open a listening socket on all the interfaces.
+ *
+ *	@return 	The socket, or -1 if the port can not be bound.
+ */
+int net_listen(int port)
+{
+	struct sockaddr_in addr;
+	int one = 1;
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if(fd < 0)
+	{
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_ANY);
+	addr.sin_port = htons(port);
+	if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/** Send a frame holding only a problem id.
+ *
+ */
+int net_send_id(int fd, uint8_t type, uint32_t problem_id)
+{
+	unsigned char payload[4];
+	put_u32(payload, problem_id);
+	return net_send_frame(fd, type, payload, 4);
+}
+
+/** Send a problem to a worker.
+ *
+ *	@brief The numbers are sent in hexadecimal, each followed by a zero byte.
+ */
+int net_send_problem(int fd, uint32_t problem_id, uint32_t worker, elliptic_curve_t E, mpz_t n, point_t P, point_t Q, mpz_t *A, mpz_t *B, uint8_t nb_bits, uint8_t trailling_bits, uint8_t level)
+{
+	mpz_ptr numbers[__NET_NB_NUMBERS__] = {E.A, E.B, E.p, n, P.x, P.y, Q.x, Q.y};
+	unsigned char *payload;
+	size_t len = 12;
+	int i, ret;
+	for(i = 0; i < 20; i++)
+	{
+		numbers[8 + 2 * i] = A[i];
+		numbers[9 + 2 * i] = B[i];
+	}
+	for(i = 0; i < __NET_NB_NUMBERS__; i++)
+	{
+		len += mpz_sizeinbase(numbers[i], 16) + 2;
+	}
+	payload = malloc(len);
+	put_u32(payload, problem_id);
+	put_u32(payload + 4, worker);
+	payload[8] = nb_bits;
+	payload[9] = trailling_bits;
+	payload[10] = level;
+	payload[11] = E.field;
+	len = 12;
+	for(i = 0; i < __NET_NB_NUMBERS__; i++)
+	{
+		mpz_get_str((char *)payload + len, 16, numbers[i]);
+		len += strlen((char *)payload + len) + 1;
+	}
+	ret = net_send_frame(fd, __NET_FRAME_PROBLEM__, payload, len);
+	free(payload);
+	return ret;
+}
+
+/** Decode a frame of points.
+ *
+ *	@param[in]	fn	The function called for each point.
+ *	@return 	The number of points, or -1 if the frame is malformed.
+ */
+int net_decode_points(const unsigned char *payload, uint32_t len, uint32_t *problem_id, uint32_t *worker, net_point_fn_t fn, void *arg)
+{
+	mpz_t x, delta, a, tmp;
+	uint32_t count, i;
+	uint8_t flags;
+	int x_bytes, a_bytes, ret;
+	size_t pos = __NET_POINTS_HEADER_SIZE__;
+
+	if(len < __NET_POINTS_HEADER_SIZE__)
+	{
+		return -1;
+	}
+	*problem_id = get_u32(payload);
+	*worker = get_u32(payload + 4);
+	count = get_u32(payload + 8);
+	flags = payload[12];
+	x_bytes = payload[13];
+	a_bytes = payload[14];
+	if(!(flags & __NET_COMPRESSED__) && (x_bytes + a_bytes == 0 || (len - pos) / (x_bytes + a_bytes) < count))
+	{
+		return -1;
+	}
+	mpz_inits(x, delta, a, tmp, NULL);
+	ret = count;
+	for(i = 0; i < count; i++)
+	{
+		if(flags & __NET_COMPRESSED__)
+		{
+			if(!get_varint(payload, len, &pos, delta, tmp) || len - pos < (size_t)a_bytes)
+			{
+				ret = -1;
+				break;
+			}
+			mpz_add(x, x, delta);
+			mpz_import(a, a_bytes, -1, 1, -1, 0, payload + pos);
+			pos += a_bytes;
+		}
+		else
+		{
+			mpz_import(x, x_bytes, -1, 1, -1, 0, payload + pos);
+			pos += x_bytes;
+			mpz_import(a, a_bytes, -1, 1, -1, 0, payload + pos);
+			pos += a_bytes;
+		}
+		fn(x, a, arg);
+	}
+	mpz_clears(x, delta, a, tmp, NULL);
+	return ret;
+}
+
+static int compare_x(const void *p1, const void *p2)
+{
+	return mpz_cmp(**(mpz_t * const *)p1, **(mpz_t * const *)p2);
+}
+
+/** Send the batch of a walker thread, and empty it.
+ *
+ *	@brief If the connection is lost, the run is stopped.
+ */
+static void net_flush(net_t *net, net_batch_t *b)
+{
+	size_t pos = __NET_POINTS_HEADER_SIZE__;
+	mpz_t *prev, *tmp, *delta;
+	int i, j;
+
+	put_u32(b->frame, net->problem_id);
+	put_u32(b->frame + 4, net->worker);
+	put_u32(b->frame + 8, b->count);
+	b->frame[12] = net->compress ? __NET_COMPRESSED__ : 0;
+	b->frame[13] = net->x_bytes;
+	b->frame[14] = net->a_bytes;
+	if(net->compress)
+	{
+		//the two spare numbers at the end of the batch
+		tmp = &b->x[net->batch_size];
+		delta = &b->a[net->batch_size];
+		for(i = 0; i < b->count; i++)
+		{
+			b->order[i] = &b->x[i];
+		}
+		qsort(b->order, b->count, sizeof(mpz_t *), compare_x);
+		prev = NULL;
+		for(i = 0; i < b->count; i++)
+		{
+			j = b->order[i] - b->x;
+			if(prev == NULL)
+			{
+				mpz_set(*delta, b->x[j]);
+			}
+			else
+			{
+				mpz_sub(*delta, b->x[j], *prev);
+			}
+			put_varint(b->frame, &pos, *delta, *tmp);
+			put_number(b->frame, &pos, b->a[j], net->a_bytes);
+			prev = &b->x[j];
+		}
+	}
+	else
+	{
+		for(i = 0; i < b->count; i++)
+		{
+			put_number(b->frame, &pos, b->x[i], net->x_bytes);
+			put_number(b->frame, &pos, b->a[i], net->a_bytes);
+		}
+	}
+	pthread_mutex_lock(&net->send_lock);
+	if(!net_send_frame(net->fd, __NET_FRAME_POINTS__, b->frame, pos))
+	{
+		net->stop = 1;
+	}
+	net->nb_points += b->count;
+	net->nb_bytes += pos + __NET_FRAME_HEADER_SIZE__;
+	pthread_mutex_unlock(&net->send_lock);
+	b->count = 0;
+}
+
+/** Send the batches whose oldest point has waited for __NET_FLUSH_US__.
+ *
+ */
+static void net_flush_due(net_t *net)
+{
+	net_batch_t *b;
+	unsigned long long int t = now_us();
+	int i;
+	for(i = 0; i < net->nb_threads; i++)
+	{
+		b = &net->batches[i];
+		pthread_mutex_lock(&b->lock);
+		if(b->count > 0 && t - b->first_us >= __NET_FLUSH_US__)
+		{
+			net_flush(net, b);
+		}
+		pthread_mutex_unlock(&b->lock);
+	}
+}
+
+/** Read the frames of the coordinator until the connection is closed.
+ *
+ *	@brief The batches that are due are sent between the frames, the
+ *	connection being polled every half of __NET_FLUSH_US__.
+ */
+static void *net_reader(void *arg)
+{
+	net_t *net = arg;
+	unsigned char header[__NET_FRAME_HEADER_SIZE__];
+	unsigned char *payload;
+	uint32_t len;
+	struct pollfd pfd;
+	int bye = 0, ready;
+
+	pfd.fd = net->fd;
+	pfd.events = POLLIN;
+	while(!bye)
+	{
+		ready = poll(&pfd, 1, __NET_FLUSH_US__ / 2000);
+		net_flush_due(net);
+		if(ready == 0 || (ready < 0 && errno == EINTR))
+		{
+			continue;
+		}
+		if(ready < 0 || !recv_all(net->fd, header, __NET_FRAME_HEADER_SIZE__))
+		{
+			break;
+		}
+		len = get_u32(header + 1);
+		payload = malloc(len + 1);
+		if(!recv_all(net->fd, payload, len))
+		{
+			free(payload);
+			break;
+		}
+		pthread_mutex_lock(&net->lock);
+		switch(header[0])
+		{
+			case __NET_FRAME_PROBLEM__:
+				free(net->problem);
+				net->problem = payload;
+				net->problem_len = len;
+				payload = NULL;
+				//a new problem means that the current one is over
+				net->stop = 1;
+				break;
+			case __NET_FRAME_STOP__:
+				if(len >= 4)
+				{
+					net->stopped_id = get_u32(payload);
+					if(net->stopped_id == net->problem_id)
+					{
+						net->stop = 1;
+					}
+				}
+				break;
+			case __NET_FRAME_BYE__:
+				bye = 1;
+				break;
+		}
+		pthread_cond_broadcast(&net->cond);
+		pthread_mutex_unlock(&net->lock);
+		free(payload);
+	}
+	pthread_mutex_lock(&net->lock);
+	net->closed = 1;
+	net->stop = 1;
+	pthread_cond_broadcast(&net->cond);
+	pthread_mutex_unlock(&net->lock);
+	return NULL;
+}
+
+/** Connect to a coordinator.
+ *
+ *	@param[in]	nb_threads	The number of walker threads that will add points.
+ *	@param[in]	batch_size	The number of points sent in one frame.
+ *	@param[in]	compress	1 to send compressed frames.
+ *	@return 	The connection, or NULL if the coordinator can not be reached.
+ */
+net_t *net_connect(const char *host, int port, int nb_threads, int batch_size, int compress)
+{
+	struct addrinfo hints, *res, *ai;
+	char port_str[16];
+	net_t *net;
+	int fd = -1;
+	int one = 1;
+	int i, j;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(port_str, sizeof(port_str), "%d", port);
+	if(getaddrinfo(host, port_str, &hints, &res) != 0)
+	{
+		fprintf(stderr, "Can not resolve %s.\n", host);
+		return NULL;
+	}
+	for(ai = res; ai != NULL; ai = ai->ai_next)
+	{
+		fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if(fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+		{
+			break;
+		}
+		if(fd >= 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	freeaddrinfo(res);
+	if(fd < 0)
+	{
+		fprintf(stderr, "Can not connect to %s:%d.\n", host, port);
+		return NULL;
+	}
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	net = calloc(1, sizeof(net_t));
+	net->fd = fd;
+	net->nb_threads = nb_threads;
+	net->batch_size = batch_size;
+	net->compress = compress;
+	net->stop = 1;
+	net->batches = calloc(nb_threads, sizeof(net_batch_t));
+	for(i = 0; i < nb_threads; i++)
+	{
+		//two more numbers, used as temporaries by the compression
+		net->batches[i].x = malloc(sizeof(mpz_t) * (batch_size + 1));
+		net->batches[i].a = malloc(sizeof(mpz_t) * (batch_size + 1));
+		for(j = 0; j <= batch_size; j++)
+		{
+			mpz_init(net->batches[i].x[j]);
+			mpz_init(net->batches[i].a[j]);
+		}
+		net->batches[i].order = malloc(sizeof(mpz_t *) * batch_size);
+		pthread_mutex_init(&net->batches[i].lock, NULL);
+	}
+	pthread_mutex_init(&net->send_lock, NULL);
+	pthread_mutex_init(&net->lock, NULL);
+	pthread_cond_init(&net->cond, NULL);
+	pthread_create(&net->reader, NULL, net_reader, net);
+	return net;
+}
+
+/** Close the connection to the coordinator.
+ *
+ */
+void net_close(net_t *net)
+{
+	int i, j;
+	shutdown(net->fd, SHUT_RDWR);
+	pthread_join(net->reader, NULL);
+	close(net->fd);
+	for(i = 0; i < net->nb_threads; i++)
+	{
+		for(j = 0; j <= net->batch_size; j++)
+		{
+			mpz_clear(net->batches[i].x[j]);
+			mpz_clear(net->batches[i].a[j]);
+		}
+		free(net->batches[i].x);
+		free(net->batches[i].a);
+		free(net->batches[i].order);
+		free(net->batches[i].frame);
+		pthread_mutex_destroy(&net->batches[i].lock);
+	}
+	free(net->batches);
+	free(net->problem);
+	pthread_mutex_destroy(&net->send_lock);
+	pthread_mutex_destroy(&net->lock);
+	pthread_cond_destroy(&net->cond);
+	free(net);
+}
+
+/** Wait for the next problem sent by the coordinator.
+ *
+ *	@brief The batches are emptied and sized for the new problem.
+ *
+ *	@return 	1 if a problem was received, 0 if the coordinator ended the session.
+ */
+int net_wait_problem(net_t *net, elliptic_curve_t *E, mpz_t n, point_t *P, point_t *Q, mpz_t *A, mpz_t *B, uint8_t *nb_bits, uint8_t *trailling_bits, uint8_t *level, uint32_t *problem_id)
+{
+	mpz_ptr numbers[__NET_NB_NUMBERS__] = {E->A, E->B, E->p, n, P->x, P->y, Q->x, Q->y};
+	unsigned char *payload;
+	uint32_t len;
+	size_t pos = 12;
+	int i;
+
+	pthread_mutex_lock(&net->lock);
+	while(net->problem == NULL && !net->closed)
+	{
+		pthread_cond_wait(&net->cond, &net->lock);
+	}
+	if(net->problem == NULL)
+	{
+		pthread_mutex_unlock(&net->lock);
+		return 0;
+	}
+	payload = net->problem;
+	len = net->problem_len;
+	net->problem = NULL;
+
+	for(i = 0; i < 20; i++)
+	{
+		numbers[8 + 2 * i] = A[i];
+		numbers[9 + 2 * i] = B[i];
+	}
+	payload[len] = '\0';
+	for(i = 0; i < __NET_NB_NUMBERS__; i++)
+	{
+		if(pos >= len || mpz_set_str(numbers[i], (char *)payload + pos, 16) != 0)
+		{
+			fprintf(stderr, "Malformed problem received from the coordinator.\n");
+			exit(1);
+		}
+		pos += strlen((char *)payload + pos) + 1;
+	}
+	mpz_set_ui(P->z, 1);
+	mpz_set_ui(Q->z, 1);
+	net->problem_id = get_u32(payload);
+	net->worker = get_u32(payload + 4);
+	*nb_bits = payload[8];
+	*trailling_bits = payload[9];
+	*level = payload[10];
+	E->field = payload[11];
+	*problem_id = net->problem_id;
+	net->stop = (net->stopped_id == net->problem_id);
+	pthread_mutex_unlock(&net->lock);
+	free(payload);
+
+	net->x_bytes = (mpz_sizeinbase(E->p, 2) - *trailling_bits + 7) / 8;
+	net->a_bytes = ((*nb_bits > mpz_sizeinbase(n, 2) ? *nb_bits : mpz_sizeinbase(n, 2)) + 7) / 8;
+	for(i = 0; i < net->nb_threads; i++)
+	{
+		pthread_mutex_lock(&net->batches[i].lock);
+		net->batches[i].count = 0;
+		net->batches[i].frame_size = __NET_POINTS_HEADER_SIZE__ + (size_t)net->batch_size * 2 * (net->x_bytes + net->a_bytes);
+		net->batches[i].frame = realloc(net->batches[i].frame, net->batches[i].frame_size);
+		pthread_mutex_unlock(&net->batches[i].lock);
+	}
+	return 1;
+}
+
+/** Get the flag telling the walkers to stop.
+ *
+ */
+volatile uint32_t *net_stop(net_t *net)
+{
+	return &net->stop;
+}
+
+/** Get the number of points and bytes sent since the connection.
+ *
+ */
+void net_sent(net_t *net, unsigned long long int *nb_points, unsigned long long int *nb_bytes)
+{
+	pthread_mutex_lock(&net->send_lock);
+	*nb_points = net->nb_points;
+	*nb_bytes = net->nb_bytes;
+	pthread_mutex_unlock(&net->send_lock);
+}
+
+/** Queue a point to be sent to the coordinator.
+ *
+ *	@brief The coordinator looks for collisions, so the point is never
+ *	found here. The batch is sent once full or due, and else by the
+ *	reader thread once due.
+ *
+ *	@return 	0.
+ */
+int struct_add_net(net_t *net, mpz_t a_in, mpz_t xDist)
+{
+	net_batch_t *b = &net->batches[omp_get_thread_num()];
+	unsigned long long int t = now_us();
+	pthread_mutex_lock(&b->lock);
+	if(b->count == 0)
+	{
+		b->first_us = t;
+	}
+	mpz_set(b->x[b->count], xDist);
+	mpz_set(b->a[b->count], a_in);
+	b->count++;
+	if(b->count == net->batch_size || t - b->first_us >= __NET_FLUSH_US__)
+	{
+		net_flush(net, b);
+	}
+	pthread_mutex_unlock(&b->lock);
+	return 0;
+}
+
+/** Drop the points not sent yet.
+ *
+ */
+void struct_reset_net(net_t *net)
+{
+	int i;
+	for(i = 0; i < net->nb_threads; i++)
+	{
+		pthread_mutex_lock(&net->batches[i].lock);
+		net->batches[i].count = 0;
+		pthread_mutex_unlock(&net->batches[i].lock);
+	}
+}
+
+/** The connection is closed by net_close.
+ *
+ */
+void struct_free_net(net_t *net)
+{
+	(void)net;
+}
+
+/** Get the memory occupation of the batches.
+ *
+ *	@param[out]	nb_points	The number of points sent since the connection.
+ *	@return 	The memory occupation in bytes.
+ */
+unsigned long long int struct_memory_net(net_t *net, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	unsigned long long int memory = 0;
+	int i;
+	for(i = 0; i < net->nb_threads; i++)
+	{
+		memory += net->batches[i].frame_size + (unsigned long long int)(net->batch_size + 1) * 2 * (sizeof(mpz_t) + net->x_bytes + net->a_bytes);
+	}
+	*nb_points = net->nb_points;
+	*rate_of_use = 0;
+	*rate_slots = 0;
+	return memory;
+}
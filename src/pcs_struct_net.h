@@ -0,0 +1,50 @@
+/** @file pcs_struct_net.h
+ *
+ */
+#ifndef PCS_STRUCT_NET_H
+#define PCS_STRUCT_NET_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_storage.h"
+
+#define __STRUCT_NET__ 3
+#define __NET_DEFAULT_BATCH__ 256
+#define __NET_FLUSH_US__ 100000
+#define __NET_FRAME_HEADER_SIZE__ 5
+
+/* Types of frames */
+#define __NET_FRAME_PROBLEM__ 1
+#define __NET_FRAME_POINTS__ 2
+#define __NET_FRAME_STOP__ 3
+#define __NET_FRAME_BYE__ 4
+
+/* Flags of a frame of points */
+#define __NET_COMPRESSED__ 1
+
+typedef struct net net_t;
+
+/** Function called for each point of a frame by net_decode_points.
+ */
+typedef void (*net_point_fn_t)(mpz_t xDist, mpz_t a, void *arg);
+
+net_t *net_connect(const char *host, int port, int nb_threads, int batch_size, int compress);
+void net_close(net_t *net);
+int net_wait_problem(net_t *net, elliptic_curve_t *E, mpz_t n, point_t *P, point_t *Q, mpz_t *A, mpz_t *B, uint8_t *nb_bits, uint8_t *trailling_bits, uint8_t *level, uint32_t *problem_id);
+volatile uint32_t *net_stop(net_t *net);
+void net_sent(net_t *net, unsigned long long int *nb_points, unsigned long long int *nb_bytes);
+
+int net_listen(int port);
+int net_send_frame(int fd, uint8_t type, const unsigned char *payload, uint32_t len);
+size_t net_parse_frame(const unsigned char *buffer, size_t len, uint8_t *type, const unsigned char **payload, uint32_t *payload_len);
+int net_send_problem(int fd, uint32_t problem_id, uint32_t worker, elliptic_curve_t E, mpz_t n, point_t P, point_t Q, mpz_t *A, mpz_t *B, uint8_t nb_bits, uint8_t trailling_bits, uint8_t level);
+int net_send_id(int fd, uint8_t type, uint32_t problem_id);
+int net_decode_points(const unsigned char *payload, uint32_t len, uint32_t *problem_id, uint32_t *worker, net_point_fn_t fn, void *arg);
+
+int struct_add_net(net_t *net, mpz_t a_in, mpz_t xDist);
+void struct_reset_net(net_t *net);
+void struct_free_net(net_t *net);
+unsigned long long int struct_memory_net(net_t *net, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+#endif
@@ -0,0 +1,566 @@
+/** @file pcs_struct_shm.c
+ *  @brief A distinguished-point store in a POSIX shared-memory segment, fed by several processes.
+ *
+ *	The segment is created by a coordinator process and holds a header,
+ *	the heads of the 2^level slots, one spinlock per slot and an array of
+ *	cells. A cell holds the same packed vector as the PRTL structure and
+ *	the index of the next cell of its list, since the segment is mapped at
+ *	different addresses in each process. Cells are taken from the array
+ *	with an atomic counter, so no process allocates memory on behalf of the
+ *	others.
+ *
+ *	The header also holds the problem being solved, a flag telling the
+ *	processes that it is solved and a ring buffer of the collisions found.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pcs_vect_bin.h"
+#include "pcs_struct_shm.h"
+
+#define __SHM_MAGIC__ "PCSSHM01"
+#define __SHM_NB_NUMBERS__ (8 + 2 * 20)
+
+/** A collision found by one of the processes.
+ */
+typedef struct
+{
+	uint64_t seq;
+	uint32_t worker;
+	char x[__SHM_NUMBER_SIZE__];
+}shm_collision_t;
+
+/** Header of the segment.
+ *  @brief The fields shared by the processes are only accessed with atomic builtins.
+ */
+typedef struct
+{
+	char magic[8];
+	uint64_t size;
+	uint64_t heads_offset;
+	uint64_t locks_offset;
+	uint64_t cells_offset;
+	uint64_t nb_slots;
+	uint64_t nb_cells;
+	uint64_t cells_used;
+	uint64_t cells_dropped;
+	uint64_t nb_steps;
+	uint64_t ring_head;
+	uint32_t nb_workers;
+	uint32_t nb_running;
+	uint32_t problem_id;
+	uint32_t done;
+	uint32_t shutdown;
+	uint32_t nb_collisions;
+	uint8_t nb_bits;
+	uint8_t trailling_bits;
+	uint8_t level;
+	uint8_t field;
+	/* curve A, B, p, n, P.x, P.y, Q.x, Q.y then A[i], B[i], in hexadecimal */
+	char numbers[__SHM_NB_NUMBERS__][__SHM_NUMBER_SIZE__];
+	shm_collision_t ring[__SHM_RING_SIZE__];
+}shm_header_t;
+
+/** A cell of a slot list.
+ */
+typedef struct
+{
+	uint32_t nxt;
+	_vect_bin_t v[__DATA_SIZE_IN_BYTES__];
+}shm_cell_t;
+
+/** Mapping of the segment in one process.
+ */
+struct shm
+{
+	char *name;
+	int owner;
+	int worker_id;
+	shm_header_t *header;
+	uint32_t *heads;
+	uint8_t *locks;
+	shm_cell_t *cells;
+	int suffix_len;
+	uint64_t mask;
+};
+
+/** Set the pointers of a mapping from the offsets of its header.
+ *
+ */
+static void shm_set_pointers(shm_t *shm)
+{
+	shm_header_t *h = shm->header;
+	shm->heads = (uint32_t *)((char *)h + h->heads_offset);
+	shm->locks = (uint8_t *)((char *)h + h->locks_offset);
+	shm->cells = (shm_cell_t *)((char *)h + h->cells_offset);
+	shm->suffix_len = h->nb_bits - h->trailling_bits - h->level;
+	shm->mask = (1ULL << h->level) - 1;
+}
+
+/** Create the shared segment and map it.
+ *
+ *	@brief An existing segment of the same name is replaced.
+ *
+ *	@param[in]	name		The name of the segment, starting with '/'.
+ *	@param[in]	nb_cells	The number of points the store can hold, at most __SHM_MAX_CELLS__.
+ *	@return		The mapping, or NULL if the segment can not be created.
+ */
+shm_t *shm_create(const char *name, uint8_t nb_bits, uint8_t trailling_bits, uint8_t level, unsigned long int nb_cells)
+{
+	shm_t *shm;
+	shm_header_t *h;
+	uint64_t nb_slots = 1ULL << level;
+	uint64_t heads_offset = (sizeof(shm_header_t) + 63) & ~63ULL;
+	uint64_t locks_offset = heads_offset + ((nb_slots * sizeof(uint32_t) + 63) & ~63ULL);
+	uint64_t cells_offset = locks_offset + ((nb_slots + 63) & ~63ULL);
+	uint64_t size = cells_offset + nb_cells * sizeof(shm_cell_t);
+	int fd;
+
+	if(nb_cells > __SHM_MAX_CELLS__)
+	{
+		fprintf(stderr, "A shared store holds at most %lu points.\n", (unsigned long int)__SHM_MAX_CELLS__);
+		return NULL;
+	}
+	shm_unlink(name);
+	fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+	if(fd < 0 || ftruncate(fd, size) != 0)
+	{
+		fprintf(stderr, "Can not create shared memory segment %s.\n", name);
+		if(fd >= 0)
+		{
+			close(fd);
+			shm_unlink(name);
+		}
+		return NULL;
+	}
+	h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(h == MAP_FAILED)
+	{
+		fprintf(stderr, "Can not map shared memory segment %s.\n", name);
+		shm_unlink(name);
+		return NULL;
+	}
+	//the segment is zero-filled by ftruncate
+	h->size = size;
+	h->heads_offset = heads_offset;
+	h->locks_offset = locks_offset;
+	h->cells_offset = cells_offset;
+	h->nb_slots = nb_slots;
+	h->nb_cells = nb_cells;
+	h->nb_bits = nb_bits;
+	h->trailling_bits = trailling_bits;
+	h->level = level;
+	h->done = 1;
+	memcpy(h->magic, __SHM_MAGIC__, 8);
+
+	shm = malloc(sizeof(shm_t));
+	shm->name = strdup(name);
+	shm->owner = 1;
+	shm->header = h;
+	shm->worker_id = __atomic_fetch_add(&h->nb_workers, 1, __ATOMIC_SEQ_CST);
+	shm_set_pointers(shm);
+	return shm;
+}
+
+/** Map a segment created by a coordinator.
+ *
+ *	@return		The mapping, or NULL if the segment can not be mapped.
+ */
+shm_t *shm_attach(const char *name)
+{
+	shm_t *shm;
+	shm_header_t *h;
+	struct stat st;
+	int fd;
+
+	fd = shm_open(name, O_RDWR, 0600);
+	if(fd < 0 || fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(shm_header_t))
+	{
+		fprintf(stderr, "Can not open shared memory segment %s.\n", name);
+		if(fd >= 0)
+		{
+			close(fd);
+		}
+		return NULL;
+	}
+	h = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(h == MAP_FAILED || memcmp(h->magic, __SHM_MAGIC__, 8) != 0 || h->size != (uint64_t)st.st_size)
+	{
+		fprintf(stderr, "Shared memory segment %s is not a PCS store.\n", name);
+		if(h != MAP_FAILED)
+		{
+			munmap(h, st.st_size);
+		}
+		return NULL;
+	}
+	shm = malloc(sizeof(shm_t));
+	shm->name = strdup(name);
+	shm->owner = 0;
+	shm->header = h;
+	shm->worker_id = __atomic_fetch_add(&h->nb_workers, 1, __ATOMIC_SEQ_CST);
+	shm_set_pointers(shm);
+	return shm;
+}
+
+/** Unmap a segment. The coordinator also removes it.
+ *
+ */
+void shm_detach(shm_t *shm)
+{
+	__atomic_sub_fetch(&shm->header->nb_workers, 1, __ATOMIC_SEQ_CST);
+	munmap(shm->header, shm->header->size);
+	if(shm->owner)
+	{
+		shm_unlink(shm->name);
+	}
+	free(shm->name);
+	free(shm);
+}
+
+/** Get the index of the process among the ones that mapped the segment.
+ *
+ */
+int shm_worker_id(shm_t *shm)
+{
+	return shm->worker_id;
+}
+
+/** Get the number of processes that currently map the segment.
+ *
+ */
+int shm_nb_workers(shm_t *shm)
+{
+	return __atomic_load_n(&shm->header->nb_workers, __ATOMIC_SEQ_CST);
+}
+
+/** Get the settings the store was created with.
+ *
+ */
+void shm_get_settings(shm_t *shm, uint8_t *nb_bits, uint8_t *trailling_bits, uint8_t *level)
+{
+	*nb_bits = shm->header->nb_bits;
+	*trailling_bits = shm->header->trailling_bits;
+	*level = shm->header->level;
+}
+
+/** Publish a new problem, called by the coordinator.
+ *
+ *	@brief Waits for all the processes to leave the previous problem,
+ *	empties the store and writes the new problem, then lets the
+ *	processes waiting in shm_join start.
+ *
+ */
+void shm_publish(shm_t *shm, elliptic_curve_t E, mpz_t n, point_t P, point_t Q, mpz_t *A, mpz_t *B, int nb_collisions)
+{
+	shm_header_t *h = shm->header;
+	int i;
+	__atomic_store_n(&h->done, 1, __ATOMIC_SEQ_CST);
+	shm_wait_idle(shm);
+
+	struct_reset_shm(shm);
+	h->field = E.field;
+	gmp_snprintf(h->numbers[0], __SHM_NUMBER_SIZE__, "%Zx", E.A);
+	gmp_snprintf(h->numbers[1], __SHM_NUMBER_SIZE__, "%Zx", E.B);
+	gmp_snprintf(h->numbers[2], __SHM_NUMBER_SIZE__, "%Zx", E.p);
+	gmp_snprintf(h->numbers[3], __SHM_NUMBER_SIZE__, "%Zx", n);
+	gmp_snprintf(h->numbers[4], __SHM_NUMBER_SIZE__, "%Zx", P.x);
+	gmp_snprintf(h->numbers[5], __SHM_NUMBER_SIZE__, "%Zx", P.y);
+	gmp_snprintf(h->numbers[6], __SHM_NUMBER_SIZE__, "%Zx", Q.x);
+	gmp_snprintf(h->numbers[7], __SHM_NUMBER_SIZE__, "%Zx", Q.y);
+	for(i = 0; i < 20; i++)
+	{
+		gmp_snprintf(h->numbers[8 + 2 * i], __SHM_NUMBER_SIZE__, "%Zx", A[i]);
+		gmp_snprintf(h->numbers[9 + 2 * i], __SHM_NUMBER_SIZE__, "%Zx", B[i]);
+	}
+	h->nb_collisions = nb_collisions;
+	h->nb_steps = 0;
+	h->ring_head = 0;
+	for(i = 0; i < __SHM_RING_SIZE__; i++)
+	{
+		h->ring[i].seq = 0;
+	}
+	__atomic_store_n(&h->done, 0, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&h->problem_id, 1, __ATOMIC_SEQ_CST);
+}
+
+/** Read the problem being solved.
+ *
+ */
+void shm_read_problem(shm_t *shm, elliptic_curve_t *E, mpz_t n, point_t *P, point_t *Q, mpz_t *A, mpz_t *B, int *nb_collisions)
+{
+	shm_header_t *h = shm->header;
+	int i;
+	E->field = h->field;
+	mpz_set_str(E->A, h->numbers[0], 16);
+	mpz_set_str(E->B, h->numbers[1], 16);
+	mpz_set_str(E->p, h->numbers[2], 16);
+	mpz_set_str(n, h->numbers[3], 16);
+	mpz_set_str(P->x, h->numbers[4], 16);
+	mpz_set_str(P->y, h->numbers[5], 16);
+	mpz_set_ui(P->z, 1);
+	mpz_set_str(Q->x, h->numbers[6], 16);
+	mpz_set_str(Q->y, h->numbers[7], 16);
+	mpz_set_ui(Q->z, 1);
+	for(i = 0; i < 20; i++)
+	{
+		mpz_set_str(A[i], h->numbers[8 + 2 * i], 16);
+		mpz_set_str(B[i], h->numbers[9 + 2 * i], 16);
+	}
+	*nb_collisions = h->nb_collisions;
+}
+
+/** Wait for a problem newer than the last one joined, and join it.
+ *
+ *	@param[in,out]	problem_id	The last problem joined, updated.
+ *	@return			1 if a problem was joined, 0 if the coordinator shut down.
+ */
+int shm_join(shm_t *shm, uint32_t *problem_id)
+{
+	shm_header_t *h = shm->header;
+	uint32_t id;
+	while(!__atomic_load_n(&h->shutdown, __ATOMIC_SEQ_CST))
+	{
+		id = __atomic_load_n(&h->problem_id, __ATOMIC_SEQ_CST);
+		if(id != *problem_id && !__atomic_load_n(&h->done, __ATOMIC_SEQ_CST))
+		{
+			__atomic_add_fetch(&h->nb_running, 1, __ATOMIC_SEQ_CST);
+			//the coordinator may have closed the problem meanwhile
+			if(__atomic_load_n(&h->problem_id, __ATOMIC_SEQ_CST) == id && !__atomic_load_n(&h->done, __ATOMIC_SEQ_CST))
+			{
+				*problem_id = id;
+				return 1;
+			}
+			__atomic_sub_fetch(&h->nb_running, 1, __ATOMIC_SEQ_CST);
+		}
+		usleep(__SHM_POLL_US__);
+	}
+	return 0;
+}
+
+/** Leave the problem joined, adding the steps walked to the total.
+ *
+ */
+void shm_leave(shm_t *shm, unsigned long long int nb_steps)
+{
+	__atomic_add_fetch(&shm->header->nb_steps, nb_steps, __ATOMIC_SEQ_CST);
+	__atomic_sub_fetch(&shm->header->nb_running, 1, __ATOMIC_SEQ_CST);
+}
+
+/** Wait until no process works on the problem any more.
+ *
+ */
+void shm_wait_idle(shm_t *shm)
+{
+	while(__atomic_load_n(&shm->header->nb_running, __ATOMIC_SEQ_CST) != 0)
+	{
+		usleep(__SHM_POLL_US__);
+	}
+}
+
+/** Tell the processes waiting for a problem to stop.
+ *
+ */
+void shm_shutdown(shm_t *shm)
+{
+	__atomic_store_n(&shm->header->done, 1, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&shm->header->shutdown, 1, __ATOMIC_SEQ_CST);
+}
+
+/** Get the flag set once the problem is solved, to stop the runs of all processes.
+ *
+ */
+volatile uint32_t *shm_done(shm_t *shm)
+{
+	return &shm->header->done;
+}
+
+/** Report a collision in the ring buffer.
+ *
+ *	@brief The problem is marked as solved once the requested number of
+ *	collisions is reported. If more collisions than the size of the ring
+ *	are found, the oldest ones are overwritten.
+ *
+ */
+void shm_report_collision(shm_t *shm, mpz_t x)
+{
+	shm_header_t *h = shm->header;
+	uint64_t i = __atomic_fetch_add(&h->ring_head, 1, __ATOMIC_SEQ_CST);
+	shm_collision_t *c = &h->ring[i % __SHM_RING_SIZE__];
+	c->worker = shm->worker_id;
+	gmp_snprintf(c->x, __SHM_NUMBER_SIZE__, "%Zx", x);
+	__atomic_store_n(&c->seq, i + 1, __ATOMIC_SEQ_CST);
+	if(i + 1 >= h->nb_collisions)
+	{
+		__atomic_store_n(&h->done, 1, __ATOMIC_SEQ_CST);
+	}
+}
+
+/** Read the i-th collision reported for the problem.
+ *
+ *	@return		1 if it is in the ring, 0 otherwise.
+ */
+int shm_get_collision(shm_t *shm, int i, mpz_t x, int *worker)
+{
+	shm_collision_t *c = &shm->header->ring[i % __SHM_RING_SIZE__];
+	if(__atomic_load_n(&c->seq, __ATOMIC_SEQ_CST) != (uint64_t)i + 1)
+	{
+		return 0;
+	}
+	mpz_set_str(x, c->x, 16);
+	*worker = c->worker;
+	return 1;
+}
+
+/** Get the number of steps walked by all the processes on the problem.
+ *
+ */
+unsigned long long int shm_steps(shm_t *shm)
+{
+	return __atomic_load_n(&shm->header->nb_steps, __ATOMIC_SEQ_CST);
+}
+
+/** Search and insert function for the shared store.
+ *
+ *  @brief Same as struct_add_PRTL, with a spinlock in the segment for
+ *  each slot. If the array of cells is full, the point is dropped.
+ *
+ *  @param[out]	a_out	The a coefficient of the found point.
+ *  @param[in]	a_in	The a coefficient of the newly added point.
+ *  @param[in]	xDist	The x-coordinate, without the trailling zeros.
+ *  @return 	1 if the point was found, 0 otherwise.
+ */
+int struct_add_shm(shm_t *shm, mpz_t a_out, mpz_t a_in, mpz_t xDist)
+{
+	shm_header_t *h = shm->header;
+	uint64_t key = mpz_getlimbn(xDist, 0) & shm->mask;
+	uint32_t *prev = &shm->heads[key];
+	uint32_t next;
+	uint64_t new;
+	int cmp = -1;
+	int retval = 0;
+
+	while(__atomic_test_and_set(&shm->locks[key], __ATOMIC_ACQUIRE))
+	{
+		while(__atomic_load_n(&shm->locks[key], __ATOMIC_RELAXED));
+	}
+	next = *prev;
+	while(next != 0 && (cmp = vect_bin_cmp_mpz(shm->cells[next - 1].v, 0, shm->suffix_len, xDist, h->level)) < 0)
+	{
+		prev = &shm->cells[next - 1].nxt;
+		next = *prev;
+	}
+	if(next != 0 && cmp == 0) //collision
+	{
+		vect_bin_get_mpz(shm->cells[next - 1].v, shm->suffix_len, h->nb_bits, a_out);
+		retval = 1;
+	}
+	else
+	{
+		new = __atomic_fetch_add(&h->cells_used, 1, __ATOMIC_RELAXED);
+		if(new < h->nb_cells)
+		{
+			vect_bin_t_reset(shm->cells[new].v);
+			vect_bin_set_mpz(shm->cells[new].v, 0, shm->suffix_len, xDist, h->level);
+			vect_bin_set_mpz(shm->cells[new].v, shm->suffix_len, h->nb_bits, a_in, 0);
+			shm->cells[new].nxt = next;
+			*prev = new + 1;
+		}
+		else
+		{
+			__atomic_add_fetch(&h->cells_dropped, 1, __ATOMIC_RELAXED);
+		}
+	}
+	__atomic_clear(&shm->locks[key], __ATOMIC_RELEASE);
+	return retval;
+}
+
+/** Empty the shared store.
+ *
+ *	@brief Only called by the coordinator in shm_publish, when no process
+ *	works on the store.
+ *
+ */
+void struct_reset_shm(shm_t *shm)
+{
+	memset(shm->heads, 0, sizeof(uint32_t) * shm->header->nb_slots);
+	shm->header->cells_used = 0;
+	shm->header->cells_dropped = 0;
+}
+
+/** Call a function on each point of the shared store.
+ *
+ */
+void struct_foreach_shm(shm_t *shm, struct_foreach_fn_t fn, void *arg)
+{
+	uint64_t i;
+	uint32_t next;
+	mpz_t xDist, a;
+	mpz_inits(xDist, a, NULL);
+	for(i = 0; i < shm->header->nb_slots; i++)
+	{
+		while(__atomic_test_and_set(&shm->locks[i], __ATOMIC_ACQUIRE));
+		for(next = shm->heads[i]; next != 0; next = shm->cells[next - 1].nxt)
+		{
+			vect_bin_get_mpz(shm->cells[next - 1].v, 0, shm->suffix_len, xDist);
+			mpz_mul_2exp(xDist, xDist, shm->header->level);
+			mpz_add_ui(xDist, xDist, i);
+			vect_bin_get_mpz(shm->cells[next - 1].v, shm->suffix_len, shm->header->nb_bits, a);
+			fn(xDist, a, arg);
+		}
+		__atomic_clear(&shm->locks[i], __ATOMIC_RELEASE);
+	}
+	mpz_clears(xDist, a, NULL);
+}
+
+/** Free the store of a context.
+ *
+ *	@brief The mapping is not owned by the context: it is kept until
+ *	shm_detach, so that the process can go on with the next problem.
+ *
+ */
+void struct_free_shm(shm_t *shm)
+{
+	(void) shm;
+}
+
+/** Get the memory occupation of the shared store.
+ *
+ *	@brief The points dropped because the array of cells was full are
+ *	printed out.
+ *
+ *  @return	The memory occupation in bytes of the whole segment.
+ */
+unsigned long long int struct_memory_shm(shm_t *shm, unsigned long int *nb_points, float *rate_of_use, float *rate_slots)
+{
+	shm_header_t *h = shm->header;
+	uint64_t i, empty_slots = 0;
+	uint64_t used = __atomic_load_n(&h->cells_used, __ATOMIC_SEQ_CST);
+	if(used > h->nb_cells)
+	{
+		used = h->nb_cells;
+	}
+	for(i = 0; i < h->nb_slots; i++)
+	{
+		if(shm->heads[i] == 0)
+		{
+			empty_slots++;
+		}
+	}
+	*nb_points = used;
+	*rate_of_use = ((float)(h->cells_offset + used * sizeof(shm_cell_t))) / ((float)h->size) * 100.0;
+	*rate_slots = (1.0 - ((float)empty_slots) / ((float)h->nb_slots)) * 100.0;
+	printf("\t\tPoints: %lu\n", *nb_points);
+	printf("\t\tEmpty slots: %lu\n", (unsigned long int)empty_slots);
+	if(h->cells_dropped > 0)
+	{
+		printf("\t\tDropped points (store full): %lu\n", (unsigned long int)h->cells_dropped);
+	}
+	return h->size;
+}
@@ -0,0 +1,42 @@
+/** @file pcs_struct_shm.h
+ *
+ */
+#ifndef PCS_STRUCT_SHM_H
+#define PCS_STRUCT_SHM_H
+
+#include <gmp.h>
+#include <inttypes.h>
+#include "pcs_elliptic_curve_operations.h"
+#include "pcs_storage.h"
+
+#define __STRUCT_SHM__ 2
+#define __SHM_NUMBER_SIZE__ 80
+#define __SHM_RING_SIZE__ 64
+#define __SHM_POLL_US__ 1000
+#define __SHM_MAX_CELLS__ (UINT32_MAX - 1) /* the cells are linked by 32-bit indexes plus one */
+
+typedef struct shm shm_t;
+
+shm_t *shm_create(const char *name, uint8_t nb_bits, uint8_t trailling_bits, uint8_t level, unsigned long int nb_cells);
+shm_t *shm_attach(const char *name);
+void shm_detach(shm_t *shm);
+int shm_worker_id(shm_t *shm);
+void shm_get_settings(shm_t *shm, uint8_t *nb_bits, uint8_t *trailling_bits, uint8_t *level);
+void shm_publish(shm_t *shm, elliptic_curve_t E, mpz_t n, point_t P, point_t Q, mpz_t *A, mpz_t *B, int nb_collisions);
+void shm_read_problem(shm_t *shm, elliptic_curve_t *E, mpz_t n, point_t *P, point_t *Q, mpz_t *A, mpz_t *B, int *nb_collisions);
+int shm_join(shm_t *shm, uint32_t *problem_id);
+void shm_leave(shm_t *shm, unsigned long long int nb_steps);
+void shm_wait_idle(shm_t *shm);
+void shm_shutdown(shm_t *shm);
+volatile uint32_t *shm_done(shm_t *shm);
+void shm_report_collision(shm_t *shm, mpz_t x);
+int shm_get_collision(shm_t *shm, int i, mpz_t x, int *worker);
+unsigned long long int shm_steps(shm_t *shm);
+int shm_nb_workers(shm_t *shm);
+
+int struct_add_shm(shm_t *shm, mpz_t a_out, mpz_t a_in, mpz_t xDist);
+void struct_reset_shm(shm_t *shm);
+void struct_foreach_shm(shm_t *shm, struct_foreach_fn_t fn, void *arg);
+void struct_free_shm(shm_t *shm);
+unsigned long long int struct_memory_shm(shm_t *shm, unsigned long int *nb_points, float *rate_of_use, float *rate_slots);
+#endif
@@ -16,14 +16,92 @@
 /// [N-------][--------][--------][--------][-------0]
 /// [--------][--------][--------][--------][--------]
 
-unsigned long long _vect_bin_alloc_size;
-omp_lock_t _vect_alloc_size_lock;
+/// call once for each structure built on chained cells
+void _vect_bin_t_initiate(_vect_bin_pool_t *pool, int nb_threads)
+{
+	int i;
+	pool->alloc_size = 0ULL;
+	pool->nb_arenas = nb_threads;
+	pool->arenas = (_vect_bin_arena_t *) malloc(sizeof(_vect_bin_arena_t) * nb_threads);
+	for(i = 0; i < nb_threads; i++)
+	{
+		pool->arenas[i].first = NULL;
+		pool->arenas[i].current = NULL;
+		pool->arenas[i].used = __VECT_BIN_SLAB_SIZE__;
+		pool->arenas[i].nb_cells = 0ULL;
+	}
+}
+
+/// take one cell from an arena, chaining a new slab only when all
+/// the slabs already owned by the arena are full
+_vect_bin_chain_t *_vect_bin_arena_alloc(_vect_bin_arena_t *arena)
+{
+	_vect_bin_slab_t *slab;
+	if(arena->used == __VECT_BIN_SLAB_SIZE__)
+	{
+		if(arena->current != NULL && arena->current->nxt != NULL)
+		{
+			arena->current = arena->current->nxt;
+		}
+		else
+		{
+			slab = (_vect_bin_slab_t *) malloc(sizeof(_vect_bin_slab_t));
+			slab->nxt = NULL;
+			if(arena->current == NULL)
+				arena->first = slab;
+			else
+				arena->current->nxt = slab;
+			arena->current = slab;
+		}
+		arena->used = 0;
+	}
+	arena->nb_cells++;
+	return &(arena->current->cells[arena->used++]);
+}
+
+/// forget all the cells of all arenas, but keep their slabs for reuse
+void _vect_bin_t_reset_arenas(_vect_bin_pool_t *pool)
+{
+	int i;
+	for(i = 0; i < pool->nb_arenas; i++)
+	{
+		pool->arenas[i].current = pool->arenas[i].first;
+		pool->arenas[i].used = (pool->arenas[i].first == NULL) ? __VECT_BIN_SLAB_SIZE__ : 0;
+		pool->arenas[i].nb_cells = 0ULL;
+	}
+}
+
+/// give all slabs back to the system
+void _vect_bin_t_terminate(_vect_bin_pool_t *pool)
+{
+	int i;
+	_vect_bin_slab_t *slab;
+	_vect_bin_slab_t *next;
+	for(i = 0; i < pool->nb_arenas; i++)
+	{
+		next = pool->arenas[i].first;
+		while(next != NULL)
+		{
+			slab = next;
+			next = next->nxt;
+			free(slab);
+		}
+	}
+	free(pool->arenas);
+	pool->nb_arenas = 0;
+}
 
-/// call once at the begin of each program
-void _vect_bin_t_initiate()
+/// memory used by the cells handed out by the arenas, plus the cells
+/// counted with _vect_bin_t_count_memory
+unsigned long long _vect_bin_t_memory(_vect_bin_pool_t *pool)
 {
-	_vect_bin_alloc_size = 0ULL;
-	omp_init_lock(&_vect_alloc_size_lock);
+	int i;
+	unsigned long long sum = pool->alloc_size;
+	for(i = 0; i < pool->nb_arenas; i++)
+	{
+		sum += sizeof(_vect_bin_chain_t) * pool->arenas[i].nb_cells;
+	}
+	return sum;
 }
 
 /// get bit at rank return _true or _false respectively to 1 and 0
@@ -15,8 +15,8 @@ typedef char _bool_t;
 /// Size (in bytes) of data stored in a single vector
 #define __DATA_SIZE_IN_BYTES__ 29
 
-extern unsigned long long _vect_bin_alloc_size;
-extern omp_lock_t _vect_alloc_size_lock;
+/// Number of chained cells carved out of one slab of an arena
+#define __VECT_BIN_SLAB_SIZE__ 4096
 
 /// type of one cell of the binary vector
 typedef char _vect_bin_t;
@@ -37,28 +37,48 @@ typedef struct __vect_bin_list_t {
   struct __vect_bin_list_t *nxt;
 } __attribute__((packed)) _vect_bin_chain_t;
 
+/// A slab of chained cells. Slabs are never given back to the system
+/// before _vect_bin_t_terminate, so that a structure can be emptied
+/// and refilled without calling malloc again.
+typedef struct __vect_bin_slab_t {
+  _vect_bin_chain_t cells[__VECT_BIN_SLAB_SIZE__];
+  struct __vect_bin_slab_t *nxt;
+} _vect_bin_slab_t;
+
+/// Per-thread arena of chained cells. Each thread only allocates from
+/// its own arena, hence no lock is needed.
+typedef struct {
+  _vect_bin_slab_t *first;
+  _vect_bin_slab_t *current;
+  unsigned int used;
+  unsigned long long nb_cells;
+} _vect_bin_arena_t;
+
+/// All the arenas of one structure, one per thread, and the memory
+/// counted for the cells that start each list.
+typedef struct {
+  _vect_bin_arena_t *arenas;
+  int nb_arenas;
+  unsigned long long alloc_size;
+} _vect_bin_pool_t;
+
 /// call it when you allocate several (_n) cells that will start
 /// each one list.
-#define _vect_bin_t_count_memory(_n) \
-  _vect_bin_alloc_size += (sizeof(_vect_bin_chain_t) * _n)
+#define _vect_bin_t_count_memory(_pool, _n) \
+  (_pool)->alloc_size += (sizeof(_vect_bin_chain_t) * _n)
 
 /// Initialization of one cell that will be chained
-#define _vect_bin_chain_t_new(_v) \
-    omp_set_lock(&_vect_alloc_size_lock); \
-  _v = (_vect_bin_chain_t *) malloc(sizeof(_vect_bin_chain_t)); \
-  _v->nxt = NULL; \
-  _vect_bin_alloc_size += sizeof(_vect_bin_chain_t); \
-  omp_unset_lock(&_vect_alloc_size_lock) 
-  
-
-  /// Initialization of one cell that will be chained
-  #define _vect_bin_chain_t_free(_v) \
-    free(_v); \
-    _vect_bin_alloc_size -= sizeof(_vect_bin_chain_t)
+#define _vect_bin_chain_t_new(_pool, _v) \
+  _v = _vect_bin_arena_alloc(&(_pool)->arenas[omp_get_thread_num()]); \
+  _v->nxt = NULL
 
 /// ----------------------------------- prototypes
 
-void _vect_bin_t_initiate(void);
+void _vect_bin_t_initiate(_vect_bin_pool_t *pool, int nb_threads);
+void _vect_bin_t_reset_arenas(_vect_bin_pool_t *pool);
+void _vect_bin_t_terminate(_vect_bin_pool_t *pool);
+unsigned long long _vect_bin_t_memory(_vect_bin_pool_t *pool);
+_vect_bin_chain_t *_vect_bin_arena_alloc(_vect_bin_arena_t *arena);
 void print_vect_bin(_vect_bin_t *);
 _vect_bin_t *vect_bin_t_reset(_vect_bin_t *);
 _bool_t vect_bin_get_bit(_vect_bin_t *, int);